@@ -0,0 +1,218 @@
+//
+//  BenchmarkTests.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import XCTest
+import PMJSON
+@testable import PMHTTP
+
+/// End-to-end benchmarks for the request hot path.
+///
+/// Each benchmark runs a fixed batch of work inside `measure(_:)`, so the reported time divided
+/// by the batch size is the per-request cost. `testMockedRequestAllocations` counts allocations
+/// per request instead, and fails on its own when the count passes its ceiling.
+///
+/// These live in the PMHTTPBenchmarks target so they don't slow down or destabilize the regular
+/// test suite. Run them with the PMHTTPBenchmarks scheme, and record baselines on the reference
+/// machine so they're shared through `PMHTTP.xcodeproj/xcshareddata/xcbaselines`, at which point
+/// regressions fail the test.
+final class BenchmarkTests: PMHTTPTestCase {
+    func testRequestConstruction() {
+        // Covers path resolution, header normalization and form encoding.
+        let parameters = (0..<16).map({ i in URLQueryItem(name: "param\(i)", value: "value \(i)") })
+        measure {
+            for i in 0..<1000 {
+                let request = HTTP.request(POST: "api/v1/users/\(i)/items", parameters: parameters)
+                request.headerFields["x-request-id"] = "\(i)"
+                request.headerFields["accept-language"] = "en-US"
+                request.headerFields["X-Client-Version"] = "1.0"
+                XCTAssertNotNil(request.preparedURLRequest.httpBody)
+            }
+        }
+    }
+    
+    func testMockedRequestThroughput() {
+        // Covers mock lookup, task bookkeeping and completion dispatch without any networking.
+        for i in 0..<100 {
+            HTTP.mockManager.addMock(for: "api/v1/resource\(i)/:id", statusCode: 200, text: "mock \(i)", delay: 0)
+        }
+        measure {
+            let group = DispatchGroup()
+            for i in 0..<200 {
+                group.enter()
+                HTTP.request(GET: "api/v1/resource\(i % 100)/\(i)").performRequest { (task, result) in
+                    XCTAssertNotNil(result.value)
+                    group.leave()
+                }
+            }
+            XCTAssert(group.wait(timeout: .now() + 10) == .success, "timeout waiting for requests")
+        }
+    }
+    
+    // Completions per second as the number of requests in flight grows. Each runs the same 1000
+    // mocked requests, so the times compare directly across concurrency levels.
+    
+    func testConcurrentCompletionThroughput10() {
+        measureConcurrentCompletionThroughput(concurrency: 10)
+    }
+    
+    func testConcurrentCompletionThroughput100() {
+        measureConcurrentCompletionThroughput(concurrency: 100)
+    }
+    
+    func testConcurrentCompletionThroughput500() {
+        measureConcurrentCompletionThroughput(concurrency: 500)
+    }
+    
+    /// Measures 1000 mocked requests with at most `concurrency` of them in flight at once.
+    private func measureConcurrentCompletionThroughput(concurrency: Int) {
+        // Mocks keep the cost in task bookkeeping and completion dispatch rather than the server.
+        HTTP.mockManager.addMock(for: "foo", statusCode: 200, text: "Mock response", delay: 0)
+        measure {
+            let inFlight = DispatchSemaphore(value: concurrency)
+            let group = DispatchGroup()
+            for _ in 0..<1000 {
+                inFlight.wait()
+                group.enter()
+                HTTP.request(GET: "foo").performRequest { (task, result) in
+                    XCTAssertNotNil(result.value)
+                    inFlight.signal()
+                    group.leave()
+                }
+            }
+            XCTAssert(group.wait(timeout: .now() + 30) == .success, "timeout waiting for requests")
+        }
+    }
+    
+    func testMockedRequestAllocations() {
+        // Counts heap allocations per request while HTTPManager drives mocked GETs through
+        // HTTPMockURLProtocol. Unlike timings, the count barely depends on the machine, so it's
+        // checked against a fixed ceiling instead of a per-machine baseline.
+        guard let counter = AllocationCounter() else {
+            NSLog("Skipping allocation count: the malloc hook isn't available")
+            return
+        }
+        HTTP.mockManager.addMock(for: "api/v1/resource/:id", statusCode: 200, text: "mock", delay: 0)
+        func performRequests(_ count: Int) {
+            let group = DispatchGroup()
+            for i in 0..<count {
+                group.enter()
+                HTTP.request(GET: "api/v1/resource/\(i)").performRequest { (task, result) in
+                    XCTAssertNotNil(result.value)
+                    group.leave()
+                }
+            }
+            XCTAssert(group.wait(timeout: .now() + 10) == .success, "timeout waiting for requests")
+        }
+        // Warm up the session, the mock lookup and any lazily-created state first.
+        performRequests(20)
+        let requestCount = 200
+        let allocations = counter.count { performRequests(requestCount) }
+        let allocationsPerRequest = Double(allocations) / Double(requestCount)
+        NSLog("%.1f allocations per mocked request", allocationsPerRequest)
+        XCTAssertLessThan(allocationsPerRequest, BenchmarkTests.maximumAllocationsPerMockedRequest, "allocations per request")
+    }
+    
+    /// The ceiling for `testMockedRequestAllocations`. Most of the allocations come from
+    /// `URLSession` and the URL loading system rather than PMHTTP, so this leaves room for OS
+    /// differences. Lower it when a change to the request path reduces the logged count.
+    private static let maximumAllocationsPerMockedRequest: Double = 4000
+    
+    func testLoopbackRequestThroughput() {
+        // Covers the full path through URLSession against a local server.
+        let token = httpServer.registerRequestCallback(for: "/foo") { (request, completionHandler) in
+            completionHandler(HTTPServer.Response(status: .ok, text: "success"))
+        }
+        defer { httpServer.unregisterRequestCallback(token) }
+        measure {
+            let group = DispatchGroup()
+            for _ in 0..<50 {
+                group.enter()
+                HTTP.request(GET: "foo").performRequest { (task, result) in
+                    XCTAssertNotNil(result.value)
+                    group.leave()
+                }
+            }
+            XCTAssert(group.wait(timeout: .now() + 10) == .success, "timeout waiting for requests")
+        }
+    }
+    
+    func testMultipartUploadThroughput() {
+        // Simulates uploading a batch of photos to a local server.
+        let photo = Data(repeating: 0xA5, count: 512 * 1024)
+        let token = httpServer.registerRequestCallback(for: "/upload") { (request, completionHandler) in
+            completionHandler(HTTPServer.Response(status: .ok, text: "\(request.body?.count ?? 0)"))
+        }
+        defer { httpServer.unregisterRequestCallback(token) }
+        measure {
+            let group = DispatchGroup()
+            for _ in 0..<4 {
+                group.enter()
+                let request = HTTP.request(POST: "upload", parameters: ["caption": "photos"])
+                for i in 0..<4 {
+                    request.addMultipart(data: photo, withName: "photo\(i)", mimeType: "image/jpeg", filename: "photo\(i).jpg")
+                }
+                request.performRequest { (task, result) in
+                    let length = result.value.flatMap({ String(data: $0, encoding: .utf8) }).flatMap({ Int($0) }) ?? 0
+                    XCTAssertGreaterThan(length, photo.count * 4, "uploaded body length")
+                    group.leave()
+                }
+            }
+            XCTAssert(group.wait(timeout: .now() + 10) == .success, "timeout waiting for requests")
+        }
+    }
+    
+    func testJSONParseLatency() {
+        // Covers parse handler dispatch for a typical list response.
+        let items = (0..<500).map({ i -> JSON in
+            ["id": JSON(Int64(i)), "name": JSON("item \(i)"), "price": 9.99, "tags": ["a", "b", "c"], "available": true]
+        })
+        HTTP.mockManager.addMock(for: "items", statusCode: 200, json: ["items": .array(JSONArray(items))], delay: 0)
+        measure {
+            let group = DispatchGroup()
+            for _ in 0..<20 {
+                group.enter()
+                HTTP.request(GET: "items").parseAsJSON(using: { (response, json) -> Int in
+                    return try json.getArray("items").count
+                }).performRequest { (task, result) in
+                    XCTAssertEqual(result.value, 500, "item count")
+                    group.leave()
+                }
+            }
+            XCTAssert(group.wait(timeout: .now() + 10) == .success, "timeout waiting for requests")
+        }
+    }
+}
+
+/// Counts heap allocations using `PMHTTPBenchmarkAllocationCounter`.
+private final class AllocationCounter {
+    /// Returns `nil` if allocations can't be counted.
+    init?() {
+        guard let counterClass = NSClassFromString("PMHTTPBenchmarkAllocationCounter") as? NSObject.Type else { return nil }
+        counter = counterClass.init()
+        // Make sure the hook can be installed before relying on it.
+        counter.setValue(true, forKey: "counting")
+        guard (counter.value(forKey: "counting") as? Bool) == true else { return nil }
+        counter.setValue(false, forKey: "counting")
+    }
+    
+    /// Returns the number of allocations made by every thread while `block` runs.
+    func count(during block: () -> Void) -> UInt64 {
+        counter.setValue(true, forKey: "counting")
+        block()
+        counter.setValue(false, forKey: "counting")
+        return (counter.value(forKey: "allocationCount") as? NSNumber)?.uint64Value ?? 0
+    }
+    
+    private let counter: NSObject
+}
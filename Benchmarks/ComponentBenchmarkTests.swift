@@ -0,0 +1,157 @@
+//
+//  ComponentBenchmarkTests.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import XCTest
+@testable import PMHTTP
+
+/// Benchmarks for the individual pieces of the request hot path, measured in isolation.
+///
+/// The correctness tests for each of these live with the regular tests in PMHTTPTests.
+final class ComponentBenchmarkTests: XCTestCase {
+    func testBuildHeadersPerformance() {
+        // Simulates building the headers for a typical request.
+        let fields = ["Accept", "Accept-Encoding", "Accept-Language", "Authorization", "Cache-Control",
+                      "Content-Type", "Content-Length", "User-Agent", "If-None-Match", "x-request-id",
+                      "X-Client-Version", "x-session-token", "Cookie", "Origin", "Referer"]
+        measure {
+            var count = 0
+            for _ in 0..<10_000 {
+                var headers = HTTPHeaders(minimumCapacity: fields.count)
+                for field in fields {
+                    headers[field] = "value"
+                }
+                count += headers.count
+            }
+            XCTAssertEqual(count, 10_000 * fields.count)
+        }
+    }
+    
+    func testCaseInsensitiveLookupPerformance() {
+        let keys = ["Content-Type", "content-type", "Cache-Control", "no-store", "max-age"].map(CaseInsensitiveASCIIString.init)
+        let set = Set(keys)
+        measure {
+            var found = 0
+            for _ in 0..<100_000 {
+                for key in keys where set.contains(key) {
+                    found += 1
+                }
+            }
+            XCTAssertEqual(found, 100_000 * keys.count)
+        }
+    }
+    
+    func testFormURLEncodingPerformance() {
+        // Simulates a batch of analytics events.
+        let queryItems = (0..<5000).map({ i in URLQueryItem(name: "events[\(i)][name]", value: "screen view \(i) / caf\u{E9}") })
+        measure {
+            for _ in 0..<10 {
+                XCTAssertFalse(FormURLEncoded.data(for: queryItems).isEmpty)
+            }
+        }
+    }
+    
+    func testMockLookupPerformance() {
+        // Simulates a large integration test suite.
+        let mockManager = HTTPMockManager()
+        for i in 0..<2000 {
+            mockManager.addMock(for: "api/v1/resource\(i % 100)/:id/item\(i)", statusCode: 200, text: "mock \(i)")
+        }
+        mockManager.addMock(for: "api/v1/fallback", statusCode: 200, text: "fallback")
+        let environment = HTTPManager.Environment(string: "http://example.com/")!
+        let requests = (0..<100).map({ i in URLRequest(url: URL(string: "http://example.com/api/v1/resource\(i)/\(i)/item\(i + 100 * (i % 20))")!) })
+            + [URLRequest(url: URL(string: "http://example.com/api/v1/fallback")!)]
+        measure {
+            for _ in 0..<10 {
+                for request in requests {
+                    XCTAssertNotNil(mockManager.mockForRequest(request, environment: environment))
+                }
+            }
+        }
+    }
+    
+    func testDateParsePerformance() {
+        let strings = dateStrings
+        measure {
+            for _ in 0..<1000 {
+                for string in strings {
+                    _ = HTTPManager.parsedDateHeader(from: string)
+                }
+            }
+        }
+    }
+    
+    func testDateFormatterParsePerformance() {
+        // The DateFormatter chain the parser replaced, for comparison with testDateParsePerformance.
+        let formatters = DateFormatters()
+        let strings = dateStrings
+        measure {
+            for _ in 0..<1000 {
+                for string in strings {
+                    _ = formatters.parse(string)
+                }
+            }
+        }
+    }
+    
+    func testMultipartBodyStreamThroughput() {
+        // Covers serializing and streaming a batch of photos without any networking. Reads copy
+        // whole serialized segments and continue across part boundaries, so the stream's
+        // handler runs once per read rather than once per part.
+        let photo = Data(repeating: 0xA5, count: 2 * 1024 * 1024)
+        let parts = (0..<8).map({ i in MultipartBodyPart.known(.init(.data(photo), name: "photo\(i)", mimeType: "image/jpeg", filename: "photo\(i).jpg")) })
+        let parameters = (0..<32).map({ i in URLQueryItem(name: "param\(i)", value: "value \(i)") })
+        var buffer = [UInt8](repeating: 0, count: 32 * 1024)
+        measure {
+            let stream = HTTPBody.createMultipartMixedStream("boundary", parameters: parameters, bodyParts: parts)
+            stream.open()
+            var total = 0
+            var count = 0
+            repeat {
+                count = stream.read(&buffer, maxLength: buffer.count)
+                total += max(count, 0)
+            } while count > 0
+            XCTAssertGreaterThan(total, photo.count * parts.count, "body length")
+        }
+    }
+    
+    func testBodyStreamReadWhileScheduling() {
+        // Measures reads contending with run loop bookkeeping from another thread.
+        let photo = Data(repeating: 0xA5, count: 2 * 1024 * 1024)
+        let parts = (0..<8).map({ i in MultipartBodyPart.known(.init(.data(photo), name: "photo\(i)", mimeType: "image/jpeg", filename: "photo\(i).jpg")) })
+        #if swift(>=4.2)
+        let mode = RunLoop.Mode.default
+        #else
+        let mode = RunLoopMode.defaultRunLoopMode
+        #endif
+        measure {
+            let stream = HTTPBody.createMultipartMixedStream("boundary", parameters: [], bodyParts: parts)
+            stream.open()
+            DispatchQueue.concurrentPerform(iterations: 2) { i in
+                if i == 0 {
+                    var buffer = [UInt8](repeating: 0, count: 4096)
+                    while stream.read(&buffer, maxLength: buffer.count) > 0 {}
+                } else {
+                    let runLoop = RunLoop.current
+                    for _ in 0..<10_000 {
+                        stream.schedule(in: runLoop, forMode: mode)
+                        stream.remove(from: runLoop, forMode: mode)
+                    }
+                }
+            }
+            stream.close()
+        }
+    }
+    
+    private let dateStrings = ["Sun, 06 Nov 1994 08:49:37 GMT", "Sunday, 06-Nov-94 08:49:37 GMT", "Sun Nov  6 08:49:37 1994", "bob's yer uncle"]
+}
@@ -0,0 +1,75 @@
+//
+//  PMHTTPBenchmarkAllocationCounter.m
+//  PMHTTPBenchmarks
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+#import <Foundation/Foundation.h>
+#import <dlfcn.h>
+#import <stdatomic.h>
+
+// The hook libmalloc calls for every allocation and deallocation when it's set. It's what
+// MallocStackLogging uses, and it's exported from libsystem_malloc but not declared in any public
+// header, so it's looked up at runtime.
+typedef void (PMHTTPMallocLogger)(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3, uintptr_t result, uint32_t numHotFramesToSkip);
+
+// MALLOC_LOG_TYPE_ALLOCATE from libmalloc. It's also set for reallocations.
+static const uint32_t kMallocLogTypeAllocate = 2;
+
+static atomic_ullong allocationCount;
+static PMHTTPMallocLogger *previousLogger;
+
+static void countAllocation(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3, uintptr_t result, uint32_t numHotFramesToSkip) {
+    if (type & kMallocLogTypeAllocate) {
+        atomic_fetch_add_explicit(&allocationCount, 1, memory_order_relaxed);
+    }
+    if (previousLogger) {
+        previousLogger(type, arg1, arg2, arg3, result, numHotFramesToSkip + 1);
+    }
+}
+
+/// Counts heap allocations made by every thread while `counting` is `YES`.
+///
+/// The benchmarks are written in Swift, which can't see this class without a bridging header, so
+/// they look it up with `NSClassFromString` and drive it with key-value coding. Only one counter
+/// can count at a time.
+@interface PMHTTPBenchmarkAllocationCounter : NSObject
+/// Setting this to `YES` resets `allocationCount`. It stays `NO` if the malloc hook isn't available.
+@property (nonatomic, getter=isCounting) BOOL counting;
+@property (nonatomic, readonly) unsigned long long allocationCount;
+@end
+
+@implementation PMHTTPBenchmarkAllocationCounter
+
+- (void)setCounting:(BOOL)counting {
+    if (counting == _counting) return;
+    PMHTTPMallocLogger **logger = (PMHTTPMallocLogger **)dlsym(RTLD_DEFAULT, "malloc_logger");
+    if (!logger) return;
+    if (counting) {
+        atomic_store(&allocationCount, 0);
+        previousLogger = *logger;
+        *logger = countAllocation;
+    } else {
+        *logger = previousLogger;
+        previousLogger = NULL;
+    }
+    _counting = counting;
+}
+
+- (unsigned long long)allocationCount {
+    return atomic_load(&allocationCount);
+}
+
+- (void)dealloc {
+    self.counting = NO;
+}
+
+@end
@@ -0,0 +1,57 @@
+//
+//  BodyCompression.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import Foundation
+import PMHTTP.Private
+
+/// The content coding used to compress the body of an upload request.
+///
+/// - SeeAlso: `HTTPManagerRequest.requestBodyCompression`.
+@objc public enum HTTPManagerRequestBodyCompression: Int, CustomStringConvertible {
+    /// The body is sent as-is.
+    case none = 0
+    /// The body is compressed with the `gzip` content coding.
+    case gzip = 1
+    /// The body is compressed with the `deflate` content coding, i.e. as a zlib stream.
+    case deflate = 2
+    
+    /// The value of the `Content-Encoding` header for the coding, or `nil` for `.none`.
+    public var contentEncoding: String? {
+        switch self {
+        case .none: return nil
+        case .gzip: return "gzip"
+        case .deflate: return "deflate"
+        }
+    }
+    
+    public var description: String {
+        return contentEncoding ?? "none"
+    }
+    
+    /// Returns `data` compressed with the coding, or `nil` if zlib failed.
+    internal func compress(_ data: Data) -> Data? {
+        switch self {
+        case .none: return data
+        case .gzip, .deflate: return _PMHTTPBodyCompression.compressData(data, gzip: self == .gzip)
+        }
+    }
+    
+    /// Returns a stream that compresses the contents of `stream` with the coding as it's read.
+    internal func compressingStream(_ stream: InputStream) -> InputStream {
+        switch self {
+        case .none: return stream
+        case .gzip, .deflate: return _PMHTTPBodyCompression.compressingStream(with: stream, gzip: self == .gzip)
+        }
+    }
+}
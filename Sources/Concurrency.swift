@@ -0,0 +1,151 @@
+//
+//  Concurrency.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import Foundation
+
+#if swift(>=4.1.9) // Swift 4.2+ compiler, required for compiler()
+#if compiler(>=5.5)
+
+@available(iOS 13, macOS 10.15, tvOS 13, watchOS 6, *)
+extension HTTPManagerRequestPerformable {
+    /// Performs the request and returns the resulting value.
+    ///
+    /// The result is delivered straight from the task's completion path, without first hopping to
+    /// a completion queue. If the current `Task` is canceled, the underlying `HTTPManagerTask` is
+    /// canceled as well.
+    ///
+    /// - Returns: The value produced by the request.
+    /// - Throws: The error the request failed with, or `CancellationError` if the request was
+    ///   canceled, either because the current `Task` was canceled or because the
+    ///   `HTTPManagerTask` was canceled some other way.
+    public func performRequest() async throws -> ResultValue {
+        return try await performRequestWithResponse().value
+    }
+    
+    /// Performs the request and returns the resulting value along with the response.
+    ///
+    /// The result is delivered straight from the task's completion path, without first hopping to
+    /// a completion queue. If the current `Task` is canceled, the underlying `HTTPManagerTask` is
+    /// canceled as well.
+    ///
+    /// - Returns: The response and the value produced by the request.
+    /// - Throws: The error the request failed with, or `CancellationError` if the request was
+    ///   canceled, either because the current `Task` was canceled or because the
+    ///   `HTTPManagerTask` was canceled some other way.
+    public func performRequestWithResponse() async throws -> (response: URLResponse, value: ResultValue) {
+        try Task.checkCancellation()
+        let cancellation = AsyncTaskCancellation()
+        return try await withCancellation(of: cancellation) {
+            try await withCheckedThrowingContinuation { (continuation: CheckedContinuation<(response: URLResponse, value: ResultValue), Error>) in
+                let task = createTask(withCompletionQueue: nil) { (_, result) in
+                    switch result {
+                    case let .success(response, value):
+                        continuation.resume(returning: (response, value))
+                    case let .error(_, error):
+                        continuation.resume(throwing: error)
+                    case .canceled:
+                        continuation.resume(throwing: CancellationError())
+                    }
+                }
+                cancellation.setTask(task)
+                task.resume()
+            }
+        }
+    }
+}
+
+@available(iOS 13, macOS 10.15, tvOS 13, watchOS 6, *)
+extension Sequence where Element: HTTPManagerRequestPerformable {
+    /// Performs every request concurrently in a task group and returns their values.
+    ///
+    /// If any request fails, the remaining requests are canceled and the error is rethrown.
+    ///
+    /// - Returns: The values produced by the requests, in the same order as the requests.
+    /// - Throws: The first error any of the requests failed with.
+    public func performRequests() async throws -> [Element.ResultValue] {
+        // Neither the requests nor their values are required to be Sendable. Each request is only
+        // used by the child task it's handed to, and each value is only handed back once, so they're
+        // boxed to cross into and out of the group.
+        return try await withThrowingTaskGroup(of: (Int, UncheckedSendableBox<Element.ResultValue>).self) { group in
+            var count = 0
+            for (i, request) in enumerated() {
+                let request = UncheckedSendableBox(request)
+                group.addTask {
+                    return (i, UncheckedSendableBox(try await request.value.performRequest()))
+                }
+                count += 1
+            }
+            var values = [Element.ResultValue?](repeating: nil, count: count)
+            do {
+                for try await (i, value) in group {
+                    values[i] = value.value
+                }
+            } catch {
+                group.cancelAll()
+                throw error
+            }
+            return values.map({ $0! })
+        }
+    }
+}
+
+/// Transfers a value that isn't `Sendable` between tasks. Only use this when the value is no longer
+/// used by the task that sends it.
+private struct UncheckedSendableBox<T>: @unchecked Sendable {
+    let value: T
+    
+    init(_ value: T) {
+        self.value = value
+    }
+}
+
+/// Records the `HTTPManagerTask` for an `async` request so it can be canceled when the enclosing
+/// `Task` is, even if cancellation happens before the task has been created.
+///
+/// **Thread safety:** All methods in this class are safe to call from any thread.
+private final class AsyncTaskCancellation: @unchecked Sendable {
+    func setTask(_ task: HTTPManagerTask) {
+        lock.lock()
+        self.task = task
+        let isCanceled = self.isCanceled
+        lock.unlock()
+        if isCanceled {
+            task.cancel()
+        }
+    }
+    
+    func cancel() {
+        lock.lock()
+        isCanceled = true
+        let task = self.task
+        lock.unlock()
+        task?.cancel()
+    }
+    
+    private let lock = NSLock()
+    private var task: HTTPManagerTask?
+    private var isCanceled = false
+}
+
+@available(iOS 13, macOS 10.15, tvOS 13, watchOS 6, *)
+private func withCancellation<T>(of cancellation: AsyncTaskCancellation, operation: () async throws -> T) async rethrows -> T {
+    #if compiler(>=5.6)
+    return try await withTaskCancellationHandler(operation: operation, onCancel: { cancellation.cancel() })
+    #else
+    return try await withTaskCancellationHandler(handler: { cancellation.cancel() }, operation: operation)
+    #endif
+}
+
+#endif
+#endif
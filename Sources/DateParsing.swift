@@ -41,50 +41,186 @@ public extension HTTPManager {
     /// - Returns: An `NSDate`, or `nil` if `dateString` contains an invalid format.
     @objc(parsedDateHeaderFromString:)
     static func parsedDateHeader(from dateString: String) -> Date? {
-        return rfc1123DateFormatter.date(from: dateString)
-            ?? rfc850DateFormatter.date(from: dateString)
-            ?? asctimeDateFormatter.date(from: dateString)
+        return HTTPDateParser.parse(dateString)
     }
+}
+
+/// A parser for the three formats allowed by the `HTTP-date` production.
+///
+/// Unlike `DateFormatter`, which costs a full ICU parse attempt for each format that doesn't match
+/// and contends on internal locks when used from many threads, this makes a single pass over the
+/// UTF-8 bytes without allocating. The format is determined by the punctuation following the day of
+/// the week:
+///
+/// ```
+/// Sun, 06 Nov 1994 08:49:37 GMT  ; RFC 1123
+/// Sunday, 06-Nov-94 08:49:37 GMT ; RFC 850
+/// Sun Nov  6 08:49:37 1994       ; asctime
+/// ```
+///
+/// Names are matched case-insensitively, and either the abbreviated or the full name of the day of
+/// the week is accepted in any format. The day of the week isn't checked against the date.
+private struct HTTPDateParser {
+    static func parse(_ string: String) -> Date? {
+        // The longest valid date is 33 bytes, so anything that doesn't fit here is invalid.
+        var storage: (UInt64, UInt64, UInt64, UInt64, UInt64) = (0, 0, 0, 0, 0)
+        return withUnsafeMutableBytes(of: &storage) { buffer -> Date? in
+            var count = 0
+            for c in string.utf8 {
+                guard count < buffer.count else { return nil }
+                buffer[count] = c
+                count += 1
+            }
+            var parser = HTTPDateParser(bytes: UnsafeRawBufferPointer(start: buffer.baseAddress, count: count))
+            return parser.parseDate()
+        }
+    }
+    
+    private let bytes: UnsafeRawBufferPointer
+    private var index = 0
+    
+    private init(bytes: UnsafeRawBufferPointer) {
+        self.bytes = bytes
+    }
+    
+    private mutating func parseDate() -> Date? {
+        guard let weekday = scanWord(), HTTPDateParser.weekdays.contains(weekday) else { return nil }
+        let year, month, day, time: Int
+        if scan(","), scan(" ") {
+            guard let dayValue = scanNumber(minDigits: 2, maxDigits: 2) else { return nil }
+            day = dayValue
+            if scan(" ") {
+                // RFC 1123: dd MMM yyyy
+                guard let monthValue = scanMonth(), scan(" "), let yearValue = scanNumber(minDigits: 4, maxDigits: 4) else { return nil }
+                month = monthValue
+                year = yearValue
+            } else if scan("-") {
+                // RFC 850: dd-MMM-yy
+                guard let monthValue = scanMonth(), scan("-"), let yearValue = scanNumber(minDigits: 2, maxDigits: 2) else { return nil }
+                month = monthValue
+                year = HTTPDateParser.expandTwoDigitYear(yearValue)
+            } else {
+                return nil
+            }
+            guard scan(" "), let timeValue = scanTime(), scan(" "), scanWord() == HTTPDateParser.gmt else { return nil }
+            time = timeValue
+        } else if scan(" ") {
+            // asctime: MMM ( 2DIGIT | SP 1DIGIT ) HH:mm:ss yyyy
+            guard let monthValue = scanMonth(), scan(" ") else { return nil }
+            _ = scan(" ")
+            guard let dayValue = scanNumber(minDigits: 1, maxDigits: 2), scan(" "),
+                let timeValue = scanTime(), scan(" "),
+                let yearValue = scanNumber(minDigits: 4, maxDigits: 4)
+                else { return nil }
+            month = monthValue
+            day = dayValue
+            time = timeValue
+            year = yearValue
+        } else {
+            return nil
+        }
+        guard index == bytes.count, day >= 1, day <= HTTPDateParser.daysInMonth(month, year: year) else { return nil }
+        let days = HTTPDateParser.daysSinceEpoch(year: year, month: month, day: day)
+        return Date(timeIntervalSince1970: TimeInterval(days * 86400 + time))
+    }
+    
+    /// Scans `HH:mm:ss` and returns the number of seconds since midnight.
+    private mutating func scanTime() -> Int? {
+        guard let hour = scanNumber(minDigits: 2, maxDigits: 2), hour <= 23, scan(":"),
+            let minute = scanNumber(minDigits: 2, maxDigits: 2), minute <= 59, scan(":"),
+            let second = scanNumber(minDigits: 2, maxDigits: 2), second <= 60 // allow leap seconds
+            else { return nil }
+        return hour * 3600 + minute * 60 + second
+    }
+    
+    /// Scans a 3-letter month name and returns its number, starting at 1.
+    private mutating func scanMonth() -> Int? {
+        guard let word = scanWord(), let idx = HTTPDateParser.months.index(of: word) else { return nil }
+        return idx + 1
+    }
+    
+    private mutating func scan(_ c: UnicodeScalar) -> Bool {
+        guard index < bytes.count, bytes[index] == UInt8(c.value) else { return false }
+        index += 1
+        return true
+    }
+    
+    private mutating func scanNumber(minDigits: Int, maxDigits: Int) -> Int? {
+        var value = 0
+        var count = 0
+        while count < maxDigits && index < bytes.count {
+            let digit = bytes[index] &- 0x30
+            guard digit < 10 else { break }
+            value = value * 10 + Int(digit)
+            count += 1
+            index += 1
+        }
+        return count >= minDigits ? value : nil
+    }
+    
+    /// Scans a run of ASCII letters and returns them packed by `HTTPDateParser.pack(_:)`.
+    private mutating func scanWord() -> UInt64? {
+        var packed: UInt64 = 0
+        var count = 0
+        while index < bytes.count {
+            let c = bytes[index] | 0x20 // ASCII lowercase
+            guard c >= 0x61 && c <= 0x7a else { break } // a-z
+            count += 1
+            // No name we accept is longer than 9 letters.
+            guard count <= 9 else { return nil }
+            packed = packed << 5 | UInt64(c - 0x60)
+            index += 1
+        }
+        return count > 0 ? packed : nil
+    }
+    
+    /// Packs a lowercase ASCII word into an integer using 5 bits per letter.
+    private static func pack(_ word: String) -> UInt64 {
+        return word.utf8.reduce(0, { $0 << 5 | UInt64($1 - 0x60) })
+    }
+    
+    private static let weekdays: [UInt64] = ["mon", "tue", "wed", "thu", "fri", "sat", "sun",
+                                             "monday", "tuesday", "wednesday", "thursday", "friday", "saturday", "sunday"].map(HTTPDateParser.pack)
+    private static let months: [UInt64] = ["jan", "feb", "mar", "apr", "may", "jun", "jul", "aug", "sep", "oct", "nov", "dec"].map(HTTPDateParser.pack)
+    private static let gmt: UInt64 = pack("gmt")
     
-    private static let posixLocale = Locale(identifier: "en_US_POSIX")
-    private static let gregorianCalendar: Calendar = {
+    /// The first year of the century that two-digit years are interpreted in.
+    ///
+    /// From RFC 2616 Section 19.3 Tolerant Applications:
+    /// > HTTP/1.1 clients and caches SHOULD assume that an RFC-850 date
+    /// > which appears to be more than 50 years in the future is in fact
+    /// > in the past (this helps solve the "year 2000" problem).
+    private static let twoDigitStartYear: Int = {
         var calendar = Calendar(identifier: .gregorian)
         calendar.timeZone = TimeZone(secondsFromGMT: 0)!
-        return calendar
-    }()
-    private static let rfc1123DateFormatter: DateFormatter = {
-        let formatter = DateFormatter()
-        formatter.locale = posixLocale
-        formatter.calendar = gregorianCalendar
-        formatter.timeZone = gregorianCalendar.timeZone
-        formatter.dateFormat = "EEE',' dd MMM yyyy HH':'mm':'ss 'GMT'"
-        formatter.isLenient = false
-        return formatter
-    }()
-    private static let rfc850DateFormatter: DateFormatter = {
-        let formatter = DateFormatter()
-        formatter.locale = posixLocale
-        formatter.calendar = gregorianCalendar
-        formatter.timeZone = gregorianCalendar.timeZone
-        formatter.dateFormat = "EEEE',' dd'-'MMM'-'yy HH':'mm':'ss 'GMT'"
-        formatter.isLenient = false
-        // From RFC 2616 Section 19.3 Tolerant Applications:
-        // > HTTP/1.1 clients and caches SHOULD assume that an RFC-850 date
-        // > which appears to be more than 50 years in the future is in fact
-        // > in the past (this helps solve the "year 2000" problem).
-        formatter.twoDigitStartDate = gregorianCalendar.date(byAdding: DateComponents(year: -49), to: Date())
-        return formatter
-    }()
-    private static let asctimeDateFormatter: DateFormatter = {
-        let formatter = DateFormatter()
-        formatter.locale = posixLocale
-        formatter.calendar = gregorianCalendar
-        formatter.timeZone = gregorianCalendar.timeZone
-        // NB: asctime specifies day as ( 2DIGIT | ( SP 1DIGIT ) ). There's no way to represent this with a
-        // date format, ICU seems to treat stretches of consecutive whitespace all as a single space, so this should
-        // still parse just fine. Luckily we don't have to generate these strings.
-        formatter.dateFormat = "EEE MMM dd HH':'mm':'ss yyyy"
-        formatter.isLenient = false
-        return formatter
+        return calendar.component(.year, from: Date()) - 49
     }()
+    
+    private static func expandTwoDigitYear(_ year: Int) -> Int {
+        return twoDigitStartYear + (year - twoDigitStartYear % 100 + 100) % 100
+    }
+    
+    private static func daysInMonth(_ month: Int, year: Int) -> Int {
+        switch month {
+        case 2:
+            let isLeapYear = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0)
+            return isLeapYear ? 29 : 28
+        case 4, 6, 9, 11:
+            return 30
+        default:
+            return 31
+        }
+    }
+    
+    /// Returns the number of days between 1970-01-01 and the given date in the proleptic Gregorian
+    /// calendar.
+    private static func daysSinceEpoch(year: Int, month: Int, day: Int) -> Int {
+        // Count from March 1st so the leap day falls at the end of the year.
+        let y = month <= 2 ? year - 1 : year
+        let era = (y >= 0 ? y : y - 399) / 400
+        let yearOfEra = y - era * 400
+        let dayOfYear = (153 * ((month + 9) % 12) + 2) / 5 + day - 1
+        let dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear
+        return era * 146097 + dayOfEra - 719468
+    }
 }
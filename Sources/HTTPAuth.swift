@@ -230,8 +230,48 @@ open class HTTPRefreshableAuth: NSObject, HTTPAuth {
     ///   be invoked from any thread, including being invoked synchronously from
     ///   `authenticationRefreshBlock`.
     public init<T>(info: T, authenticationHeadersBlock: @escaping (_ request: URLRequest, _ info: T) -> [String: String], authenticationRefreshBlock: @escaping (_ response: HTTPURLResponse, _ body: Data, _ info: T, _ completion: @escaping (_ info: T?, _ retry: Bool) -> Void) -> HTTPManagerTask?) {
+        self.authenticationHeadersBlock = { authenticationHeadersBlock($0, $1 as! T) }
+        // Without an expirationDateBlock there are no proactive refreshes, so the response and body
+        // are always present.
+        self.authenticationRefreshBlock = { authenticationRefreshBlock($0!, $1!, $2 as! T, $3) }
+        self.expirationDateBlock = nil
+        self.inner = QueueConfined(label: "HTTPRefreshableAuth private queue", value: Inner(info: info))
+        super.init()
+    }
+    
+    /// Returns a new `HTTPRefreshableAuth` that refreshes its authentication information shortly
+    /// before it expires.
+    ///
+    /// When a request's headers are computed less than `proactiveRefreshInterval` seconds before
+    /// the expiration date returned by `expirationDateBlock`, a refresh is started in the
+    /// background. The request itself still uses the current authentication information. Any
+    /// requests that receive a 401 Unauthorized response while the refresh is outstanding wait for
+    /// it and are then retried with the new info, exactly as they would for a refresh triggered by
+    /// a 401. Each `info` value is only refreshed proactively once, so a failed proactive refresh
+    /// isn't retried until a request fails.
+    ///
+    /// Requests created once the expiration date has passed don't use the expired info. Their
+    /// network tasks aren't created until the refresh finishes, and then use the refreshed info.
+    /// If the info has already been refreshed proactively and the refresh failed, requests go
+    /// out with the expired info and are handled like any other 401 Unauthorized response.
+    ///
+    /// - Parameter info: A value that is used to calculate authentication headers and refresh
+    ///   authentication information. This parameter may have any type, as long as it's thread-safe.
+    /// - Parameter authenticationHeadersBlock: A block that is used to return the authentication
+    ///   headers for a request. The `info` parameter is provided to this block.
+    ///
+    ///   This block may be called from any thread.
+    /// - Parameter expirationDateBlock: A block that returns the date at which the authentication
+    ///   information expires, or `nil` if it's not known. This block may be called from any thread.
+    /// - Parameter authenticationRefreshBlock: A block that is invoked in order to refresh the
+    ///   authentication information. The `response` and `body` parameters are the 401 Unauthorized
+    ///   response that triggered the refresh, or `nil` if the refresh was started because the info
+    ///   is about to expire. Otherwise this block behaves the same as the `authenticationRefreshBlock`
+    ///   of `init(info:authenticationHeadersBlock:authenticationRefreshBlock:)`.
+    @nonobjc public init<T>(info: T, authenticationHeadersBlock: @escaping (_ request: URLRequest, _ info: T) -> [String: String], expirationDateBlock: @escaping (_ info: T) -> Date?, authenticationRefreshBlock: @escaping (_ response: HTTPURLResponse?, _ body: Data?, _ info: T, _ completion: @escaping (_ info: T?, _ retry: Bool) -> Void) -> HTTPManagerTask?) {
         self.authenticationHeadersBlock = { authenticationHeadersBlock($0, $1 as! T) }
         self.authenticationRefreshBlock = { authenticationRefreshBlock($0, $1, $2 as! T, $3) }
+        self.expirationDateBlock = { expirationDateBlock($0 as! T) }
         self.inner = QueueConfined(label: "HTTPRefreshableAuth private queue", value: Inner(info: info))
         super.init()
     }
@@ -267,8 +307,46 @@ open class HTTPRefreshableAuth: NSObject, HTTPAuth {
         self.init(info: info, authenticationHeadersBlock: authenticationHeadersBlock, authenticationRefreshBlock: authenticationRefreshBlock)
     }
     
+    /// Returns a new `HTTPRefreshableAuth` that refreshes its authentication information shortly
+    /// before it expires.
+    ///
+    /// See `init(info:authenticationHeadersBlock:expirationDateBlock:authenticationRefreshBlock:)`
+    /// for details.
+    @objc(initWithInfo:authenticationHeadersBlock:expirationDateBlock:authenticationRefreshBlock:)
+    public convenience init(__info info: Any, authenticationHeadersBlock: @escaping (_ request: URLRequest, _ info: Any) -> [String: String], expirationDateBlock: @escaping (_ info: Any) -> Date?, authenticationRefreshBlock: @escaping (_ response: HTTPURLResponse?, _ body: Data?, _ info: Any, _ completion: @escaping (_ info: Any?, _ retry: Bool) -> Void) -> HTTPManagerTask?) {
+        self.init(info: info, authenticationHeadersBlock: authenticationHeadersBlock, expirationDateBlock: expirationDateBlock, authenticationRefreshBlock: authenticationRefreshBlock)
+    }
+    
+    /// How long before the authentication information expires that a refresh is started.
+    ///
+    /// This only has an effect if the instance was created with an `expirationDateBlock`. The
+    /// default value is 60 seconds.
+    @objc public var proactiveRefreshInterval: TimeInterval {
+        get {
+            return inner.sync({ $0.proactiveRefreshInterval })
+        }
+        set {
+            inner.asyncBarrier({ $0.proactiveRefreshInterval = newValue })
+        }
+    }
+    
     @objc public final func headers(for request: URLRequest) -> [String: String] {
-        let info = inner.sync({ $0.info })
+        guard let expirationDateBlock = expirationDateBlock else {
+            let info = inner.sync({ $0.info })
+            return authenticationHeadersBlock(request, info)
+        }
+        let (info, token, interval, canRefresh) = inner.sync({ inner in
+            (inner.info, inner.currentToken, inner.proactiveRefreshInterval,
+             inner.refreshToken == nil && inner.proactivelyRefreshedToken !== inner.currentToken)
+        })
+        if canRefresh, let expirationDate = expirationDateBlock(info), expirationDate.timeIntervalSinceNow < interval {
+            inner.asyncBarrier { [weak self] inner in
+                // Recheck now that we're on the barrier, as another request may have beaten us here.
+                guard let this = self, inner.currentToken === token, inner.proactivelyRefreshedToken !== token, inner.refreshToken == nil else { return }
+                inner.proactivelyRefreshedToken = token
+                this.startRefresh(inner, response: nil, body: nil)
+            }
+        }
         return authenticationHeadersBlock(request, info)
     }
     
@@ -276,6 +354,39 @@ open class HTTPRefreshableAuth: NSObject, HTTPAuth {
         return inner.sync({ $0.currentToken })
     }
     
+    /// Starts a refresh if the authentication information has already expired and it hasn't been
+    /// refreshed proactively yet.
+    ///
+    /// - Returns: `true` if a refresh of the expired information is outstanding. Requests should
+    ///   then wait for `notifyWhenRefreshed(_:)` before computing their headers.
+    internal final func refreshIfExpired() -> Bool {
+        guard let expirationDateBlock = expirationDateBlock else { return false }
+        let (info, token) = inner.sync({ ($0.info, $0.currentToken) })
+        guard let expirationDate = expirationDateBlock(info), expirationDate.timeIntervalSinceNow <= 0 else { return false }
+        return inner.syncBarrier { inner -> Bool in
+            // If the token changed, it was refreshed while we were checking the expiration date.
+            guard inner.currentToken === token else { return false }
+            if inner.refreshToken == nil {
+                guard inner.proactivelyRefreshedToken !== token else { return false }
+                inner.proactivelyRefreshedToken = token
+                startRefresh(inner, response: nil, body: nil)
+            }
+            return true
+        }
+    }
+    
+    /// Invokes `completion` on a background queue once the outstanding refresh finishes, whether
+    /// or not it succeeds, or right away if there is no outstanding refresh.
+    internal final func notifyWhenRefreshed(_ completion: @escaping () -> Void) {
+        inner.asyncBarrier { inner in
+            if inner.refreshToken == nil {
+                DispatchQueue.global(qos: .userInitiated).async(execute: completion)
+            } else {
+                inner.completions.append({ _ in completion() })
+            }
+        }
+    }
+    
     /// Invoked when a 401 Unauthorized response is received.
     ///
     /// The default implementation refreshes the authentication information if necessary. If you
@@ -299,46 +410,57 @@ open class HTTPRefreshableAuth: NSObject, HTTPAuth {
             
             inner.completions.append(completion)
             guard inner.refreshToken === nil else { return }
-            let refreshToken = Inner.Token()
-            inner.refreshToken = refreshToken
-            let info = inner.info
-            queue.async {
-                guard let this = self else { return }
-                let task = HTTPManager.withoutDefaultAuth(this) {
-                    return this.authenticationRefreshBlock(response, body, info, { (info, retry) in
-                        guard let this = self else { return }
-                        this.inner.asyncBarrier { [selfType=type(of: this)] inner in
-                            guard inner.refreshToken === refreshToken else {
-                                NSLog("[HTTPManager] HTTPRefreshableAuth authenticationRefreshBlock invoked multiple times (\(selfType))")
-                                assertionFailure("HTTPRefreshableAuth authenticationRefreshBlock invoked multiple times")
-                                return
-                            }
-                            inner.refreshToken = nil
-                            inner.task = nil
-                            if let info = info {
-                                inner.info = info
-                                inner.currentToken = Inner.Token()
-                            }
-                            let completions = inner.completions
-                            inner.completions = []
-                            queue.async {
-                                DispatchQueue.concurrentPerform(iterations: completions.count, execute: { i in
-                                    completions[i](retry)
-                                })
-                            }
+            self?.startRefresh(inner, response: response, body: body)
+        }
+    }
+    
+    /// Starts a refresh. Every completion in `inner.completions` at the time the refresh finishes
+    /// is invoked with its results.
+    ///
+    /// - Important: This must be called from a barrier block on `inner`, and only when no refresh
+    ///   is outstanding.
+    private func startRefresh(_ inner: Inner, response: HTTPURLResponse?, body: Data?) {
+        let refreshToken = Inner.Token()
+        inner.refreshToken = refreshToken
+        let info = inner.info
+        let queue = DispatchQueue.global(qos: .userInitiated)
+        queue.async { [weak self] in
+            guard let this = self else { return }
+            let task = HTTPManager.withoutDefaultAuth(this) {
+                return this.authenticationRefreshBlock(response, body, info, { (info, retry) in
+                    guard let this = self else { return }
+                    this.inner.asyncBarrier { [selfType=type(of: this)] inner in
+                        guard inner.refreshToken === refreshToken else {
+                            NSLog("[HTTPManager] HTTPRefreshableAuth authenticationRefreshBlock invoked multiple times (\(selfType))")
+                            assertionFailure("HTTPRefreshableAuth authenticationRefreshBlock invoked multiple times")
+                            return
                         }
-                    })
-                }
-                this.inner.asyncBarrier { inner in
-                    guard inner.refreshToken === refreshToken else { return }
-                    inner.task = task
-                }
+                        inner.refreshToken = nil
+                        inner.task = nil
+                        if let info = info {
+                            inner.info = info
+                            inner.currentToken = Inner.Token()
+                        }
+                        let completions = inner.completions
+                        inner.completions = []
+                        queue.async {
+                            DispatchQueue.concurrentPerform(iterations: completions.count, execute: { i in
+                                completions[i](retry)
+                            })
+                        }
+                    }
+                })
+            }
+            this.inner.asyncBarrier { inner in
+                guard inner.refreshToken === refreshToken else { return }
+                inner.task = task
             }
         }
     }
     
     private let authenticationHeadersBlock: (_ request: URLRequest, _ info: Any) -> [String: String]
-    private let authenticationRefreshBlock: (_ response: HTTPURLResponse, _ body: Data, _ info: Any, _ completion: @escaping (_ info: Any?, _ retry: Bool) -> Void) -> HTTPManagerTask?
+    private let authenticationRefreshBlock: (_ response: HTTPURLResponse?, _ body: Data?, _ info: Any, _ completion: @escaping (_ info: Any?, _ retry: Bool) -> Void) -> HTTPManagerTask?
+    private let expirationDateBlock: ((_ info: Any) -> Date?)?
     private let inner: QueueConfined<Inner>
     
     private class Inner {
@@ -357,6 +479,9 @@ open class HTTPRefreshableAuth: NSObject, HTTPAuth {
         var refreshToken: Token?
         var task: HTTPManagerTask?
         var completions: [(Bool) -> Void] = []
+        var proactiveRefreshInterval: TimeInterval = 60
+        /// The `currentToken` that a proactive refresh was last started for.
+        var proactivelyRefreshedToken: Token?
         
         
         deinit {
@@ -21,178 +21,66 @@ internal final class HTTPBody {
     /// - Note: Any `.pending` body part must be evaluated before calling this
     ///   method, and should be waited on to guarantee the value is ready.
     class func createMultipartMixedStream(_ boundary: String, parameters: [URLQueryItem], bodyParts: [MultipartBodyPart]) -> InputStream {
-        let body = HTTPBody(boundary: boundary, parameters: parameters, bodyParts: bodyParts)
+        return createMultipartMixedStream(SerializedMultipartBody(boundary: boundary, parameters: parameters, bodyParts: bodyParts))
+    }
+    
+    /// Returns an `NSInputStream` that produces a previously-serialized multipart/mixed HTTP body.
+    class func createMultipartMixedStream(_ serializedBody: SerializedMultipartBody) -> InputStream {
+        let body = HTTPBody(segments: serializedBody.segments)
         return _PMHTTPManagerBodyStream(handler: { (buffer, maxLength) -> Int in
             return body.readIntoBuffer(buffer, maxLength)
+        }, bufferHandler: { (buffer, length) -> Bool in
+            return body.getBuffer(buffer, length)
         })
     }
     
-    private let boundary: String
-    private var queryItemGenerator: Array<URLQueryItem>.Iterator?
-    private var bodyPartGenerator: Array<MultipartBodyPart>.Iterator
-    private var deferredPartGenerator: Array<MultipartBodyPart.Data>.Iterator?
-    private var state: State = .initial
-    
-    private enum State {
-        case initial
-        /// Header includes the boundary and all header fields and the empty line
-        /// terminator. The body part data should be able to be concatenated on the
-        /// header in order to form a complete valid body part.
-        case header(Substring.UTF8View, Content)
-        case data(Content)
-        case terminator(Substring.UTF8View)
-        case eof
-    }
-    
-    private enum Content {
-        case data(Data, offset: Int)
-        case text(Substring.UTF8View)
-    }
+    private let segments: [Data]
+    /// The index of the segment currently being read.
+    private var index = 0
+    /// The offset of the next byte to read within the current segment.
+    private var offset = 0
+    /// The storage most recently lent out by `getBuffer(_:_:)`, which must stay alive until the
+    /// next stream operation.
+    private var lentStorage: NSData?
     
-    private init(boundary: String, parameters: [URLQueryItem], bodyParts: [MultipartBodyPart]) {
-        self.boundary = boundary
-        queryItemGenerator = parameters.makeIterator()
-        bodyPartGenerator = bodyParts.makeIterator()
-        advanceState()
+    private init(segments: [Data]) {
+        self.segments = segments
     }
     
+    /// Fills as much of the buffer as possible, continuing across as many segments as necessary.
     private func readIntoBuffer(_ bufferPtr: UnsafeMutablePointer<UInt8>, _ bufferLength: Int) -> Int {
+        lentStorage = nil
         var buffer = UnsafeMutableBufferPointer(start: bufferPtr, count: bufferLength)
-        func copyUTF8(_ buffer: inout UnsafeMutableBufferPointer<UInt8>, utf8: Substring.UTF8View) -> Substring.UTF8View.Index? {
-            var count = 0
-            var ptr = buffer.baseAddress!
-            defer { buffer = UnsafeMutableBufferPointer(start: ptr, count: buffer.count - count) }
-            for idx in utf8.indices {
-                if count == buffer.count {
-                    return idx
-                }
-                ptr.initialize(to: utf8[idx])
-                ptr += 1
-                count += 1
-            }
-            return nil
-        }
-        loop: while !buffer.isEmpty {
-            switch state {
-            case let .header(utf8, content):
-                if let idx = copyUTF8(&buffer, utf8: utf8) {
-                    state = .header(utf8.suffix(from: idx), content)
-                } else {
-                    advanceState()
-                }
-            case let .data(.data(data, offset)):
-                let count = min(buffer.count, data.count - offset)
-                guard count > 0 else {
-                    // we shouldn't hit this
-                    break loop
-                }
-                let end = offset + count
-                data.copyBytes(to: buffer.baseAddress!, from: offset..<end)
-                buffer = UnsafeMutableBufferPointer(start: buffer.baseAddress! + count, count: buffer.count - count)
-                if end >= data.count {
-                    advanceState()
-                } else {
-                    state = .data(.data(data, offset: end))
-                }
-            case .data(.text(let utf8)):
-                if let idx = copyUTF8(&buffer, utf8: utf8) {
-                    state = .data(.text(utf8.suffix(from: idx)))
-                } else {
-                    advanceState()
-                }
-            case .terminator(let utf8):
-                if let idx = copyUTF8(&buffer, utf8: utf8) {
-                    state = .terminator(utf8.suffix(from: idx))
-                } else {
-                    advanceState()
-                }
-            case .eof:
-                break loop
-            case .initial:
-                fatalError("HTTPManager internal error: unreachable state .Initial in streamRead()")
+        while !buffer.isEmpty && index < segments.count {
+            let segment = segments[index]
+            let count = min(buffer.count, segment.count - offset)
+            let start = segment.startIndex + offset
+            segment.copyBytes(to: buffer.baseAddress!, from: start..<(start + count))
+            buffer = UnsafeMutableBufferPointer(start: buffer.baseAddress! + count, count: buffer.count - count)
+            offset += count
+            if offset == segment.count {
+                index += 1
+                offset = 0
             }
         }
         return buffer.baseAddress! - bufferPtr
     }
     
-    /// Sets `state` to the appropriate state for the next part.
-    /// Once the `state` hits `.eof` it stays there.
-    private func advanceState() {
-        switch state {
-        case .header(_, let content):
-            state = .data(content)
-            // Make sure the content isn't empty. If it is, advance again.
-            switch content {
-            case let .data(data, offset) where data.count <= offset: return advanceState()
-            case .text(let utf8) where utf8.isEmpty: return advanceState()
-            default: break
-            }
-        case .initial, .data:
-            let prefix: String
-            if case .initial = state {
-                prefix = "" // no CRLF before the first boundary
-            } else {
-                prefix = "\r\n"
-            }
-            if let queryItem = queryItemGenerator?.next() {
-                // Parameters are always text/plain.
-                // We could probably get away with not specifying Content-Type and allowing the server to infer it,
-                // since it should normally infer it as UTF-8, but it's safer to be explicit.
-                let header = prefix
-                    + "--\(boundary)\r\n"
-                    + "Content-Disposition: form-data; name=\"\(quotedString(queryItem.name))\"\r\n"
-                    + "Content-Type: text/plain; charset=utf-8\r\n"
-                    + "\r\n"
-                state = .header(Substring(header).utf8, .text(Substring(queryItem.value ?? "").utf8))
-            } else {
-                queryItemGenerator = nil
-                loop: while true {
-                    let data: MultipartBodyPart.Data
-                    if let data_ = deferredPartGenerator?.next() {
-                        data = data_
-                    } else {
-                        deferredPartGenerator = nil
-                        switch bodyPartGenerator.next() {
-                        case .known(let data_)?:
-                            data = data_
-                        case .pending(let deferred)?:
-                            var gen = deferred.wait().makeIterator()
-                            if let data_ = gen.next() {
-                                data = data_
-                                deferredPartGenerator = gen
-                            } else {
-                                continue loop
-                            }
-                        case nil:
-                            state = .terminator(Substring("\(prefix)--\(boundary)--\r\n").utf8)
-                            break loop
-                        }
-                    }
-                    let filename = data.filename.map({ "; filename=\"\(quotedString($0))\"" }) ?? ""
-                    let mimeType: String
-                    let content: Content
-                    switch data.content {
-                    case .data(let data_):
-                        content = .data(data_, offset: 0)
-                        mimeType = data.mimeType ?? "application/octet-stream"
-                    case .text(let text):
-                        content = .text(Substring(text).utf8)
-                        mimeType = data.mimeType ?? "text/plain; charset=utf-8"
-                    }
-                    let header = prefix
-                        + "--\(boundary)\r\n"
-                        + "Content-Disposition: form-data; name=\"\(quotedString(data.name))\"\(filename)\r\n"
-                        + "Content-Type: \(mimeType)\r\n"
-                        + "\r\n"
-                    state = .header(Substring(header).utf8, content)
-                    break
-                }
-            }
-        case .terminator:
-            state = .eof
-        case .eof:
-            break
-        }
+    /// Lends out the remainder of the current segment without copying it.
+    ///
+    /// The lent bytes are considered read, and the pointer remains valid until the next call to
+    /// this method or `readIntoBuffer(_:_:)`.
+    private func getBuffer(_ buffer: UnsafeMutablePointer<UnsafePointer<UInt8>?>, _ length: UnsafeMutablePointer<UInt>) -> Bool {
+        lentStorage = nil
+        guard index < segments.count else { return false }
+        // Bridging doesn't copy the storage, and NSData gives us a pointer that outlives this call.
+        let storage = segments[index] as NSData
+        buffer.pointee = storage.bytes.assumingMemoryBound(to: UInt8.self) + offset
+        length.pointee = UInt(storage.length - offset)
+        lentStorage = storage
+        index += 1
+        offset = 0
+        return true
     }
     
     #if enableDebugLogging
@@ -205,6 +93,131 @@ internal final class HTTPBody {
     #endif
 }
 
+/// A multipart/mixed body that has been serialized into contiguous segments.
+///
+/// Every boundary and header block is serialized up front, and body part content is referenced
+/// rather than copied. The body can then be streamed any number of times, and its length is known
+/// without reading it.
+internal struct SerializedMultipartBody {
+    /// The segments of the body, in order. Segments are never empty.
+    let segments: [Data]
+    /// The total length of the body in bytes.
+    let count: Int
+    
+    /// Serializes a multipart/mixed body.
+    /// - Note: Any `.pending` body part must be evaluated before calling this initializer. This
+    ///   initializer blocks until they're ready.
+    init(boundary: String, parameters: [URLQueryItem], bodyParts: [MultipartBodyPart]) {
+        var segments: [Data] = []
+        var count = 0
+        func append(_ data: Data) {
+            guard !data.isEmpty else { return }
+            segments.append(data)
+            count += data.count
+        }
+        // There's no CRLF before the first boundary.
+        var prefix = ""
+        for queryItem in parameters {
+            // Parameters are always text/plain.
+            // We could probably get away with not specifying Content-Type and allowing the server to infer it,
+            // since it should normally infer it as UTF-8, but it's safer to be explicit.
+            append((prefix
+                + "--\(boundary)\r\n"
+                + "Content-Disposition: form-data; name=\"\(quotedString(queryItem.name))\"\r\n"
+                + "Content-Type: text/plain; charset=utf-8\r\n"
+                + "\r\n").data(using: .utf8)!)
+            append((queryItem.value ?? "").data(using: .utf8)!)
+            prefix = "\r\n"
+        }
+        for bodyPart in bodyParts {
+            let values: [MultipartBodyPart.Data]
+            switch bodyPart {
+            case .known(let data): values = [data]
+            case .pending(let deferred): values = deferred.wait()
+            }
+            for data in values {
+                let filename = data.filename.map({ "; filename=\"\(quotedString($0))\"" }) ?? ""
+                let mimeType: String
+                let content: Data
+                switch data.content {
+                case .data(let data_):
+                    content = data_
+                    mimeType = data.mimeType ?? "application/octet-stream"
+                case .text(let text):
+                    content = text.data(using: .utf8)!
+                    mimeType = data.mimeType ?? "text/plain; charset=utf-8"
+                }
+                append((prefix
+                    + "--\(boundary)\r\n"
+                    + "Content-Disposition: form-data; name=\"\(quotedString(data.name))\"\(filename)\r\n"
+                    + "Content-Type: \(mimeType)\r\n"
+                    + "\r\n").data(using: .utf8)!)
+                append(content)
+                prefix = "\r\n"
+            }
+        }
+        append("\(prefix)--\(boundary)--\r\n".data(using: .utf8)!)
+        self.segments = segments
+        self.count = count
+    }
+}
+
+/// Serializes a multipart/mixed body once and shares it between every attempt of a task, so
+/// retries and redirects don't rebuild it.
+internal final class MultipartBodyCache {
+    init(boundary: String, parameters: [URLQueryItem], bodyParts: [MultipartBodyPart]) {
+        self.boundary = boundary
+        self.parameters = parameters
+        self.bodyParts = bodyParts
+    }
+    
+    /// Returns the serialized body, serializing it first if necessary.
+    /// - Note: Any `.pending` body part must be evaluated before calling this method. This method
+    ///   blocks until they're ready.
+    func wait() -> SerializedMultipartBody {
+        return queue.sync(flags: .barrier, execute: serializeIfNeeded)
+    }
+    
+    /// Asynchronously executes a given block on a global queue with the serialized body,
+    /// serializing it first if necessary.
+    ///
+    /// Pending body parts are waited on asynchronously, so this never blocks the calling thread.
+    /// - Note: Any `.pending` body part must be evaluated before calling this method.
+    func async(_ qos: DispatchQoS, handler: @escaping (SerializedMultipartBody) -> Void) {
+        let group = DispatchGroup()
+        for case .pending(let deferred) in bodyParts {
+            group.enter()
+            deferred.async(qos) { _ in
+                group.leave()
+            }
+        }
+        group.notify(qos: qos, flags: [.barrier, .enforceQoS], queue: queue) {
+            let body = self.serializeIfNeeded()
+            DispatchQueue.global(qos: qos.qosClass).async {
+                autoreleasepool {
+                    handler(body)
+                }
+            }
+        }
+    }
+    
+    private let boundary: String
+    private let parameters: [URLQueryItem]
+    private let bodyParts: [MultipartBodyPart]
+    private let queue = DispatchQueue(label: "PMHTTP multipart body cache queue", qos: .utility, attributes: .concurrent)
+    private var value: SerializedMultipartBody?
+    
+    /// - Requires: This must be invoked as a barrier on `queue`.
+    private func serializeIfNeeded() -> SerializedMultipartBody {
+        if let value = value {
+            return value
+        }
+        let body = SerializedMultipartBody(boundary: boundary, parameters: parameters, bodyParts: bodyParts)
+        value = body
+        return body
+    }
+}
+
 /// Returns a string with quotes and line breaks escaped.
 /// - Note: The returned string is *not* surrounded by quotes.
 private func quotedString(_ str: String) -> String {
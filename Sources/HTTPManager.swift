@@ -54,6 +54,41 @@ public final class HTTPManager: NSObject {
         }
     }
     
+    /// The minimum interval in seconds between invocations of `networkActivityHandler`, except for
+    /// changes to or from zero outstanding tasks. The default value is `0`.
+    ///
+    /// Changes to or from zero always invoke the handler right away. Any other change that happens
+    /// within this interval of the previous invocation is delayed until the end of the interval,
+    /// so a burst of tasks invokes the handler at most once per interval with the latest count.
+    ///
+    /// - SeeAlso: `networkActivityChangeThreshold`.
+    @objc public static var networkActivityCoalescingInterval: TimeInterval {
+        get {
+            return NetworkActivityManager.shared.coalescingInterval
+        }
+        set {
+            NetworkActivityManager.shared.coalescingInterval = newValue
+        }
+    }
+    
+    /// The minimum change in the number of outstanding tasks since the previous invocation of
+    /// `networkActivityHandler` that invokes it again, except for changes to or from zero. The
+    /// default value is `1`.
+    ///
+    /// Changes to or from zero always invoke the handler. Smaller changes aren't reported until
+    /// they add up to the threshold, so if you only care whether there are outstanding tasks you
+    /// can set this to `Int.max`.
+    ///
+    /// - SeeAlso: `networkActivityCoalescingInterval`.
+    @objc public static var networkActivityChangeThreshold: Int {
+        get {
+            return NetworkActivityManager.shared.changeThreshold
+        }
+        set {
+            NetworkActivityManager.shared.changeThreshold = newValue
+        }
+    }
+    
     /// The current environment. The default value is `nil`.
     ///
     /// Changes to this property affects any newly-created requests but do not
@@ -70,10 +105,10 @@ public final class HTTPManager: NSObject {
     ///   `defaultServerRequiresContentLength`.
     @objc public var environment: Environment? {
         get {
-            return inner.sync({ $0.environment })
+            return inner.snapshot.environment
         }
         set {
-            inner.asyncBarrier {
+            inner.syncBarrier {
                 if $0.environment != newValue {
                     $0.environment = newValue
                     $0.defaultAuth = nil
@@ -139,8 +174,8 @@ public final class HTTPManager: NSObject {
         set {
             inner.asyncBarrier {
                 $0.sessionLevelAuthenticationHandler = newValue
-                if let session = $0.session {
-                    session.delegateQueue.addOperation { [delegate=$0.sessionDelegate!] in
+                for (session, delegate) in $0.allSessions {
+                    session.delegateQueue.addOperation {
                         delegate.sessionLevelAuthenticationHandler = newValue
                     }
                 }
@@ -176,11 +211,15 @@ public final class HTTPManager: NSObject {
         set {
             inner.asyncBarrier { inner in
                 inner.metricsCallbackWrapper = MetricsCallbackWrapper(newValue)
-                if let delegate = inner.sessionDelegate as? MetricsSessionDelegate {
-                    inner.session.delegateQueue.addOperation {
-                        // Always set this even if newValue is nil, otherwise any existing running tasks will
-                        // end up invoking the callback we removed.
-                        delegate.metricsCallback = newValue
+                if inner.sessionDelegate is MetricsSessionDelegate {
+                    // Pooled sessions share the same callback, so metrics from every session are
+                    // aggregated into it.
+                    for case let (session, delegate as MetricsSessionDelegate) in inner.allSessions {
+                        session.delegateQueue.addOperation {
+                            // Always set this even if newValue is nil, otherwise any existing running tasks will
+                            // end up invoking the callback we removed.
+                            delegate.metricsCallback = newValue
+                        }
                     }
                     if newValue == nil {
                         // We had a value, and now we don't.
@@ -209,10 +248,10 @@ public final class HTTPManager: NSObject {
     /// - SeeAlso: `environment`, `HTTPBasicAuth`, `HTTPManagerRequest.auth`.
     @objc public var defaultAuth: HTTPAuth? {
         get {
-            return inner.sync({ $0.defaultAuth })
+            return inner.snapshot.defaultAuth
         }
         set {
-            inner.asyncBarrier {
+            inner.syncBarrier {
                 $0.defaultAuth = newValue
             }
         }
@@ -233,10 +272,10 @@ public final class HTTPManager: NSObject {
     /// - SeeAlso: `environment`, `HTTPManagerRequest.headerFields`.
     @nonobjc public var defaultHeaderFields: HTTPManagerRequest.HTTPHeaders {
         get {
-            return inner.sync({ $0.defaultHeaderFields })
+            return inner.snapshot.defaultHeaderFields
         }
         set {
-            inner.asyncBarrier {
+            inner.syncBarrier {
                 $0.defaultHeaderFields = newValue
             }
         }
@@ -252,10 +291,10 @@ public final class HTTPManager: NSObject {
     /// - SeeAlso: `HTTPManagerRequest.retryBehavior`.
     @objc public var defaultRetryBehavior: HTTPManagerRetryBehavior? {
         get {
-            return inner.sync({ $0.defaultRetryBehavior })
+            return inner.snapshot.defaultRetryBehavior
         }
         set {
-            inner.asyncBarrier {
+            inner.syncBarrier {
                 $0.defaultRetryBehavior = newValue
             }
         }
@@ -273,10 +312,10 @@ public final class HTTPManager: NSObject {
     /// - SeeAlso: `HTTPManagerRequest.assumeErrorsAreJSON`.
     @objc public var defaultAssumeErrorsAreJSON: Bool {
         get {
-            return inner.sync({ $0.defaultAssumeErrorsAreJSON })
+            return inner.snapshot.defaultAssumeErrorsAreJSON
         }
         set {
-            inner.asyncBarrier {
+            inner.syncBarrier {
                 $0.defaultAssumeErrorsAreJSON = newValue
             }
         }
@@ -299,15 +338,42 @@ public final class HTTPManager: NSObject {
     /// - SeeAlso: `environment`, `HTTPManagerRequest.serverRequiresContentLength`.
     @objc public var defaultServerRequiresContentLength: Bool {
         get {
-            return inner.sync({ $0.defaultServerRequiresContentLength })
+            return inner.snapshot.defaultServerRequiresContentLength
         }
         set {
-            inner.asyncBarrier {
+            inner.syncBarrier {
                 $0.defaultServerRequiresContentLength = newValue
             }
         }
     }
     
+    /// If `true`, assume the server supports HTTP/3, so the first request to it can use HTTP/3
+    /// without first discovering support over an HTTP/2 or HTTP/1.1 connection. The default value
+    /// is `false`.
+    ///
+    /// This only has an effect on iOS 14.5, macOS 11.3, tvOS 14.5, watchOS 7.4 and later, and only
+    /// when PMHTTP is built with Swift 5.4 or later. It's ignored elsewhere.
+    ///
+    /// - Note: This property is only used for HTTP requests that are located within the current
+    ///   environment's base URL. If a request is created with an absolute path or absolute URL, and
+    ///   the resulting URL does not represent a resource found within the environment's base URL,
+    ///   the request will not be assigned this value.
+    ///
+    /// Changes to this property affect any newly-created requests but do not affect any existing
+    /// requests or any tasks that are in-progress.
+    ///
+    /// - SeeAlso: `environment`, `HTTPManagerRequest.assumesHTTP3Capable`.
+    @objc public var defaultAssumesHTTP3Capable: Bool {
+        get {
+            return inner.snapshot.defaultAssumesHTTP3Capable
+        }
+        set {
+            inner.syncBarrier {
+                $0.defaultAssumesHTTP3Capable = newValue
+            }
+        }
+    }
+    
     /// The user agent that's passed to every request.
     @objc public var userAgent: String {
         return inner.sync({
@@ -332,6 +398,230 @@ public final class HTTPManager: NSObject {
         }
     }
     
+    /// Opens a connection to a host ahead of the first request to it.
+    ///
+    /// This sends a `HEAD` request for the root path of the host through the session that requests
+    /// to the host use, so the DNS lookup and TCP and TLS handshakes are done by the time the first
+    /// real request is performed. With HTTP/2 or HTTP/3, later requests to the host are multiplexed
+    /// over the prewarmed connection. This is intended to be called at launch, or when the app
+    /// returns to the foreground.
+    ///
+    /// The status code of the response is ignored. The request doesn't use any auth, isn't subject
+    /// to `requestScheduler`, and doesn't affect the network activity indicator.
+    ///
+    /// - Parameter url: (Optional) A URL on the host to connect to. Only its scheme, host and port
+    ///   are used. The default value of `nil` means the host of the `environment`.
+    /// - Parameter userInitiated: (Optional) Whether to prewarm the session used for user-initiated
+    ///   requests. This only matters when `usesSessionPool` is `true`. The default value is
+    ///   `false`.
+    /// - Parameter completion: (Optional) A block that's invoked on a global background queue once
+    ///   the request finishes. `error` is `nil` if the host responded. If `url` is `nil` and there
+    ///   is no `environment`, this is invoked with a `URLError.badURL`.
+    ///
+    /// - SeeAlso: `defaultAssumesHTTP3Capable`, `HTTPManagerTask.connectionInfo`.
+    @objc(prewarmConnectionToURL:userInitiated:completion:)
+    public func prewarmConnection(to url: URL? = nil, userInitiated: Bool = false, completion: ((_ error: Error?) -> Void)? = nil) {
+        let snapshot = inner.snapshot
+        let qos: DispatchQoS.QoSClass = userInitiated ? .userInitiated : .utility
+        func complete(_ error: Error?) {
+            guard let completion = completion else { return }
+            DispatchQueue.global(qos: qos).async {
+                completion(error)
+            }
+        }
+        guard let target = url ?? snapshot.environment?.baseURL,
+            var comps = URLComponents(url: target, resolvingAgainstBaseURL: true),
+            comps.host != nil
+            else { return complete(URLError(.badURL)) }
+        comps.percentEncodedPath = "/"
+        comps.percentEncodedQuery = nil
+        comps.percentEncodedFragment = nil
+        guard let origin = comps.url else { return complete(URLError(.badURL)) }
+        var request = URLRequest(url: origin)
+        request.httpMethod = "HEAD"
+        request.cachePolicy = .reloadIgnoringLocalCacheData
+        #if swift(>=4.1.9) // Swift 4.2+ compiler, required for compiler()
+        #if compiler(>=5.4) // URLRequest.assumesHTTP3Capable needs the iOS 14.5 SDK
+        if #available(iOS 14.5, macOS 11.3, tvOS 14.5, watchOS 7.4, *), snapshot.defaultAssumesHTTP3Capable, snapshot.environment?.isPrefix(of: target) ?? false {
+            request.assumesHTTP3Capable = true
+        }
+        #endif
+        #endif
+        // NB: Tasks with completion handlers don't invoke the data delegate methods, so the
+        // session delegate never sees the task.
+        let networkTask = withSession(for: origin, userInitiated: userInitiated) { (session, _) -> URLSessionDataTask in
+            return session.dataTask(with: request, completionHandler: { (_, _, error) in
+                complete(error)
+            })
+        }
+        if userInitiated {
+            networkTask.priority = URLSessionTask.highPriority
+        }
+        networkTask.resume()
+    }
+    
+    /// Whether tasks are spread across a pool of sessions keyed by host and priority. The default
+    /// value is `false`.
+    ///
+    /// When this is `false`, every task shares a single `URLSession`. That means every host shares
+    /// one connection pool, and the delegate callbacks for every task are serialized on one queue.
+    /// When this is `true`, each combination of host and `HTTPManagerRequest.userInitiated` gets
+    /// its own session, so user-initiated requests don't queue behind bulk traffic. Sessions are
+    /// created on demand and all share `sessionConfiguration`. The pool holds at most 16 sessions;
+    /// beyond that the least recently used session is invalidated once its tasks finish.
+    ///
+    /// Changing this property affects all newly-created tasks but does not cancel any tasks that
+    /// are in-flight. `resetSession()` resets every session in the pool, and metrics for every
+    /// session are reported to `metricsCallback`.
+    ///
+    /// - SeeAlso: `resetSession()`, `sessionConfiguration`.
+    @objc public var usesSessionPool: Bool {
+        get {
+            return inner.sync({ $0.usesSessionPool })
+        }
+        set {
+            inner.asyncBarrier { inner in
+                guard inner.usesSessionPool != newValue else { return }
+                inner.usesSessionPool = newValue
+                if !newValue {
+                    autoreleasepool {
+                        self.resetSessionPool(inner, invalidate: false)
+                    }
+                }
+            }
+        }
+    }
+    
+    /// Whether identical in-flight `GET` requests share a single network task. The default value
+    /// is `false`.
+    ///
+    /// When this is `true`, a `GET` request that is performed while an identical request is still
+    /// talking to the network doesn't create a new `URLSessionTask`. Instead it waits for the
+    /// existing network task and receives the same response body. Each `HTTPManagerTask` still
+    /// parses the body, retries, and invokes its completion handler independently. Requests are
+    /// identical if their prepared `URLRequest`s have the same URL, header fields (including any
+    /// headers added by `HTTPAuth`), cache policy and timeout, and they agree on
+    /// `shouldFollowRedirects` and `defaultResponseCacheStoragePolicy`.
+    ///
+    /// Canceling one of the `HTTPManagerTask`s doesn't affect the others. The shared network
+    /// task is only canceled once every `HTTPManagerTask` using it has been canceled.
+    ///
+    /// - Note: Requests that aren't idempotent, requests with upload bodies, streamed requests,
+    ///   and mocked requests are never coalesced.
+    ///
+    /// Changes to this property affect any newly-created tasks but do not affect any tasks that
+    /// are in-progress.
+    @objc public var coalescesIdenticalRequests: Bool {
+        get {
+            return inner.snapshot.coalescesIdenticalRequests
+        }
+        set {
+            inner.syncBarrier {
+                $0.coalescesIdenticalRequests = newValue
+            }
+        }
+    }
+    
+    /// The cache used by requests that set `HTTPManagerParseRequest.usesResponseCache`. The default
+    /// value is `nil`, which disables response caching.
+    ///
+    /// Requests that use the cache return cached results without waiting for the network, and keep
+    /// the cache up to date by revalidating stale entries in the background. See
+    /// `HTTPManagerResponseCache` for details.
+    ///
+    /// Changes to this property affect any newly-created tasks but do not affect any tasks that
+    /// are in-progress.
+    @objc public var responseCache: HTTPManagerResponseCache? {
+        get {
+            return inner.snapshot.responseCache
+        }
+        set {
+            inner.syncBarrier {
+                $0.responseCache = newValue
+            }
+        }
+    }
+    
+    /// The budget that limits retries requested by `HTTPManagerRetryBehavior`s, per host. The
+    /// default value is `nil`, which doesn't limit retries.
+    ///
+    /// When a task's retry behavior asks for a retry and the budget for the host of the request is
+    /// exhausted, the task isn't retried and fails with the error that triggered the retry.
+    /// Retries requested by an `HTTPAuth` aren't limited by the budget.
+    ///
+    /// Changes to this property affect any subsequent retries, including those of tasks that are
+    /// in-progress.
+    ///
+    /// - SeeAlso: `HTTPManagerRetryBudget`, `HTTPManagerRetryBehavior.backoffStrategy(maximumAttempts:baseDelay:maximumDelay:)`.
+    @objc public var retryBudget: HTTPManagerRetryBudget? {
+        get {
+            return inner.snapshot.retryBudget
+        }
+        set {
+            inner.syncBarrier {
+                $0.retryBudget = newValue
+            }
+        }
+    }
+    
+    /// The scheduler that limits how many network tasks run at once for each host. The default
+    /// value is `nil`, which starts every task as soon as it's resumed.
+    ///
+    /// When set, resumed tasks wait for the scheduler to start them, and waiting tasks start in
+    /// order of their `HTTPManagerTask.priority`. See `HTTPManagerRequestScheduler` for details.
+    ///
+    /// Changes to this property affect any newly-created tasks. Existing tasks, including any that
+    /// are waiting on the previous scheduler, continue to use the scheduler they were created with.
+    ///
+    /// - SeeAlso: `HTTPManagerRequestScheduler`, `HTTPManagerRequest.priority`.
+    @objc public var requestScheduler: HTTPManagerRequestScheduler? {
+        get {
+            return inner.snapshot.requestScheduler
+        }
+        set {
+            inner.syncBarrier {
+                $0.requestScheduler = newValue
+            }
+        }
+    }
+    
+    /// The recorder that aggregates how long tasks spend in each phase of their lifetime. The
+    /// default value is `nil`, which disables latency instrumentation.
+    ///
+    /// When set, each newly-created task records its latency breakdown in `HTTPManagerTask.latency`
+    /// and the recorder's per-endpoint histograms when it completes. See
+    /// `HTTPManagerLatencyRecorder` for details.
+    ///
+    /// Changes to this property affect any newly-created tasks.
+    ///
+    /// - SeeAlso: `HTTPManagerLatencyRecorder`, `HTTPManagerTask.latency`.
+    @objc public var latencyRecorder: HTTPManagerLatencyRecorder? {
+        get {
+            return inner.snapshot.latencyRecorder
+        }
+        set {
+            inner.syncBarrier {
+                $0.latencyRecorder = newValue
+            }
+        }
+    }
+    
+    /// The maximum total size in bytes of the response bodies whose parsed values are remembered
+    /// for requests that set `HTTPManagerParseRequest.memoizesParse`. The default value is 4 MiB.
+    ///
+    /// The size of the parsed values themselves isn't measured, so the memory used is roughly the
+    /// size of the bodies plus the size of the values parsed from them. Setting this to `0`
+    /// disables memoization and discards every remembered value. Lowering it discards values
+    /// until the remaining bodies fit.
+    @objc public var parseMemoizationByteLimit: Int {
+        get {
+            return parseResultMemo.byteLimit
+        }
+        set {
+            parseResultMemo.byteLimit = newValue
+        }
+    }
+    
     /// Creates and returns a new `HTTPManager`.
     ///
     /// The returned `HTTPManager` needs its `environment` set, but is otherwise ready
@@ -407,12 +697,43 @@ public final class HTTPManager: NSObject {
         var defaultRetryBehavior: HTTPManagerRetryBehavior?
         var defaultAssumeErrorsAreJSON: Bool = false
         var defaultServerRequiresContentLength: Bool = false
+        var defaultAssumesHTTP3Capable: Bool = false
         var defaultHeaderFields: HTTPManagerRequest.HTTPHeaders = [:]
 
         var session: URLSession!
         var sessionDelegate: SessionDelegate!
         var oldSessions: [URLSession] = []
         
+        var usesSessionPool: Bool = false
+        var coalescesIdenticalRequests: Bool = false
+        var responseCache: HTTPManagerResponseCache?
+        var retryBudget: HTTPManagerRetryBudget?
+        var requestScheduler: HTTPManagerRequestScheduler?
+        var latencyRecorder: HTTPManagerLatencyRecorder?
+        /// The pooled sessions, keyed by host and priority. Only used if `usesSessionPool` is `true`.
+        var pooledSessions: [SessionPoolKey: PooledSession] = [:]
+        /// The maximum number of pooled sessions. Creating another one evicts the least recently
+        /// used session.
+        var maximumPooledSessionCount = HTTPManager.defaultMaximumPooledSessionCount
+        
+        /// Every live session along with its delegate, including pooled sessions.
+        var allSessions: [(session: URLSession, delegate: SessionDelegate)] {
+            var result = pooledSessions.values.map({ ($0.session, $0.delegate) })
+            if let session = session {
+                result.insert((session, sessionDelegate), at: 0)
+            }
+            return result
+        }
+        
+        /// Returns the session to use for a request with the given URL and priority, or `nil` if
+        /// the appropriate pooled session hasn't been created yet.
+        func session(for url: URL?, userInitiated: Bool) -> (session: URLSession, delegate: SessionDelegate)? {
+            guard usesSessionPool else { return (session, sessionDelegate) }
+            guard let pooled = pooledSessions[SessionPoolKey(url: url, userInitiated: userInitiated)] else { return nil }
+            pooled.markUsed()
+            return (pooled.session, pooled.delegate)
+        }
+        
         func setHeader(_ header: String, value: String, overwrite: Bool = true) {
             var headers = sessionConfiguration.httpAdditionalHeaders ?? [:]
             if overwrite || headers[header] == nil {
@@ -422,7 +743,135 @@ public final class HTTPManager: NSObject {
         }
     }
     
-    fileprivate let inner: QueueConfined<Inner> = QueueConfined(label: "HTTPManager internal queue", value: Inner())
+    /// The values from `Inner` that are read whenever a request or task is created, published so
+    /// they can be read without waiting on the internal queue.
+    ///
+    /// The setters for these values use `syncBarrier` so a new value is visible as soon as the
+    /// setter returns.
+    fileprivate final class Snapshot {
+        let environment: Environment?
+        let defaultAuth: HTTPAuth?
+        let defaultRetryBehavior: HTTPManagerRetryBehavior?
+        let defaultAssumeErrorsAreJSON: Bool
+        let defaultServerRequiresContentLength: Bool
+        let defaultAssumesHTTP3Capable: Bool
+        let defaultHeaderFields: HTTPManagerRequest.HTTPHeaders
+        let coalescesIdenticalRequests: Bool
+        let responseCache: HTTPManagerResponseCache?
+        let retryBudget: HTTPManagerRetryBudget?
+        let requestScheduler: HTTPManagerRequestScheduler?
+        let latencyRecorder: HTTPManagerLatencyRecorder?
+        
+        init(_ inner: Inner) {
+            environment = inner.environment
+            defaultAuth = inner.defaultAuth
+            defaultRetryBehavior = inner.defaultRetryBehavior
+            defaultAssumeErrorsAreJSON = inner.defaultAssumeErrorsAreJSON
+            defaultServerRequiresContentLength = inner.defaultServerRequiresContentLength
+            defaultAssumesHTTP3Capable = inner.defaultAssumesHTTP3Capable
+            defaultHeaderFields = inner.defaultHeaderFields
+            coalescesIdenticalRequests = inner.coalescesIdenticalRequests
+            responseCache = inner.responseCache
+            retryBudget = inner.retryBudget
+            requestScheduler = inner.requestScheduler
+            latencyRecorder = inner.latencyRecorder
+        }
+    }
+    
+    fileprivate struct SessionPoolKey: Hashable {
+        let host: String
+        let userInitiated: Bool
+        
+        init(url: URL?, userInitiated: Bool) {
+            host = url?.host?.lowercased() ?? ""
+            self.userInitiated = userInitiated
+        }
+        
+        #if swift(>=4.1.9) // detect Swift 4.2 compiler
+        func hash(into hasher: inout Hasher) {
+            hasher.combine(host)
+            hasher.combine(userInitiated)
+        }
+        #else
+        var hashValue: Int {
+            var hasher = SipHasher()
+            hasher.write(host)
+            hasher.write(userInitiated)
+            return Int(truncatingIfNeeded: hasher.finish())
+        }
+        #endif
+        
+        static func ==(lhs: SessionPoolKey, rhs: SessionPoolKey) -> Bool {
+            return lhs.host == rhs.host && lhs.userInitiated == rhs.userInitiated
+        }
+    }
+    
+    /// A pooled session along with when it was last used.
+    fileprivate final class PooledSession {
+        let session: URLSession
+        let delegate: SessionDelegate
+        
+        init(_ pair: (session: URLSession, delegate: SessionDelegate)) {
+            session = pair.session
+            delegate = pair.delegate
+            _lastUse = DispatchTime.now().uptimeNanoseconds
+        }
+        
+        /// When a task was last created with the session, in uptime nanoseconds.
+        var lastUse: UInt64 {
+            lock.lock()
+            defer { lock.unlock() }
+            return _lastUse
+        }
+        
+        /// Records that a task is being created with the session.
+        ///
+        /// Tasks are created concurrently on the internal queue, so this takes a lock rather than
+        /// requiring a barrier.
+        func markUsed() {
+            let now = DispatchTime.now().uptimeNanoseconds
+            lock.lock()
+            defer { lock.unlock() }
+            _lastUse = now
+        }
+        
+        private var _lastUse: UInt64
+        private let lock = NSLock()
+    }
+    
+    /// The default value of `maximumPooledSessionCount`.
+    internal static let defaultMaximumPooledSessionCount = 16
+    
+    /// The maximum number of sessions in the session pool. The default value is 16.
+    ///
+    /// Creating a pooled session for another host or priority beyond this evicts the least recently
+    /// used session, whose in-flight tasks are allowed to finish.
+    internal var maximumPooledSessionCount: Int {
+        get {
+            return inner.sync({ $0.maximumPooledSessionCount })
+        }
+        set {
+            inner.asyncBarrier { inner in
+                inner.maximumPooledSessionCount = max(newValue, 1)
+                autoreleasepool {
+                    while inner.pooledSessions.count > inner.maximumPooledSessionCount {
+                        self.evictPooledSession(inner)
+                    }
+                }
+            }
+        }
+    }
+    
+    /// The hosts of the pooled sessions, which may include duplicates for sessions with different
+    /// priorities.
+    internal var pooledSessionHosts: [String] {
+        return inner.sync({ $0.pooledSessions.keys.map({ $0.host }) })
+    }
+    
+    fileprivate let inner: SnapshotQueueConfined<Inner, Snapshot> = SnapshotQueueConfined(label: "HTTPManager internal queue", value: Inner(), makeSnapshot: Snapshot.init)
+    
+    /// The memo used by requests that set `HTTPManagerParseRequest.memoizesParse`.
+    internal let parseResultMemo = ParseResultMemo(byteLimit: 4 * 1024 * 1024)
     
     fileprivate init(shared: Bool) {
         super.init()
@@ -465,7 +914,9 @@ public final class HTTPManager: NSObject {
     deinit {
         inner.asyncBarrier { inner in
             autoreleasepool {
-                inner.session?.finishTasksAndInvalidate()
+                for (session, _) in inner.allSessions {
+                    session.finishTasksAndInvalidate()
+                }
             }
         }
     }
@@ -483,21 +934,84 @@ public final class HTTPManager: NSObject {
                 inner.oldSessions.append(session)
             }
         }
+        resetSessionPool(inner, invalidate: invalidate)
+        let pair = makeSession(inner, name: "HTTPManager session delegate queue")
+        inner.session = pair.session
+        inner.sessionDelegate = pair.delegate
+    }
+    
+    /// Invalidates every pooled session. New pooled sessions are created on demand.
+    private func resetSessionPool(_ inner: Inner, invalidate: Bool) {
+        for pooled in inner.pooledSessions.values {
+            if invalidate {
+                pooled.session.invalidateAndCancel()
+            } else {
+                pooled.session.finishTasksAndInvalidate()
+                inner.oldSessions.append(pooled.session)
+            }
+        }
+        inner.pooledSessions.removeAll()
+    }
+    
+    /// Removes the least recently used session from the pool and invalidates it once its tasks
+    /// finish.
+    private func evictPooledSession(_ inner: Inner) {
+        guard let lru = inner.pooledSessions.min(by: { $0.value.lastUse < $1.value.lastUse }) else { return }
+        inner.pooledSessions[lru.key] = nil
+        lru.value.session.finishTasksAndInvalidate()
+        inner.oldSessions.append(lru.value.session)
+    }
+    
+    /// Creates a new session from the current configuration.
+    private func makeSession(_ inner: Inner, name: String, qualityOfService: QualityOfService? = nil) -> (session: URLSession, delegate: SessionDelegate) {
         let sessionDelegate: SessionDelegate
         if #available(iOS 10, macOS 10.12, tvOS 10, watchOS 3, *), let metricsCallback = inner.metricsCallbackWrapper.asOptional {
             sessionDelegate = MetricsSessionDelegate(apiManager: self, metricsCallback: metricsCallback)
         } else {
             sessionDelegate = SessionDelegate(apiManager: self)
         }
-        inner.sessionDelegate = sessionDelegate
+        sessionDelegate.sessionLevelAuthenticationHandler = inner.sessionLevelAuthenticationHandler
         // Insert HTTPMockURLProtocol into the protocol classes list.
         let config = unsafeDowncast(inner.sessionConfiguration.copy() as AnyObject, to: URLSessionConfiguration.self)
         var classes = config.protocolClasses ?? []
         classes.insert(HTTPMockURLProtocol.self, at: 0)
         config.protocolClasses = classes
         let session = URLSession(configuration: config, delegate: sessionDelegate, delegateQueue: nil)
-        inner.session = session
-        session.delegateQueue.name = "HTTPManager session delegate queue"
+        session.delegateQueue.name = name
+        if let qualityOfService = qualityOfService {
+            session.delegateQueue.qualityOfService = qualityOfService
+        }
+        return (session, sessionDelegate)
+    }
+    
+    /// Executes a block with the session to use for a request, creating a pooled session if
+    /// necessary.
+    ///
+    /// The block is executed on the internal queue so the session can't be invalidated while the
+    /// block is creating tasks with it.
+    fileprivate func withSession<T>(for url: URL?, userInitiated: Bool, _ body: (URLSession, SessionDelegate) -> T) -> T {
+        let result = inner.sync { inner -> T? in
+            guard let pair = inner.session(for: url, userInitiated: userInitiated) else { return nil }
+            return .some(body(pair.session, pair.delegate))
+        }
+        if let result = result {
+            return result
+        }
+        return inner.syncBarrier { inner -> T in
+            if let pair = inner.session(for: url, userInitiated: userInitiated) {
+                return body(pair.session, pair.delegate)
+            }
+            let key = SessionPoolKey(url: url, userInitiated: userInitiated)
+            // Pooled sessions are only removed by resetting the pool, so cap the pool for apps that
+            // talk to many hosts.
+            while inner.pooledSessions.count >= inner.maximumPooledSessionCount {
+                evictPooledSession(inner)
+            }
+            let pooled = PooledSession(makeSession(inner, name: "HTTPManager session delegate queue (\(key.host)\(userInitiated ? ", user-initiated" : ""))",
+                                                   qualityOfService: userInitiated ? .userInitiated : .utility))
+            inner.pooledSessions[key] = pooled
+            return body(pooled.session, pooled.delegate)
+        }
     }
 }
 
@@ -1180,12 +1694,11 @@ extension HTTPManager {
         return request
     }
     
-    private typealias ConfigureRequestInfo = (environment: Environment?, auth: HTTPAuth?, retryBehavior: HTTPManagerRetryBehavior?, assumeErrorsAreJSON: Bool, serverRequiresContentLength: Bool, headerFields: HTTPManagerRequest.HTTPHeaders)
+    private typealias ConfigureRequestInfo = (environment: Environment?, auth: HTTPAuth?, retryBehavior: HTTPManagerRetryBehavior?, assumeErrorsAreJSON: Bool, serverRequiresContentLength: Bool, assumesHTTP3Capable: Bool, headerFields: HTTPManagerRequest.HTTPHeaders)
     
     private func _configureRequestInfo() -> ConfigureRequestInfo {
-        return inner.sync({ inner in
-            return (inner.environment, inner.defaultAuth, inner.defaultRetryBehavior, inner.defaultAssumeErrorsAreJSON, inner.defaultServerRequiresContentLength, inner.defaultHeaderFields)
-        })
+        let snapshot = inner.snapshot
+        return (snapshot.environment, snapshot.defaultAuth, snapshot.defaultRetryBehavior, snapshot.defaultAssumeErrorsAreJSON, snapshot.defaultServerRequiresContentLength, snapshot.defaultAssumesHTTP3Capable, snapshot.defaultHeaderFields)
     }
     
     private func _configureRequest<T: HTTPManagerRequest>(_ request: T, url: URL, with info: ConfigureRequestInfo) {
@@ -1199,6 +1712,7 @@ extension HTTPManager {
                 request.auth = auth
             }
             request.serverRequiresContentLength = info.serverRequiresContentLength
+            request.assumesHTTP3Capable = info.assumesHTTP3Capable
             request.headerFields = info.headerFields
         }
         request.retryBehavior = info.retryBehavior
@@ -1206,19 +1720,19 @@ extension HTTPManager {
     }
     
     internal func applyEnvironmentDefaultValues(to request: HTTPManagerRequest) {
-        inner.sync { inner in
-            let auth = inner.defaultAuth
-            if auth.map({ !HTTPManager.isAuthSuppressed($0) }) ?? true {
-                request.auth = auth
-            }
-            request.serverRequiresContentLength = inner.defaultServerRequiresContentLength
-            if !inner.defaultHeaderFields.isEmpty {
-                request.headerFields.merge(inner.defaultHeaderFields, uniquingKeysWith: { (current, _) in current })
-            }
+        let snapshot = inner.snapshot
+        let auth = snapshot.defaultAuth
+        if auth.map({ !HTTPManager.isAuthSuppressed($0) }) ?? true {
+            request.auth = auth
+        }
+        request.serverRequiresContentLength = snapshot.defaultServerRequiresContentLength
+        request.assumesHTTP3Capable = snapshot.defaultAssumesHTTP3Capable
+        if !snapshot.defaultHeaderFields.isEmpty {
+            request.headerFields.merge(snapshot.defaultHeaderFields, uniquingKeysWith: { (current, _) in current })
         }
     }
     
-    private func expandParameters(_ parameters: [String: Any]) -> [URLQueryItem] {
+    internal func expandParameters(_ parameters: [String: Any]) -> [URLQueryItem] {
         var queryItems: [URLQueryItem] = []
         queryItems.reserveCapacity(parameters.count) // optimize for no expansion
         func expand(key prefix: String, dict: [AnyHashable: Any], queryItems: inout [URLQueryItem]) {
@@ -1548,7 +2062,7 @@ public final class HTTPManagerRetryBehavior: NSObject {
                     callback(true)
                 case 1:
                     let queue = DispatchQueue.global(qos: task.userInitiated ? .userInitiated : .utility)
-                    queue.asyncAfter(deadline: DispatchTime.now() + delay, execute: { autoreleasepool { callback(true) } })
+                    RetryScheduler.shared.schedule(after: delay, on: queue, execute: { autoreleasepool { callback(true) } })
                 default:
                     callback(false)
                 }
@@ -1576,6 +2090,41 @@ public final class HTTPManagerRetryBehavior: NSObject {
     ///   **Requires:** This block must not be executed more than once.
     public typealias CustomStrategy = (_ task: HTTPManagerTask, _ error: Error, _ attempt: Int, _ callback: @escaping (_ retry: Bool) -> Void) -> Void
     
+    // NB: Backoff is a custom strategy rather than a `Strategy` case, as adding a case would break
+    // exhaustive switches over `Strategy`. It can become a case once `CustomStrategy` is merged in.
+    
+    /// Returns a custom retry strategy that retries up to `maximumAttempts` times, waiting a
+    /// randomized delay before each retry.
+    ///
+    /// The delays use decorrelated jitter: each one is chosen at random between `baseDelay` and
+    /// three times the previous delay, and is capped at `maximumDelay`. This spreads out the
+    /// retries of tasks that failed at the same time instead of having them all retry in step.
+    ///
+    /// - Parameter maximumAttempts: The maximum number of retries.
+    /// - Parameter baseDelay: The minimum amount of time in seconds to wait before each retry.
+    /// - Parameter maximumDelay: The maximum amount of time in seconds to wait before each retry.
+    public static func backoffStrategy(maximumAttempts: Int, baseDelay: TimeInterval, maximumDelay: TimeInterval) -> CustomStrategy {
+        return { (task, error, attempt, callback) in
+            guard attempt < maximumAttempts else {
+                callback(false)
+                return
+            }
+            // Retry behaviors are evaluated serially for a given task, so this doesn't race.
+            let delay = decorrelatedJitter(previousDelay: attempt == 0 ? nil : task.previousRetryDelay, baseDelay: baseDelay, maximumDelay: maximumDelay)
+            task.previousRetryDelay = delay
+            let queue = DispatchQueue.global(qos: task.userInitiated ? .userInitiated : .utility)
+            RetryScheduler.shared.schedule(after: delay, on: queue, execute: { autoreleasepool { callback(true) } })
+        }
+    }
+    
+    /// Returns a random delay between `baseDelay` and three times `previousDelay`, capped at
+    /// `maximumDelay`.
+    internal static func decorrelatedJitter(previousDelay: TimeInterval?, baseDelay: TimeInterval, maximumDelay: TimeInterval) -> TimeInterval {
+        let upperBound = max((previousDelay ?? baseDelay) * 3, baseDelay)
+        let fraction = Double(arc4random()) / Double(UInt32.max)
+        return min(baseDelay + (upperBound - baseDelay) * fraction, maximumDelay)
+    }
+    
     /// Returns a retry behavior that retries automatically for networking errors.
     ///
     /// A networking error is defined as many errors in `URLError`, or a `PMJSON.JSONParserError`
@@ -1920,7 +2469,15 @@ extension HTTPManager {
 private class SessionDelegate: NSObject {
     weak var apiManager: HTTPManager?
     
-    var tasks: [TaskIdentifier: TaskInfo] = [:]
+    /// The tasks that belong to the session.
+    ///
+    /// - Note: Unlike the rest of the delegate's state, tasks may be inserted from any thread.
+    let tasks = TaskTable()
+    
+    /// The in-flight requests that identical requests can share.
+    ///
+    /// - Note: Like `tasks`, this may be accessed from any thread.
+    let inFlightRequests = InFlightTable()
     
     var sessionLevelAuthenticationHandler: ((_ httpManager: HTTPManager, _ challenge: URLAuthenticationChallenge, _ completionHandler: @escaping (URLSession.AuthChallengeDisposition, URLCredential?) -> Void) -> Void)?
     
@@ -1932,23 +2489,244 @@ private class SessionDelegate: NSObject {
     /// A task identifier for a `URLSessionTask`.
     typealias TaskIdentifier = Int
     
-    struct TaskInfo {
+    /// The bookkeeping for a single attempt of a task.
+    ///
+    /// This is a class so the delegate methods can update it in place instead of copying it out of
+    /// the task table and writing it back. The mutable properties must only be accessed from the
+    /// session delegate queue once the `TaskInfo` has been added to the task table.
+    final class TaskInfo: SharedNetworkTaskSubscriber {
         let task: HTTPManagerTask
         let uploadBody: UploadBody?
+        /// The serialized body for `.multipartMixed` uploads, shared by every attempt.
+        let multipartBody: MultipartBodyCache?
+        /// The compression applied to streamed upload bodies. `.data` bodies are already compressed.
+        let bodyCompression: HTTPManagerRequestBodyCompression
         let originalRequest: URLRequest
         let authToken: Any?
+        /// If non-`nil`, successful response bodies are handed to the stream instead of being
+        /// accumulated in `data`.
+        let responseStream: ResponseStream?
         let processor: (HTTPManagerTask, HTTPManagerTaskResult<Data>, _ authToken: Any??, _ attempt: Int, _ retry: @escaping (_ reason: HTTPManager.RetryReason) -> Bool) -> Void
         var data: NSMutableData? = nil
+        /// `true` if the body of the current response is being delivered to `responseStream`.
+        var isStreaming: Bool = false
         var attempt: Int = 0
         var highestRetryReason: HTTPManager.RetryReason?
+        /// The key this task is registered under in `inFlightRequests`, if identical requests
+        /// can share its network task. Not carried over to retries.
+        var coalescingKey: CoalescingKey?
         
-        init(task: HTTPManagerTask, uploadBody: UploadBody?, originalRequest: URLRequest, authToken: Any?, processor: @escaping (HTTPManagerTask, HTTPManagerTaskResult<Data>, _ authToken: Any??, _ attempt: Int, _ retry: @escaping (_ reason: HTTPManager.RetryReason) -> Bool) -> Void) {
+        init(task: HTTPManagerTask, uploadBody: UploadBody?, multipartBody: MultipartBodyCache?, bodyCompression: HTTPManagerRequestBodyCompression, originalRequest: URLRequest, authToken: Any?, responseStream: ResponseStream?, processor: @escaping (HTTPManagerTask, HTTPManagerTaskResult<Data>, _ authToken: Any??, _ attempt: Int, _ retry: @escaping (_ reason: HTTPManager.RetryReason) -> Bool) -> Void) {
             self.task = task
             self.uploadBody = uploadBody
+            self.multipartBody = multipartBody
+            self.bodyCompression = bodyCompression
             self.originalRequest = originalRequest
             self.authToken = authToken
+            self.responseStream = responseStream
             self.processor = processor
         }
+        
+        /// Returns a new `TaskInfo` for the next attempt of a task.
+        init(retrying taskInfo: TaskInfo, reason: HTTPManager.RetryReason) {
+            task = taskInfo.task
+            uploadBody = taskInfo.uploadBody
+            multipartBody = taskInfo.multipartBody
+            bodyCompression = taskInfo.bodyCompression
+            originalRequest = taskInfo.originalRequest
+            authToken = taskInfo.authToken
+            responseStream = taskInfo.responseStream
+            processor = taskInfo.processor
+            switch reason {
+            case .normal:
+                attempt = taskInfo.attempt + 1
+            case .unauthorized, .forbidden:
+                attempt = 0
+            }
+            highestRetryReason = max(taskInfo.highestRetryReason ?? .normal, reason)
+        }
+        
+        /// Must be called on the session delegate queue.
+        func processCancellation() {
+            let task = self.task, processor = self.processor, attempt = self.attempt
+            DispatchQueue.global(qos: task.userInitiated ? .userInitiated : .utility).async {
+                autoreleasepool {
+                    processor(task, .canceled, nil, attempt, { _ in false })
+                }
+            }
+        }
+    }
+    
+    /// A table of `TaskInfo`s keyed by task identifier.
+    ///
+    /// Lookups and removals must happen on the session delegate queue, and read a plain dictionary
+    /// without any locking, since they happen for every delegate callback. Tasks are registered
+    /// directly from whatever thread creates them instead of hopping onto the delegate queue, so
+    /// creating tasks doesn't compete with delegate callbacks for that queue. Registrations go into
+    /// a locked inbox that the delegate queue drains the first time it looks up a task it doesn't
+    /// know about. A task is always registered before it's resumed, so its first delegate callback
+    /// finds it in the inbox.
+    final class TaskTable {
+        /// Looks up a task. Must be called on the session delegate queue.
+        subscript(identifier: TaskIdentifier) -> TaskInfo? {
+            if let taskInfo = tasks[identifier] {
+                return taskInfo
+            }
+            return drainInbox() ? tasks[identifier] : nil
+        }
+        
+        /// Adds a `TaskInfo` for a newly-created network task. May be called from any thread.
+        func insert(_ taskInfo: TaskInfo, for identifier: TaskIdentifier) {
+            lock.lock()
+            inbox.append((identifier, taskInfo))
+            lock.unlock()
+        }
+        
+        /// Removes a task. Must be called on the session delegate queue.
+        func removeValue(forKey identifier: TaskIdentifier) -> TaskInfo? {
+            if let taskInfo = tasks.removeValue(forKey: identifier) {
+                return taskInfo
+            }
+            return drainInbox() ? tasks.removeValue(forKey: identifier) : nil
+        }
+        
+        /// Removes every `TaskInfo` from the table and returns them. Must be called on the session
+        /// delegate queue.
+        func removeAll() -> [TaskInfo] {
+            _ = drainInbox()
+            let result = Array(tasks.values)
+            tasks.removeAll()
+            return result
+        }
+        
+        /// Only accessed from the session delegate queue.
+        private var tasks: [TaskIdentifier: TaskInfo] = [:]
+        
+        private let lock = NSLock()
+        /// Tasks registered since the inbox was last drained. Guarded by `lock`.
+        private var inbox: [(TaskIdentifier, TaskInfo)] = []
+        
+        /// Moves every registered task into `tasks`. Returns `false` if there weren't any.
+        private func drainInbox() -> Bool {
+            lock.lock()
+            let registered = inbox
+            inbox.removeAll()
+            lock.unlock()
+            for (identifier, taskInfo) in registered {
+                assert(tasks[identifier] == nil, "internal HTTPManager error: tasks contains unknown taskInfo")
+                tasks[identifier] = taskInfo
+            }
+            return !registered.isEmpty
+        }
+    }
+    
+    /// Identifies requests that can share a single network task.
+    struct CoalescingKey: Hashable {
+        let url: URL?
+        let headerFields: [String: String]
+        let cachePolicy: URLRequest.CachePolicy
+        let timeoutInterval: TimeInterval
+        let followRedirects: Bool
+        let cacheStoragePolicy: URLCache.StoragePolicy
+        
+        init(request: URLRequest, followRedirects: Bool, cacheStoragePolicy: URLCache.StoragePolicy) {
+            url = request.url
+            headerFields = request.allHTTPHeaderFields ?? [:]
+            cachePolicy = request.cachePolicy
+            timeoutInterval = request.timeoutInterval
+            self.followRedirects = followRedirects
+            self.cacheStoragePolicy = cacheStoragePolicy
+        }
+        
+        #if swift(>=4.1.9) // detect Swift 4.2 compiler
+        func hash(into hasher: inout Hasher) {
+            hasher.combine(url)
+            hasher.combine(headerFields)
+            hasher.combine(cachePolicy.rawValue)
+            hasher.combine(timeoutInterval)
+            hasher.combine(followRedirects)
+            hasher.combine(cacheStoragePolicy.rawValue)
+        }
+        #else
+        var hashValue: Int {
+            var hasher = SipHasher()
+            hasher.write(Int64(url?.hashValue ?? 0))
+            hasher.write(headerFields)
+            hasher.write(UInt64(cachePolicy.rawValue))
+            hasher.write(Int64(timeoutInterval.hashValue))
+            hasher.write(followRedirects)
+            hasher.write(UInt64(cacheStoragePolicy.rawValue))
+            return Int(truncatingIfNeeded: hasher.finish())
+        }
+        #endif
+        
+        static func ==(lhs: CoalescingKey, rhs: CoalescingKey) -> Bool {
+            return lhs.url == rhs.url && lhs.headerFields == rhs.headerFields && lhs.cachePolicy == rhs.cachePolicy
+                && lhs.timeoutInterval == rhs.timeoutInterval && lhs.followRedirects == rhs.followRedirects
+                && lhs.cacheStoragePolicy == rhs.cacheStoragePolicy
+        }
+    }
+    
+    /// A thread-safe table of the in-flight network tasks that identical requests can share.
+    ///
+    /// The `TaskInfo` of the task that created the network task lives in `tasks` as usual. The
+    /// `TaskInfo`s of the tasks sharing it are kept by its `SharedNetworkTask` until the network
+    /// task completes or they're canceled.
+    final class InFlightTable {
+        /// Adds a subscriber to the in-flight network task for `key`, if there is one.
+        ///
+        /// - Parameter makeTaskInfo: A block that creates the `TaskInfo` for the new subscriber.
+        ///   It's invoked synchronously only if the network task can be shared.
+        /// - Returns: The new subscriber's `TaskInfo`, or `nil` if there is no in-flight network
+        ///   task for `key` or every existing subscriber has been canceled.
+        func join(_ key: CoalescingKey, makeTaskInfo: (SharedNetworkTask) -> TaskInfo) -> TaskInfo? {
+            return inner.syncBarrier { inner -> TaskInfo? in
+                return inner.entries[key]?.join(makeSubscriber: makeTaskInfo)
+            }
+        }
+        
+        /// Registers a network task that identical requests can share. Does nothing if another
+        /// network task is already registered for `key`.
+        func insert(_ sharedNetworkTask: SharedNetworkTask, for key: CoalescingKey) {
+            inner.syncBarrier { inner in
+                if inner.entries[key] == nil {
+                    inner.entries[key] = sharedNetworkTask
+                }
+            }
+        }
+        
+        /// Unregisters a network task and returns the `TaskInfo`s of the tasks sharing it that
+        /// haven't been canceled.
+        ///
+        /// Returns an empty array if `sharedNetworkTask` isn't the network task registered for `key`.
+        func removeValue(forKey key: CoalescingKey, sharedNetworkTask: SharedNetworkTask) -> [TaskInfo] {
+            return inner.syncBarrier { inner -> [TaskInfo] in
+                guard inner.entries[key] === sharedNetworkTask else { return [] }
+                inner.entries[key] = nil
+                return sharedNetworkTask.removeJoinedSubscribers().map(InFlightTable.taskInfo(for:))
+            }
+        }
+        
+        /// Unregisters every network task and returns the `TaskInfo`s of the tasks sharing them
+        /// that haven't been canceled.
+        func removeAll() -> [TaskInfo] {
+            return inner.syncBarrier { inner -> [TaskInfo] in
+                let subscribers = inner.entries.values.flatMap({ $0.removeJoinedSubscribers().map(InFlightTable.taskInfo(for:)) })
+                inner.entries.removeAll()
+                return subscribers
+            }
+        }
+        
+        private let inner = QueueConfined(label: "PMHTTP session delegate in-flight request table", value: Inner())
+        
+        /// Only `TaskInfo`s join the network tasks in the table.
+        private static func taskInfo(for subscriber: SharedNetworkTaskSubscriber) -> TaskInfo {
+            return unsafeDowncast(subscriber, to: TaskInfo.self)
+        }
+        
+        private final class Inner {
+            var entries: [CoalescingKey: SharedNetworkTask] = [:]
+        }
     }
 }
 
@@ -1967,13 +2745,15 @@ extension HTTPManager {
     /// Creates and returns an `HTTPManagerTask`.
     /// - Parameter request: The request to create the task from.
     /// - Parameter uploadBody: The data to upload, if any.
+    /// - Parameter responseStream: (Optional) A stream to deliver the response body to as it's
+    ///   received. If provided, the processor is invoked with an empty body for streamed responses.
     /// - Parameter processor: The processing block. The `retry` parameter to the block is a closure that may be
     ///   executed to attempt to retry the task. If executed, the retry block will return `true` if the task could be
     ///   retried or `false` otherwise. If the task is not retried (or if retrying fails), the processor must arrange
     ///   for the task to transition to `.completed` (unless it's already been canceled).
     /// - Returns: An `HTTPManagerTask`.
     /// - Important: After creating the task, you must start it by calling the `resume()` method.
-    internal func createNetworkTaskWithRequest(_ request: HTTPManagerRequest, uploadBody: UploadBody?, processor: @escaping (HTTPManagerTask, HTTPManagerTaskResult<Data>, _ authToken: Any??, _ attempt: Int, _ retry: @escaping (_ reason: RetryReason) -> Bool) -> Void) -> HTTPManagerTask {
+    internal func createNetworkTaskWithRequest(_ request: HTTPManagerRequest, uploadBody: UploadBody?, responseStream: ResponseStream? = nil, processor: @escaping (HTTPManagerTask, HTTPManagerTaskResult<Data>, _ authToken: Any??, _ attempt: Int, _ retry: @escaping (_ reason: RetryReason) -> Bool) -> Void) -> HTTPManagerTask {
         var urlRequest = request._preparedURLRequest
         var uploadBody = uploadBody
         switch uploadBody {
@@ -1983,24 +2763,47 @@ extension HTTPManager {
         case .json(let json)? where request.serverRequiresContentLength:
             uploadBody = .data(JSON.encodeAsData(json))
         case .json?: break
-        case let .multipartMixed(boundary, parameters, bodyParts)? where request.serverRequiresContentLength:
-            uploadBody?.evaluatePending()
-            let stream = HTTPBody.createMultipartMixedStream(boundary, parameters: parameters, bodyParts: bodyParts)
-            stream.open()
-            do {
-                uploadBody = try .data(stream.readAll())
-            } catch {
-                // If we can't read it now (and it really shouldn't be able to fail anyway), just
-                // leave it as a streaming body, where it will presumably fail again and produce a
-                // URL error.
-            }
         case .multipartMixed?: break
         }
         uploadBody?.evaluatePending()
+        var bodyCompression = request.requestBodyCompression
+        var compressesUpload = false
+        if uploadBody == nil || urlRequest.value(forHTTPHeaderField: "Content-Encoding") != nil {
+            bodyCompression = .none
+        } else if case .data(let data)? = uploadBody, bodyCompression != .none {
+            if data.count < request.requestBodyCompressionThreshold {
+                // Short bodies are sent uncompressed.
+                bodyCompression = .none
+            } else if data.count >= HTTPManager.backgroundCompressionLength {
+                // Compressing this much data would block the calling thread, so it's done in the
+                // background. See compressUpload(for:request:).
+                compressesUpload = true
+            } else if let compressed = bodyCompression.compress(data) {
+                uploadBody = .data(compressed)
+            } else {
+                // Bodies zlib fails to compress, which only happens if it can't allocate its state,
+                // are sent uncompressed.
+                bodyCompression = .none
+            }
+        }
+        let multipartBody: MultipartBodyCache?
+        if case let .multipartMixed(boundary, parameters, bodyParts)? = uploadBody {
+            multipartBody = MultipartBodyCache(boundary: boundary, parameters: parameters, bodyParts: bodyParts)
+        } else {
+            multipartBody = nil
+        }
+        // The Content-Length of a multipart body isn't known until any pending body parts are
+        // ready and the body is compressed, so the network task is created once that's been done
+        // in the background. See prepareUpload(for:request:compressionThreshold:).
+        let preparesUpload = multipartBody != nil && request.serverRequiresContentLength
+        if let contentEncoding = bodyCompression.contentEncoding {
+            urlRequest.setValue(contentEncoding, forHTTPHeaderField: "Content-Encoding")
+        }
         // NB: We are evaluating the mock before adding the auth headers. If we ever add the ability
         // to conditionally mock a request depending on the evaluation of a block, we should
         // explicitly document this behavior.
-        if let mock = request.mock ?? mockManager.mockForRequest(urlRequest, environment: environment) {
+        let mock = request.mock ?? mockManager.mockForRequest(urlRequest, environment: environment)
+        if let mock = mock {
             // [SR-2804] We have to go through NSMutableURLRequest in order to set the protocol property
             let mutReq = { (x: NSURLRequest) in x as? NSMutableURLRequest ?? unsafeDowncast(x.mutableCopy() as AnyObject, to: NSMutableURLRequest.self) }(urlRequest as NSURLRequest)
             for (key, value) in request.urlProtocolProperties {
@@ -2012,32 +2815,296 @@ extension HTTPManager {
             request.applyURLProtocolProperties(to: &urlRequest)
         }
         let originalUrlRequest = urlRequest
+        // Requests whose auth information has already expired wait for it to be refreshed instead
+        // of going out with credentials the server will reject, so their network task is also
+        // created later. See prepareNetworkTask(for:request:waitsForAuth:preparesUpload:compressesUpload:compressionThreshold:).
+        let waitsForAuth = mock == nil && (request.auth as? HTTPRefreshableAuth)?.refreshIfExpired() == true
+        let defersNetworkTask = preparesUpload || compressesUpload || waitsForAuth
         request.auth?.applyHeaders(to: &urlRequest)
         let authToken = request.auth?.opaqueToken?(for: urlRequest)
-        let apiTask = inner.sync { inner -> HTTPManagerTask in
+        let snapshot = inner.snapshot
+        // Mocked requests don't touch the network, so there's nothing to schedule.
+        let requestScheduler = mock == nil ? snapshot.requestScheduler : nil
+        // Each task gets its own timeline, including tasks that are coalesced.
+        let latencyRecorder = snapshot.latencyRecorder
+        let coalescingKey: SessionDelegate.CoalescingKey?
+        if request.requestMethod == .GET && request.isIdempotent && uploadBody == nil && responseStream == nil
+            && mock == nil && !waitsForAuth && request.urlProtocolProperties.isEmpty && snapshot.coalescesIdenticalRequests
+        {
+            coalescingKey = SessionDelegate.CoalescingKey(request: urlRequest, followRedirects: request.shouldFollowRedirects, cacheStoragePolicy: request.defaultResponseCacheStoragePolicy)
+        } else {
+            coalescingKey = nil
+        }
+        let taskInfo = withSession(for: urlRequest.url, userInitiated: request.userInitiated) { session, sessionDelegate -> SessionDelegate.TaskInfo in
+            if let coalescingKey = coalescingKey,
+                let taskInfo = sessionDelegate.inFlightRequests.join(coalescingKey, makeTaskInfo: { sharedNetworkTask in
+                    let apiTask = HTTPManagerTask(networkTask: sharedNetworkTask.networkTask, request: request, sessionDelegateQueue: session.delegateQueue, sharedNetworkTask: sharedNetworkTask, requestScheduler: requestScheduler, latencyTimeline: latencyRecorder?.makeTimeline(for: originalUrlRequest))
+                    return SessionDelegate.TaskInfo(task: apiTask, uploadBody: nil, multipartBody: nil, bodyCompression: .none, originalRequest: originalUrlRequest, authToken: authToken, responseStream: nil, processor: processor)
+                })
+            {
+                return taskInfo
+            }
             let networkTask: URLSessionTask
             switch uploadBody {
+            case _ where defersNetworkTask:
+                // A placeholder that's never resumed, so it isn't registered in `tasks`.
+                networkTask = session.dataTask(with: urlRequest)
             case .data(let data)?:
-                networkTask = inner.session.uploadTask(with: urlRequest, from: data)
+                networkTask = session.uploadTask(with: urlRequest, from: data)
             case _?:
-                networkTask = inner.session.uploadTask(withStreamedRequest: urlRequest)
+                networkTask = session.uploadTask(withStreamedRequest: urlRequest)
             case nil:
-                networkTask = inner.session.dataTask(with: urlRequest)
+                networkTask = session.dataTask(with: urlRequest)
             }
-            let apiTask = HTTPManagerTask(networkTask: networkTask, request: request, sessionDelegateQueue: inner.session.delegateQueue)
-            let taskInfo = SessionDelegate.TaskInfo(task: apiTask, uploadBody: uploadBody, originalRequest: originalUrlRequest, authToken: authToken, processor: processor)
-            inner.session.delegateQueue.addOperation { [sessionDelegate=inner.sessionDelegate!] in
-                assert(sessionDelegate.tasks[networkTask.taskIdentifier] == nil, "internal HTTPManager error: tasks contains unknown taskInfo")
-                sessionDelegate.tasks[networkTask.taskIdentifier] = taskInfo
+            let sharedNetworkTask = coalescingKey.map({ _ in SharedNetworkTask(networkTask: networkTask) })
+            let apiTask = HTTPManagerTask(networkTask: networkTask, request: request, sessionDelegateQueue: session.delegateQueue, sharedNetworkTask: sharedNetworkTask, requestScheduler: requestScheduler, latencyTimeline: latencyRecorder?.makeTimeline(for: originalUrlRequest), defersNetworkTask: defersNetworkTask)
+            let taskInfo = SessionDelegate.TaskInfo(task: apiTask, uploadBody: uploadBody, multipartBody: multipartBody, bodyCompression: bodyCompression, originalRequest: originalUrlRequest, authToken: authToken, responseStream: responseStream, processor: processor)
+            taskInfo.coalescingKey = coalescingKey
+            if !defersNetworkTask {
+                sessionDelegate.tasks.insert(taskInfo, for: networkTask.taskIdentifier)
             }
-            return apiTask
+            if let coalescingKey = coalescingKey, let sharedNetworkTask = sharedNetworkTask {
+                sessionDelegate.inFlightRequests.insert(sharedNetworkTask, for: coalescingKey)
+            }
+            return taskInfo
         }
-        if apiTask.userInitiated {
-            apiTask.networkTask.priority = URLSessionTask.highPriority
+        let apiTask = taskInfo.task
+        setPriority(of: apiTask.networkTask, for: apiTask)
+        if defersNetworkTask {
+            prepareNetworkTask(for: taskInfo, request: urlRequest, waitsForAuth: waitsForAuth, preparesUpload: preparesUpload, compressesUpload: compressesUpload, compressionThreshold: request.requestBodyCompressionThreshold)
         }
         return apiTask
     }
     
+    /// The length of the shortest data body that's compressed in the background instead of on the
+    /// thread creating the task.
+    private static let backgroundCompressionLength = 64 * 1024
+    
+    /// Sets the priority of a network task to match the `HTTPManagerTask` it belongs to.
+    private func setPriority(of networkTask: URLSessionTask, for apiTask: HTTPManagerTask) {
+        switch apiTask.priority {
+        case .userInitiated:
+            networkTask.priority = URLSessionTask.highPriority
+        case .background:
+            networkTask.priority = URLSessionTask.lowPriority
+        case .normal:
+            break
+        }
+    }
+    
+    /// Replaces the placeholder network task of a task created with `defersNetworkTask`.
+    ///
+    /// - Parameter taskInfo: The `TaskInfo` of the task. It isn't registered in `tasks`, since its
+    ///   network task is a placeholder that's never resumed.
+    /// - Parameter request: The request the placeholder was created with, including auth headers.
+    /// - Parameter waitsForAuth: If `true`, the task's auth information has expired and is being
+    ///   refreshed, so the auth headers are recomputed once the refresh finishes.
+    /// - Parameter preparesUpload: If `true`, the task's multipart body is prepared with
+    ///   `prepareUpload(for:request:compressionThreshold:)` before the network task is created.
+    /// - Parameter compressesUpload: If `true`, the task's data body is compressed with
+    ///   `compressUpload(for:request:)` before the network task is created.
+    /// - Parameter compressionThreshold: The minimum body length to compress, if
+    ///   `taskInfo.bodyCompression` isn't `.none`.
+    private func prepareNetworkTask(for taskInfo: SessionDelegate.TaskInfo, request: URLRequest, waitsForAuth: Bool, preparesUpload: Bool, compressesUpload: Bool, compressionThreshold: Int) {
+        func prepare(_ manager: HTTPManager, _ taskInfo: SessionDelegate.TaskInfo, _ request: URLRequest) {
+            if preparesUpload {
+                manager.prepareUpload(for: taskInfo, request: request, compressionThreshold: compressionThreshold)
+            } else if compressesUpload {
+                manager.compressUpload(for: taskInfo, request: request)
+            } else {
+                manager.replacePlaceholderNetworkTask(for: taskInfo, request: request)
+            }
+        }
+        guard waitsForAuth, let auth = taskInfo.task.auth as? HTTPRefreshableAuth else {
+            prepare(self, taskInfo, request)
+            return
+        }
+        auth.notifyWhenRefreshed { [weak self] in
+            guard let strongSelf = self else {
+                HTTPManager.cancelTaskWithoutNetworkTask(taskInfo)
+                return
+            }
+            // The refresh may have failed, in which case this is the expired info again and the
+            // request is handled like any other 401 Unauthorized.
+            var request = taskInfo.originalRequest
+            auth.applyHeaders(to: &request)
+            let refreshedInfo = SessionDelegate.TaskInfo(task: taskInfo.task, uploadBody: taskInfo.uploadBody, multipartBody: taskInfo.multipartBody, bodyCompression: taskInfo.bodyCompression, originalRequest: taskInfo.originalRequest, authToken: auth.opaqueToken(for: request), responseStream: taskInfo.responseStream, processor: taskInfo.processor)
+            prepare(strongSelf, refreshedInfo, request)
+        }
+    }
+    
+    /// Prepares the body of a multipart upload whose `Content-Length` has to be computed first,
+    /// then replaces the task's placeholder network task.
+    ///
+    /// This waits on any pending body parts and serializes the body on a global queue, compressing
+    /// it into memory if necessary, so creating the task never blocks the calling thread. If the
+    /// body can't be compressed, the task fails with the compression error.
+    ///
+    /// - Parameter taskInfo: The `TaskInfo` of the task. It isn't registered in `tasks`, since its
+    ///   network task is a placeholder that's never resumed.
+    /// - Parameter request: The request the placeholder was created with, including auth headers.
+    /// - Parameter compressionThreshold: The minimum body length to compress, if
+    ///   `taskInfo.bodyCompression` isn't `.none`.
+    private func prepareUpload(for taskInfo: SessionDelegate.TaskInfo, request: URLRequest, compressionThreshold: Int) {
+        guard let multipartBody = taskInfo.multipartBody else { return }
+        let apiTask = taskInfo.task
+        multipartBody.async(apiTask.userInitiated ? .userInitiated : .utility) { [weak self] body in
+            var request = request
+            var originalRequest = taskInfo.originalRequest
+            var uploadBody = taskInfo.uploadBody
+            var bodyCompression = taskInfo.bodyCompression
+            func setValue(_ value: String?, forHTTPHeaderField field: String) {
+                request.setValue(value, forHTTPHeaderField: field)
+                originalRequest.setValue(value, forHTTPHeaderField: field)
+            }
+            if bodyCompression == .none || body.count < compressionThreshold {
+                if bodyCompression != .none {
+                    bodyCompression = .none
+                    setValue(nil, forHTTPHeaderField: "Content-Encoding")
+                }
+                // The length is known from the serialized segments, so the body can still be
+                // streamed instead of being read into memory.
+                setValue(String(body.count), forHTTPHeaderField: "Content-Length")
+            } else {
+                // The compressed length isn't known until the body is compressed.
+                let stream = bodyCompression.compressingStream(HTTPBody.createMultipartMixedStream(body))
+                stream.open()
+                do {
+                    uploadBody = try .data(stream.readAll())
+                } catch {
+                    // A streamed body wouldn't have the Content-Length the server requires.
+                    guard let strongSelf = self else {
+                        HTTPManager.cancelTaskWithoutNetworkTask(taskInfo)
+                        return
+                    }
+                    strongSelf.failPlaceholderNetworkTask(for: taskInfo, error: error)
+                    return
+                }
+            }
+            let preparedMultipartBody: MultipartBodyCache?
+            if case .data? = uploadBody {
+                preparedMultipartBody = nil
+            } else {
+                preparedMultipartBody = multipartBody
+            }
+            let preparedInfo = SessionDelegate.TaskInfo(task: apiTask, uploadBody: uploadBody, multipartBody: preparedMultipartBody, bodyCompression: bodyCompression, originalRequest: originalRequest, authToken: taskInfo.authToken, responseStream: taskInfo.responseStream, processor: taskInfo.processor)
+            guard let strongSelf = self else {
+                HTTPManager.cancelTaskWithoutNetworkTask(taskInfo)
+                return
+            }
+            strongSelf.replacePlaceholderNetworkTask(for: preparedInfo, request: request)
+        }
+    }
+    
+    /// Compresses the data body of an upload on a global queue, then replaces the task's placeholder
+    /// network task.
+    ///
+    /// - Parameter taskInfo: The `TaskInfo` of the task. It isn't registered in `tasks`, since its
+    ///   network task is a placeholder that's never resumed.
+    /// - Parameter request: The request the placeholder was created with, including auth headers.
+    private func compressUpload(for taskInfo: SessionDelegate.TaskInfo, request: URLRequest) {
+        guard case .data(let data)? = taskInfo.uploadBody else { return }
+        let apiTask = taskInfo.task
+        DispatchQueue.global(qos: apiTask.userInitiated ? .userInitiated : .utility).async { [weak self] in
+            var request = request
+            var originalRequest = taskInfo.originalRequest
+            var uploadBody = taskInfo.uploadBody
+            var bodyCompression = taskInfo.bodyCompression
+            if let compressed = autoreleasepool(invoking: { bodyCompression.compress(data) }) {
+                uploadBody = .data(compressed)
+            } else {
+                // Bodies zlib fails to compress, which only happens if it can't allocate its state,
+                // are sent uncompressed.
+                bodyCompression = .none
+                request.setValue(nil, forHTTPHeaderField: "Content-Encoding")
+                originalRequest.setValue(nil, forHTTPHeaderField: "Content-Encoding")
+            }
+            let preparedInfo = SessionDelegate.TaskInfo(task: apiTask, uploadBody: uploadBody, multipartBody: nil, bodyCompression: bodyCompression, originalRequest: originalRequest, authToken: taskInfo.authToken, responseStream: taskInfo.responseStream, processor: taskInfo.processor)
+            guard let strongSelf = self else {
+                HTTPManager.cancelTaskWithoutNetworkTask(taskInfo)
+                return
+            }
+            strongSelf.replacePlaceholderNetworkTask(for: preparedInfo, request: request)
+        }
+    }
+    
+    /// Creates the network task for a task created with `defersNetworkTask`, once its request and
+    /// upload body are final.
+    ///
+    /// The new network task is swapped in on the session delegate queue, which means a `cancel()`
+    /// that races with the swap still finds it in `tasks`. It's started right away if `resume()`
+    /// was already called.
+    private func replacePlaceholderNetworkTask(for taskInfo: SessionDelegate.TaskInfo, request: URLRequest) {
+        let apiTask = taskInfo.task
+        withSession(for: request.url, userInitiated: apiTask.userInitiated) { session, sessionDelegate in
+            let networkTask: URLSessionTask
+            switch taskInfo.uploadBody {
+            case .data(let data)?:
+                networkTask = session.uploadTask(with: request, from: data)
+            case _?:
+                networkTask = session.uploadTask(withStreamedRequest: request)
+            case nil:
+                networkTask = session.dataTask(with: request)
+            }
+            setPriority(of: networkTask, for: apiTask)
+            session.delegateQueue.addOperation {
+                let placeholder = apiTask.networkTask
+                let result = apiTask.resetStateToRunning(with: networkTask)
+                if !result.ok {
+                    // The task was canceled before its network task was created, which canceled
+                    // the untracked placeholder, so the cancellation is reported here instead.
+                    assert(result.oldState == .canceled, "internal HTTPManager error: task left Running before its network task was created")
+                    networkTask.cancel()
+                    apiTask.clearTrackingNetworkActivity()
+                    taskInfo.processCancellation()
+                    return
+                }
+                sessionDelegate.tasks.insert(taskInfo, for: networkTask.taskIdentifier)
+                placeholder.cancel()
+                if apiTask.state == .canceled {
+                    // cancel() ran between the swap and now and may have canceled the placeholder instead.
+                    networkTask.cancel()
+                }
+                apiTask.finishNetworkTaskPreparation()
+            }
+        }
+    }
+    
+    /// Fails a task created with `defersNetworkTask` whose upload body couldn't be prepared,
+    /// without creating its network task.
+    private func failPlaceholderNetworkTask(for taskInfo: SessionDelegate.TaskInfo, error: Error) {
+        let apiTask = taskInfo.task
+        withSession(for: taskInfo.originalRequest.url, userInitiated: apiTask.userInitiated) { session, _ in
+            // The state only leaves Running on the session delegate queue, which is also where
+            // resume() updates the activity indicator.
+            session.delegateQueue.addOperation {
+                let result = apiTask.transitionState(to: .processing)
+                apiTask.clearTrackingNetworkActivity()
+                apiTask.networkTask.cancel()
+                guard result.ok else {
+                    // The task was canceled while its body was being prepared, which canceled the
+                    // untracked placeholder, so the cancellation is reported here instead.
+                    assert(result.oldState == .canceled, "internal HTTPManager error: task left Running before its network task was created")
+                    taskInfo.processCancellation()
+                    return
+                }
+                DispatchQueue.global(qos: apiTask.userInitiated ? .userInitiated : .utility).async {
+                    autoreleasepool {
+                        taskInfo.processor(apiTask, .error(nil, error), .some(taskInfo.authToken), taskInfo.attempt, { _ in false })
+                    }
+                }
+            }
+        }
+    }
+    
+    /// Reports the cancellation of a task created with `defersNetworkTask` whose network task
+    /// can't be created because the manager is gone along with its sessions.
+    private static func cancelTaskWithoutNetworkTask(_ taskInfo: SessionDelegate.TaskInfo) {
+        if taskInfo.task._cancel() {
+            taskInfo.processor(taskInfo.task, .canceled, nil, taskInfo.attempt, { _ in false })
+        }
+    }
+    
     /// The reason for retrying a task.
     internal enum RetryReason: Comparable {
         /// The retry was requested by the configured retry behavior.
@@ -2066,51 +3133,52 @@ extension HTTPManager {
     /// network task, but it does not attempt to remove any existing entry for the
     /// old task. The caller is responsible for removing the old entry.
     ///
-    /// The newly-created `URLSessionTask` is automatically resumed.
+    /// The newly-created `URLSessionTask` is automatically resumed, or submitted to the task's
+    /// `requestScheduler` if it has one.
     ///
     /// - Parameter taskInfo: The `TaskInfo` object representing the task to retry.
     /// - Parameter reason: The reason for retrying the task.
     /// - Returns: `true` if the task is retrying, or `false` if it could not be retried
-    ///   (e.g. because it's already been canceled).
+    ///   (e.g. because it's already been canceled, or `retryBudget` is exhausted).
     fileprivate func retryNetworkTask(_ taskInfo: SessionDelegate.TaskInfo, reason: RetryReason) -> Bool {
+        // The token is returned below if the task turns out to have been canceled, so it's only
+        // spent on retries that actually happen.
+        let retryBudget = reason == .normal ? inner.snapshot.retryBudget : nil
+        if let retryBudget = retryBudget, !retryBudget.consumeToken(forHost: taskInfo.originalRequest.url?.host) {
+            return false
+        }
         var request = taskInfo.originalRequest
         taskInfo.task.auth?.applyHeaders(to: &request)
-        let networkTask = inner.sync { inner -> URLSessionTask? in
+        let networkTask = withSession(for: request.url, userInitiated: taskInfo.task.userInitiated) { session, sessionDelegate -> URLSessionTask? in
             let networkTask: URLSessionTask
             switch taskInfo.uploadBody {
             case .data(let data)?:
-                networkTask = inner.session.uploadTask(with: request, from: data)
+                networkTask = session.uploadTask(with: request, from: data)
             case _?:
-                networkTask = inner.session.uploadTask(withStreamedRequest: request)
+                networkTask = session.uploadTask(withStreamedRequest: request)
             case nil:
-                networkTask = inner.session.dataTask(with: request)
+                networkTask = session.dataTask(with: request)
             }
             networkTask.priority = taskInfo.task.networkTask.priority
             let result = taskInfo.task.resetStateToRunning(with: networkTask)
             if !result.ok {
                 assert(result.oldState == .canceled, "internal HTTPManager error: could not reset non-canceled task back to Running state")
                 networkTask.cancel()
+                retryBudget?.refundToken(forHost: taskInfo.originalRequest.url?.host)
                 return nil
             }
-            var taskInfo = taskInfo
-            switch reason {
-            case .normal:
-                taskInfo.attempt += 1
-            case .unauthorized, .forbidden:
-                taskInfo.attempt = 0
-            }
-            taskInfo.highestRetryReason = max(taskInfo.highestRetryReason ?? .normal, reason)
-            inner.session.delegateQueue.addOperation { [sessionDelegate=inner.sessionDelegate!] in
-                assert(sessionDelegate.tasks[networkTask.taskIdentifier] == nil, "internal HTTPManager error: tasks contains unknown taskInfo")
-                sessionDelegate.tasks[networkTask.taskIdentifier] = taskInfo
-            }
+            sessionDelegate.tasks.insert(SessionDelegate.TaskInfo(retrying: taskInfo, reason: reason), for: networkTask.taskIdentifier)
             return networkTask
         }
         if let networkTask = networkTask {
             if taskInfo.task.affectsNetworkActivityIndicator {
                 taskInfo.task.setTrackingNetworkActivity()
             }
-            networkTask.resume()
+            if let requestScheduler = taskInfo.task.requestScheduler {
+                requestScheduler.submit(taskInfo.task, networkTask: networkTask)
+            } else {
+                taskInfo.task.startNetworkTask(networkTask)
+            }
             return true
         } else {
             return false
@@ -2133,13 +3201,14 @@ extension SessionDelegate: URLSessionDataDelegate {
     @objc func urlSession(_ session: URLSession, didBecomeInvalidWithError error: Error?) {
         log("didBecomeInvalidWithError: \(error.map(String.init(describing:)) ?? "nil")")
         apiManager?.inner.asyncBarrier { inner in
-            if let idx = inner.oldSessions.index(where: { $0 === self }) {
+            if let idx = inner.oldSessions.index(where: { $0 === session }) {
                 inner.oldSessions.remove(at: idx)
             }
         }
         // Any tasks in our tasks array must have been created but not resumed.
-        for taskInfo in tasks.values {
+        for taskInfo in tasks.removeAll() + inFlightRequests.removeAll() {
             log("canceling zombie task \(taskInfo.task)")
+            taskInfo.task.requestScheduler?.finish(taskInfo.task.networkTask)
             taskInfo.task.clearTrackingNetworkActivity()
             if taskInfo.task._cancel() {
                 let queue = DispatchQueue.global(qos: taskInfo.task.userInitiated ? .userInitiated : .utility)
@@ -2150,7 +3219,6 @@ extension SessionDelegate: URLSessionDataDelegate {
                 }
             }
         }
-        tasks.removeAll()
     }
     
     @objc func urlSession(_ session: URLSession, didReceive challenge: URLAuthenticationChallenge, completionHandler: @escaping (URLSession.AuthChallengeDisposition, URLCredential?) -> Void) {
@@ -2163,27 +3231,29 @@ extension SessionDelegate: URLSessionDataDelegate {
     }
     
     @objc func urlSession(_ session: URLSession, dataTask: URLSessionDataTask, didReceive response: URLResponse, completionHandler: @escaping (URLSession.ResponseDisposition) -> Void) {
-        guard var taskInfo = tasks[dataTask.taskIdentifier] else {
+        guard let taskInfo = tasks[dataTask.taskIdentifier] else {
             log("didReceiveResponse; ignoring, task \(dataTask) not tracked")
             completionHandler(.cancel)
             return
         }
         assert(taskInfo.task.networkTask === dataTask, "internal HTTPManager error: taskInfo out of sync")
         log("didReceiveResponse for task \(dataTask)")
-        if taskInfo.data != nil {
-            taskInfo.data = nil
-            tasks[dataTask.taskIdentifier] = taskInfo
-        }
+        taskInfo.isStreaming = taskInfo.responseStream?.begin(response) ?? false
+        taskInfo.data = nil
         completionHandler(.allow)
     }
     
     @objc func urlSession(_ session: URLSession, dataTask: URLSessionDataTask, didReceive data: Data) {
-        guard var taskInfo = tasks[dataTask.taskIdentifier] else {
+        guard let taskInfo = tasks[dataTask.taskIdentifier] else {
             log("didReceiveData; ignoring, task \(dataTask) not tracked")
             return
         }
         assert(taskInfo.task.networkTask === dataTask, "internal HTTPManager error: taskInfo out of sync")
         log("didReceiveData for task \(dataTask)")
+        if taskInfo.isStreaming, let responseStream = taskInfo.responseStream {
+            responseStream.append(data, for: dataTask)
+            return
+        }
         let taskData: NSMutableData
         if let data = taskInfo.data {
             taskData = data
@@ -2196,7 +3266,6 @@ extension SessionDelegate: URLSessionDataDelegate {
                 taskData = NSMutableData(capacity: Int(min(length, 10*1024*1024))) ?? NSMutableData()
             }
             taskInfo.data = taskData
-            tasks[dataTask.taskIdentifier] = taskInfo
         }
         taskData.append(data)
     }
@@ -2212,21 +3281,63 @@ extension SessionDelegate: URLSessionDataDelegate {
             log("task:didCompleteWithError; ignoring, task \(task) not tracked")
             return
         }
+        // Let the next waiting task for the host start as soon as possible.
+        taskInfo.task.requestScheduler?.finish(task)
+        // Identical requests that were coalesced into this one complete along with it and share its
+        // response body.
+        let subscribers: [TaskInfo]
+        if let coalescingKey = taskInfo.coalescingKey, let sharedNetworkTask = taskInfo.task.sharedNetworkTask {
+            subscribers = [taskInfo] + inFlightRequests.removeValue(forKey: coalescingKey, sharedNetworkTask: sharedNetworkTask)
+        } else {
+            subscribers = [taskInfo]
+        }
+        let sharedData: Data? = subscribers.count > 1 ? (taskInfo.data as Data? ?? Data()) : nil
+        // Record the network load once, no matter how many tasks shared it. Check for a recorder
+        // first. It's a single atomic load, so tasks pay nothing else when recording is off.
+        if let recorder = apiManager?.mockManager.recorder, error == nil, taskInfo.responseStream == nil,
+            let response = task.response as? HTTPURLResponse,
+            URLProtocol.property(forKey: HTTPMockURLProtocol.requestProperty, in: taskInfo.originalRequest) == nil
+        {
+            recorder.record(taskInfo.originalRequest, response: response, body: sharedData ?? taskInfo.data as Data? ?? Data(),
+                            startTime: taskInfo.task.networkStartTime, endTime: DispatchTime.now().uptimeNanoseconds)
+        }
+        for subscriber in subscribers {
+            complete(subscriber, for: task, error: error, data: sharedData)
+        }
+    }
+    
+    /// Finishes the networking portion of a task and dispatches its processor.
+    ///
+    /// - Parameter data: The response body, if `taskInfo` shares its network task with other
+    ///   tasks. Otherwise the body is read from `taskInfo`.
+    private func complete(_ taskInfo: TaskInfo, for task: URLSessionTask, error: Error?, data: Data?) {
         let apiTask = taskInfo.task
         assert(apiTask.networkTask === task, "internal HTTPManager error: taskInfo out of sync")
         log("task:didCompleteWithError for task \(task), error: \(error.map(String.init(describing:)) ?? "nil")")
+        apiTask.latencyTimeline?.networkFinished()
         let processor = taskInfo.processor
+        // If the stream handler threw an error, the resulting cancellation should report that error.
+        let error = taskInfo.responseStream?.error ?? error
         
         apiTask.clearTrackingNetworkActivity()
         
         let queue = DispatchQueue.global(qos: apiTask.userInitiated ? .userInitiated : .utility)
+        // Runs the block on `queue` once any streamed body has been fully delivered.
+        func dispatch(_ block: @escaping () -> Void) {
+            if let responseStream = taskInfo.responseStream {
+                responseStream.notify(queue: queue, execute: block)
+            } else {
+                queue.async(execute: block)
+            }
+        }
         if let error = error as? URLError, error.code == .cancelled {
             // Either we canceled during the networking portion, or someone called
             // cancel() on the URLSessionTask directly. In the latter case, treat it
             // as a cancellation anyway.
             let result = apiTask.transitionState(to: .canceled)
             assert(result.ok, "internal HTTPManager error: tried to cancel task that's already completed")
-            queue.async {
+            taskInfo.responseStream?.cancel()
+            dispatch {
                 autoreleasepool {
                     processor(apiTask, .canceled, nil, taskInfo.attempt, { _ in false })
                 }
@@ -2235,7 +3346,7 @@ extension SessionDelegate: URLSessionDataDelegate {
             let result = apiTask.transitionState(to: .processing)
             if result.ok {
                 assert(result.oldState == .running, "internal HTTPManager error: tried to process task that's already processing")
-                queue.async { [weak apiManager] in
+                dispatch { [weak apiManager] in
                     func retry(reason: HTTPManager.RetryReason) -> Bool {
                         return apiManager?.retryNetworkTask(taskInfo, reason: reason) ?? false
                     }
@@ -2253,7 +3364,7 @@ extension SessionDelegate: URLSessionDataDelegate {
                         if let error = error {
                             processor(apiTask, .error(task.response, error), authToken, taskInfo.attempt, retry)
                         } else if let response = task.response {
-                            processor(apiTask, .success(response, taskInfo.data as Data? ?? Data()), authToken, taskInfo.attempt, retry)
+                            processor(apiTask, .success(response, data ?? taskInfo.data as Data? ?? Data()), authToken, taskInfo.attempt, retry)
                         } else {
                             // this should be unreachable
                             let userInfo = [NSLocalizedDescriptionKey: "internal error: task response was nil with no error"]
@@ -2264,7 +3375,8 @@ extension SessionDelegate: URLSessionDataDelegate {
             } else {
                 assert(result.oldState == .canceled, "internal HTTPManager error: tried to process task that's already completed")
                 // We must have canceled concurrently with the networking portion finishing
-                queue.async {
+                taskInfo.responseStream?.cancel()
+                dispatch {
                     autoreleasepool {
                         processor(apiTask, .canceled, nil, taskInfo.attempt, { _ in return false })
                     }
@@ -2357,33 +3469,22 @@ extension SessionDelegate: URLSessionDataDelegate {
                     self.log("providing stream for JSON")
                 #endif
                 autoreleasepool {
-                    completionHandler(InputStream(data: JSON.encodeAsData(json)))
+                    // The Content-Encoding header is already set, so this goes through the
+                    // compressing stream, which fails the upload if zlib does.
+                    completionHandler(taskInfo.bodyCompression.compressingStream(InputStream(data: JSON.encodeAsData(json))))
                 }
             }
-        case let .multipartMixed(boundary, parameters, bodyParts)?:
-            if bodyParts.contains(where: { if case .pending = $0 { return true } else { return false } }) {
-                // We have at least one Pending value, we need to wait for them to evaluate
-                // (otherwise we might block the network thread) so we'll do it asynchronously.
-                let group = DispatchGroup()
-                let qos: DispatchQoS = taskInfo.task.userInitiated ? .userInitiated : .utility
-                for case .pending(let deferred) in bodyParts {
-                    group.enter()
-                    deferred.async(qos) { _ in
-                        group.leave()
-                    }
-                }
-                log("delaying until body parts have been evaluated")
-                group.notify(queue: DispatchQueue.global(qos: qos.qosClass)) {
-                    // All our Pending values have been evaluated.
-                    #if enableDebugLogging
-                        self.log("providing stream for MultipartMixed")
-                    #endif
-                    completionHandler(HTTPBody.createMultipartMixedStream(boundary, parameters: parameters, bodyParts: bodyParts))
-                }
-            } else {
-                // All our values have been evaluated already, no need to wait.
-                log("providing stream for MultipartMixed")
-                completionHandler(HTTPBody.createMultipartMixedStream(boundary, parameters: parameters, bodyParts: bodyParts))
+        case .multipartMixed?:
+            guard let multipartBody = taskInfo.multipartBody else {
+                assertionFailure("internal HTTPManager error: multipart upload has no serialized body")
+                completionHandler(nil)
+                return
+            }
+            // The body is serialized once, off the delegate queue, and shared by every attempt,
+            // so retries and redirects don't rebuild it.
+            log("providing stream for MultipartMixed")
+            multipartBody.async(taskInfo.task.userInitiated ? .userInitiated : .utility) { body in
+                completionHandler(taskInfo.bodyCompression.compressingStream(HTTPBody.createMultipartMixedStream(body)))
             }
         case nil:
             self.log("no uploadBody, providing no stream")
@@ -2403,6 +3504,9 @@ extension MetricsSessionDelegate {
         let apiTask = taskInfo.task
         assert(apiTask.networkTask === task, "internal HTTPManager error: taskInfo out of sync")
         log("task:didFinishCollecting for task \(task)")
+        if let connectionInfo = HTTPManagerTaskConnectionInfo(metrics: metrics) {
+            apiTask.setConnectionInfo(connectionInfo)
+        }
         if let operationQueue = metricsCallback.queue {
             operationQueue.addOperation { [callback=metricsCallback.handler] in
                 callback(apiTask, task, metrics)
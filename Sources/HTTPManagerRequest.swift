@@ -149,6 +149,17 @@ public class HTTPManagerRequest: NSObject, NSCopying {
     /// Set this to `true` to increase the priority. Default is `false`.
     @objc public var userInitiated: Bool = false
     
+    /// The priority of the request relative to other requests for the same host. Default is
+    /// `.normal`.
+    ///
+    /// If `HTTPManager.requestScheduler` is set, this determines the order in which waiting
+    /// requests start. A `.background` request also asks `URLSession` to give its network task a
+    /// low priority. If `userInitiated` is `true`, the request is treated as `.userInitiated`
+    /// regardless of this property.
+    ///
+    /// - SeeAlso: `HTTPManagerRequestScheduler`.
+    @objc public var priority: HTTPManagerRequestPriority = .normal
+    
     /// The retry behavior to use for the request. Default is the value of
     /// `HTTPManager.defaultRetryBehavior` for requests in the current environment, otherwise `nil`.
     ///
@@ -169,14 +180,50 @@ public class HTTPManagerRequest: NSObject, NSCopying {
     /// If `true`, assume the server requires the `Content-Length` header for uploads. The default
     /// value is `false`.
     ///
-    /// Setting this to `true` forces JSON and multipart/mixed uploads to be encoded synchronously
-    /// when the request is performed rather than happening in the background.
+    /// Setting this to `true` forces JSON uploads to be encoded synchronously when the request is
+    /// performed rather than happening in the background. Multipart/mixed uploads are still
+    /// encoded in the background, but their network task isn't created until the body is ready,
+    /// so `HTTPManagerTask.networkTask` is replaced once it is.
     ///
     /// The default value is provided by `HTTPManager.defaultServerRequiresContentLength`.
     ///
     /// - SeeAlso: `HTTPManager.defaultServerRequiresContentLength`.
     @objc public var serverRequiresContentLength: Bool = false
     
+    /// If `true`, assume the server supports HTTP/3, so the request can use HTTP/3 without first
+    /// discovering support over an HTTP/2 or HTTP/1.1 connection. The default value is `false`.
+    ///
+    /// This only has an effect on iOS 14.5, macOS 11.3, tvOS 14.5, watchOS 7.4 and later, and only
+    /// when PMHTTP is built with Swift 5.4 or later. It's ignored elsewhere.
+    ///
+    /// The default value is provided by `HTTPManager.defaultAssumesHTTP3Capable`.
+    ///
+    /// - SeeAlso: `HTTPManager.defaultAssumesHTTP3Capable`.
+    @objc public var assumesHTTP3Capable: Bool = false
+    
+    /// The content coding used to compress upload bodies. The default value is `.none`.
+    ///
+    /// When set, the body is compressed and sent with a `Content-Encoding` header, provided the
+    /// server is known to accept compressed request bodies. Bodies that are sent as a single
+    /// `Data`, which includes form uploads and, if `serverRequiresContentLength` is `true`, JSON
+    /// and multipart/mixed uploads, are compressed once before they're sent, but only if they're at
+    /// least `requestBodyCompressionThreshold` bytes long. Streamed bodies are
+    /// compressed as they're read and are always compressed, as their length isn't known when the
+    /// headers are sent.
+    ///
+    /// Bodies are left alone if `headerFields` already contains `Content-Encoding`.
+    /// `preparedURLRequest` always contains the uncompressed body.
+    ///
+    /// - SeeAlso: `requestBodyCompressionThreshold`.
+    @objc public var requestBodyCompression: HTTPManagerRequestBodyCompression = .none
+    
+    /// The minimum length in bytes of an upload body that's compressed according to
+    /// `requestBodyCompression`. The default value is 1024.
+    ///
+    /// Bodies shorter than this are sent uncompressed, as compression saves little and may even
+    /// make them larger. This doesn't apply to streamed bodies.
+    @objc public var requestBodyCompressionThreshold: Int = 1024
+    
     /// Whether tasks created from this request should affect the visiblity of the
     /// network activity indicator. Default is `true`.
     ///
@@ -255,7 +302,8 @@ public class HTTPManagerRequest: NSObject, NSCopying {
     
     internal let apiManager: HTTPManager
     
-    internal let baseURL: URL
+    /// Only reassigned by `HTTPManagerRequestTemplate`, on a freshly-copied request.
+    internal var baseURL: URL
     
     internal var urlProtocolProperties: [String: Any] = [:]
     
@@ -277,9 +325,13 @@ public class HTTPManagerRequest: NSObject, NSCopying {
         mainDocumentURL = request.mainDocumentURL
         httpShouldHandleCookies = request.httpShouldHandleCookies
         userInitiated = request.userInitiated
+        priority = request.priority
         retryBehavior = request.retryBehavior
         assumeErrorsAreJSON = request.assumeErrorsAreJSON
         serverRequiresContentLength = request.serverRequiresContentLength
+        assumesHTTP3Capable = request.assumesHTTP3Capable
+        requestBodyCompression = request.requestBodyCompression
+        requestBodyCompressionThreshold = request.requestBodyCompressionThreshold
         mock = request.mock
         affectsNetworkActivityIndicator = request.affectsNetworkActivityIndicator
         headerFields = request.headerFields
@@ -301,6 +353,13 @@ public class HTTPManagerRequest: NSObject, NSCopying {
             request.mainDocumentURL = url
         }
         request.httpShouldHandleCookies = httpShouldHandleCookies
+        #if swift(>=4.1.9) // Swift 4.2+ compiler, required for compiler()
+        #if compiler(>=5.4) // URLRequest.assumesHTTP3Capable needs the iOS 14.5 SDK
+        if #available(iOS 14.5, macOS 11.3, tvOS 14.5, watchOS 7.4, *) {
+            request.assumesHTTP3Capable = assumesHTTP3Capable
+        }
+        #endif
+        #endif
         request.allHTTPHeaderFields = headerFields.dictionary
         let contentType = self.contentType
         if contentType.isEmpty {
@@ -490,6 +549,66 @@ extension HTTPManagerRequest {
         /// Known acronyms are preserved in uppercase. Invalid characters are replaced
         /// with `_`.
         public static func normalizedHTTPHeaderField(_ field: String) -> String {
+            // Most fields are either already normalized or are common fields in a different case,
+            // and neither of those needs to allocate.
+            if isNormalizedHTTPHeaderField(field) {
+                return field
+            } else if let normalized = commonHTTPHeaderFields[CaseInsensitiveASCIIString(field)] {
+                return normalized
+            } else {
+                return slowNormalizedHTTPHeaderField(field)
+            }
+        }
+        
+        /// Returns `true` if `field` is known to be unchanged by normalization.
+        ///
+        /// This makes a single pass over the UTF-8 bytes and only accepts components that are
+        /// either a known acronym or an ASCII word in titlecase. Anything else returns `false`,
+        /// even if normalization wouldn't change it.
+        internal static func isNormalizedHTTPHeaderField(_ field: String) -> Bool {
+            // The first 4 bytes of the current component, to check for acronyms.
+            var prefix: UInt32 = 0
+            var length = 0
+            var isTitlecase = true
+            func isComponentNormalized() -> Bool {
+                if length <= 4 {
+                    switch prefix {
+                    case 0x575757, 0x45546167, 0x4d4435, 0x5445, 0x444e49: // WWW, ETag, MD5, TE, DNI
+                        return true
+                    default:
+                        // Any other spelling of an acronym, such as Www, isn't normalized.
+                        let mask: UInt32 = length == 4 ? ~0 : (1 << UInt32(length * 8)) - 1
+                        switch prefix | (0x20202020 & mask) {
+                        case 0x777777, 0x65746167, 0x6d6435, 0x7465, 0x646e69: return false // www, etag, md5, te, dni
+                        default: break
+                        }
+                    }
+                }
+                return isTitlecase
+            }
+            for c in field.utf8 {
+                if c == 0x2d { // -
+                    guard isComponentNormalized() else { return false }
+                    (prefix, length, isTitlecase) = (0, 0, true)
+                    continue
+                }
+                if length < 4 {
+                    prefix = prefix << 8 | UInt32(c)
+                }
+                if isTitlecase {
+                    switch c {
+                    case 0x41...0x5a: isTitlecase = length == 0 // A-Z
+                    case 0x61...0x7a: isTitlecase = length != 0 // a-z
+                    default: isTitlecase = false
+                    }
+                }
+                length += 1
+            }
+            return isComponentNormalized()
+        }
+        
+        /// Normalizes an HTTP header field without taking any shortcuts.
+        internal static func slowNormalizedHTTPHeaderField(_ field: String) -> String {
             func normalizeComponent(_ comp: String) -> String {
                 if comp.caseInsensitiveCompare("WWW") == .orderedSame {
                     return "WWW"
@@ -528,6 +647,24 @@ extension HTTPManagerRequest {
             return field.components(separatedBy: "-").lazy.map(normalizeComponent).joined(separator: "-")
         }
         
+        /// The normalized spellings of common header fields, keyed case-insensitively.
+        private static let commonHTTPHeaderFields: [CaseInsensitiveASCIIString: String] = {
+            let fields = ["Accept", "Accept-Charset", "Accept-Encoding", "Accept-Language", "Accept-Ranges", "Age",
+                          "Allow", "Authorization", "Cache-Control", "Connection", "Content-Disposition",
+                          "Content-Encoding", "Content-Language", "Content-Length", "Content-Location", "Content-MD5",
+                          "Content-Range", "Content-Type", "Cookie", "Date", "ETag", "Expect", "Expires", "Host",
+                          "If-Match", "If-Modified-Since", "If-None-Match", "If-Range", "If-Unmodified-Since",
+                          "Keep-Alive", "Last-Modified", "Link", "Location", "Origin", "Pragma", "Range", "Referer",
+                          "Retry-After", "Server", "Set-Cookie", "TE", "Trailer", "Transfer-Encoding", "Upgrade",
+                          "User-Agent", "Vary", "Via", "Warning", "WWW-Authenticate", "X-Requested-With"]
+            var result = [CaseInsensitiveASCIIString: String](minimumCapacity: fields.count)
+            for field in fields {
+                // Run them through the slow path so the table can't disagree with it.
+                result[CaseInsensitiveASCIIString(field)] = slowNormalizedHTTPHeaderField(field)
+            }
+            return result
+        }()
+        
         public static func ==(lhs: HTTPHeaders, rhs: HTTPHeaders) -> Bool {
             return lhs.dictionary == rhs.dictionary
         }
@@ -609,6 +746,69 @@ public class HTTPManagerNetworkRequest: HTTPManagerRequest, HTTPManagerRequestPe
         return HTTPManagerParseRequest(request: self, uploadBody: uploadBody, parseHandler: handler)
     }
     
+    /// Returns a new request that writes the response body to a file as it's received.
+    ///
+    /// The task's result is the contents of the file mapped into memory, so large bodies never need
+    /// to be held on the heap. Error responses are accumulated as usual so they can produce the
+    /// normal `HTTPManagerError` values.
+    ///
+    /// - Parameter destinationURL: (Optional) The file URL to write the body to. Any existing file
+    ///   at this location is replaced. The default value of `nil` writes the body to a temporary
+    ///   file that's removed once it has been mapped.
+    /// - Returns: An `HTTPManagerDownloadRequest`.
+    /// - Note: If the server responds with 204 No Content, the result is an empty data.
+    @nonobjc public func download(to destinationURL: URL? = nil) -> HTTPManagerDownloadRequest<Data> {
+        return HTTPManagerDownloadRequest(request: self, uploadBody: uploadBody, destinationURL: destinationURL, parseHandler: { $1 })
+    }
+    
+    /// Returns a new request that writes the response body to a file as it's received, and then
+    /// parses the memory-mapped file with the specified handler.
+    ///
+    /// - Parameter destinationURL: (Optional) The file URL to write the body to. Any existing file
+    ///   at this location is replaced. The default value of `nil` writes the body to a temporary
+    ///   file that's removed once it has been mapped.
+    /// - Parameter handler: The handler to call as part of the request processing. This handler is
+    ///   not guaranteed to be called on any particular thread. The data passed to the handler is
+    ///   backed by the mapped file. The handler returns the new value for the request.
+    /// - Returns: An `HTTPManagerDownloadRequest`.
+    /// - Note: If the server responds with 204 No Content, the parse handler is invoked with an
+    ///   empty data.
+    /// - Warning: The download request inherits the `isIdempotent` value of `self`. If the parse
+    ///   handler has side effects and can throw, you should either ensure that it's safe to run the
+    ///   parse handler again or set `isIdempotent` to `false`.
+    @nonobjc public func download<T>(to destinationURL: URL? = nil, using handler: @escaping (_ response: URLResponse, _ data: Data) throws -> T) -> HTTPManagerDownloadRequest<T> {
+        return HTTPManagerDownloadRequest(request: self, uploadBody: uploadBody, destinationURL: destinationURL, parseHandler: handler)
+    }
+    
+    /// Returns a new request that passes the response body to the specified handler as it's
+    /// received, instead of accumulating the whole body in memory.
+    ///
+    /// The handler is invoked once for each chunk of the body, in order. Chunks are buffered while
+    /// the handler is running, and if more than `maximumBufferedBytes` are waiting to be delivered
+    /// the network transfer is paused until the handler catches up.
+    ///
+    /// Only the body of a successful response is streamed. Non-2xx responses, redirects, and 204
+    /// No Content responses are accumulated as usual, and the task completes with the same errors
+    /// that a parse request would produce.
+    ///
+    /// - Parameter maximumBufferedBytes: The maximum number of received bytes that may be waiting on
+    ///   the handler before the transfer is paused. Defaults to 1MB.
+    /// - Parameter handler: The handler to call with each chunk of the response body. This handler
+    ///   is not guaranteed to be called on any particular thread, but invocations are serialized.
+    ///   If the handler throws an error, the transfer is canceled and the task completes with that
+    ///   error.
+    /// - Returns: An `HTTPManagerStreamRequest`.
+    /// - Note: Once the handler has been invoked, the task will not be retried, as doing so would
+    ///   replay the body from the beginning.
+    /// - Warning: If the request is canceled, chunks that were received but not yet delivered are
+    ///   discarded. Any side-effects performed by your handler must be safe in the event of a
+    ///   cancelation.
+    @nonobjc public func stream(maximumBufferedBytes: Int = 1024 * 1024, using handler: @escaping (_ response: URLResponse, _ data: Data) throws -> Void) -> HTTPManagerStreamRequest {
+        return HTTPManagerStreamRequest(request: self, uploadBody: uploadBody, maximumBufferedBytes: maximumBufferedBytes, makeHandlers: {
+            (chunk: handler, finish: { _ in })
+        })
+    }
+    
     /// Creates a suspended `HTTPManagerTask` for the request with the given completion handler.
     ///
     /// This method is intended for cases where you need access to the `URLSessionTask` prior to
@@ -756,14 +956,26 @@ private func networkTaskProcessor<T>(queue: OperationQueue?,
     -> (HTTPManagerTask, HTTPManagerTaskResult<Data>, _ authToken: Any??, _ attempt: Int, _ retry: @escaping (_ reason: HTTPManager.RetryReason) -> Bool) -> Void
 {
     return { (task, result, authToken, attempt, retry) in
+        let latencyTimeline = task.latencyTimeline
+        latencyTimeline?.processingStarted()
         let result = processor(task, result)
+        latencyTimeline?.processingFinished()
         func runCompletion() {
+            latencyTimeline?.completionScheduled()
+            func complete() {
+                if case .canceled = result {
+                    latencyTimeline?.completionStarted(record: false)
+                } else {
+                    latencyTimeline?.completionStarted(record: true)
+                }
+                taskCompletion(task, result, completion)
+            }
             if let queue = queue {
                 queue.addOperation {
-                    taskCompletion(task, result, completion)
+                    complete()
                 }
             } else {
-                taskCompletion(task, result, completion)
+                complete()
             }
         }
         if case .error(_, let HTTPManagerError.unauthorized(auth?, response, body, _)) = result {
@@ -895,6 +1107,76 @@ public class HTTPManagerDataRequest: HTTPManagerNetworkRequest {
         })
     }
     
+    /// Returns a new request that parses the data as a JSON array and passes each element to the
+    /// specified handler as soon as it's received.
+    ///
+    /// Unlike `parseAsJSON(options:using:)`, the response body is never held in memory at once.
+    /// Only the element currently being received is buffered, so this is suitable for very large
+    /// arrays.
+    /// - Note: If the server responds with 204 No Content, the task fails with
+    ///   `HTTPManagerError.unexpectedNoContent`. If the top-level value isn't an array, or the
+    ///   body ends before the array is closed, the task fails with a `JSONParserError`.
+    /// - Parameter options: Options to use for JSON parsing. Defaults to `[]`.
+    /// - Parameter maximumBufferedBytes: The maximum number of received bytes that may be waiting
+    ///   on the handler before the transfer is paused. Defaults to 1MB.
+    /// - Parameter handler: The handler to call with each element of the array, in order. This
+    ///   handler is not guaranteed to be called on any particular thread, but invocations are
+    ///   serialized. If the handler throws an error, the transfer is canceled and the task
+    ///   completes with that error.
+    /// - Returns: An `HTTPManagerStreamRequest`.
+    /// - Note: Once the handler has been invoked, the task will not be retried, as doing so would
+    ///   replay the array from the beginning.
+    /// - Warning: If the request is canceled, elements that were received but not yet delivered
+    ///   are discarded. Any side-effects performed by your handler must be safe in the event of a
+    ///   cancelation.
+    @nonobjc public func streamAsJSONArray(options: JSONOptions = [], maximumBufferedBytes: Int = 1024 * 1024, using handler: @escaping (_ response: URLResponse, _ element: JSON) throws -> Void) -> HTTPManagerStreamRequest {
+        return streamAsJSONArray(maximumBufferedBytes: maximumBufferedBytes, decode: { try JSON.decode($0, options: options) }, using: handler)
+    }
+    
+    /// Returns a new request that parses the data as a JSON array, decodes each element as a
+    /// `Decodable` type, and passes it to the specified handler as soon as it's received.
+    ///
+    /// Unlike `decodeAsJSON(_:with:options:)`, the response body is never held in memory at once.
+    /// Only the element currently being received is buffered, so this is suitable for very large
+    /// arrays.
+    /// - Note: If the server responds with 204 No Content, the task fails with
+    ///   `HTTPManagerError.unexpectedNoContent`. If the top-level value isn't an array, or the
+    ///   body ends before the array is closed, the task fails with a `JSONParserError`.
+    /// - Parameter type: The type to decode each element as. Must conform to `Decodable`.
+    /// - Parameter decoder: The `JSON.Decoder` to use for decoding. Defaults to `JSON.Decoder()`.
+    /// - Parameter options: Options to use for JSON parsing. Defaults to `[]`.
+    /// - Parameter maximumBufferedBytes: The maximum number of received bytes that may be waiting
+    ///   on the handler before the transfer is paused. Defaults to 1MB.
+    /// - Parameter handler: The handler to call with each decoded element, in order. This handler
+    ///   is not guaranteed to be called on any particular thread, but invocations are serialized.
+    ///   If the handler throws an error, the transfer is canceled and the task completes with that
+    ///   error.
+    /// - Returns: An `HTTPManagerStreamRequest`.
+    /// - Note: Once the handler has been invoked, the task will not be retried, as doing so would
+    ///   replay the array from the beginning.
+    /// - Warning: If the request is canceled, elements that were received but not yet delivered
+    ///   are discarded. Any side-effects performed by your handler must be safe in the event of a
+    ///   cancelation.
+    @nonobjc public func streamAsJSONArray<T: Decodable>(of type: T.Type, with decoder: JSON.Decoder = JSON.Decoder(), options: JSONOptions = [], maximumBufferedBytes: Int = 1024 * 1024, using handler: @escaping (_ response: URLResponse, _ element: T) throws -> Void) -> HTTPManagerStreamRequest {
+        return streamAsJSONArray(maximumBufferedBytes: maximumBufferedBytes, decode: { try decoder.decode(type, from: $0, options: options) }, using: handler)
+    }
+    
+    private func streamAsJSONArray<T>(maximumBufferedBytes: Int, decode: @escaping (Data) throws -> T, using handler: @escaping (URLResponse, T) throws -> Void) -> HTTPManagerStreamRequest {
+        return HTTPManagerStreamRequest(request: self, uploadBody: uploadBody, expectedContentTypes: ["application/json"], maximumBufferedBytes: maximumBufferedBytes, makeHandlers: {
+            var splitter = JSONArrayElementSplitter()
+            return (chunk: { response, data in
+                try splitter.append(data, { element in
+                    try handler(response, decode(element))
+                })
+            }, finish: { response in
+                if let response = response as? HTTPURLResponse, response.statusCode == 204 {
+                    throw HTTPManagerError.unexpectedNoContent(response: response)
+                }
+                try splitter.finish()
+            })
+        })
+    }
+    
     /// Executes a block with `self` as the argument, and then returns `self` again.
     /// - Parameter f: A block to execute, with `self` as the argument.
     /// - Returns: `self`.
@@ -964,6 +1246,53 @@ public final class HTTPManagerParseRequest<T>: HTTPManagerRequest, HTTPManagerRe
     ///   request incorrectly.
     public var expectedContentTypes: [String]
     
+    /// Whether the request uses the `HTTPManager`'s `responseCache`. The default value is `false`.
+    ///
+    /// If `true` and the `HTTPManager` has a `responseCache`, a cached response is returned without
+    /// waiting for the network. If the request also sets `parseIdentifier` and the cache holds the
+    /// value parsed from that response by a request with the same parse identifier and result
+    /// type, the parse handler is skipped too. Stale entries are returned while they're
+    /// revalidated in the background. Fresh responses are stored in the cache along with their
+    /// parsed values.
+    ///
+    /// This property is ignored for requests other than `GET`, and for mocked requests.
+    ///
+    /// - SeeAlso: `HTTPManagerResponseCache`.
+    public var usesResponseCache: Bool = false
+    
+    /// Whether the request reuses a previously parsed value when the response body is identical
+    /// to one it has already parsed. The default value is `false`.
+    ///
+    /// If `true`, the response body is hashed and looked up in a memo owned by the `HTTPManager`,
+    /// and if an identical body was parsed by a request with the same URL, method, result type and
+    /// `parseIdentifier`, the value it produced is returned without calling the parse handler. This
+    /// is useful for polling endpoints that usually return the same large body. The memo is bounded
+    /// by `HTTPManager.parseMemoizationByteLimit`.
+    ///
+    /// This property is ignored for requests without a `parseIdentifier`, and for requests with a
+    /// mocked data value.
+    ///
+    /// - Important: The memo assumes that the parse handler doesn't depend on anything other than
+    ///   the body. Don't set this if the parse handler inspects the response headers, or if the
+    ///   result is a mutable reference type, since the same instance is returned each time.
+    public var memoizesParse: Bool = false
+    
+    /// Identifies the parse handler, so values it parsed can be shared with other requests. The
+    /// default value is `nil`.
+    ///
+    /// Requests that set `usesResponseCache` only reuse a cached parsed value if it was produced by
+    /// a request with the same parse identifier and result type. Without a parse identifier the
+    /// cached response body is still used, but the parse handler always runs. Likewise,
+    /// `memoizesParse` has no effect without a parse identifier.
+    ///
+    /// - Important: Requests that share a parse identifier must parse a given response the same
+    ///   way. Use a different identifier for each distinct parse handler, e.g. one derived from the
+    ///   model type and the options passed to it.
+    ///
+    /// - Note: `map(_:)` returns a request without a parse identifier, since the mapped parse
+    ///   handler differs from the original one.
+    public var parseIdentifier: String?
+    
     /// Returns a new request that maps the parsed data through the specified handler.
     /// - Note: In most cases you should do any mapping of the desired value inside the original
     ///   parse handler. This method exists as a convenience for when a method applies a canned
@@ -998,13 +1327,16 @@ public final class HTTPManagerParseRequest<T>: HTTPManagerRequest, HTTPManagerRe
     /// - Returns: An `HTTPManagerTask` that represents the operation.
     /// - Important: After you create the task, you must start it by calling the `resume()` method.
     public func createTask(withCompletionQueue queue: OperationQueue? = nil, completion: @escaping (_ task: HTTPManagerTask, _ result: HTTPManagerTaskResult<T>) -> Void) -> HTTPManagerTask {
+        if usesResponseCache && requestMethod == .GET && mock == nil && dataMock == nil, let responseCache = apiManager.responseCache {
+            return createTask(using: responseCache, queue: queue, completion: completion)
+        }
         let parseHandler: (URLResponse, Data) throws -> T
         let expectedContentTypes: [String]
         if let dataMock = dataMock {
             parseHandler = { _,_  in dataMock() }
             expectedContentTypes = [] // skip Content-Type handling in the task processor
         } else {
-            parseHandler = self.parseHandler
+            parseHandler = memoizedParseHandler()
             expectedContentTypes = self.expectedContentTypes
         }
         let completion = completionThunk(for: completion)
@@ -1032,7 +1364,80 @@ public final class HTTPManagerParseRequest<T>: HTTPManagerRequest, HTTPManagerRe
         return self
     }
     
-    private static func taskProcessor(_ task: HTTPManagerTask, _ result: HTTPManagerTaskResult<Data>, _ expectedContentTypes: [String], _ parseHandler: @escaping (URLResponse, Data) throws -> T) -> HTTPManagerTaskResult<T> {
+    /// Creates a task that's served from `responseCache` when possible.
+    private func createTask(using responseCache: HTTPManagerResponseCache, queue: OperationQueue?, completion: @escaping (_ task: HTTPManagerTask, _ result: HTTPManagerTaskResult<T>) -> Void) -> HTTPManagerTask {
+        var urlRequest = _preparedURLRequest
+        auth?.applyHeaders(to: &urlRequest)
+        let key = HTTPManagerResponseCache.Key(request: urlRequest)
+        let valueKey = parseIdentifier.map({ HTTPManagerResponseCache.ValueKey(valueType: T.self, parseIdentifier: $0) })
+        let hit = responseCache.lookup(key, valueKey: valueKey)
+        if let hit = hit, hit.needsRevalidation {
+            revalidate(key, valueKey: valueKey, using: responseCache, validators: hit.validators)
+        }
+        let parseHandler = memoizedParseHandler()
+        let request = HTTPManagerParseRequest<T>(request: self, uploadBody: uploadBody, expectedContentTypes: expectedContentTypes, prepareRequestHandler: prepareRequestHandler, parseHandler: { response, data in
+            let value = try parseHandler(response, data)
+            if let hit = hit {
+                if let valueKey = valueKey {
+                    responseCache.add(value, valueKey: valueKey, for: key, response: hit.response)
+                }
+            } else if let response = response as? HTTPURLResponse {
+                responseCache.store(response, data: data, value: value, valueKey: valueKey, for: key)
+            }
+            return value
+        })
+        if let hit = hit {
+            // Serve the cached response the same way mocks are served, so the task behaves like any other.
+            let body = hit.value == nil ? hit.data : Data()
+            request.mock = HTTPMockInstance(queue: DispatchQueue.global(qos: userInitiated ? .userInitiated : .utility), parameters: [:], handler: { (_, _, completion) in
+                completion(hit.response, body)
+            })
+            if let value = hit.value as? T {
+                request.dataMock = { value }
+            }
+        }
+        return request.createTask(withCompletionQueue: queue, completion: completion)
+    }
+    
+    /// Revalidates a stale `responseCache` entry in the background.
+    private func revalidate(_ key: HTTPManagerResponseCache.Key, valueKey: HTTPManagerResponseCache.ValueKey?, using responseCache: HTTPManagerResponseCache, validators: [String: String]) {
+        let request = HTTPManagerParseRequest<T>(request: self, uploadBody: uploadBody, expectedContentTypes: expectedContentTypes, prepareRequestHandler: prepareRequestHandler, parseHandler: parseHandler)
+        for (field, value) in validators {
+            request.headerFields[field] = value
+        }
+        // Make sure URLCache doesn't answer the conditional request itself.
+        request.cachePolicy = .reloadIgnoringLocalCacheData
+        request.userInitiated = false
+        request.priority = .background
+        request.affectsNetworkActivityIndicator = false
+        let expectedContentTypes = self.expectedContentTypes
+        let parseHandler = memoizedParseHandler()
+        let task = apiManager.createNetworkTaskWithRequest(request, uploadBody: nil, processor: { task, result, _, _, _ in
+            defer {
+                // Revalidation doesn't retry, so we're done with the task either way.
+                _ = task.transitionState(to: .completed)
+            }
+            if case .success(let response as HTTPURLResponse, _) = result, response.statusCode == 304 {
+                responseCache.refresh(for: key, notModified: response)
+            } else if case .success(let response as HTTPURLResponse, let value) = HTTPManagerParseRequest<T>.taskProcessor(task, result, expectedContentTypes, parseHandler),
+                case .success(_, let data) = result
+            {
+                responseCache.store(response, data: data, value: value, valueKey: valueKey, for: key)
+            } else {
+                responseCache.revalidationFailed(for: key)
+            }
+        })
+        task.resume()
+    }
+    
+    /// Returns `parseHandler`, wrapped in the `HTTPManager`'s parse result memo if `memoizesParse`
+    /// and `parseIdentifier` are set.
+    private func memoizedParseHandler() -> (URLResponse, Data) throws -> T {
+        guard memoizesParse, let parseIdentifier = parseIdentifier, apiManager.parseMemoizationByteLimit > 0 else { return parseHandler }
+        return apiManager.parseResultMemo.memoizing(parseHandler, url: url, method: requestMethod.rawValue, parseIdentifier: parseIdentifier)
+    }
+    
+    fileprivate static func taskProcessor(_ task: HTTPManagerTask, _ result: HTTPManagerTaskResult<Data>, _ expectedContentTypes: [String], _ parseHandler: @escaping (URLResponse, Data) throws -> T) -> HTTPManagerTaskResult<T> {
         // check for cancellation before processing
         if task.state == .canceled {
             return .canceled
@@ -1057,34 +1462,16 @@ public final class HTTPManagerParseRequest<T>: HTTPManagerRequest, HTTPManagerRe
                     } else {
                         throw HTTPManagerError.failedResponse(statusCode: statusCode, response: response, body: data, bodyJson: json)
                     }
-                } else if statusCode != 204 && !expectedContentTypes.isEmpty, let contentType = (response.allHeaderFields["Content-Type"] as? String).map(MediaType.init), !contentType.typeSubtype.isEmpty {
-                    // Not a 204 No Content, check the MIME type against the list
-                    // As per the doc comment on expectedContentTypes, we check both the response mimeType and, if it's different, the Content-Type header.
-                    var mimeType = response.mimeType.map(MediaType.init)
-                    if mimeType?.rawValue == contentType.rawValue {
-                        mimeType = nil
-                    }
-                    let contentTypeAlias = contentTypeAliases[contentType.typeSubtype].map(MediaType.init)
-                    let mimeTypeAlias = mimeType.flatMap({ contentTypeAliases[$0.typeSubtype].map(MediaType.init) })
-                    let valid = expectedContentTypes.contains(where: {
-                        // ignore the parameters from expectedContentTypes
-                        let pattern = MediaType(MediaType($0).typeSubtype)
-                        if let mimeType = mimeType, pattern ~= mimeType { return true }
-                        if pattern ~= contentType { return true }
-                        if let contentTypeAliases = contentTypeAlias, pattern ~= contentTypeAliases { return true }
-                        if let mimeTypeAlias = mimeTypeAlias, pattern ~= mimeTypeAlias { return true }
-                        return false
-                    })
-                    if !valid {
-                        throw HTTPManagerError.unexpectedContentType(contentType: (mimeType ?? contentType).rawValue, response: response, body: data)
-                    }
+                } else if statusCode != 204, let contentType = unexpectedContentType(of: response, expectedContentTypes: expectedContentTypes) {
+                    // Not a 204 No Content, and the MIME type doesn't match the list
+                    throw HTTPManagerError.unexpectedContentType(contentType: contentType, response: response, body: data)
                 }
             }
             return try parseHandler(response, data)
         })
     }
     
-    private static func taskCompletion(_ task: HTTPManagerTask, _ result: HTTPManagerTaskResult<T>, _ handler: @escaping (HTTPManagerTask, HTTPManagerTaskResult<T>) -> Void) {
+    fileprivate static func taskCompletion(_ task: HTTPManagerTask, _ result: HTTPManagerTaskResult<T>, _ handler: @escaping (HTTPManagerTask, HTTPManagerTaskResult<T>) -> Void) {
         let transition = task.transitionState(to: .completed)
         if transition.ok {
             assert(transition.oldState != .completed, "internal HTTPManager error: tried to complete task that's already completed")
@@ -1122,9 +1509,13 @@ public final class HTTPManagerParseRequest<T>: HTTPManagerRequest, HTTPManagerRe
         mainDocumentURL = request.mainDocumentURL
         httpShouldHandleCookies = request.httpShouldHandleCookies
         userInitiated = request.userInitiated
+        priority = request.priority
         retryBehavior = request.retryBehavior
         assumeErrorsAreJSON = request.assumeErrorsAreJSON
         serverRequiresContentLength = request.serverRequiresContentLength
+        assumesHTTP3Capable = request.assumesHTTP3Capable
+        requestBodyCompression = request.requestBodyCompression
+        requestBodyCompressionThreshold = request.requestBodyCompressionThreshold
         mock = request.mock
         affectsNetworkActivityIndicator = request.affectsNetworkActivityIndicator
         headerFields = request.headerFields
@@ -1137,6 +1528,9 @@ public final class HTTPManagerParseRequest<T>: HTTPManagerRequest, HTTPManagerRe
         _contentType = request._contentType
         uploadBody = request.uploadBody
         expectedContentTypes = request.expectedContentTypes
+        usesResponseCache = request.usesResponseCache
+        memoizesParse = request.memoizesParse
+        parseIdentifier = request.parseIdentifier
         dataMock = request.dataMock
         super.init(__copyOfRequest: request)
     }
@@ -1156,6 +1550,8 @@ public final class HTTPManagerParseRequest<T>: HTTPManagerRequest, HTTPManagerRe
         _contentType = request._contentType
         uploadBody = request.uploadBody
         expectedContentTypes = request.expectedContentTypes
+        usesResponseCache = request.usesResponseCache
+        memoizesParse = request.memoizesParse
         super.init(__copyOfRequest: request)
     }
     
@@ -1175,6 +1571,34 @@ public final class HTTPManagerParseRequest<T>: HTTPManagerRequest, HTTPManagerRe
 
 private let contentTypeAliases: [String: String] = ["text/json": "application/json"]
 
+/// Checks the MIME type of a response against a list of expected content types.
+///
+/// See the doc comment on `HTTPManagerParseRequest.expectedContentTypes` for details.
+///
+/// - Returns: The unexpected MIME type of the response, or `nil` if the response is acceptable.
+internal func unexpectedContentType(of response: HTTPURLResponse, expectedContentTypes: [String]) -> String? {
+    guard !expectedContentTypes.isEmpty, let contentType = (response.allHeaderFields["Content-Type"] as? String).map(MediaType.init), !contentType.typeSubtype.isEmpty else {
+        return nil
+    }
+    // As per the doc comment on expectedContentTypes, we check both the response mimeType and, if it's different, the Content-Type header.
+    var mimeType = response.mimeType.map(MediaType.init)
+    if mimeType?.rawValue == contentType.rawValue {
+        mimeType = nil
+    }
+    let contentTypeAlias = contentTypeAliases[contentType.typeSubtype].map(MediaType.init)
+    let mimeTypeAlias = mimeType.flatMap({ contentTypeAliases[$0.typeSubtype].map(MediaType.init) })
+    let valid = expectedContentTypes.contains(where: {
+        // ignore the parameters from expectedContentTypes
+        let pattern = MediaType(MediaType($0).typeSubtype)
+        if let mimeType = mimeType, pattern ~= mimeType { return true }
+        if pattern ~= contentType { return true }
+        if let contentTypeAliases = contentTypeAlias, pattern ~= contentTypeAliases { return true }
+        if let mimeTypeAlias = mimeTypeAlias, pattern ~= mimeTypeAlias { return true }
+        return false
+    })
+    return valid ? nil : (mimeType ?? contentType).rawValue
+}
+
 private func acceptHeaderValueForContentTypes(_ contentTypes: [String]) -> String {
     guard var value = contentTypes.first else { return "" }
     var priority = 9
@@ -1192,6 +1616,299 @@ private func acceptHeaderValueForContentTypes(_ contentTypes: [String]) -> Strin
     return value
 }
 
+// MARK: - Stream Request
+
+/// An HTTP request that delivers the response body to a handler as it's received.
+///
+/// - SeeAlso: `HTTPManagerNetworkRequest.stream(maximumBufferedBytes:using:)`,
+///   `HTTPManagerDataRequest.streamAsJSONArray(options:maximumBufferedBytes:using:)`.
+public final class HTTPManagerStreamRequest: HTTPManagerRequest, HTTPManagerRequestPerformable {
+    /// The URL for the request, including any query items as appropriate.
+    public override var url: URL {
+        return baseURL
+    }
+    
+    /// The Content-Type for the request.
+    /// If no data is being submitted in the request body, the `contentType`
+    /// will be empty.
+    public override var contentType: String {
+        return _contentType
+    }
+    
+    /// The expected MIME type of the response. Defaults to `[]`.
+    ///
+    /// This property is used to generate the `Accept` header, if not otherwise specified by the
+    /// request, and to validate the MIME type of the response in the same manner as
+    /// `HTTPManagerParseRequest.expectedContentTypes`. If the response doesn't match, the body is
+    /// not streamed and `HTTPManagerError.unexpectedContentType` is returned as the result.
+    public var expectedContentTypes: [String]
+    
+    /// The maximum number of received bytes that may be waiting on the stream handler before the
+    /// transfer is paused.
+    public var maximumBufferedBytes: Int
+    
+    /// Creates a suspended `HTTPManagerTask` for the request with the given completion handler.
+    ///
+    /// This method is intended for cases where you need access to the `URLSessionTask` prior to
+    /// the task executing, e.g. if you need to record the task identifier somewhere before the
+    /// completion block fires.
+    /// - Parameter queue: (Optional) The queue to call the handler on. The default value
+    ///   of `nil` means the handler will be called on a global concurrent queue.
+    /// - Parameter completion: The handler to call when the request is done. This handler
+    ///   will be invoked on *queue* if provided, otherwise on a global concurrent queue. It is
+    ///   invoked after the stream handler has finished processing the last chunk.
+    /// - Returns: An `HTTPManagerTask` that represents the operation.
+    /// - Important: After you create the task, you must start it by calling the `resume()` method.
+    @nonobjc public func createTask(withCompletionQueue queue: OperationQueue? = nil, completion: @escaping (_ task: HTTPManagerTask, _ result: HTTPManagerTaskResult<Void>) -> Void) -> HTTPManagerTask {
+        let expectedContentTypes = self.expectedContentTypes
+        let handlers = makeHandlers()
+        let responseStream = ResponseStream(expectedContentTypes: expectedContentTypes, maximumBufferedBytes: maximumBufferedBytes, userInitiated: userInitiated, handler: handlers.chunk)
+        let completion = completionThunk(for: completion)
+        let processor = networkTaskProcessor(queue: queue,
+                                             processor: { (task, result) in HTTPManagerParseRequest<Void>.taskProcessor(task, result, expectedContentTypes, { response, _ in try handlers.finish(response) }) },
+                                             taskCompletion: HTTPManagerParseRequest<Void>.taskCompletion,
+                                             completion: completion)
+        return apiManager.createNetworkTaskWithRequest(self, uploadBody: uploadBody, responseStream: responseStream, processor: { (task, result, authToken, attempt, retry) in
+            processor(task, result, authToken, attempt, { reason in
+                // Retrying would replay the body from the beginning.
+                guard !responseStream.hasDeliveredData else { return false }
+                return retry(reason)
+            })
+        })
+    }
+    
+    /// Executes a block with `self` as the argument, and then returns `self` again.
+    /// - Parameter f: A block to execute, with `self` as the argument.
+    /// - Returns: `self`.
+    /// This method exists to help with functional-style chaining, e.g.:
+    /// ```
+    /// HTTP.request(GET: "foo")
+    ///     .stream(using: { process($1) })
+    ///     .with({ $0.userInitiated = true })
+    ///     .performRequest { task, result in
+    ///         // ...
+    /// }
+    /// ```
+    @nonobjc public override func with(_ f: (HTTPManagerStreamRequest) throws -> Void) rethrows -> Self {
+        try f(self)
+        return self
+    }
+    
+    /// The handlers for a single task.
+    ///
+    /// `chunk` is invoked with each chunk of the body, and `finish` is invoked once the whole body
+    /// has been delivered. Either one may throw to fail the task.
+    internal typealias Handlers = (chunk: (URLResponse, Data) throws -> Void, finish: (URLResponse) throws -> Void)
+    
+    /// Creates the handlers for each task, so handlers can keep state across chunks.
+    private let makeHandlers: () -> Handlers
+    private let prepareRequestHandler: ((inout URLRequest) -> Void)?
+    private let _contentType: String
+    private let uploadBody: UploadBody?
+    
+    internal init(request: HTTPManagerRequest, uploadBody: UploadBody?, expectedContentTypes: [String] = [], maximumBufferedBytes: Int, makeHandlers: @escaping () -> Handlers) {
+        self.makeHandlers = makeHandlers
+        prepareRequestHandler = request.prepareURLRequest()
+        _contentType = request.contentType
+        self.uploadBody = uploadBody
+        self.expectedContentTypes = expectedContentTypes
+        self.maximumBufferedBytes = maximumBufferedBytes
+        super.init(apiManager: request.apiManager, URL: request.url, method: request.requestMethod, parameters: request.parameters)
+        urlProtocolProperties = request.urlProtocolProperties
+        isIdempotent = request.isIdempotent
+        auth = request.auth
+        timeoutInterval = request.timeoutInterval
+        cachePolicy = request.cachePolicy
+        shouldFollowRedirects = request.shouldFollowRedirects
+        // Streamed bodies are never accumulated, so there's nothing useful to cache.
+        defaultResponseCacheStoragePolicy = .notAllowed
+        allowsCellularAccess = request.allowsCellularAccess
+        mainDocumentURL = request.mainDocumentURL
+        httpShouldHandleCookies = request.httpShouldHandleCookies
+        userInitiated = request.userInitiated
+        priority = request.priority
+        retryBehavior = request.retryBehavior
+        assumeErrorsAreJSON = request.assumeErrorsAreJSON
+        serverRequiresContentLength = request.serverRequiresContentLength
+        assumesHTTP3Capable = request.assumesHTTP3Capable
+        requestBodyCompression = request.requestBodyCompression
+        requestBodyCompressionThreshold = request.requestBodyCompressionThreshold
+        mock = request.mock
+        affectsNetworkActivityIndicator = request.affectsNetworkActivityIndicator
+        headerFields = request.headerFields
+    }
+    
+    public required init(__copyOfRequest request: HTTPManagerRequest) {
+        let request = unsafeDowncast(request, to: HTTPManagerStreamRequest.self)
+        makeHandlers = request.makeHandlers
+        prepareRequestHandler = request.prepareRequestHandler
+        _contentType = request._contentType
+        uploadBody = request.uploadBody
+        expectedContentTypes = request.expectedContentTypes
+        maximumBufferedBytes = request.maximumBufferedBytes
+        super.init(__copyOfRequest: request)
+    }
+    
+    internal override func prepareURLRequest() -> ((inout URLRequest) -> Void)? {
+        if !expectedContentTypes.isEmpty {
+            return { [expectedContentTypes, prepareRequestHandler] request in
+                if request.allHTTPHeaderFields?["Accept"] == nil {
+                    request.setValue(acceptHeaderValueForContentTypes(expectedContentTypes), forHTTPHeaderField: "Accept")
+                }
+                prepareRequestHandler?(&request)
+            }
+        } else {
+            return prepareRequestHandler
+        }
+    }
+}
+
+// MARK: - Download Request
+
+/// An HTTP request that writes the response body to a file as it's received.
+///
+/// The body is never accumulated in memory. Once the download completes, the file is mapped into
+/// memory and handed to the parse handler, so reading it doesn't require copying it onto the heap.
+///
+/// - SeeAlso: `HTTPManagerNetworkRequest.download(to:)`,
+///   `HTTPManagerNetworkRequest.download(to:using:)`.
+public final class HTTPManagerDownloadRequest<T>: HTTPManagerRequest, HTTPManagerRequestPerformable {
+    public typealias ResultValue = T
+    
+    /// The URL for the request, including any query items as appropriate.
+    public override var url: URL {
+        return baseURL
+    }
+    
+    /// The Content-Type for the request.
+    /// If no data is being submitted in the request body, the `contentType`
+    /// will be empty.
+    public override var contentType: String {
+        return _contentType
+    }
+    
+    /// The file URL that the response body is written to, or `nil` if the body is written to a
+    /// temporary file.
+    ///
+    /// An existing file at this location is replaced. If the task fails or is canceled, the file is
+    /// removed. Temporary files are removed as soon as they've been mapped into memory; the mapped
+    /// data remains valid for as long as it's referenced.
+    public let destinationURL: URL?
+    
+    /// The expected MIME type of the response. Defaults to `[]`.
+    ///
+    /// This property is used to generate the `Accept` header, if not otherwise specified by the
+    /// request, and to validate the MIME type of the response in the same manner as
+    /// `HTTPManagerParseRequest.expectedContentTypes`.
+    public var expectedContentTypes: [String]
+    
+    /// Creates a suspended `HTTPManagerTask` for the request with the given completion handler.
+    ///
+    /// This method is intended for cases where you need access to the `URLSessionTask` prior to
+    /// the task executing, e.g. if you need to record the task identifier somewhere before the
+    /// completion block fires.
+    /// - Parameter queue: (Optional) The queue to call the handler on. The default value
+    ///   of `nil` means the handler will be called on a global concurrent queue.
+    /// - Parameter completion: The handler to call when the request is done. This handler
+    ///   will be invoked on *queue* if provided, otherwise on a global concurrent queue.
+    /// - Returns: An `HTTPManagerTask` that represents the operation.
+    /// - Important: After you create the task, you must start it by calling the `resume()` method.
+    @nonobjc public func createTask(withCompletionQueue queue: OperationQueue? = nil, completion: @escaping (_ task: HTTPManagerTask, _ result: HTTPManagerTaskResult<T>) -> Void) -> HTTPManagerTask {
+        let expectedContentTypes = self.expectedContentTypes
+        let parseHandler = self.parseHandler
+        let writer = ResponseFileWriter(destinationURL: destinationURL)
+        let responseStream = ResponseStream(expectedContentTypes: expectedContentTypes, maximumBufferedBytes: 1024 * 1024, userInitiated: userInitiated, handler: { response, data in
+            try writer.write(data, for: response)
+        })
+        let completion = completionThunk(for: completion)
+        // Unlike stream requests, downloads may be retried, as the writer starts the file over for
+        // each new response.
+        return apiManager.createNetworkTaskWithRequest(self, uploadBody: uploadBody, responseStream: responseStream,
+                                                       processor: networkTaskProcessor(queue: queue,
+                                                                                       processor: { (task, result) in HTTPManagerParseRequest<T>.taskProcessor(task, result, expectedContentTypes, { response, _ in try parseHandler(response, writer.finish(for: response)) }) },
+                                                                                       taskCompletion: HTTPManagerParseRequest<T>.taskCompletion,
+                                                                                       completion: completion))
+    }
+    
+    /// Executes a block with `self` as the argument, and then returns `self` again.
+    /// - Parameter f: A block to execute, with `self` as the argument.
+    /// - Returns: `self`.
+    /// This method exists to help with functional-style chaining, e.g.:
+    /// ```
+    /// HTTP.request(GET: "foo")
+    ///     .download(to: fileURL)
+    ///     .with({ $0.userInitiated = true })
+    ///     .performRequest { task, result in
+    ///         // ...
+    /// }
+    /// ```
+    @nonobjc public override func with(_ f: (HTTPManagerDownloadRequest) throws -> Void) rethrows -> Self {
+        try f(self)
+        return self
+    }
+    
+    private let parseHandler: (URLResponse, Data) throws -> T
+    private let prepareRequestHandler: ((inout URLRequest) -> Void)?
+    private let _contentType: String
+    private let uploadBody: UploadBody?
+    
+    internal init(request: HTTPManagerRequest, uploadBody: UploadBody?, destinationURL: URL?, parseHandler: @escaping (URLResponse, Data) throws -> T) {
+        self.parseHandler = parseHandler
+        prepareRequestHandler = request.prepareURLRequest()
+        _contentType = request.contentType
+        self.uploadBody = uploadBody
+        self.destinationURL = destinationURL
+        expectedContentTypes = []
+        super.init(apiManager: request.apiManager, URL: request.url, method: request.requestMethod, parameters: request.parameters)
+        urlProtocolProperties = request.urlProtocolProperties
+        isIdempotent = request.isIdempotent
+        auth = request.auth
+        timeoutInterval = request.timeoutInterval
+        cachePolicy = request.cachePolicy
+        shouldFollowRedirects = request.shouldFollowRedirects
+        // Downloaded bodies are never accumulated, so there's nothing useful to cache.
+        defaultResponseCacheStoragePolicy = .notAllowed
+        allowsCellularAccess = request.allowsCellularAccess
+        mainDocumentURL = request.mainDocumentURL
+        httpShouldHandleCookies = request.httpShouldHandleCookies
+        userInitiated = request.userInitiated
+        priority = request.priority
+        retryBehavior = request.retryBehavior
+        assumeErrorsAreJSON = request.assumeErrorsAreJSON
+        serverRequiresContentLength = request.serverRequiresContentLength
+        assumesHTTP3Capable = request.assumesHTTP3Capable
+        requestBodyCompression = request.requestBodyCompression
+        requestBodyCompressionThreshold = request.requestBodyCompressionThreshold
+        mock = request.mock
+        affectsNetworkActivityIndicator = request.affectsNetworkActivityIndicator
+        headerFields = request.headerFields
+    }
+    
+    public required init(__copyOfRequest request: HTTPManagerRequest) {
+        let request = unsafeDowncast(request, to: HTTPManagerDownloadRequest<T>.self)
+        parseHandler = request.parseHandler
+        prepareRequestHandler = request.prepareRequestHandler
+        _contentType = request._contentType
+        uploadBody = request.uploadBody
+        destinationURL = request.destinationURL
+        expectedContentTypes = request.expectedContentTypes
+        super.init(__copyOfRequest: request)
+    }
+    
+    internal override func prepareURLRequest() -> ((inout URLRequest) -> Void)? {
+        if !expectedContentTypes.isEmpty {
+            return { [expectedContentTypes, prepareRequestHandler] request in
+                if request.allHTTPHeaderFields?["Accept"] == nil {
+                    request.setValue(acceptHeaderValueForContentTypes(expectedContentTypes), forHTTPHeaderField: "Accept")
+                }
+                prepareRequestHandler?(&request)
+            }
+        } else {
+            return prepareRequestHandler
+        }
+    }
+}
+
 // MARK: - Action Request
 
 /// An HTTP POST/PUT/PATCH/DELETE request that does not yet have a parse handler.
@@ -24,7 +24,9 @@ public final class HTTPManagerTask: NSObject {
     /// The underlying `URLSessionTask`.
     ///
     /// If a failed request is automatically retried, this property value
-    /// will change.
+    /// will change. It also changes once the body is ready for multipart uploads
+    /// whose `serverRequiresContentLength` is `true`, as the `Content-Length`
+    /// header can't be set until then.
     ///
     /// - Note: This property supports key-value observing.
     @objc public var networkTask: URLSessionTask {
@@ -64,6 +66,61 @@ public final class HTTPManagerTask: NSObject {
     /// when implementing custom retry logic.
     @objc public let userInitiated: Bool
     
+    /// The priority the task waits at in `HTTPManager.requestScheduler`.
+    ///
+    /// This is `.userInitiated` if the original request's `userInitiated` property was `true`,
+    /// otherwise it's the value of the original request's `priority` property.
+    @objc public let priority: HTTPManagerRequestPriority
+    
+    /// How long the task's current network task waited in `HTTPManager.requestScheduler` before it
+    /// started, in seconds.
+    ///
+    /// This is `0` if the task wasn't scheduled by a request scheduler or hasn't started yet. It's
+    /// updated before the network task of each attempt starts, so it's up to date when the
+    /// `HTTPManager.metricsCallback` is invoked.
+    ///
+    /// - Note: This property is thread-safe and may be accessed concurrently.
+    @objc public var schedulerQueueDuration: TimeInterval {
+        return (_schedulingInfo?.value as? SchedulingInfo)?.queueDuration ?? 0
+    }
+    
+    /// The number of tasks for the same host that were already waiting in
+    /// `HTTPManager.requestScheduler` when the task's current network task was queued.
+    ///
+    /// This is `0` if the network task started without waiting, or if the task wasn't scheduled by
+    /// a request scheduler. It's updated before the network task of each attempt starts, so it's
+    /// up to date when the `HTTPManager.metricsCallback` is invoked.
+    ///
+    /// - Note: This property is thread-safe and may be accessed concurrently.
+    @objc public var schedulerQueueDepth: Int {
+        return (_schedulingInfo?.value as? SchedulingInfo)?.queueDepth ?? 0
+    }
+    
+    /// The time the task spent in each phase of its lifetime.
+    ///
+    /// This is `nil` unless `HTTPManager.latencyRecorder` was set when the task was created. It's
+    /// set just before the completion handler is invoked, so it's available from the completion
+    /// handler.
+    ///
+    /// - Note: This property is thread-safe and may be accessed concurrently.
+    ///
+    /// - SeeAlso: `HTTPManagerLatencyRecorder`.
+    @objc public var latency: HTTPManagerTaskLatency? {
+        return latencyTimeline?.latency
+    }
+    
+    /// The protocol and connection used by the task's most recent network task.
+    ///
+    /// This comes from the collected task metrics, so it's `nil` unless
+    /// `HTTPManager.metricsCallback` was set when the task was created. It's updated before the
+    /// `metricsCallback` is invoked for each network task.
+    ///
+    /// - Note: This property is thread-safe and may be accessed concurrently.
+    @available(iOS 10, macOS 10.12, tvOS 10, watchOS 3, *)
+    @objc public var connectionInfo: HTTPManagerTaskConnectionInfo? {
+        return _connectionInfo.value as? HTTPManagerTaskConnectionInfo
+    }
+    
     @objc public override class func automaticallyNotifiesObservers(forKey _: String) -> Bool {
         return false
     }
@@ -89,7 +146,12 @@ public final class HTTPManagerTask: NSObject {
                 }
             }
         }
-        networkTask.resume()
+        latencyTimeline?.resumed()
+        if let networkTaskPreparation = networkTaskPreparation, !networkTaskPreparation.shouldStart() {
+            // The network task is started by finishNetworkTaskPreparation() once it's been created.
+            return
+        }
+        startCurrentNetworkTask()
     }
     
     /// Use `networkTask.suspend()` instead.
@@ -119,7 +181,20 @@ public final class HTTPManagerTask: NSObject {
         defer { didChangeValue(forKey: "state") }
         let result = _stateBox.transitionState(to: .canceled)
         if result.completed && result.oldState != .canceled {
-            networkTask.cancel()
+            let networkTask = self.networkTask
+            if let sharedNetworkTask = sharedNetworkTask, sharedNetworkTask.networkTask === networkTask {
+                // Other tasks may still be waiting on the network task, so it may not finish any
+                // time soon. Report the cancellation now instead of when it does.
+                if let subscriber = sharedNetworkTask.leave(self) {
+                    // The activity indicator is only updated on the session delegate queue.
+                    sessionDelegateQueue.addOperation {
+                        self.clearTrackingNetworkActivity()
+                        subscriber.processCancellation()
+                    }
+                }
+            } else {
+                networkTask.cancel()
+            }
         }
     }
     
@@ -137,20 +212,43 @@ public final class HTTPManagerTask: NSObject {
     internal let assumeErrorsAreJSON: Bool
     internal let defaultResponseCacheStoragePolicy: URLCache.StoragePolicy
     internal let retryBehavior: HTTPManagerRetryBehavior?
+    /// The delay before the most recent retry scheduled by
+    /// `HTTPManagerRetryBehavior.backoffStrategy(maximumAttempts:baseDelay:maximumDelay:)`.
+    ///
+    /// - Important: This is only accessed while evaluating the retry behavior, which happens serially.
+    internal var previousRetryDelay: TimeInterval = 0
     internal let affectsNetworkActivityIndicator: Bool
     private let sessionDelegateQueue: OperationQueue
-    
-    internal init(networkTask: URLSessionTask, request: HTTPManagerRequest, sessionDelegateQueue: OperationQueue) {
+    /// The network task this task shares with identical requests, if it was coalesced.
+    ///
+    /// This only applies while `networkTask` is the shared network task. Retries always get their
+    /// own network task.
+    internal let sharedNetworkTask: SharedNetworkTask?
+    /// The scheduler that starts the task's network tasks, if any.
+    internal let requestScheduler: HTTPManagerRequestScheduler?
+    /// The timestamps of the task's phases. Only present if `HTTPManager.latencyRecorder` was set.
+    internal let latencyTimeline: LatencyTimeline?
+    
+    /// - Parameter defersNetworkTask: If `true`, `networkTask` is a placeholder that's replaced
+    ///   once the real network task can be created, e.g. once the upload body has been prepared,
+    ///   and `resume()` doesn't start anything until `finishNetworkTaskPreparation()` is called.
+    internal init(networkTask: URLSessionTask, request: HTTPManagerRequest, sessionDelegateQueue: OperationQueue, sharedNetworkTask: SharedNetworkTask? = nil, requestScheduler: HTTPManagerRequestScheduler? = nil, latencyTimeline: LatencyTimeline? = nil, defersNetworkTask: Bool = false) {
         _stateBox = _PMHTTPManagerTaskStateBox(state: State.running.boxState, networkTask: networkTask)
         isIdempotent = request.isIdempotent
         auth = request.auth
         userInitiated = request.userInitiated
+        priority = request.userInitiated ? .userInitiated : request.priority
         followRedirects = request.shouldFollowRedirects
         assumeErrorsAreJSON = request.assumeErrorsAreJSON
         defaultResponseCacheStoragePolicy = request.defaultResponseCacheStoragePolicy
         retryBehavior = request.retryBehavior
         affectsNetworkActivityIndicator = request.affectsNetworkActivityIndicator
         self.sessionDelegateQueue = sessionDelegateQueue
+        self.sharedNetworkTask = sharedNetworkTask
+        self.requestScheduler = requestScheduler
+        self.latencyTimeline = latencyTimeline
+        networkTaskPreparation = defersNetworkTask ? NetworkTaskPreparation() : nil
+        _schedulingInfo = requestScheduler.map({ _ in _PMHTTPAtomicReference(value: SchedulingInfo(queueDuration: 0, queueDepth: 0)) })
         super.init()
     }
     
@@ -203,7 +301,95 @@ public final class HTTPManagerTask: NSObject {
         }
     }
     
+    /// Resumes `networkTask`, which must be the task's current network task.
+    ///
+    /// All network tasks are started through this method so their start time can be recorded.
+    internal func startNetworkTask(_ networkTask: URLSessionTask) {
+        latencyTimeline?.networkStarted()
+        networkStartTime = DispatchTime.now().uptimeNanoseconds
+        networkTask.resume()
+    }
+    
+    /// Starts the network task that replaced the placeholder given to `init`, if `resume()` has
+    /// already been called.
+    ///
+    /// - Requires: The task must have been created with `defersNetworkTask`, and the new network
+    ///   task must already be in place.
+    internal func finishNetworkTaskPreparation() {
+        if networkTaskPreparation?.finish() == true {
+            startCurrentNetworkTask()
+        }
+    }
+    
+    /// Starts `networkTask`, or submits it to `requestScheduler` if it hasn't been started yet.
+    private func startCurrentNetworkTask() {
+        let networkTask = self.networkTask
+        if let requestScheduler = requestScheduler, networkTask.state == .suspended {
+            requestScheduler.submit(self, networkTask: networkTask)
+        } else {
+            startNetworkTask(networkTask)
+        }
+    }
+    
+    /// When the current network task was resumed, in uptime nanoseconds.
+    ///
+    /// This is only written before the network task is resumed, and only read by the session
+    /// delegate once the network task finishes, so it doesn't need any synchronization.
+    internal private(set) var networkStartTime: UInt64 = 0
+    
+    /// Records how long the current network task waited in `requestScheduler`.
+    internal func setSchedulingInfo(queueDuration: TimeInterval, queueDepth: Int) {
+        _schedulingInfo?.value = SchedulingInfo(queueDuration: queueDuration, queueDepth: queueDepth)
+    }
+    
+    /// Records the connection used by the current network task.
+    @available(iOS 10, macOS 10.12, tvOS 10, watchOS 3, *)
+    internal func setConnectionInfo(_ connectionInfo: HTTPManagerTaskConnectionInfo) {
+        _connectionInfo.value = connectionInfo
+    }
+    
     private let _stateBox: _PMHTTPManagerTaskStateBox
+    /// Only present if the task was created with `defersNetworkTask`.
+    private let networkTaskPreparation: NetworkTaskPreparation?
+    /// Holds a `SchedulingInfo`. Only present if the task has a `requestScheduler`.
+    private let _schedulingInfo: _PMHTTPAtomicReference?
+    /// Holds an `HTTPManagerTaskConnectionInfo`, or `NSNull` until metrics are collected.
+    private let _connectionInfo = _PMHTTPAtomicReference(value: NSNull())
+    
+    /// Tracks whether `resume()` was called before the network task was created.
+    private final class NetworkTaskPreparation {
+        /// Returns `true` if the network task is ready. Otherwise the resume is recorded for `finish()`.
+        func shouldStart() -> Bool {
+            lock.lock()
+            defer { lock.unlock() }
+            if !isFinished {
+                resumeRequested = true
+            }
+            return isFinished
+        }
+        
+        /// Marks the network task as ready. Returns `true` if `shouldStart()` was already called.
+        func finish() -> Bool {
+            lock.lock()
+            defer { lock.unlock() }
+            isFinished = true
+            return resumeRequested
+        }
+        
+        private let lock = NSLock()
+        private var isFinished = false
+        private var resumeRequested = false
+    }
+    
+    private final class SchedulingInfo {
+        let queueDuration: TimeInterval
+        let queueDepth: Int
+        
+        init(queueDuration: TimeInterval, queueDepth: Int) {
+            self.queueDuration = queueDuration
+            self.queueDepth = queueDepth
+        }
+    }
 }
 
 // MARK: -
@@ -228,6 +414,8 @@ extension HTTPManagerTask {
         }
         if userInitiated {
             s += " userInitiated"
+        } else if priority != .normal {
+            s += " priority=\(priority)"
         }
         if followRedirects {
             s += " followRedirects"
@@ -432,3 +620,119 @@ public func ??<Value>(result: HTTPManagerTaskResult<Value>, defaultValue: @autoc
     default: return try defaultValue()
     }
 }
+
+// MARK: - SharedNetworkTask
+
+/// A network task that is shared by several `HTTPManagerTask`s for identical requests.
+///
+/// The network task is only canceled once every `HTTPManagerTask` sharing it has been canceled.
+///
+/// The task that created the network task is tracked by the session delegate as usual. The tasks
+/// that joined it are kept here, so a joined task that's canceled can be completed right away
+/// instead of waiting for the network task.
+internal final class SharedNetworkTask {
+    let networkTask: URLSessionTask
+    
+    /// Creates a `SharedNetworkTask` for a network task with one subscriber.
+    init(networkTask: URLSessionTask) {
+        self.networkTask = networkTask
+    }
+    
+    /// Adds another subscriber to the network task.
+    ///
+    /// - Parameter makeSubscriber: A block that creates the new subscriber. It's invoked
+    ///   synchronously only if the subscriber can be added.
+    /// - Returns: The new subscriber, or `nil` if every existing subscriber has already been
+    ///   canceled.
+    func join<Subscriber: SharedNetworkTaskSubscriber>(makeSubscriber: (SharedNetworkTask) -> Subscriber) -> Subscriber? {
+        return inner.syncBarrier { inner -> Subscriber? in
+            guard inner.subscriberCount > 0 else { return nil }
+            let subscriber = makeSubscriber(self)
+            inner.subscriberCount += 1
+            inner.joinedSubscribers.append(subscriber)
+            return subscriber
+        }
+    }
+    
+    /// Removes a canceled subscriber, canceling the network task if no subscribers remain.
+    ///
+    /// - Returns: The subscriber for `task` if it was added with `join(makeSubscriber:)` and hasn't
+    ///   been handed out by `removeJoinedSubscribers()`. The caller is then responsible for
+    ///   completing it, since nothing else will.
+    func leave(_ task: HTTPManagerTask) -> SharedNetworkTaskSubscriber? {
+        let (subscriber, isLast) = inner.syncBarrier { inner -> (SharedNetworkTaskSubscriber?, Bool) in
+            inner.subscriberCount -= 1
+            let subscriber = inner.joinedSubscribers.index(where: { $0.task === task }).map({ inner.joinedSubscribers.remove(at: $0) })
+            return (subscriber, inner.subscriberCount == 0)
+        }
+        if isLast {
+            networkTask.cancel()
+        }
+        return subscriber
+    }
+    
+    /// Returns the subscribers added with `join(makeSubscriber:)` that haven't been canceled, so
+    /// they can be completed along with the network task.
+    func removeJoinedSubscribers() -> [SharedNetworkTaskSubscriber] {
+        return inner.syncBarrier { inner -> [SharedNetworkTaskSubscriber] in
+            let subscribers = inner.joinedSubscribers
+            inner.joinedSubscribers.removeAll()
+            return subscribers
+        }
+    }
+    
+    private let inner = QueueConfined(label: "PMHTTP shared network task internal queue", value: Inner())
+    
+    private final class Inner {
+        var subscriberCount: Int = 1
+        var joinedSubscribers: [SharedNetworkTaskSubscriber] = []
+    }
+}
+
+/// A task that joined a `SharedNetworkTask`.
+internal protocol SharedNetworkTaskSubscriber: class {
+    var task: HTTPManagerTask { get }
+    
+    /// Dispatches the task's processor with a `.canceled` result.
+    func processCancellation()
+}
+
+// MARK: -
+
+/// The protocol and connection that a network task used, taken from its task metrics.
+///
+/// - SeeAlso: `HTTPManagerTask.connectionInfo`.
+@available(iOS 10, macOS 10.12, tvOS 10, watchOS 3, *)
+public final class HTTPManagerTaskConnectionInfo: NSObject {
+    /// The ALPN protocol identifier negotiated for the connection, such as `"http/1.1"`, `"h2"` or
+    /// `"h3"`, or `nil` if it's not known.
+    @objc public let networkProtocolName: String?
+    
+    /// `true` if the network task was sent over a connection that was already open, either from
+    /// an earlier task or from `HTTPManager.prewarmConnection(to:userInitiated:completion:)`.
+    @objc public let isReusedConnection: Bool
+    
+    /// `true` if the network task was sent through a proxy.
+    @objc public let isProxyConnection: Bool
+    
+    /// `true` if the negotiated protocol multiplexes requests over a single connection, which is
+    /// the case for HTTP/2 and HTTP/3.
+    @objc public var isMultiplexed: Bool {
+        guard let name = networkProtocolName?.lowercased() else { return false }
+        return name == "h2" || name == "h2c" || name.hasPrefix("h3") || name.hasPrefix("spdy/")
+    }
+    
+    public override var description: String {
+        return "<HTTPManagerTaskConnectionInfo: protocol=\(networkProtocolName ?? "unknown")\(isReusedConnection ? " reused" : "")\(isProxyConnection ? " proxy" : "")>"
+    }
+    
+    /// Returns the connection info for the last network load in `metrics`, or `nil` if the
+    /// resource didn't come from the network.
+    internal init?(metrics: URLSessionTaskMetrics) {
+        guard let transaction = metrics.transactionMetrics.reversed().first(where: { $0.resourceFetchType == .networkLoad }) else { return nil }
+        networkProtocolName = transaction.networkProtocolName
+        isReusedConnection = transaction.isReusedConnection
+        isProxyConnection = transaction.isProxyConnection
+        super.init()
+    }
+}
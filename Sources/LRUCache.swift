@@ -0,0 +1,132 @@
+//
+//  LRUCache.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+/// A dictionary that evicts its least recently used entries once their total cost exceeds a limit.
+///
+/// **Thread safety:** This class is not thread-safe. It's meant to be wrapped in a `QueueConfined`.
+internal final class LRUCache<Key: Hashable, Value> {
+    /// The maximum total cost of the entries.
+    var costLimit: Int {
+        didSet { evict() }
+    }
+    
+    /// The total cost of the entries.
+    private(set) var totalCost: Int = 0
+    
+    init(costLimit: Int) {
+        self.costLimit = costLimit
+    }
+    
+    /// Returns the value for `key`, marking it as the most recently used.
+    func value(forKey key: Key) -> Value? {
+        guard let node = nodes[key] else { return nil }
+        if head !== node {
+            unlink(node)
+            link(node)
+        }
+        return node.value
+    }
+    
+    /// Returns the value for `key` without affecting the eviction order.
+    func peekValue(forKey key: Key) -> Value? {
+        return nodes[key]?.value
+    }
+    
+    /// Sets the value for `key` and marks it as the most recently used, evicting other entries as
+    /// necessary.
+    ///
+    /// If `cost` exceeds `costLimit` the value isn't stored, but any existing value is still removed.
+    func setValue(_ value: Value, forKey key: Key, cost: Int) {
+        removeValue(forKey: key)
+        guard cost <= costLimit else { return }
+        let node = Node(key: key, value: value, cost: cost)
+        nodes[key] = node
+        totalCost += cost
+        link(node)
+        evict()
+    }
+    
+    /// Removes the value for `key`.
+    @discardableResult
+    func removeValue(forKey key: Key) -> Value? {
+        guard let node = nodes.removeValue(forKey: key) else { return nil }
+        totalCost -= node.cost
+        unlink(node)
+        return node.value
+    }
+    
+    /// Removes every entry.
+    func removeAll() {
+        nodes.removeAll()
+        // Break the links iteratively so a long list can't overflow the stack when it's released.
+        while let node = head {
+            head = node.next
+            node.next = nil
+        }
+        tail = nil
+        totalCost = 0
+    }
+    
+    private final class Node {
+        let key: Key
+        let value: Value
+        let cost: Int
+        /// The previous node, which was used more recently.
+        weak var prev: Node?
+        /// The next node, which was used less recently.
+        var next: Node?
+        
+        init(key: Key, value: Value, cost: Int) {
+            self.key = key
+            self.value = value
+            self.cost = cost
+        }
+    }
+    
+    private var nodes: [Key: Node] = [:]
+    /// The most recently used node.
+    private var head: Node?
+    /// The least recently used node.
+    private var tail: Node?
+    
+    private func evict() {
+        while totalCost > costLimit, let node = tail {
+            removeValue(forKey: node.key)
+        }
+    }
+    
+    private func link(_ node: Node) {
+        node.next = head
+        head?.prev = node
+        head = node
+        if tail == nil {
+            tail = node
+        }
+    }
+    
+    private func unlink(_ node: Node) {
+        if let prev = node.prev {
+            prev.next = node.next
+        } else {
+            head = node.next
+        }
+        if let next = node.next {
+            next.prev = node.prev
+        } else {
+            tail = node.prev
+        }
+        node.prev = nil
+        node.next = nil
+    }
+}
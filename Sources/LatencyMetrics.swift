@@ -0,0 +1,426 @@
+//
+//  LatencyMetrics.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import Foundation
+import PMHTTP.Private
+
+/// A phase of the lifetime of an `HTTPManagerTask`, as measured by `HTTPManagerLatencyRecorder`.
+@objc public enum HTTPManagerLatencyPhase: Int, CustomStringConvertible {
+    /// From the task being resumed until its first network task starts. This includes any time
+    /// spent waiting in `HTTPManager.requestScheduler`.
+    case queue = 0
+    /// The time the network tasks were running, summed across every attempt.
+    case network = 1
+    /// From the session delegate being told a network task finished until the response starts
+    /// processing, summed across every attempt. This covers PMHTTP's bookkeeping and the hop to
+    /// the processing queue.
+    case dispatch = 2
+    /// The time spent validating and parsing responses, summed across every attempt.
+    case processing = 3
+    /// The time spent deciding whether to retry, summed across every attempt. This covers
+    /// `HTTPAuth` refreshes, retry behaviors and their backoff delays, and for retries, any time
+    /// spent waiting in `HTTPManager.requestScheduler`.
+    case retry = 4
+    /// From the result being ready until the hop to the completion queue finishes and the
+    /// completion handler is about to be invoked.
+    case completion = 5
+    /// From the task being resumed until the completion handler is about to be invoked.
+    case total = 6
+    
+    /// Every phase, in order.
+    public static let allPhases: [HTTPManagerLatencyPhase] = [.queue, .network, .dispatch, .processing, .retry, .completion, .total]
+    
+    public var description: String {
+        switch self {
+        case .queue: return "queue"
+        case .network: return "network"
+        case .dispatch: return "dispatch"
+        case .processing: return "processing"
+        case .retry: return "retry"
+        case .completion: return "completion"
+        case .total: return "total"
+        }
+    }
+}
+
+/// The time a single task spent in each `HTTPManagerLatencyPhase`.
+///
+/// - SeeAlso: `HTTPManagerTask.latency`.
+public final class HTTPManagerTaskLatency: NSObject {
+    /// The number of attempts the task made, which is more than 1 if it was retried.
+    @objc public let attempts: Int
+    
+    /// Returns the time the task spent in `phase`, in seconds.
+    @objc(durationOfPhase:)
+    public func duration(of phase: HTTPManagerLatencyPhase) -> TimeInterval {
+        return TimeInterval(nanoseconds[phase.rawValue]) / 1e9
+    }
+    
+    public override var description: String {
+        let ptr = UInt(bitPattern: Unmanaged.passUnretained(self).toOpaque())
+        let phases = HTTPManagerLatencyPhase.allPhases.map({ "\($0)=\(String(format: "%.3fms", duration(of: $0) * 1000))" })
+        return "<HTTPManagerTaskLatency: 0x\(String(ptr, radix: 16)) attempts=\(attempts) \(phases.joined(separator: " "))>"
+    }
+    
+    /// The duration of each phase in nanoseconds, indexed by `HTTPManagerLatencyPhase.rawValue`.
+    internal let nanoseconds: [UInt64]
+    
+    internal init(attempts: Int, nanoseconds: [UInt64]) {
+        self.attempts = attempts
+        self.nanoseconds = nanoseconds
+        super.init()
+    }
+}
+
+/// Aggregates the latency of completed tasks into per-endpoint histograms.
+///
+/// When `HTTPManager.latencyRecorder` is set, every task timestamps each phase of its lifetime
+/// with a monotonic clock. When the task completes, the time spent in each phase is available
+/// from `HTTPManagerTask.latency` and recorded into the histograms for the task's endpoint.
+/// Canceled tasks aren't recorded.
+///
+/// The histograms are updated with atomic counters, and the histograms for an endpoint that's
+/// been seen before are found with a concurrent read, so recording is cheap enough to leave
+/// enabled in production. Call `snapshot()` periodically to export the histograms, optionally
+/// followed by `reset()`.
+///
+/// **Thread safety:** All methods in this class are safe to call from any thread.
+///
+/// - SeeAlso: `HTTPManager.latencyRecorder`.
+public final class HTTPManagerLatencyRecorder: NSObject {
+    /// The name that tasks are recorded under once `maximumEndpointCount` endpoints have been seen.
+    @objc public static let otherEndpoint = "(other)"
+    
+    /// The maximum number of distinct endpoints that are recorded separately.
+    @objc public let maximumEndpointCount: Int
+    
+    /// Creates a new latency recorder that names endpoints by the method, host and path of the
+    /// request, e.g. `"GET example.com/v1/users"`.
+    ///
+    /// - Parameter maximumEndpointCount: (Optional) The maximum number of distinct endpoints
+    ///   that are recorded separately. Tasks for any other endpoints are recorded under
+    ///   `otherEndpoint`. The default value is 100.
+    @objc public convenience init(maximumEndpointCount: Int = 100) {
+        self.init(maximumEndpointCount: maximumEndpointCount, endpointName: HTTPManagerLatencyRecorder.defaultEndpointName)
+    }
+    
+    /// Creates a new latency recorder that names endpoints with a custom block.
+    ///
+    /// - Parameter maximumEndpointCount: (Optional) The maximum number of distinct endpoints
+    ///   that are recorded separately. Tasks for any other endpoints are recorded under
+    ///   `otherEndpoint`. The default value is 100.
+    /// - Parameter endpointName: A block that returns the endpoint name for a request. This is
+    ///   invoked once for each task when it's created, and should collapse paths that contain
+    ///   identifiers, e.g. `"GET /users/:id"`.
+    @objc public init(maximumEndpointCount: Int = 100, endpointName: @escaping (URLRequest) -> String) {
+        self.maximumEndpointCount = max(maximumEndpointCount, 1)
+        self.endpointName = endpointName
+        super.init()
+    }
+    
+    /// Returns the histograms for every endpoint that has recorded tasks, sorted by endpoint.
+    @objc public func snapshot() -> [HTTPManagerLatencySnapshot] {
+        let endpoints = inner.sync({ $0.endpoints })
+        return endpoints.sorted(by: { $0.key < $1.key }).map({ (name, endpoint) in
+            HTTPManagerLatencySnapshot(endpoint: name, histograms: endpoint.histograms.map(HTTPManagerLatencyHistogram.init))
+        }).filter({ $0.count > 0 })
+    }
+    
+    /// Clears every histogram.
+    ///
+    /// Tasks that complete while the histograms are being cleared may or may not be recorded.
+    @objc public func reset() {
+        for endpoint in inner.sync({ Array($0.endpoints.values) }) {
+            for histogram in endpoint.histograms {
+                histogram.reset()
+            }
+        }
+    }
+    
+    // MARK: - Internal
+    
+    /// Returns a new timeline for a task with the given request.
+    internal func makeTimeline(for request: URLRequest) -> LatencyTimeline {
+        return LatencyTimeline(recorder: self, endpoint: endpointName(request))
+    }
+    
+    /// Records the latency of a completed task.
+    internal func record(_ latency: HTTPManagerTaskLatency, endpoint name: String) {
+        let histograms = self.histograms(for: name)
+        for (histogram, nanoseconds) in zip(histograms, latency.nanoseconds) {
+            histogram.recordNanoseconds(nanoseconds)
+        }
+    }
+    
+    // MARK: - Private
+    
+    private static func defaultEndpointName(_ request: URLRequest) -> String {
+        return "\(request.httpMethod ?? "GET") \(request.url?.host ?? "")\(request.url?.path ?? "")"
+    }
+    
+    private let endpointName: (URLRequest) -> String
+    
+    private final class Endpoint {
+        /// One histogram per phase, indexed by `HTTPManagerLatencyPhase.rawValue`.
+        let histograms = HTTPManagerLatencyPhase.allPhases.map({ _ in _PMHTTPLatencyHistogram() })
+    }
+    
+    private final class Inner {
+        var endpoints: [String: Endpoint] = [:]
+    }
+    
+    private let inner = QueueConfined(label: "HTTPManagerLatencyRecorder internal queue", value: Inner())
+    
+    private func histograms(for name: String) -> [_PMHTTPLatencyHistogram] {
+        if let endpoint = inner.sync({ $0.endpoints[name] }) {
+            return endpoint.histograms
+        }
+        return inner.syncBarrier { inner -> [_PMHTTPLatencyHistogram] in
+            if let endpoint = inner.endpoints[name] {
+                return endpoint.histograms
+            }
+            // The overflow bucket doesn't count against the limit.
+            let key = inner.endpoints.count - (inner.endpoints[HTTPManagerLatencyRecorder.otherEndpoint] == nil ? 0 : 1) < maximumEndpointCount ? name : HTTPManagerLatencyRecorder.otherEndpoint
+            let endpoint = inner.endpoints[key] ?? Endpoint()
+            inner.endpoints[key] = endpoint
+            return endpoint.histograms
+        }
+    }
+}
+
+/// The aggregated latency of the tasks recorded for one endpoint.
+///
+/// - SeeAlso: `HTTPManagerLatencyRecorder.snapshot()`.
+public final class HTTPManagerLatencySnapshot: NSObject {
+    /// The name of the endpoint.
+    @objc public let endpoint: String
+    
+    /// The number of tasks recorded for the endpoint.
+    @objc public var count: Int {
+        return histograms[HTTPManagerLatencyPhase.total.rawValue].count
+    }
+    
+    /// Returns the histogram for `phase`.
+    @objc(histogramForPhase:)
+    public func histogram(for phase: HTTPManagerLatencyPhase) -> HTTPManagerLatencyHistogram {
+        return histograms[phase.rawValue]
+    }
+    
+    public override var description: String {
+        let ptr = UInt(bitPattern: Unmanaged.passUnretained(self).toOpaque())
+        return "<HTTPManagerLatencySnapshot: 0x\(String(ptr, radix: 16)) endpoint=\(String(reflecting: endpoint)) count=\(count) total=\(histogram(for: .total))>"
+    }
+    
+    private let histograms: [HTTPManagerLatencyHistogram]
+    
+    fileprivate init(endpoint: String, histograms: [HTTPManagerLatencyHistogram]) {
+        self.endpoint = endpoint
+        self.histograms = histograms
+        super.init()
+    }
+}
+
+/// A snapshot of the distribution of durations for one phase of one endpoint.
+///
+/// Durations are recorded with microsecond granularity into buckets that are at most 12.5% wide,
+/// so percentiles are accurate to within 12.5%. `minimum`, `maximum` and `mean` are exact.
+public final class HTTPManagerLatencyHistogram: NSObject {
+    /// The number of recorded durations.
+    @objc public let count: Int
+    /// The smallest recorded duration in seconds, or `0` if `count` is `0`.
+    @objc public let minimum: TimeInterval
+    /// The largest recorded duration in seconds, or `0` if `count` is `0`.
+    @objc public let maximum: TimeInterval
+    /// The mean of the recorded durations in seconds, or `0` if `count` is `0`.
+    @objc public let mean: TimeInterval
+    
+    /// The median duration in seconds.
+    @objc public var p50: TimeInterval {
+        return percentile(50)
+    }
+    
+    /// The 95th percentile duration in seconds.
+    @objc public var p95: TimeInterval {
+        return percentile(95)
+    }
+    
+    /// The 99th percentile duration in seconds.
+    @objc public var p99: TimeInterval {
+        return percentile(99)
+    }
+    
+    /// Returns the duration in seconds that `percentile` percent of the recorded durations are
+    /// less than or equal to, or `0` if `count` is `0`.
+    ///
+    /// - Parameter percentile: A percentile between 0 and 100.
+    @objc(durationAtPercentile:)
+    public func percentile(_ percentile: Double) -> TimeInterval {
+        let total = bucketCounts.reduce(0, +)
+        guard total > 0 else { return 0 }
+        let rank = max(UInt64((min(max(percentile, 0), 100) / 100 * Double(total)).rounded(.up)), 1)
+        var seen: UInt64 = 0
+        for (index, bucketCount) in bucketCounts.enumerated() where bucketCount > 0 {
+            seen += bucketCount
+            if seen >= rank {
+                // Report the middle of the bucket, clamped to the exact bounds we know about.
+                let lower = _PMHTTPLatencyHistogram.lowerBound(ofBucket: UInt(index))
+                let upper = _PMHTTPLatencyHistogram.upperBound(ofBucket: UInt(index))
+                let midpoint = TimeInterval(lower + (upper - lower) / 2) / 1e6
+                return min(max(midpoint, minimum), maximum)
+            }
+        }
+        return maximum
+    }
+    
+    public override var description: String {
+        func format(_ value: TimeInterval) -> String {
+            return String(format: "%.3fms", value * 1000)
+        }
+        return "<HTTPManagerLatencyHistogram: count=\(count) p50=\(format(p50)) p95=\(format(p95)) p99=\(format(p99)) max=\(format(maximum))>"
+    }
+    
+    private let bucketCounts: [UInt64]
+    
+    fileprivate init(_ histogram: _PMHTTPLatencyHistogram) {
+        var bucketCounts = [UInt64](repeating: 0, count: Int(_PMHTTPLatencyHistogram.bucketCount))
+        histogram.getBucketCounts(&bucketCounts)
+        self.bucketCounts = bucketCounts
+        // Every bucket is incremented before the totals, so use the buckets for the count in case
+        // a task is being recorded concurrently.
+        let count = bucketCounts.reduce(0, +)
+        self.count = Int(count)
+        if count > 0 {
+            minimum = TimeInterval(min(histogram.minimum, histogram.maximum)) / 1e6
+            maximum = TimeInterval(histogram.maximum) / 1e6
+            mean = TimeInterval(histogram.sum) / 1e6 / TimeInterval(count)
+        } else {
+            minimum = 0
+            maximum = 0
+            mean = 0
+        }
+        super.init()
+    }
+}
+
+/// Collects the timestamps of the phases of a single task.
+///
+/// The phases of a task happen one after another, but not always on the same thread, so the
+/// timeline is guarded by a lock. The lock is never contended in practice.
+internal final class LatencyTimeline {
+    init(recorder: HTTPManagerLatencyRecorder, endpoint: String) {
+        self.recorder = recorder
+        self.endpoint = endpoint
+    }
+    
+    /// The latency of the task, once it's completed.
+    var latency: HTTPManagerTaskLatency? {
+        lock.lock()
+        defer { lock.unlock() }
+        return _latency
+    }
+    
+    /// Records that the task was resumed. Only the first call has any effect.
+    func resumed() {
+        let now = getMachAbsoluteTimeInNanoseconds()
+        lock.lock()
+        defer { lock.unlock() }
+        guard resumeTime == nil else { return }
+        resumeTime = now
+        lastEvent = now
+    }
+    
+    /// Records that a network task of the task is starting.
+    func networkStarted() {
+        let now = getMachAbsoluteTimeInNanoseconds()
+        lock.lock()
+        defer { lock.unlock() }
+        // Retries start a new network task once the previous result has been processed.
+        guard resumeTime != nil, state == .created || state == .deciding else { return }
+        let phase: HTTPManagerLatencyPhase = state == .created ? .queue : .retry
+        durations[phase.rawValue] += now &- lastEvent
+        lastEvent = now
+        state = .network
+        attempts += 1
+    }
+    
+    /// Records that the session delegate was told the current network task finished.
+    func networkFinished() {
+        mark(.network, from: .network, to: .dispatching)
+    }
+    
+    /// Records that the result of the current network task is starting to be processed.
+    func processingStarted() {
+        mark(.dispatch, from: .dispatching, to: .processing)
+    }
+    
+    /// Records that the result of the current network task has been processed.
+    func processingFinished() {
+        mark(.processing, from: .processing, to: .deciding)
+    }
+    
+    /// Records that the result is being handed to the completion queue.
+    func completionScheduled() {
+        mark(.retry, from: .deciding, to: .completing)
+    }
+    
+    /// Records that the completion handler is about to be invoked, and records the task's
+    /// latency with the recorder.
+    ///
+    /// - Parameter record: `false` if the task was canceled, in which case its latency isn't
+    ///   recorded.
+    func completionStarted(record: Bool) {
+        let now = getMachAbsoluteTimeInNanoseconds()
+        lock.lock()
+        guard state == .completing, let resumeTime = resumeTime else {
+            lock.unlock()
+            return
+        }
+        durations[HTTPManagerLatencyPhase.completion.rawValue] += now &- lastEvent
+        durations[HTTPManagerLatencyPhase.total.rawValue] = now &- resumeTime
+        state = .completed
+        let latency = HTTPManagerTaskLatency(attempts: attempts, nanoseconds: durations)
+        _latency = latency
+        lock.unlock()
+        if record {
+            recorder.record(latency, endpoint: endpoint)
+        }
+    }
+    
+    private enum State {
+        case created, network, dispatching, processing, deciding, completing, completed
+    }
+    
+    private let recorder: HTTPManagerLatencyRecorder
+    private let endpoint: String
+    private let lock = NSLock()
+    private var state: State = .created
+    private var resumeTime: UInt64?
+    private var lastEvent: UInt64 = 0
+    private var attempts = 0
+    private var durations = [UInt64](repeating: 0, count: HTTPManagerLatencyPhase.allPhases.count)
+    private var _latency: HTTPManagerTaskLatency?
+    
+    /// Adds the time since the last event to `phase` and moves to `newState`.
+    ///
+    /// Does nothing if the task isn't in `oldState` or was never resumed.
+    private func mark(_ phase: HTTPManagerLatencyPhase, from oldState: State, to newState: State) {
+        let now = getMachAbsoluteTimeInNanoseconds()
+        lock.lock()
+        defer { lock.unlock() }
+        guard resumeTime != nil, state == oldState else { return }
+        durations[phase.rawValue] += now &- lastEvent
+        lastEvent = now
+        state = newState
+    }
+}
@@ -0,0 +1,486 @@
+//
+//  MockRecording.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import Foundation
+
+extension HTTPMockManager {
+    /// Serves the responses in an archive as mocks.
+    ///
+    /// Requests are matched against the recorded requests by HTTP method and absolute URL,
+    /// including the query. Requests that match the same recorded request are given its responses
+    /// in the order they were recorded, and once those run out the last one is repeated.
+    ///
+    /// Mocks added with `addMock(for:…)` take precedence over replays, and replays added later
+    /// take precedence over replays added earlier. Requests that don't match any recorded request
+    /// are handled as though there was no replay, which means they're subject to
+    /// `interceptUnhandledEnvironmentURLs` and `interceptUnhandledExternalURLs`.
+    ///
+    /// - Parameter archive: The archive to serve responses from.
+    /// - Parameter timing: (Optional) When to deliver each response. The default value is
+    ///   `.original`.
+    /// - Returns: An `HTTPMockToken` object that can be passed to `removeMock(_:)` to stop the
+    ///   replay.
+    ///
+    /// - SeeAlso: `HTTPMockRecorder`, `HTTPMockArchive`.
+    @discardableResult
+    @objc(addReplayOfArchive:timing:)
+    public func addReplay(of archive: HTTPMockArchive, timing: HTTPMockReplayTiming = .original) -> HTTPMockToken {
+        let replay = HTTPMockReplay(archive: archive, timing: timing)
+        addReplay(replay)
+        return replay
+    }
+}
+
+/// When `HTTPMockManager.addReplay(of:timing:)` delivers recorded responses.
+@objc public enum HTTPMockReplayTiming: Int, CustomStringConvertible {
+    /// Each response is delivered once as much time has passed as the original request took.
+    case original
+    /// Each response is delivered as soon as possible.
+    case immediate
+    
+    public var description: String {
+        switch self {
+        case .original: return "original"
+        case .immediate: return "immediate"
+        }
+    }
+}
+
+/// Errors thrown when opening an `HTTPMockArchive` or appending to one with an `HTTPMockRecorder`.
+@objc public enum HTTPMockArchiveError: Int, Error {
+    /// The data doesn't start with an archive header for a supported version.
+    case invalidHeader
+    /// A record in the archive is malformed.
+    case invalidRecord
+}
+
+// MARK: -
+
+/// Records the live responses to requests into an archive.
+///
+/// Assign a recorder to `HTTPMockManager.recorder` to record the response to every network task
+/// that isn't mocked. This includes each retry of a task. Streamed responses aren't recorded,
+/// since their bodies aren't buffered. The archive can later be opened with `HTTPMockArchive` and
+/// served with `HTTPMockManager.addReplay(of:timing:)`.
+///
+/// The archive is append-only. Opening a recorder on an existing archive appends to it, and a
+/// partially-written record at the end of an archive (such as when the app is killed while it's
+/// recording) is ignored when the archive is opened. Records are encoded and written on a private
+/// queue, and writes are buffered, so recording adds little to the cost of completing a task.
+/// Call `flush()` to make sure everything recorded so far is in the file.
+///
+/// Bodies are recorded as delivered by `URLSession`, which means after any `Content-Encoding` has
+/// been decoded, so the `Content-Encoding`, `Content-Length` and `Transfer-Encoding` headers are
+/// left out. Request bodies aren't recorded.
+///
+/// **Thread safety:** All methods in this class are safe to call from any thread.
+public final class HTTPMockRecorder: NSObject {
+    /// The URL of the archive.
+    @objc public let fileURL: URL
+    
+    /// Creates a recorder that appends to the archive at `fileURL`, creating it if necessary.
+    ///
+    /// If the archive ends with a partially-written record, that record is discarded before
+    /// anything new is appended.
+    ///
+    /// - Parameter fileURL: The file URL of the archive.
+    /// - Throws: `HTTPMockArchiveError` if the file already exists but isn't a valid archive, or
+    ///   any error that occurs while opening the file.
+    @objc public init(fileURL: URL) throws {
+        self.fileURL = fileURL
+        let attributes = try? FileManager.default.attributesOfItem(atPath: fileURL.path)
+        let length: Int
+        if ((attributes?[.size] as? NSNumber)?.intValue ?? 0) == 0 {
+            try HTTPMockArchive.header.write(to: fileURL)
+            length = HTTPMockArchive.header.count
+        } else {
+            // The mapping must be gone before the file is truncated.
+            length = try autoreleasepool(invoking: { try HTTPMockArchive(contentsOf: fileURL).completeLength })
+        }
+        fileHandle = try FileHandle(forWritingTo: fileURL)
+        // This also positions the file handle at the end. Without it, new records would be
+        // appended inside the length of a partially-written one.
+        fileHandle.truncateFile(atOffset: UInt64(length))
+        startTime = DispatchTime.now().uptimeNanoseconds
+        super.init()
+    }
+    
+    deinit {
+        write()
+        fileHandle.closeFile()
+    }
+    
+    /// The number of responses recorded so far.
+    @objc public var recordedCount: Int {
+        return queue.sync(execute: { _recordedCount })
+    }
+    
+    /// Writes every response recorded so far to the archive.
+    @objc public func flush() {
+        queue.sync(execute: write)
+    }
+    
+    // MARK: Internal
+    
+    /// Appends a response to the archive. Responses too large for the archive format are skipped.
+    ///
+    /// - Parameter startTime: The uptime in nanoseconds when the request's network task was resumed.
+    /// - Parameter endTime: The uptime in nanoseconds when the network task finished.
+    internal func record(_ request: URLRequest, response: HTTPURLResponse, body: Data, startTime: UInt64, endTime: UInt64) {
+        guard let url = request.url else { return }
+        let method = request.httpMethod ?? "GET"
+        var headers: [(String, String)] = []
+        headers.reserveCapacity(response.allHeaderFields.count)
+        for case let (name as String, value as String) in response.allHeaderFields {
+            if HTTPMockRecorder.omittedHeaders.contains(CaseInsensitiveASCIIString(name)) { continue }
+            headers.append((name, value))
+        }
+        let statusCode = response.statusCode
+        queue.async {
+            let start = startTime >= self.startTime ? startTime - self.startTime : 0
+            let duration = endTime >= startTime ? endTime - startTime : 0
+            guard HTTPMockArchive.appendRecord(to: &self.buffer, startOffset: start, duration: duration, statusCode: statusCode, method: method, url: url.absoluteString, headers: headers, body: body) else {
+                NSLog("[HTTPManager] HTTPMockRecorder skipped a response for \(method) \(url.absoluteString) that's too large to archive (\(body.count) bytes)")
+                return
+            }
+            self._recordedCount += 1
+            if self.buffer.count >= HTTPMockRecorder.bufferSize {
+                self.write()
+            }
+        }
+    }
+    
+    // MARK: Private
+    
+    private static let omittedHeaders: Set<CaseInsensitiveASCIIString> = ["Content-Encoding", "Content-Length", "Transfer-Encoding"]
+    
+    /// The number of buffered bytes that triggers a write.
+    private static let bufferSize = 256 * 1024
+    
+    private let queue = DispatchQueue(label: "HTTPMockRecorder queue")
+    private let fileHandle: FileHandle
+    /// The uptime in nanoseconds when the recorder was created. Start offsets are relative to this.
+    private let startTime: UInt64
+    /// Encoded records that haven't been written yet. Only accessed from `queue`.
+    private var buffer = Data()
+    /// Only accessed from `queue`.
+    private var _recordedCount = 0
+    
+    /// Must be called on `queue`, or from `deinit`.
+    private func write() {
+        guard !buffer.isEmpty else { return }
+        fileHandle.write(buffer)
+        buffer.removeAll(keepingCapacity: true)
+    }
+}
+
+// MARK: -
+
+/// An archive of responses recorded by an `HTTPMockRecorder`.
+///
+/// Archives opened from a file are memory-mapped, and the bodies of the entries refer to the
+/// mapped data instead of being copied. Opening an archive only validates and indexes its
+/// records; entries are decoded when they're requested.
+///
+/// **Thread safety:** Archives are immutable, and all methods in this class are safe to call from any
+/// thread.
+public final class HTTPMockArchive: NSObject {
+    /// Opens the archive at `fileURL`.
+    ///
+    /// - Parameter fileURL: The file URL of the archive.
+    /// - Throws: `HTTPMockArchiveError` if the file isn't a valid archive, or any error that
+    ///   occurs while reading the file.
+    @objc public convenience init(contentsOf fileURL: URL) throws {
+        try self.init(data: Data(contentsOf: fileURL, options: .alwaysMapped))
+    }
+    
+    /// Opens an archive from data in memory.
+    ///
+    /// - Parameter data: The contents of an archive.
+    /// - Throws: `HTTPMockArchiveError` if the data isn't a valid archive.
+    @objc public init(data: Data) throws {
+        guard data.count >= HTTPMockArchive.header.count, data.prefix(HTTPMockArchive.header.count) == HTTPMockArchive.header else {
+            throw HTTPMockArchiveError.invalidHeader
+        }
+        var records: [Range<Int>] = []
+        var index: [String: [Int]] = [:]
+        var offset = data.startIndex + HTTPMockArchive.header.count
+        while true {
+            var reader = Reader(data: data, range: offset..<data.endIndex)
+            // A partially-written record can only be the last one, so it's ignored.
+            guard let length = reader.readInteger(UInt32.self), let range = reader.readRange(count: Int(length)) else { break }
+            var recordReader = Reader(data: data, range: range)
+            guard let key = recordReader.validateRecord() else { throw HTTPMockArchiveError.invalidRecord }
+            index[key, default: []].append(records.count)
+            records.append(range)
+            offset = range.upperBound
+        }
+        self.data = data
+        self.records = records
+        self.index = index
+        completeLength = offset - data.startIndex
+        super.init()
+    }
+    
+    /// The number of entries in the archive.
+    @objc public var count: Int {
+        return records.count
+    }
+    
+    /// Returns the entry at `index`, which must be less than `count`.
+    @objc(entryAtIndex:)
+    public func entry(at index: Int) -> HTTPMockArchiveEntry {
+        var reader = Reader(data: data, range: records[index])
+        guard let entry = reader.readEntry() else {
+            fatalError("HTTPMockArchive: record \(index) changed after it was validated")
+        }
+        return entry
+    }
+    
+    // MARK: Internal
+    
+    /// The magic number and format version that every archive starts with.
+    internal static let header = Data("PMHTTPMA\u{1}\0\0\0".utf8)
+    
+    /// Returns the indices of the entries for a key returned by `key(method:url:)`, in the order
+    /// they were recorded.
+    internal func entryIndices(forKey key: String) -> [Int]? {
+        return index[key]
+    }
+    
+    /// The length of the archive up to the end of the last complete record.
+    internal let completeLength: Int
+    
+    internal static func key(method: String, url: String) -> String {
+        return "\(method.uppercased()) \(url)"
+    }
+    
+    /// Encodes a record and appends it to `data`.
+    ///
+    /// Each record is a little-endian `UInt32` length followed by the start offset and duration in
+    /// nanoseconds (`UInt64`), the status code (`UInt16`), the method (`UInt16` length and UTF-8),
+    /// the URL (`UInt32` length and UTF-8), the header count (`UInt16`) and each header name
+    /// (`UInt16` length and UTF-8) and value (`UInt32` length and UTF-8), and then the body, which
+    /// takes up the rest of the record.
+    ///
+    /// - Returns: `false` without appending anything if the record is too long for its length to
+    ///   fit in a `UInt32`, i.e. if the body is around 4 GiB or larger.
+    @discardableResult
+    internal static func appendRecord(to data: inout Data, startOffset: UInt64, duration: UInt64, statusCode: Int, method: String, url: String, headers: [(String, String)], body: Data) -> Bool {
+        let headerCount = min(headers.count, Int(UInt16.max))
+        var length = 8 + 8 + 2 + 2 + method.utf8.count + 4 + url.utf8.count + 2 + body.count
+        for (name, value) in headers.prefix(headerCount) {
+            length += 2 + name.utf8.count + 4 + value.utf8.count
+        }
+        // A truncated length would make the rest of the archive unreadable.
+        guard let encodedLength = UInt32(exactly: length) else { return false }
+        data.reserveCapacity(data.count + 4 + length)
+        data.appendLittleEndian(encodedLength)
+        data.appendLittleEndian(startOffset)
+        data.appendLittleEndian(duration)
+        data.appendLittleEndian(UInt16(clamping: statusCode))
+        data.appendString(method, lengthType: UInt16.self)
+        data.appendString(url, lengthType: UInt32.self)
+        data.appendLittleEndian(UInt16(headerCount))
+        for (name, value) in headers.prefix(headerCount) {
+            data.appendString(name, lengthType: UInt16.self)
+            data.appendString(value, lengthType: UInt32.self)
+        }
+        data.append(body)
+        return true
+    }
+    
+    // MARK: Private
+    
+    private let data: Data
+    /// The byte range of each record, not including its length.
+    private let records: [Range<Int>]
+    /// The indices of the records for each method and URL.
+    private let index: [String: [Int]]
+    
+    private struct Reader {
+        let data: Data
+        var offset: Int
+        let end: Int
+        
+        init(data: Data, range: Range<Int>) {
+            self.data = data
+            offset = range.lowerBound
+            end = range.upperBound
+        }
+        
+        mutating func readInteger<T: FixedWidthInteger>(_: T.Type) -> T? {
+            let size = MemoryLayout<T>.size
+            guard end - offset >= size else { return nil }
+            var value: T = 0
+            let range = offset..<(offset + size)
+            Swift.withUnsafeMutableBytes(of: &value) { buffer in
+                data.copyBytes(to: buffer.baseAddress!.assumingMemoryBound(to: UInt8.self), from: range)
+            }
+            offset += size
+            return T(littleEndian: value)
+        }
+        
+        mutating func readRange(count: Int) -> Range<Int>? {
+            guard end - offset >= count else { return nil }
+            defer { offset += count }
+            return offset..<(offset + count)
+        }
+        
+        mutating func readString<T: FixedWidthInteger>(lengthType: T.Type) -> String? {
+            guard let length = readInteger(T.self), let range = readRange(count: Int(length)) else { return nil }
+            return String(decoding: data[range], as: UTF8.self)
+        }
+        
+        mutating func skipString<T: FixedWidthInteger>(lengthType: T.Type) -> Bool {
+            guard let length = readInteger(T.self) else { return false }
+            return readRange(count: Int(length)) != nil
+        }
+        
+        /// Checks that a record is well-formed without decoding its headers or body, and returns
+        /// its index key.
+        mutating func validateRecord() -> String? {
+            guard readRange(count: 8 + 8 + 2) != nil,
+                let method = readString(lengthType: UInt16.self),
+                let url = readString(lengthType: UInt32.self),
+                let headerCount = readInteger(UInt16.self)
+                else { return nil }
+            for _ in 0..<headerCount {
+                guard skipString(lengthType: UInt16.self), skipString(lengthType: UInt32.self) else { return nil }
+            }
+            return HTTPMockArchive.key(method: method, url: url)
+        }
+        
+        mutating func readEntry() -> HTTPMockArchiveEntry? {
+            guard let startOffset = readInteger(UInt64.self),
+                let duration = readInteger(UInt64.self),
+                let statusCode = readInteger(UInt16.self),
+                let method = readString(lengthType: UInt16.self),
+                let url = readString(lengthType: UInt32.self),
+                let headerCount = readInteger(UInt16.self)
+                else { return nil }
+            var headers: [String: String] = [:]
+            headers.reserveCapacity(Int(headerCount))
+            for _ in 0..<headerCount {
+                guard let name = readString(lengthType: UInt16.self), let value = readString(lengthType: UInt32.self) else { return nil }
+                headers[name] = value
+            }
+            return HTTPMockArchiveEntry(startOffset: TimeInterval(startOffset) / 1e9, duration: TimeInterval(duration) / 1e9, httpMethod: method, urlString: url,
+                                        statusCode: Int(statusCode), headerFields: headers, body: data[offset..<end])
+        }
+    }
+}
+
+/// A response recorded in an `HTTPMockArchive`.
+public final class HTTPMockArchiveEntry: NSObject {
+    /// When the request started, in seconds since its `HTTPMockRecorder` was created.
+    ///
+    /// This can be used to issue recorded requests at their original rate.
+    @objc public let startOffset: TimeInterval
+    /// How long the request took, in seconds.
+    @objc public let duration: TimeInterval
+    /// The HTTP method of the request.
+    @objc public let httpMethod: String
+    /// The absolute URL of the request, as a string.
+    @objc public let urlString: String
+    /// The status code of the response.
+    @objc public let statusCode: Int
+    /// The header fields of the response.
+    @objc public let headerFields: [String: String]
+    /// The body of the response.
+    @objc public let body: Data
+    
+    /// The URL of the request, or `nil` if `urlString` can't be parsed.
+    @objc public var url: URL? {
+        return URL(string: urlString)
+    }
+    
+    public override var description: String {
+        return "<HTTPMockArchiveEntry: \(httpMethod) \(urlString) -> \(statusCode), \(body.count) bytes>"
+    }
+    
+    fileprivate init(startOffset: TimeInterval, duration: TimeInterval, httpMethod: String, urlString: String, statusCode: Int, headerFields: [String: String], body: Data) {
+        self.startOffset = startOffset
+        self.duration = duration
+        self.httpMethod = httpMethod
+        self.urlString = urlString
+        self.statusCode = statusCode
+        self.headerFields = headerFields
+        self.body = body
+        super.init()
+    }
+}
+
+// MARK: - Internal
+
+/// A replay registered with `HTTPMockManager.addReplay(of:timing:)`.
+internal final class HTTPMockReplay: HTTPMockToken {
+    let archive: HTTPMockArchive
+    let timing: HTTPMockReplayTiming
+    
+    init(archive: HTTPMockArchive, timing: HTTPMockReplayTiming) {
+        self.archive = archive
+        self.timing = timing
+    }
+    
+    /// Returns a mock that serves the next recorded response for `request`, or `nil` if the
+    /// request wasn't recorded.
+    func mockInstance(for request: URLRequest) -> HTTPMockInstance? {
+        guard let url = request.url else { return nil }
+        let key = HTTPMockArchive.key(method: request.httpMethod ?? "GET", url: url.absoluteString)
+        guard let indices = archive.entryIndices(forKey: key) else { return nil }
+        lock.lock()
+        let position = cursors[key] ?? 0
+        cursors[key] = min(position + 1, indices.count - 1)
+        lock.unlock()
+        let entry = archive.entry(at: indices[position])
+        let delay = timing == .original ? entry.duration : 0
+        return HTTPMockInstance(queue: DispatchQueue.global(qos: .utility), parameters: [:], handler: { (request, parameters, completion) in
+            var headers = entry.headerFields
+            headers["Content-Length"] = String(entry.body.count)
+            let response = HTTPURLResponse(url: request.url!, statusCode: entry.statusCode, httpVersion: "HTTP/1.1", headerFields: headers)!
+            if delay > 0 {
+                DispatchQueue.global(qos: .utility).asyncAfter(deadline: DispatchTime.now() + delay) {
+                    autoreleasepool {
+                        completion(response, entry.body)
+                    }
+                }
+            } else {
+                completion(response, entry.body)
+            }
+        })
+    }
+    
+    private let lock = NSLock()
+    /// The position in the recorded responses for each request. Guarded by `lock`.
+    private var cursors: [String: Int] = [:]
+}
+
+private extension Data {
+    mutating func appendLittleEndian<T: FixedWidthInteger>(_ value: T) {
+        var value = value.littleEndian
+        Swift.withUnsafeBytes(of: &value) { buffer in
+            append(buffer.baseAddress!.assumingMemoryBound(to: UInt8.self), count: buffer.count)
+        }
+    }
+    
+    /// Appends the length of the UTF-8 form of `string` followed by the UTF-8 itself, truncating
+    /// it if its length doesn't fit in `lengthType`.
+    mutating func appendString<T: FixedWidthInteger>(_ string: String, lengthType: T.Type) {
+        let utf8 = string.utf8
+        let count = Swift.min(utf8.count, Int(clamping: T.max))
+        appendLittleEndian(T(count))
+        append(contentsOf: utf8.prefix(count))
+    }
+}
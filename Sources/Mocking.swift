@@ -63,6 +63,21 @@ public final class HTTPMockManager: NSObject {
         }
     }
     
+    /// A recorder that the response to every network task that isn't mocked is recorded to.
+    /// The default value is `nil`.
+    ///
+    /// - SeeAlso: `HTTPMockRecorder`, `addReplay(of:timing:)`.
+    @objc public var recorder: HTTPMockRecorder? {
+        get {
+            // This is read when every unmocked network task finishes, so it's kept out of `inner`
+            // to avoid a trip through the queue.
+            return _recorder.value as? HTTPMockRecorder
+        }
+        set {
+            _recorder.value = newValue ?? NSNull()
+        }
+    }
+    
     /// Adds a mock to the mock manager that returns a given response.
     ///
     /// All requests that match this mock will be given the same response.
@@ -234,7 +249,7 @@ public final class HTTPMockManager: NSObject {
     @objc public func addMock(for url: String, httpMethod: String? = nil, queue: DispatchQueue? = nil, handler: @escaping (_ request: URLRequest, _ parameters: [String: String], _ completion: @escaping (_ response: HTTPURLResponse, _ body: Data) -> Void) -> Void) -> HTTPMockToken {
         let mock = HTTPMock(url: url, httpMethod: httpMethod, queue: queue ?? DispatchQueue(label: "HTTPMock queue"), handler: handler)
         inner.asyncBarrier { inner in
-            inner.mocks.append(mock)
+            inner.add(mock)
         }
         return mock
     }
@@ -275,36 +290,55 @@ public final class HTTPMockManager: NSObject {
     ///
     /// - Parameter token: An `HTTPMockToken` returned by a previous call to `addMock`.
     @objc public func removeMock(_ token: HTTPMockToken) {
-        inner.asyncBarrier { inner in
-            if let idx = inner.mocks.index(where: { $0 === token }) {
-                inner.mocks.remove(at: idx)
+        if let replay = token as? HTTPMockReplay {
+            inner.asyncBarrier { inner in
+                if let idx = inner.replays.index(where: { $0 === replay }) {
+                    inner.replays.remove(at: idx)
+                }
             }
+            return
+        }
+        guard let mock = token as? HTTPMock else { return }
+        inner.asyncBarrier { inner in
+            inner.index.remove(mock)
         }
     }
     
-    /// Removes all mocks from the mock manager.
+    /// Removes all mocks and replays from the mock manager.
     @objc public func removeAllMocks() {
         inner.asyncBarrier { inner in
-            inner.mocks.removeAll()
+            inner.index = HTTPMockIndex()
+            inner.replays.removeAll()
         }
     }
     
     /// Resets the mock manager back to the defaults.
     ///
-    /// This removes all mocks and resets all properties back to their default values.
+    /// This removes all mocks and replays and resets all properties back to their default values.
     @objc public func reset() {
         inner.asyncBarrier({ $0.reset() })
+        _recorder.value = NSNull()
     }
     
     internal func mockForRequest(_ request: URLRequest, environment: HTTPManager.Environment?) -> HTTPMockInstance? {
         guard let url = request.url, let components = URLComponents(url: url, resolvingAgainstBaseURL: true) else { return nil }
         let method = request.httpMethod
+        let pathComponents = components.pathComponents ?? []
         return inner.sync { inner in
-            for mock in inner.mocks.reversed() {
+            // The index only narrows down the mocks that could match. Evaluate them in reverse order
+            // of addition so the most recently added mock wins.
+            var candidates = inner.index.candidates(host: components.percentEncodedHost, httpMethod: method, pathComponents: pathComponents)
+            candidates.sort(by: { $0.sequenceNumber > $1.sequenceNumber })
+            for mock in candidates {
                 if case .matches(let parameters) = mock.handleURL(components, method, environment) {
                     return HTTPMockInstance(queue: mock.queue, parameters: parameters, handler: mock.handler)
                 }
             }
+            for replay in inner.replays.reversed() {
+                if let mock = replay.mockInstance(for: request) {
+                    return mock
+                }
+            }
             if environment?.isPrefix(of: url) ?? false {
                 if inner.interceptUnhandledEnvironmentURLs {
                     return HTTPMockInstance.unhandledURLMock
@@ -316,15 +350,34 @@ public final class HTTPMockManager: NSObject {
         }
     }
     
+    internal func addReplay(_ replay: HTTPMockReplay) {
+        inner.asyncBarrier { inner in
+            inner.replays.append(replay)
+        }
+    }
+    
     private var inner: QueueConfined<Inner> = QueueConfined(label: "HTTPMockManager internal queue", value: Inner())
+    /// Holds the `recorder`, or `NSNull` if there isn't one.
+    private let _recorder = _PMHTTPAtomicReference(value: NSNull())
     
     private class Inner {
-        var mocks: [HTTPMock] = []
+        var index = HTTPMockIndex()
+        /// The sequence number for the next mock that's added.
+        var nextSequenceNumber = 0
         var interceptUnhandledEnvironmentURLs: Bool = false
         var interceptUnhandledExternalURLs: Bool = false
+        /// Replays in order of addition.
+        var replays: [HTTPMockReplay] = []
+        
+        func add(_ mock: HTTPMock) {
+            mock.sequenceNumber = nextSequenceNumber
+            nextSequenceNumber += 1
+            index.insert(mock)
+        }
         
         func reset() {
-            mocks.removeAll()
+            index = HTTPMockIndex()
+            replays = []
             interceptUnhandledExternalURLs = false
             interceptUnhandledEnvironmentURLs = false
         }
@@ -624,8 +677,34 @@ internal class HTTPMock: HTTPMockToken, CustomStringConvertible {
         case matches(parameters: [String: String])
     }
     
+    /// A component of the path of a mock URL.
+    enum PathComponent {
+        case string(Swift.String)
+        case token(Swift.String)
+        
+        init(_ string: Swift.String) {
+            if string.hasPrefix(":") && string != ":" {
+                self = .token(Swift.String(string.unicodeScalars.dropFirst()))
+            } else {
+                self = .string(string)
+            }
+        }
+    }
+    
     let handleURL: (URLComponents, _ httpMethod: String?, _ environment: HTTPManager.Environment?) -> MatchResult
     
+    /// The components of the mock's own path, which must match the end of a request's path, or
+    /// `nil` if the mock's URL couldn't be parsed.
+    let pathPattern: [PathComponent]?
+    /// The lowercased host of an absolute mock URL, or `nil` if the mock can match any host.
+    let host: String?
+    /// The uppercased HTTP method, or `nil` if the mock matches any method.
+    let normalizedHTTPMethod: String?
+    /// The order in which the mock was added to its `HTTPMockManager`.
+    ///
+    /// Only accessed from within the manager's queue.
+    var sequenceNumber = 0
+    
     fileprivate let handler: (_ request: URLRequest, _ parameters: [String: String], _ completion: @escaping (_ response: HTTPURLResponse, _ body: Data) -> Void) -> Void
     fileprivate let queue: DispatchQueue
     /// The `url` parameter provided to `init`. Only used for `description`.
@@ -636,28 +715,22 @@ internal class HTTPMock: HTTPMockToken, CustomStringConvertible {
     init(url: String, httpMethod: String?, queue: DispatchQueue, handler: @escaping (_ request: URLRequest, _ parameters: [String: String], _ completion: @escaping (_ response: HTTPURLResponse, _ body: Data) -> Void) -> Void) {
         urlString = url
         self.httpMethod = httpMethod
+        normalizedHTTPMethod = httpMethod?.uppercased()
         self.queue = queue
         self.handler = handler
         // NB: URLComponents parses ":foo/bar" as a path but URL does not.
         guard var comps = URLComponents(string: url) else {
             NSLog("[HTTPManager] Warning: Mock was added with the URL \(String(reflecting: url)) but the URL could not be parsed, so the mock will never match.")
             handleURL = { _,_,_  in .noMatch}
+            pathPattern = nil
+            host = nil
             return
         }
+        // Relative mocks may pick up any host from the environment.
+        host = comps.scheme != nil ? comps.percentEncodedHost?.lowercased() : nil
         // Don't convert comps into absolute yet as environment changes should affect relative mocks.
         // But do parse out the :tokens right now so that way :tokens in the environment path aren't treated as parameters.
-        enum Component {
-            case string(Swift.String)
-            case token(Swift.String)
-            init(_ string: Swift.String) {
-                if string.hasPrefix(":") && string != ":" {
-                    self = .token(Swift.String(string.unicodeScalars.dropFirst()))
-                } else {
-                    self = .string(string)
-                }
-            }
-        }
-        let mockComps: [Component]
+        let mockComps: [PathComponent]
         do {
             var pathComps = comps.pathComponents ?? []
             // Drop the leading "/" if present since we'll test that against the absolute path instead.
@@ -669,8 +742,9 @@ internal class HTTPMock: HTTPMockToken, CustomStringConvertible {
                 // Resolving against the environment should keep the path.
                 comps.percentEncodedPath = ""
             }
-            mockComps = pathComps.map(Component.init)
+            mockComps = pathComps.map(PathComponent.init)
         }
+        pathPattern = mockComps
         
         handleURL = { (requestComponents, requestMethod, environment) in
             // Compare HTTP method
@@ -702,7 +776,7 @@ internal class HTTPMock: HTTPMockToken, CustomStringConvertible {
             guard requestPathComps.count == (pathComps.count + mockComps.count) else { return .noMatch }
             // Walk the paths and handle any :name tokens (if any).
             var parameters: [String: String] = [:]
-            for (urlComp, comp) in zip(requestPathComps, pathComps.lazy.map(Component.string).chain(mockComps)) {
+            for (urlComp, comp) in zip(requestPathComps, pathComps.lazy.map(PathComponent.string).chain(mockComps)) {
                 switch comp {
                 case .string(urlComp): break
                 case .token(let token):
@@ -720,6 +794,127 @@ internal class HTTPMock: HTTPMockToken, CustomStringConvertible {
     }
 }
 
+/// An index of mocks by host, path and HTTP method.
+///
+/// Mocks are stored in a trie of their path patterns, walked from the last component so it doesn't
+/// matter what base path a relative mock is resolved against, with `:name` tokens stored as
+/// wildcard nodes. The index only narrows down the mocks that might match a request. The mocks
+/// must still be evaluated with `HTTPMock.handleURL`.
+///
+/// **Thread safety:** This type is not thread-safe. It's meant to be stored in a `QueueConfined`.
+internal struct HTTPMockIndex {
+    /// Adds a mock to the index.
+    mutating func insert(_ mock: HTTPMock) {
+        guard let pattern = mock.pathPattern else { return } // the mock can never match
+        let root: Node
+        if let host = mock.host {
+            if let node = hosts[host] {
+                root = node
+            } else {
+                root = Node()
+                hosts[host] = root
+            }
+        } else {
+            root = anyHost
+        }
+        root.insert(mock, pattern: pattern[...])
+    }
+    
+    /// Removes a mock from the index. Does nothing if the mock isn't in the index.
+    mutating func remove(_ mock: HTTPMock) {
+        guard let pattern = mock.pathPattern else { return }
+        let root: Node?
+        if let host = mock.host {
+            root = hosts[host]
+        } else {
+            root = anyHost
+        }
+        root?.remove(mock, pattern: pattern[...])
+    }
+    
+    /// Returns every mock that might match a request, in no particular order.
+    func candidates(host: String?, httpMethod: String?, pathComponents: [String]) -> [HTTPMock] {
+        var result: [HTTPMock] = []
+        let method = httpMethod?.uppercased()
+        anyHost.collect(pathComponents[...], httpMethod: method, into: &result)
+        if let host = host?.lowercased(), let root = hosts[host] {
+            root.collect(pathComponents[...], httpMethod: method, into: &result)
+        }
+        return result
+    }
+    
+    private var hosts: [String: Node] = [:]
+    private var anyHost = Node()
+    
+    private final class Node {
+        var children: [String: Node] = [:]
+        /// The child for a `:name` token.
+        var wildcard: Node?
+        /// The mocks whose patterns end at this node, keyed by uppercased HTTP method.
+        var mocks: [String: [HTTPMock]] = [:]
+        /// The mocks whose patterns end at this node and that match any HTTP method.
+        var anyMethodMocks: [HTTPMock] = []
+        
+        /// Inserts `mock` at the node for `pattern`, which is walked from the end.
+        func insert(_ mock: HTTPMock, pattern: ArraySlice<HTTPMock.PathComponent>) {
+            guard let last = pattern.last else {
+                if let method = mock.normalizedHTTPMethod {
+                    mocks[method, default: []].append(mock)
+                } else {
+                    anyMethodMocks.append(mock)
+                }
+                return
+            }
+            let child: Node
+            switch last {
+            case .string(let string):
+                if let node = children[string] {
+                    child = node
+                } else {
+                    child = Node()
+                    children[string] = child
+                }
+            case .token:
+                if let node = wildcard {
+                    child = node
+                } else {
+                    child = Node()
+                    wildcard = child
+                }
+            }
+            child.insert(mock, pattern: pattern.dropLast())
+        }
+        
+        func remove(_ mock: HTTPMock, pattern: ArraySlice<HTTPMock.PathComponent>) {
+            guard let last = pattern.last else {
+                if let method = mock.normalizedHTTPMethod {
+                    if let idx = mocks[method]?.index(where: { $0 === mock }) {
+                        mocks[method]?.remove(at: idx)
+                    }
+                } else if let idx = anyMethodMocks.index(where: { $0 === mock }) {
+                    anyMethodMocks.remove(at: idx)
+                }
+                return
+            }
+            switch last {
+            case .string(let string): children[string]?.remove(mock, pattern: pattern.dropLast())
+            case .token: wildcard?.remove(mock, pattern: pattern.dropLast())
+            }
+        }
+        
+        /// Collects the mocks whose patterns match a suffix of `pathComponents`.
+        func collect(_ pathComponents: ArraySlice<String>, httpMethod: String?, into result: inout [HTTPMock]) {
+            result.append(contentsOf: anyMethodMocks)
+            if let method = httpMethod, let methodMocks = mocks[method] {
+                result.append(contentsOf: methodMocks)
+            }
+            guard let last = pathComponents.last else { return }
+            children[last]?.collect(pathComponents.dropLast(), httpMethod: httpMethod, into: &result)
+            wildcard?.collect(pathComponents.dropLast(), httpMethod: httpMethod, into: &result)
+        }
+    }
+}
+
 internal class HTTPMockInstance {
     let parameters: [String: String]
     
@@ -44,6 +44,7 @@ internal final class NetworkActivityManager: NSObject {
                     DispatchQueue.main.async { [data] in
                         data.pendingHandlerInvocation = false
                         if data.counter > 0, let handler = data.networkActivityHandler {
+                            data.reportedCounter = data.counter
                             autoreleasepool {
                                 handler(data.counter)
                             }
@@ -66,6 +67,49 @@ internal final class NetworkActivityManager: NSObject {
         }
     }
     
+    /// The minimum interval between handler invocations for changes that aren't to or from zero.
+    var coalescingInterval: TimeInterval {
+        get {
+            if Thread.isMainThread {
+                return data.coalescingInterval
+            } else {
+                return inner.sync({ $0.coalescingInterval })
+            }
+        }
+        set {
+            let newValue = max(newValue, 0)
+            inner.asyncBarrier {
+                $0.coalescingInterval = newValue
+            }
+            onMainThread { [data] in
+                data.coalescingInterval = newValue
+            }
+        }
+    }
+    
+    /// The minimum change in the counter that invokes the handler, other than changes to or from
+    /// zero.
+    var changeThreshold: Int {
+        get {
+            if Thread.isMainThread {
+                return data.changeThreshold
+            } else {
+                return inner.sync({ $0.changeThreshold })
+            }
+        }
+        set {
+            let newValue = max(newValue, 1)
+            inner.asyncBarrier {
+                $0.changeThreshold = newValue
+            }
+            onMainThread {
+                self.data.changeThreshold = newValue
+                // Lowering the threshold may make a change we've been holding back reportable.
+                self.reportIfNeeded()
+            }
+        }
+    }
+    
     /// Increments the global network activity counter.
     func incrementCounter() {
         source.add(data: 1)
@@ -81,6 +125,8 @@ internal final class NetworkActivityManager: NSObject {
     private class Inner {
         /// A reference to the network activity handler that can only be accessed via a queue.
         var networkActivityHandler: ((_ numberOfActiveTasks: Int) -> Void)?
+        var coalescingInterval: TimeInterval = 0
+        var changeThreshold: Int = 1
     }
     
     /// Data for the network activity indicator.
@@ -94,6 +140,14 @@ internal final class NetworkActivityManager: NSObject {
         /// Set to `true` when modifying the `networkActivityHandler` property to indicate that an asynchronous
         /// invocation of the property has been scheduled.
         var pendingHandlerInvocation = false
+        /// The counter value the handler was last invoked with.
+        var reportedCounter: Int = 0
+        /// When the handler was last invoked because of a change to the counter.
+        var lastReportTime: DispatchTime?
+        /// Set to `true` when a report has been scheduled for the end of the coalescing interval.
+        var pendingCoalescedReport = false
+        var coalescingInterval: TimeInterval = 0
+        var changeThreshold: Int = 1
     }
     
     private let source: DispatchSourceUserDataAdd
@@ -104,12 +158,13 @@ internal final class NetworkActivityManager: NSObject {
         super.init()
         source.setCancelHandler { [data] in
             data.counter = 0
+            data.reportedCounter = 0
             data.networkActivityHandler?(0)
         }
-        source.setEventHandler { [data, source] in
-            let delta = Int(bitPattern: source.data)
-            data.counter = data.counter + delta
-            data.networkActivityHandler?(max(data.counter, 0))
+        source.setEventHandler { [unowned self] in
+            let delta = Int(bitPattern: self.source.data)
+            self.data.counter = self.data.counter + delta
+            self.reportIfNeeded()
         }
         source.resume()
     }
@@ -117,4 +172,48 @@ internal final class NetworkActivityManager: NSObject {
     deinit {
         source.cancel()
     }
+    
+    /// Invokes the handler with the current counter if the change since the last invocation should
+    /// be reported now, or schedules a report for the end of the coalescing interval.
+    ///
+    /// - Important: This must be invoked from the main thread.
+    private func reportIfNeeded() {
+        let counter = max(data.counter, 0)
+        guard counter != data.reportedCounter else { return }
+        // Changes to or from zero are always reported right away, since those are what show and
+        // hide activity indicators.
+        if (counter == 0) == (data.reportedCounter == 0) {
+            guard abs(counter - data.reportedCounter) >= data.changeThreshold else { return }
+            if data.coalescingInterval > 0, let lastReportTime = data.lastReportTime {
+                let deadline = lastReportTime + data.coalescingInterval
+                if deadline > DispatchTime.now() {
+                    if !data.pendingCoalescedReport {
+                        data.pendingCoalescedReport = true
+                        DispatchQueue.main.asyncAfter(deadline: deadline) {
+                            self.data.pendingCoalescedReport = false
+                            self.reportIfNeeded()
+                        }
+                    }
+                    return
+                }
+            }
+        }
+        data.reportedCounter = counter
+        data.lastReportTime = DispatchTime.now()
+        data.networkActivityHandler?(counter)
+    }
+    
+    /// Executes `block` synchronously if we're already on the main thread, otherwise asynchronously
+    /// on the main queue.
+    private func onMainThread(_ block: @escaping () -> Void) {
+        if Thread.isMainThread {
+            block()
+        } else {
+            DispatchQueue.main.async {
+                autoreleasepool {
+                    block()
+                }
+            }
+        }
+    }
 }
@@ -514,6 +514,37 @@ extension HTTPManagerRetryBehavior {
             return HTTPManagerRetryBehavior.retryNetworkFailure(withStrategy: .retryTwiceWithDelay(delay))
         }
     }
+    
+    /// Returns a retry behavior that retries automatically for networking errors, waiting a
+    /// randomized delay before each retry.
+    ///
+    /// The delays use decorrelated jitter: each one is chosen at random between `baseDelay` and
+    /// three times the previous delay, and is capped at `maximumDelay`.
+    ///
+    /// A networking error is defined as many errors in the `NSURLErrorDomain`, or a
+    /// `PMJSON.JSONParserError` with a code of `.unexpectedEOF` (as this may indicate a
+    /// truncated response). The request will not be retried for networking errors that
+    /// are unlikely to change when retrying.
+    ///
+    /// If the request is non-idempotent, it only retries if the error indicates that a
+    /// connection was never made to the server (such as cannot find host).
+    ///
+    /// - Parameter maximumAttempts: The maximum number of retries.
+    /// - Parameter baseDelay: The minimum amount of time in seconds to wait before each retry.
+    /// - Parameter maximumDelay: The maximum amount of time in seconds to wait before each retry.
+    /// - Parameter including503ServiceUnavailable: If `YES`, retries on a 503 Service Unavailable
+    ///   response as well. Non-idempotent requests will also be retried on a 503 Service Unavailable
+    ///   as the server did not handle the original request. If `NO`, only networking failures
+    ///   are retried.
+    @objc(retryNetworkFailureWithMaximumAttempts:baseDelay:maximumDelay:including503ServiceUnavailable:)
+    public class func __retryNetworkFailureWithBackoff(maximumAttempts: Int, baseDelay: TimeInterval, maximumDelay: TimeInterval, including503ServiceUnavailable: Bool) -> HTTPManagerRetryBehavior {
+        let strategy = HTTPManagerRetryBehavior.backoffStrategy(maximumAttempts: maximumAttempts, baseDelay: baseDelay, maximumDelay: maximumDelay)
+        if including503ServiceUnavailable {
+            return HTTPManagerRetryBehavior.retryNetworkFailureOrServiceUnavailable(withCustomStrategy: strategy)
+        } else {
+            return HTTPManagerRetryBehavior.retryNetworkFailure(withCustomStrategy: strategy)
+        }
+    }
 }
 
 // MARK: - Result
@@ -1063,6 +1094,11 @@ public final class HTTPManagerObjectParseRequest: HTTPManagerRequest, HTTPManage
         set { _request.userInitiated = newValue }
     }
     
+    public override var priority: HTTPManagerRequestPriority {
+        get { return _request.priority }
+        set { _request.priority = newValue }
+    }
+    
     public override var retryBehavior: HTTPManagerRetryBehavior? {
         get { return _request.retryBehavior }
         set { _request.retryBehavior = newValue }
@@ -1078,6 +1114,21 @@ public final class HTTPManagerObjectParseRequest: HTTPManagerRequest, HTTPManage
         set { _request.serverRequiresContentLength = newValue }
     }
     
+    public override var assumesHTTP3Capable: Bool {
+        get { return _request.assumesHTTP3Capable }
+        set { _request.assumesHTTP3Capable = newValue }
+    }
+    
+    public override var requestBodyCompression: HTTPManagerRequestBodyCompression {
+        get { return _request.requestBodyCompression }
+        set { _request.requestBodyCompression = newValue }
+    }
+    
+    public override var requestBodyCompressionThreshold: Int {
+        get { return _request.requestBodyCompressionThreshold }
+        set { _request.requestBodyCompressionThreshold = newValue }
+    }
+    
     public override var affectsNetworkActivityIndicator: Bool {
         get { return _request.affectsNetworkActivityIndicator }
         set { _request.affectsNetworkActivityIndicator = newValue }
@@ -1136,6 +1187,45 @@ public final class HTTPManagerObjectParseRequest: HTTPManagerRequest, HTTPManage
         set { _request.expectedContentTypes = newValue }
     }
     
+    /// Whether the request uses the `HTTPManager`'s `responseCache`. The default value is `NO`.
+    ///
+    /// If `YES` and the `HTTPManager` has a `responseCache`, a cached response is returned without
+    /// waiting for the network. If the request also sets `parseIdentifier` and the cache holds the
+    /// value parsed from that response by a request with the same parse identifier, the parse
+    /// handler is skipped too. Stale entries are returned while they're revalidated in the
+    /// background.
+    ///
+    /// This property is ignored for requests other than `GET`, and for mocked requests.
+    ///
+    /// - SeeAlso: `HTTPManagerResponseCache`.
+    @objc public var usesResponseCache: Bool {
+        get { return _request.usesResponseCache }
+        set { _request.usesResponseCache = newValue }
+    }
+    
+    /// Identifies the parse handler, so values it parsed can be shared with other requests. The
+    /// default value is `nil`.
+    ///
+    /// - Important: Requests that share a parse identifier must parse a given response the same
+    ///   way.
+    @objc public var parseIdentifier: String? {
+        get { return _request.parseIdentifier }
+        set { _request.parseIdentifier = newValue }
+    }
+    
+    /// Whether the request reuses a previously parsed value when the response body is identical
+    /// to one it has already parsed. The default value is `NO`.
+    ///
+    /// If `YES` and an identical body was parsed by another Objective-C request with the same URL,
+    /// method and `parseIdentifier`, the value it produced is returned without calling the parse
+    /// handler. The memo is bounded by `HTTPManager.parseMemoizationByteLimit`.
+    ///
+    /// This property is ignored for requests without a `parseIdentifier`.
+    @objc public var memoizesParse: Bool {
+        get { return _request.memoizesParse }
+        set { _request.memoizesParse = newValue }
+    }
+    
     /// Performs an asynchronous request and calls the specified handler when done.
     /// - Parameter queue: (Optional) The queue to call the handler on. The default value
     ///   of `nil` means the handler will be called on a global concurrent queue.
@@ -0,0 +1,28 @@
+//
+//  PMHTTPAtomicReference.h
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+@import Foundation;
+
+/// A private implementation detail of PMHTTP. Do not use this class.
+///
+/// Holds a strong reference that can be read and replaced from any thread without a queue.
+__attribute__((objc_subclassing_restricted))
+__attribute__((visibility("hidden")))
+@interface _PMHTTPAtomicReference : NSObject
+/// The referenced object. Reading it returns a retained value even if another thread is
+/// concurrently replacing it.
+@property (atomic, nonnull, strong) id value;
+- (nonnull instancetype)initWithValue:(nonnull id)value NS_DESIGNATED_INITIALIZER;
+- (nonnull instancetype)init NS_UNAVAILABLE;
+@end
@@ -0,0 +1,32 @@
+//
+//  PMHTTPAtomicReference.m
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+#import "PMHTTPAtomicReference.h"
+
+// We rely on the synthesized atomic accessors here rather than swapping a pointer with C11
+// atomics. A bare atomic load can't safely retain the value, since the writer may release it
+// between the load and the retain, and the workaround used by _PMHTTPManagerTaskStateBox of
+// keeping every old value alive doesn't work for values that are replaced an unbounded number
+// of times. The runtime's atomic getter only holds one of its striped spinlocks around the load
+// and retain, so concurrent readers don't wait on each other in practice.
+@implementation _PMHTTPAtomicReference
+
+- (nonnull instancetype)initWithValue:(nonnull id)value {
+    if ((self = [super init])) {
+        _value = value;
+    }
+    return self;
+}
+
+@end
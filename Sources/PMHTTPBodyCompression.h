@@ -0,0 +1,43 @@
+//
+//  PMHTTPBodyCompression.h
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// A private implementation detail of PMHTTP. Do not use this class.
+///
+/// Compresses upload bodies with zlib, in either the gzip format or the zlib format used by the
+/// \c deflate content coding.
+__attribute__((objc_subclassing_restricted))
+__attribute__((visibility("hidden")))
+@interface _PMHTTPBodyCompression : NSObject
+/// Returns the compressed form of \a data, or \c nil if zlib failed.
+///
+/// \param gzip \c YES to produce the gzip format, or \c NO to produce the zlib format.
++ (nullable NSData *)compressData:(NSData *)data gzip:(BOOL)gzip;
+
+/// Returns a stream that compresses the contents of \a stream as it's read.
+///
+/// \a stream is opened on the first read and closed once it reaches its end. A read error on
+/// \a stream, or a failure in zlib, puts the returned stream in \c NSStreamStatusError with the
+/// failure as its \c streamError, so an upload fails rather than sending a truncated body.
+///
+/// \param gzip \c YES to produce the gzip format, or \c NO to produce the zlib format.
++ (NSInputStream *)compressingStreamWithStream:(NSInputStream *)stream gzip:(BOOL)gzip;
+
+- (instancetype)init NS_UNAVAILABLE;
+@end
+
+NS_ASSUME_NONNULL_END
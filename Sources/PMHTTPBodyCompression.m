@@ -0,0 +1,174 @@
+//
+//  PMHTTPBodyCompression.m
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+#import "PMHTTPBodyCompression.h"
+#import "PMHTTPManagerBodyStream.h"
+#import <zlib.h>
+
+/// The size of the buffer that stream input is read into before it's compressed.
+static const NSUInteger kInputBufferSize = 16 * 1024;
+
+static int deflateInitWithFormat(z_stream *stream, BOOL gzip) {
+    // Window bits of 15 produce a zlib stream, and adding 16 produces a gzip stream instead.
+    return deflateInit2(stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, gzip ? 15 + 16 : 15, 8, Z_DEFAULT_STRATEGY);
+}
+
+/// Returns an error describing a failed zlib call.
+static NSError *zlibError(int result, const char * _Nullable msg) {
+    NSString *description = msg ? @(msg) : [NSString stringWithFormat:@"zlib error %d", result];
+    return [NSError errorWithDomain:NSPOSIXErrorDomain code:result == Z_MEM_ERROR ? ENOMEM : EIO
+                           userInfo:@{NSLocalizedDescriptionKey: description}];
+}
+
+/// The state of a compressing stream. This is owned by the stream's handler.
+__attribute__((objc_subclassing_restricted))
+@interface _PMHTTPDeflateState : NSObject
+- (nonnull instancetype)initWithStream:(nonnull NSInputStream *)stream gzip:(BOOL)gzip;
+/// Returns the number of bytes written, \c 0 at the end of the stream, or \c -1 if the source
+/// stream or zlib failed, in which case \c error describes the failure.
+- (NSInteger)read:(nonnull uint8_t *)buffer maxLength:(NSInteger)maxLength;
+@property (nonatomic, readonly, nullable) NSError *error;
+@end
+
+@implementation _PMHTTPDeflateState {
+    NSInputStream * _Nullable _source;
+    z_stream _zstream;
+    BOOL _initialized;
+    BOOL _sourceAtEnd;
+    BOOL _finished;
+    uint8_t _inputBuffer[kInputBufferSize];
+}
+
+- (nonnull instancetype)initWithStream:(nonnull NSInputStream *)stream gzip:(BOOL)gzip {
+    if ((self = [super init])) {
+        _source = stream;
+        int result = deflateInitWithFormat(&_zstream, gzip);
+        _initialized = result == Z_OK;
+        if (!_initialized) {
+            // There's nothing we can produce, so fail on the first read.
+            _error = zlibError(result, NULL);
+            _finished = YES;
+        }
+    }
+    return self;
+}
+
+- (void)dealloc {
+    if (_initialized) {
+        deflateEnd(&_zstream);
+    }
+    [_source close];
+}
+
+- (NSInteger)read:(nonnull uint8_t *)buffer maxLength:(NSInteger)maxLength {
+    if (_error) return -1;
+    if (_finished || maxLength <= 0) return 0;
+    uInt length = (uInt)MIN((NSUInteger)maxLength, (NSUInteger)UINT_MAX);
+    _zstream.next_out = buffer;
+    _zstream.avail_out = length;
+    // Keep going until we've produced something, as returning 0 signals EOF.
+    while (_zstream.avail_out == length && !_finished) {
+        if (_zstream.avail_in == 0 && !_sourceAtEnd) {
+            if (_source.streamStatus == NSStreamStatusNotOpen) {
+                [_source open];
+            }
+            NSInteger count = [_source read:_inputBuffer maxLength:kInputBufferSize];
+            if (count > 0) {
+                _zstream.next_in = _inputBuffer;
+                _zstream.avail_in = (uInt)count;
+            } else {
+                if (count < 0) {
+                    // Ending the body here would upload a valid but truncated compressed body.
+                    _error = _source.streamError ?: [NSError errorWithDomain:NSPOSIXErrorDomain code:EIO userInfo:nil];
+                }
+                _sourceAtEnd = YES;
+                [_source close];
+                _source = nil;
+                if (_error) {
+                    _finished = YES;
+                    return -1;
+                }
+            }
+        }
+        int result = deflate(&_zstream, _sourceAtEnd ? Z_FINISH : Z_NO_FLUSH);
+        if (result == Z_STREAM_END) {
+            _finished = YES;
+        } else if (result != Z_OK && result != Z_BUF_ERROR) {
+            _error = zlibError(result, _zstream.msg);
+            _finished = YES;
+            return -1;
+        }
+    }
+    return (NSInteger)(length - _zstream.avail_out);
+}
+
+@end
+
+@implementation _PMHTTPBodyCompression
+
++ (NSData *)compressData:(NSData *)data gzip:(BOOL)gzip {
+    z_stream zstream = {0};
+    if (deflateInitWithFormat(&zstream, gzip) != Z_OK) {
+        // This only fails if zlib can't allocate its state.
+        return nil;
+    }
+    NSMutableData *result = [NSMutableData dataWithLength:deflateBound(&zstream, (uLong)MIN(data.length, (NSUInteger)UINT_MAX))];
+    __block int status = Z_OK;
+    __block NSUInteger remaining = data.length;
+    zstream.next_out = result.mutableBytes;
+    zstream.avail_out = (uInt)MIN(result.length, (NSUInteger)UINT_MAX);
+    [data enumerateByteRangesUsingBlock:^(const void * _Nonnull bytes, NSRange byteRange, BOOL * _Nonnull stop) {
+        const uint8_t *ptr = bytes;
+        NSUInteger length = byteRange.length;
+        do {
+            uInt chunk = (uInt)MIN(length, (NSUInteger)UINT_MAX);
+            zstream.next_in = (Bytef *)ptr;
+            zstream.avail_in = chunk;
+            ptr += chunk;
+            length -= chunk;
+            remaining -= chunk;
+            int flush = remaining == 0 ? Z_FINISH : Z_NO_FLUSH;
+            do {
+                if (zstream.avail_out == 0) {
+                    NSUInteger used = result.length;
+                    [result increaseLengthBy:MAX(used / 2, (NSUInteger)4096)];
+                    zstream.next_out = (Bytef *)result.mutableBytes + used;
+                    zstream.avail_out = (uInt)MIN(result.length - used, (NSUInteger)UINT_MAX);
+                }
+                status = deflate(&zstream, flush);
+            } while (status == Z_OK && (zstream.avail_in > 0 || (flush == Z_FINISH && zstream.avail_out == 0)));
+        } while (length > 0 && status == Z_OK);
+        if (status != Z_OK) {
+            *stop = YES;
+        }
+    }];
+    if (data.length == 0 && status == Z_OK) {
+        // There were no byte ranges to enumerate.
+        status = deflate(&zstream, Z_FINISH);
+    }
+    result.length = (NSUInteger)((uint8_t *)zstream.next_out - (uint8_t *)result.mutableBytes);
+    deflateEnd(&zstream);
+    return status == Z_STREAM_END ? result : nil;
+}
+
++ (NSInputStream *)compressingStreamWithStream:(NSInputStream *)stream gzip:(BOOL)gzip {
+    _PMHTTPDeflateState *state = [[_PMHTTPDeflateState alloc] initWithStream:stream gzip:gzip];
+    return [[_PMHTTPManagerBodyStream alloc] initWithHandler:^NSInteger(uint8_t * _Nonnull buffer, NSInteger maxLength) {
+        return [state read:buffer maxLength:maxLength];
+    } errorHandler:^NSError * _Nonnull{
+        return state.error;
+    }];
+}
+
+@end
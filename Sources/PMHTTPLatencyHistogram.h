@@ -0,0 +1,53 @@
+//
+//  PMHTTPLatencyHistogram.h
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+@import Foundation;
+
+/// A private implementation detail of PMHTTP. Do not use this class.
+///
+/// A histogram of durations that can be recorded into from any thread without locking.
+///
+/// Durations are counted in log-linear buckets of microseconds. Values below 16µs each get their
+/// own bucket, and every power of two above that is split into 8 buckets, so a bucket's width is
+/// never more than 12.5% of its lower bound.
+__attribute__((objc_subclassing_restricted))
+__attribute__((visibility("hidden")))
+@interface _PMHTTPLatencyHistogram : NSObject
+/// The number of buckets in every histogram.
+@property (class, nonatomic, readonly) NSUInteger bucketCount;
+/// Returns the smallest duration in microseconds counted by the bucket at \a index.
++ (uint64_t)lowerBoundOfBucket:(NSUInteger)index;
+/// Returns the duration in microseconds just past the largest duration counted by the bucket at
+/// \a index.
++ (uint64_t)upperBoundOfBucket:(NSUInteger)index;
+
+/// The number of recorded durations.
+@property (atomic, readonly) uint64_t count;
+/// The sum of the recorded durations in microseconds.
+@property (atomic, readonly) uint64_t sum;
+/// The smallest recorded duration in microseconds, or \c UINT64_MAX if nothing was recorded.
+@property (atomic, readonly) uint64_t minimum;
+/// The largest recorded duration in microseconds.
+@property (atomic, readonly) uint64_t maximum;
+
+/// Records a duration in nanoseconds.
+- (void)recordNanoseconds:(uint64_t)nanoseconds;
+/// Copies the count of every bucket into \a counts, which must have room for \c bucketCount values.
+///
+/// The copy isn't atomic with respect to concurrent recording, so it may include some of the
+/// durations being recorded and not others.
+- (void)getBucketCounts:(nonnull uint64_t *)counts;
+/// Clears every recorded duration.
+- (void)reset;
+@end
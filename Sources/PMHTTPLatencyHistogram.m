@@ -0,0 +1,121 @@
+//
+//  PMHTTPLatencyHistogram.m
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+#import "PMHTTPLatencyHistogram.h"
+#import <stdatomic.h>
+
+/// The number of buckets below the first power of two that's split into sub-buckets.
+#define LINEAR_BUCKETS 16
+/// log2(LINEAR_BUCKETS).
+#define FIRST_EXPONENT 4
+/// The number of sub-buckets in each power of two. Must be LINEAR_BUCKETS / 2.
+#define SUB_BUCKETS 8
+/// The largest power of two that gets its own buckets. 2^40µs is about 12 days, and anything
+/// longer lands in the last bucket.
+#define LAST_EXPONENT 40
+#define BUCKET_COUNT (LINEAR_BUCKETS + (LAST_EXPONENT - FIRST_EXPONENT + 1) * SUB_BUCKETS)
+
+static NSUInteger bucketIndex(uint64_t value) {
+    if (value < LINEAR_BUCKETS) return (NSUInteger)value;
+    int exponent = 63 - __builtin_clzll(value);
+    if (exponent > LAST_EXPONENT) return BUCKET_COUNT - 1;
+    // The top bit is implied by the exponent, and the next 3 bits pick the sub-bucket.
+    NSUInteger subBucket = (NSUInteger)(value >> (exponent - 3)) & (SUB_BUCKETS - 1);
+    return LINEAR_BUCKETS + (NSUInteger)(exponent - FIRST_EXPONENT) * SUB_BUCKETS + subBucket;
+}
+
+@implementation _PMHTTPLatencyHistogram {
+    atomic_uint_fast64_t _buckets[BUCKET_COUNT];
+    atomic_uint_fast64_t _count;
+    atomic_uint_fast64_t _sum;
+    atomic_uint_fast64_t _minimum;
+    atomic_uint_fast64_t _maximum;
+}
+
++ (NSUInteger)bucketCount {
+    return BUCKET_COUNT;
+}
+
++ (uint64_t)lowerBoundOfBucket:(NSUInteger)index {
+    if (index < LINEAR_BUCKETS) return index;
+    NSUInteger exponent = FIRST_EXPONENT + (index - LINEAR_BUCKETS) / SUB_BUCKETS;
+    uint64_t subBucket = (index - LINEAR_BUCKETS) % SUB_BUCKETS;
+    return (SUB_BUCKETS + subBucket) << (exponent - 3);
+}
+
++ (uint64_t)upperBoundOfBucket:(NSUInteger)index {
+    if (index < LINEAR_BUCKETS) return index + 1;
+    NSUInteger exponent = FIRST_EXPONENT + (index - LINEAR_BUCKETS) / SUB_BUCKETS;
+    return [self lowerBoundOfBucket:index] + ((uint64_t)1 << (exponent - 3));
+}
+
+- (instancetype)init {
+    if ((self = [super init])) {
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            atomic_init(&_buckets[i], 0);
+        }
+        atomic_init(&_count, 0);
+        atomic_init(&_sum, 0);
+        atomic_init(&_minimum, UINT64_MAX);
+        atomic_init(&_maximum, 0);
+    }
+    return self;
+}
+
+- (uint64_t)count {
+    return atomic_load_explicit(&_count, memory_order_relaxed);
+}
+
+- (uint64_t)sum {
+    return atomic_load_explicit(&_sum, memory_order_relaxed);
+}
+
+- (uint64_t)minimum {
+    return atomic_load_explicit(&_minimum, memory_order_relaxed);
+}
+
+- (uint64_t)maximum {
+    return atomic_load_explicit(&_maximum, memory_order_relaxed);
+}
+
+- (void)recordNanoseconds:(uint64_t)nanoseconds {
+    // Every counter is independent, so relaxed ordering is enough. Readers only ever see a
+    // slightly stale histogram.
+    uint64_t value = nanoseconds / 1000;
+    atomic_fetch_add_explicit(&_buckets[bucketIndex(value)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_sum, value, memory_order_relaxed);
+    uint_fast64_t current = atomic_load_explicit(&_minimum, memory_order_relaxed);
+    while (value < current && !atomic_compare_exchange_weak_explicit(&_minimum, &current, value, memory_order_relaxed, memory_order_relaxed)) {}
+    current = atomic_load_explicit(&_maximum, memory_order_relaxed);
+    while (value > current && !atomic_compare_exchange_weak_explicit(&_maximum, &current, value, memory_order_relaxed, memory_order_relaxed)) {}
+}
+
+- (void)getBucketCounts:(uint64_t *)counts {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        counts[i] = atomic_load_explicit(&_buckets[i], memory_order_relaxed);
+    }
+}
+
+- (void)reset {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        atomic_store_explicit(&_buckets[i], 0, memory_order_relaxed);
+    }
+    atomic_store_explicit(&_count, 0, memory_order_relaxed);
+    atomic_store_explicit(&_sum, 0, memory_order_relaxed);
+    atomic_store_explicit(&_minimum, UINT64_MAX, memory_order_relaxed);
+    atomic_store_explicit(&_maximum, 0, memory_order_relaxed);
+}
+
+@end
@@ -25,7 +25,46 @@ __attribute__((visibility("hidden")))
 ///        the number of bytes written. The handler returns \c 0 to indicate EOF, at which point
 ///        the handler is released. The handler will never be called with a value of \c 0 for
 ///        <code>maxLength</code>. The handler should not return a negative value.
-- (instancetype)initWithHandler:(NSInteger (^)(uint8_t *buffer, NSInteger maxLength))handler NS_DESIGNATED_INITIALIZER;
+- (instancetype)initWithHandler:(NSInteger (^)(uint8_t *buffer, NSInteger maxLength))handler;
+
+/// Returns a new \c _PMHTTPManagerBodyStream that uses a given handler to provide the data, and
+/// can fail.
+///
+/// \param handler A handler function that is executed to fill a buffer, as in
+///        <code>-initWithHandler:</code>, except that it may also return a negative value to
+///        indicate an error. At that point the handler is released and the stream's status
+///        becomes \c NSStreamStatusError.
+/// \param errorHandler A handler function that is executed once after \a handler returns a
+///        negative value, and returns the error that's reported as the stream's
+///        <code>streamError</code>.
+- (instancetype)initWithHandler:(NSInteger (^)(uint8_t *buffer, NSInteger maxLength))handler
+                   errorHandler:(NSError * (^)(void))errorHandler;
+
+/// Returns a new \c _PMHTTPManagerBodyStream that uses a given handler to provide the data, and a
+/// second handler to lend out contiguous buffers without copying.
+///
+/// \param handler A handler function that is executed to fill a buffer, as in
+///        <code>-initWithHandler:</code>
+/// \param bufferHandler (Optional) A handler function that is executed to implement
+///        <code>-getBuffer:length:</code>. The handler returns \c YES if it can provide a pointer to
+///        the next bytes of the stream, in which case those bytes are considered read. The pointer
+///        must remain valid until the next call to either handler. The handler returns \c NO if
+///        the next bytes aren't contiguous, in which case they're read with \a handler instead.
+- (instancetype)initWithHandler:(NSInteger (^)(uint8_t *buffer, NSInteger maxLength))handler
+                  bufferHandler:(nullable BOOL (^)(const uint8_t * _Nullable * _Nonnull buffer, NSUInteger *length))bufferHandler;
+
+/// Returns a new \c _PMHTTPManagerBodyStream with the given handlers.
+///
+/// \param handler A handler function that is executed to fill a buffer, as in
+///        <code>-initWithHandler:errorHandler:</code> if \a errorHandler is provided and
+///        otherwise as in <code>-initWithHandler:</code>
+/// \param bufferHandler (Optional) A handler function that is executed to implement
+///        <code>-getBuffer:length:</code>, as in <code>-initWithHandler:bufferHandler:</code>
+/// \param errorHandler (Optional) A handler function that returns the stream's error, as in
+///        <code>-initWithHandler:errorHandler:</code>
+- (instancetype)initWithHandler:(NSInteger (^)(uint8_t *buffer, NSInteger maxLength))handler
+                  bufferHandler:(nullable BOOL (^)(const uint8_t * _Nullable * _Nonnull buffer, NSUInteger *length))bufferHandler
+                   errorHandler:(nullable NSError * (^)(void))errorHandler NS_DESIGNATED_INITIALIZER;
 
 - (instancetype)initWithData:(NSData *)data NS_UNAVAILABLE;
 - (nullable instancetype)initWithURL:(NSURL *)url NS_UNAVAILABLE;
@@ -13,9 +13,11 @@
 //
 
 #import "PMHTTPManagerBodyStream.h"
+#import <algorithm>
 #import <atomic>
+#import <cerrno>
 #import <mutex>
-#import <map>
+#import <vector>
 
 // Historically, subclassing NSInputStream has required overriding a handful of private undocumented methods.
 // I can't find any reference saying that this has been fixed, but, experimentally, as of iOS 8.1 at least
@@ -50,16 +52,28 @@ public:
         other._value = nullptr;
     }
     CF<T>& operator=(const CF<T>& other) {
+        if (other._value) CFRetain(other._value);
+        if (_value) CFRelease(_value);
         _value = other._value;
-        if (_value) CFRetain(_value);
+        return *this;
     }
     CF<T>& operator=(CF<T>&& other) {
-        _value = std::move(other._value);
-        other._value = nullptr;
+        if (this != &other) {
+            if (_value) CFRelease(_value);
+            _value = other._value;
+            other._value = nullptr;
+        }
+        return *this;
     }
     ~CF() {
         if (_value) CFRelease(_value);
     }
+    /// Takes ownership of a value returned from a Create or Copy function.
+    static CF<T> adopt(T value) {
+        CF<T> result(nullptr);
+        result._value = value;
+        return result;
+    }
     const T& operator*() const {
         return _value;
     }
@@ -68,20 +82,64 @@ public:
     }
 };
 
+/// A single run loop mode that the stream is scheduled in.
+struct RunLoopMode {
+    CF<CFRunLoopRef> runLoop;
+    CF<CFStringRef> mode;
+    
+    bool matches(CFRunLoopRef otherRunLoop, CFStringRef otherMode) const {
+        return *runLoop == otherRunLoop && CFEqual(*mode, otherMode);
+    }
+};
+
 @implementation _PMHTTPManagerBodyStream {
     std::atomic<NSStreamStatus> _streamStatus;
     std::atomic<void *> _delegate;
     std::atomic<NSStreamStatus> _lastStatus;
     
-    std::mutex _mutex;
+    // Reads and run loop bookkeeping use separate locks so a read never waits on the run loop
+    // registry, and signaling the source never waits on a read.
+    
+    /// Guards the handlers and the stream error. Only reads, -close, and -streamError take this lock.
+    std::mutex _handlerMutex;
     NSInteger (^ _Nullable _handler)(uint8_t * _Nonnull buffer, NSInteger maxLength);
-    std::map<CF<CFRunLoopRef>, NSMutableSet<NSString *> * _Nonnull> _runLoops;
+    BOOL (^ _Nullable _bufferHandler)(const uint8_t * _Nullable * _Nonnull buffer, NSUInteger * _Nonnull length);
+    NSError * _Nonnull (^ _Nullable _errorHandler)(void);
+    /// The error returned from \c _errorHandler once the handler fails.
+    NSError * _Nullable _streamError;
+    
+    /// Guards the run loop registry.
+    std::mutex _runLoopMutex;
+    /// Every run loop mode we're scheduled in. Entries for the same run loop are kept adjacent.
+    /// This is almost always a single entry, so a flat vector beats any associative container.
+    std::vector<RunLoopMode> _runLoopModes;
     CFRunLoopSourceRef _Nullable _rlSource;
 }
 
 - (instancetype)initWithHandler:(NSInteger (^)(uint8_t * _Nonnull buffer, NSInteger maxLength))handler {
+    return [self initWithHandler:handler bufferHandler:nil errorHandler:nil];
+}
+
+- (instancetype)initWithHandler:(NSInteger (^)(uint8_t * _Nonnull buffer, NSInteger maxLength))handler
+                   errorHandler:(NSError * _Nonnull (^)(void))errorHandler
+{
+    return [self initWithHandler:handler bufferHandler:nil errorHandler:errorHandler];
+}
+
+- (instancetype)initWithHandler:(NSInteger (^)(uint8_t * _Nonnull buffer, NSInteger maxLength))handler
+                  bufferHandler:(BOOL (^)(const uint8_t * _Nullable * _Nonnull buffer, NSUInteger * _Nonnull length))bufferHandler
+{
+    return [self initWithHandler:handler bufferHandler:bufferHandler errorHandler:nil];
+}
+
+- (instancetype)initWithHandler:(NSInteger (^)(uint8_t * _Nonnull buffer, NSInteger maxLength))handler
+                  bufferHandler:(BOOL (^)(const uint8_t * _Nullable * _Nonnull buffer, NSUInteger * _Nonnull length))bufferHandler
+                   errorHandler:(NSError * _Nonnull (^)(void))errorHandler
+{
     if ((self = [super init])) {
         _handler = [handler copy];
+        _bufferHandler = [bufferHandler copy];
+        _errorHandler = [errorHandler copy];
         atomic_init(&_streamStatus, NSStreamStatusNotOpen);
         atomic_init(&_delegate, (void *)nullptr);
         atomic_init(&_lastStatus, NSStreamStatusNotOpen);
@@ -106,6 +164,11 @@ public:
     return _streamStatus.load(std::memory_order_relaxed);
 }
 
+- (NSError *)streamError {
+    std::lock_guard<std::mutex> lock(_handlerMutex);
+    return _streamError;
+}
+
 - (void)open {
     NSStreamStatus status = NSStreamStatusNotOpen;
     if (_streamStatus.compare_exchange_strong(status, NSStreamStatusOpen, std::memory_order_relaxed)) {
@@ -124,14 +187,19 @@ public:
             return;
         }
     }
-    std::lock_guard<std::mutex> lock(_mutex);
-    if (_rlSource) {
-        CFRunLoopSourceInvalidate(_rlSource);
-        CFRelease(_rlSource);
-        _rlSource = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_runLoopMutex);
+        if (_rlSource) {
+            CFRunLoopSourceInvalidate(_rlSource);
+            CFRelease(_rlSource);
+            _rlSource = nullptr;
+        }
+        _runLoopModes.clear();
     }
-    _runLoops.clear();
+    std::lock_guard<std::mutex> lock(_handlerMutex);
     _handler = nil;
+    _bufferHandler = nil;
+    _errorHandler = nil;
 }
 
 - (NSInteger)read:(uint8_t *)buffer maxLength:(NSUInteger)maxLength {
@@ -149,19 +217,28 @@ public:
     }
     NSUInteger totalLen = 0;
     bool shouldSignal = false;
+    bool failed = false;
     {
-        std::lock_guard<std::mutex> lock(_mutex);
+        std::lock_guard<std::mutex> lock(_handlerMutex);
         while (maxLength > totalLen && _handler != nil) {
             NSInteger len = _handler(&buffer[totalLen], maxLength - totalLen);
             if (len <= 0) {
+                if (len < 0) {
+                    failed = true;
+                    _streamError = (_errorHandler ? _errorHandler() : nil) ?: [NSError errorWithDomain:NSPOSIXErrorDomain code:EIO userInfo:nil];
+                }
                 _handler = nil;
+                _bufferHandler = nil;
+                _errorHandler = nil;
                 break;
             }
             totalLen += len;
         }
         if (!_handler) {
+            // Any bytes produced before an error are discarded, as the body is unusable anyway.
+            NSStreamStatus newStatus = failed ? NSStreamStatusError : NSStreamStatusAtEnd;
             while (status == NSStreamStatusOpen || status == NSStreamStatusReading) {
-                if (_streamStatus.compare_exchange_weak(status, NSStreamStatusAtEnd, std::memory_order_relaxed)) {
+                if (_streamStatus.compare_exchange_weak(status, newStatus, std::memory_order_relaxed)) {
                     shouldSignal = true;
                     break;
                 }
@@ -171,11 +248,24 @@ public:
     if (shouldSignal) {
         [self signalSource];
     }
-    return totalLen;
+    return failed ? -1 : totalLen;
 }
 
 - (BOOL)getBuffer:(uint8_t * _Nullable *)buffer length:(NSUInteger *)len {
-    return NO;
+    switch (_streamStatus.load(std::memory_order_relaxed)) {
+        case NSStreamStatusOpen:
+        case NSStreamStatusReading: break;
+        default: return NO;
+    }
+    std::lock_guard<std::mutex> lock(_handlerMutex);
+    if (!_bufferHandler) return NO;
+    const uint8_t *bytes = nullptr;
+    NSUInteger length = 0;
+    if (!_bufferHandler(&bytes, &length) || !bytes || length == 0) return NO;
+    // The bytes are considered read. EOF is detected by the next -read:maxLength:.
+    *buffer = const_cast<uint8_t *>(bytes);
+    *len = length;
+    return YES;
 }
 
 - (BOOL)hasBytesAvailable {
@@ -202,7 +292,7 @@ public:
         // We can't be scheduled while closed
         return;
     }
-    std::lock_guard<std::mutex> lock(_mutex);
+    std::lock_guard<std::mutex> lock(_runLoopMutex);
     if (!_rlSource) {
         CFRunLoopSourceContext ctxt = {
             .version = 0,
@@ -260,30 +350,29 @@ public:
         _rlSource = CFRunLoopSourceCreate(kCFAllocatorDefault, 0, &ctxt);
     }
     auto cfRunLoop = [aRunLoop getCFRunLoop];
-    auto it = _runLoops.find(cfRunLoop);
-    if (it == _runLoops.end()) {
-        CFRetain(cfRunLoop);
-        it = _runLoops.emplace(cfRunLoop, [NSMutableSet set]).first;
-    }
-    if (![it->second containsObject:mode]) {
-        [it->second addObject:mode];
-        CFRunLoopAddSource([aRunLoop getCFRunLoop], _rlSource, (__bridge CFStringRef)mode);
+    auto cfMode = (__bridge CFStringRef)mode;
+    auto begin = _runLoopModes.begin(), end = _runLoopModes.end();
+    if (std::any_of(begin, end, [&](const RunLoopMode& entry){ return entry.matches(cfRunLoop, cfMode); })) {
+        return;
     }
+    // Insert after the last entry for this run loop to keep its entries adjacent.
+    auto it = std::find_if(_runLoopModes.rbegin(), _runLoopModes.rend(), [&](const RunLoopMode& entry){ return *entry.runLoop == cfRunLoop; }).base();
+    if (it == begin) it = end;
+    _runLoopModes.insert(it, RunLoopMode{cfRunLoop, cfMode});
+    CFRunLoopAddSource(cfRunLoop, _rlSource, cfMode);
 }
 
 - (void)removeFromRunLoop:(NSRunLoop *)aRunLoop forMode:(NSString *)mode {
-    std::lock_guard<std::mutex> lock(_mutex);
+    std::lock_guard<std::mutex> lock(_runLoopMutex);
     if (_rlSource) {
         auto cfRunLoop = [aRunLoop getCFRunLoop];
-        auto it = _runLoops.find(cfRunLoop);
-        if (it != _runLoops.end()) {
-            [it->second removeObject:mode];
-            CFRunLoopRemoveSource([aRunLoop getCFRunLoop], _rlSource, (__bridge CFStringRef)mode);
-            if ([it->second count] == 0) {
-                _runLoops.erase(it);
-            }
+        auto cfMode = (__bridge CFStringRef)mode;
+        auto it = std::find_if(_runLoopModes.begin(), _runLoopModes.end(), [&](const RunLoopMode& entry){ return entry.matches(cfRunLoop, cfMode); });
+        if (it != _runLoopModes.end()) {
+            _runLoopModes.erase(it);
+            CFRunLoopRemoveSource(cfRunLoop, _rlSource, cfMode);
         }
-        if (_runLoops.cbegin() == _runLoops.cend()) {
+        if (_runLoopModes.empty()) {
             // we've emptied out the run loops, so we need to discard the source as well or we'll have an infinite loop
             CFRunLoopSourceInvalidate(_rlSource);
             CFRelease(_rlSource);
@@ -293,37 +382,36 @@ public:
 }
 
 - (void)signalSource {
-    std::lock_guard<std::mutex> lock(_mutex);
+    std::lock_guard<std::mutex> lock(_runLoopMutex);
     if (!_rlSource) return;
     CFRunLoopSourceSignal(_rlSource);
-    auto cfRunLoop = [[NSRunLoop currentRunLoop] getCFRunLoop];
-    if (auto currentMode = (__bridge_transfer NSString *)CFRunLoopCopyCurrentMode(cfRunLoop)) {
-        auto it = _runLoops.find(cfRunLoop);
-        if (it == _runLoops.end() || ![it->second containsObject:currentMode]) {
-            // the source isn't scheduled on the current mode of the current run loop
-            cfRunLoop = nullptr;
+    // Prefer the current run loop if it's running in one of our modes, then the first run loop
+    // that's waiting in one of our modes, and finally just go with the first run loop.
+    // Each run loop's current mode is only copied once, since its entries are adjacent.
+    auto currentRunLoop = CFRunLoopGetCurrent();
+    CFRunLoopRef waitingRunLoop = nullptr;
+    CFRunLoopRef lastRunLoop = nullptr;
+    CF<CFStringRef> lastMode = nullptr;
+    for (const auto& entry : _runLoopModes) {
+        if (*entry.runLoop != lastRunLoop) {
+            lastRunLoop = *entry.runLoop;
+            lastMode = CF<CFStringRef>::adopt(CFRunLoopCopyCurrentMode(lastRunLoop));
         }
-    }
-    if (!cfRunLoop) {
-        // find the first runloop that's waiting in the correct mode
-        for (const auto& pair : _runLoops) {
-            if (auto currentMode = (__bridge_transfer NSString *)CFRunLoopCopyCurrentMode(*pair.first)) {
-                if ([pair.second containsObject:currentMode] && CFRunLoopIsWaiting(*pair.first)) {
-                    cfRunLoop = *pair.first;
-                    break;
-                }
-            }
+        if (!*lastMode || !CFEqual(*entry.mode, *lastMode)) continue;
+        if (lastRunLoop == currentRunLoop) {
+            waitingRunLoop = lastRunLoop;
+            break;
+        }
+        if (!waitingRunLoop && CFRunLoopIsWaiting(lastRunLoop)) {
+            waitingRunLoop = lastRunLoop;
         }
     }
-    if (!cfRunLoop) {
+    if (!waitingRunLoop && !_runLoopModes.empty()) {
         // We couldn't find any good runloops, so just go with the first one
-        auto it = _runLoops.cbegin();
-        if (it != _runLoops.cend()) {
-            cfRunLoop = *it->first;
-        }
+        waitingRunLoop = *_runLoopModes.front().runLoop;
     }
-    if (cfRunLoop) {
-        CFRunLoopWakeUp(cfRunLoop);
+    if (waitingRunLoop) {
+        CFRunLoopWakeUp(waitingRunLoop);
     }
 }
 @end
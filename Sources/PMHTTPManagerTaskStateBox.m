@@ -15,28 +15,51 @@
 #import "PMHTTPManagerTaskStateBox.h"
 #import <stdatomic.h>
 
-// In order to implement network task swapping without any runtime penalty on the getter
-// we're doing something a little unusual here. When we swap the tasks, we store the old
-// task in a linked list, and the tasks are only released when the task state box deallocs.
-// This ensures there's no threading issues with one thread reading the value, another thread
-// replacing it, and then the first thread trying to retain and use the value it just read.
-// Any thread interacting with the box has a retain on it, so the box can't dealloc until
-// all threads have finished touching the task.
+// In order to implement network task swapping without any locks on the getter we're doing
+// something a little unusual here. The getter announces itself in _activeReaders before loading
+// _networkTask and retains the task before leaving. When we swap the tasks, we first take every
+// task retired by earlier swaps and then check for active readers. If there are none, the old task
+// and everything we took can be released right away, since each of them was removed from
+// _networkTask before our check, and any reader that loaded one of them would still be counted.
+// Otherwise they're all retired again, to be released by a later swap or when the task state box
+// deallocs. Tasks retired by a concurrent swap after we took ours are left alone, because our check
+// doesn't cover readers that loaded them. This ensures there's no threading issues with one thread
+// reading the value, another thread replacing it, and then the first thread trying to retain and
+// use the value it just read.
+//
+// Retired tasks are normally stored inline in the box. Only a swap that finds every inline slot
+// full while readers are active allocates, and it pushes onto a linked list instead.
 //
 // The overall goal here is to implement network retrying without adding any locks (not even
 // spinlocks) into the task.
 typedef struct TaskList {
-    // The next pointer does not need to be atomic because it will never be mutated once the
-    // entry has been added to the linked list.
+    // The next pointer does not need to be atomic because it will never be mutated while the
+    // entry is in the linked list. A swap that takes the list owns its entries until it pushes
+    // them back.
     struct TaskList * _Nullable next;
     const void * _Nonnull object;
 } TaskList;
 
+/// Releases every task in the list and frees the entries.
+static void releaseTaskList(TaskList * _Nullable head) {
+    while (head) {
+        (void)(__bridge_transfer id)head->object;
+        TaskList *oldHead = head;
+        head = head->next;
+        free(oldHead);
+    }
+}
+
+#define RETIRED_TASK_SLOTS 4
+
 @implementation _PMHTTPManagerTaskStateBox {
     atomic_uchar _state;
     // We can't use atomic_flag because atomic_flag_clear() doesn't return the previous value.
     atomic_bool _trackingNetworkActivity;
     _Atomic(const void * _Nonnull) _networkTask;
+    // The number of threads currently inside the networkTask getter.
+    atomic_uint _activeReaders;
+    _Atomic(const void * _Nullable) _retiredTasks[RETIRED_TASK_SLOTS];
     _Atomic(TaskList * _Nullable) _taskListHead;
 }
 
@@ -45,6 +68,11 @@ typedef struct TaskList {
         atomic_init(&_state, state);
         atomic_init(&_networkTask, (__bridge_retained const void *)networkTask);
         atomic_init(&_trackingNetworkActivity, false);
+        atomic_init(&_activeReaders, 0);
+        for (size_t i = 0; i < RETIRED_TASK_SLOTS; ++i) {
+            atomic_init(&_retiredTasks[i], NULL);
+        }
+        atomic_init(&_taskListHead, NULL);
     }
     return self;
 }
@@ -56,15 +84,14 @@ typedef struct TaskList {
     // a full memory barrier already, but C11 atomics does not expose any equivalent to LLVM's
     // `unordered` ordering, so we have to use memory_order_relaxed anyway.
     (void)(__bridge_transfer id)atomic_load_explicit(&_networkTask, memory_order_relaxed);
-    // Walk the linked list and release that too. The acquire here forms an edge with the release
-    // in the compare_exchange operation.
-    TaskList *head = atomic_load_explicit(&_taskListHead, memory_order_acquire);
-    while (head) {
-        (void)(__bridge_transfer id)head->object;
-        TaskList *oldHead = head;
-        head = head->next;
-        free(oldHead);
+    // Nobody can be reading anymore, so every retired task can be released too.
+    for (size_t i = 0; i < RETIRED_TASK_SLOTS; ++i) {
+        const void *task = atomic_load_explicit(&_retiredTasks[i], memory_order_relaxed);
+        if (task) {
+            (void)(__bridge_transfer id)task;
+        }
     }
+    releaseTaskList(atomic_load_explicit(&_taskListHead, memory_order_relaxed));
 }
 
 - (_PMHTTPManagerTaskStateBoxState)state {
@@ -72,22 +99,78 @@ typedef struct TaskList {
 }
 
 - (nonnull NSURLSessionTask *)networkTask {
-    return (__bridge id)atomic_load_explicit(&_networkTask, memory_order_relaxed);
+    // The increment, the load, the exchange in -setNetworkTask: and its load of _activeReaders are
+    // all sequentially consistent. That way if the setter doesn't see us, we can't have loaded the
+    // task it replaced. We use CFRetain instead of a strong local so the retain is guaranteed to
+    // happen before the decrement.
+    atomic_fetch_add_explicit(&_activeReaders, 1, memory_order_seq_cst);
+    const void *task = atomic_load_explicit(&_networkTask, memory_order_seq_cst);
+    CFRetain(task);
+    atomic_fetch_sub_explicit(&_activeReaders, 1, memory_order_release);
+    return (__bridge_transfer id)task;
 }
 
 - (void)setNetworkTask:(nonnull NSURLSessionTask *)networkTask {
     // We swap a retained pointer into _networkTask and get the old retained pointer back.
-    // We then push that onto the linked list, where dealloc will be able to find and release it.
-    // Note that the order of the entries in the linked list is completely irrelevant, only the fact
-    // that all removed tasks end up somewhere in it, so the memory ordering can be relaxed everywhere.
-    const void *oldTask = atomic_exchange_explicit(&_networkTask, (__bridge_retained const void *)networkTask, memory_order_relaxed);
-    TaskList *newHead = (TaskList *)malloc(sizeof(TaskList));
-    newHead->object = oldTask;
+    const void *oldTask = atomic_exchange_explicit(&_networkTask, (__bridge_retained const void *)networkTask, memory_order_seq_cst);
+    // Take ownership of everything retired so far. This must happen before we look at
+    // _activeReaders, so every task we might release was removed from _networkTask before the
+    // load. The exchanges also mean a concurrent swap can't release the same task.
+    const void *retiredTasks[RETIRED_TASK_SLOTS];
+    for (size_t i = 0; i < RETIRED_TASK_SLOTS; ++i) {
+        retiredTasks[i] = atomic_exchange_explicit(&_retiredTasks[i], NULL, memory_order_seq_cst);
+    }
+    TaskList *taskList = atomic_exchange_explicit(&_taskListHead, NULL, memory_order_seq_cst);
+    if (atomic_load_explicit(&_activeReaders, memory_order_seq_cst) == 0) {
+        // Nobody can be holding any of these tasks without having retained it.
+        (void)(__bridge_transfer id)oldTask;
+        for (size_t i = 0; i < RETIRED_TASK_SLOTS; ++i) {
+            if (retiredTasks[i]) {
+                (void)(__bridge_transfer id)retiredTasks[i];
+            }
+        }
+        releaseTaskList(taskList);
+        return;
+    }
+    // A reader may have loaded one of these tasks and not retained it yet. Retire them again.
+    [self retireTask:oldTask];
+    for (size_t i = 0; i < RETIRED_TASK_SLOTS; ++i) {
+        if (retiredTasks[i]) {
+            [self retireTask:retiredTasks[i]];
+        }
+    }
+    if (taskList) {
+        TaskList *tail = taskList;
+        while (tail->next) {
+            tail = tail->next;
+        }
+        [self pushTaskList:taskList tail:tail];
+    }
+}
+
+/// Stores a task that can't be released yet because a reader may be about to retain it.
+- (void)retireTask:(nonnull const void *)task {
+    for (size_t i = 0; i < RETIRED_TASK_SLOTS; ++i) {
+        const void *expected = NULL;
+        if (atomic_compare_exchange_strong_explicit(&_retiredTasks[i], &expected, task, memory_order_seq_cst, memory_order_relaxed)) {
+            return;
+        }
+    }
+    // Every slot is in use. Fall back to the linked list.
+    TaskList *entry = (TaskList *)malloc(sizeof(TaskList));
+    entry->next = NULL;
+    entry->object = task;
+    [self pushTaskList:entry tail:entry];
+}
+
+/// Pushes the entries from \c head through \c tail onto the linked list of retired tasks.
+- (void)pushTaskList:(nonnull TaskList *)head tail:(nonnull TaskList *)tail {
+    // The order of the entries is completely irrelevant, only the fact that all retired tasks end
+    // up somewhere.
     TaskList *oldHead = atomic_load_explicit(&_taskListHead, memory_order_relaxed);
     while (1) {
-        newHead->next = oldHead;
-        // The release on the store here forms an edge with the acquire in -dealloc.
-        if (atomic_compare_exchange_weak_explicit(&_taskListHead, &oldHead, newHead, memory_order_release, memory_order_relaxed)) {
+        tail->next = oldHead;
+        if (atomic_compare_exchange_weak_explicit(&_taskListHead, &oldHead, head, memory_order_seq_cst, memory_order_relaxed)) {
             return;
         }
     }
@@ -0,0 +1,135 @@
+//
+//  ParseResultMemo.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import Foundation
+
+/// A memory-bounded memo of the values produced by parse handlers, keyed by the response body.
+///
+/// Used by requests that set `HTTPManagerParseRequest.memoizesParse`, so a body that's identical
+/// to one that was already parsed by the same parse handler returns the previous value instead of
+/// being parsed again. Parse handlers are identified by `HTTPManagerParseRequest.parseIdentifier`.
+/// The memo is bounded by the total size of the bodies it remembers and evicts the least recently
+/// used values first.
+///
+/// **Thread safety:** All methods in this class are safe to call from any thread.
+internal final class ParseResultMemo {
+    init(byteLimit: Int) {
+        inner = QueueConfined(label: "PMHTTP parse result memo", value: LRUCache(costLimit: byteLimit))
+    }
+    
+    /// The maximum total size in bytes of the bodies whose parsed values are remembered.
+    var byteLimit: Int {
+        get {
+            return inner.sync({ $0.costLimit })
+        }
+        set {
+            inner.asyncBarrier {
+                $0.costLimit = newValue
+            }
+        }
+    }
+    
+    /// The total size in bytes of the bodies whose parsed values are remembered.
+    var currentByteCount: Int {
+        return inner.sync({ $0.totalCost })
+    }
+    
+    func removeAll() {
+        inner.asyncBarrier {
+            $0.removeAll()
+        }
+    }
+    
+    /// Returns a parse handler that consults the memo before calling `parseHandler`, and remembers
+    /// the values it produces.
+    ///
+    /// - Parameter url: The URL of the request the handler belongs to.
+    /// - Parameter method: The method of the request the handler belongs to.
+    /// - Parameter parseIdentifier: Identifies `parseHandler`. Values are only shared between
+    ///   handlers with the same identifier.
+    func memoizing<T>(_ parseHandler: @escaping (URLResponse, Data) throws -> T, url: URL?, method: String, parseIdentifier: String) -> (URLResponse, Data) throws -> T {
+        return { [inner] response, data in
+            let key = Key(url: url, method: method, parseIdentifier: parseIdentifier, valueType: T.self, data: data)
+            let entry = inner.syncBarrier({ $0.value(forKey: key) })
+            // The digest is only used to find the entry. Comparing the bodies is far cheaper than
+            // parsing them, and means a collision can't return the wrong value.
+            if let entry = entry, entry.data == data, let value = entry.value as? T {
+                return value
+            }
+            let value = try parseHandler(response, data)
+            let newEntry = Entry(data: data, value: value)
+            inner.asyncBarrier {
+                $0.setValue(newEntry, forKey: key, cost: data.count)
+            }
+            return value
+        }
+    }
+    
+    private struct Key: Hashable {
+        let url: URL?
+        let method: String
+        let parseIdentifier: String
+        let valueType: ObjectIdentifier
+        let digest: UInt64
+        let length: Int
+        
+        init(url: URL?, method: String, parseIdentifier: String, valueType: Any.Type, data: Data) {
+            self.url = url
+            self.method = method
+            self.parseIdentifier = parseIdentifier
+            self.valueType = ObjectIdentifier(valueType)
+            var hasher = SipHasher(key: ParseResultMemo.digestKey)
+            hasher.write(data)
+            digest = hasher.finish()
+            length = data.count
+        }
+        
+        #if swift(>=4.1.9) // detect Swift 4.2 compiler
+        func hash(into hasher: inout Hasher) {
+            hasher.combine(digest)
+        }
+        #else
+        var hashValue: Int {
+            // The digest is already a keyed SipHash of the body.
+            return Int(truncatingIfNeeded: digest)
+        }
+        #endif
+        
+        static func ==(lhs: Key, rhs: Key) -> Bool {
+            return lhs.digest == rhs.digest && lhs.length == rhs.length && lhs.valueType == rhs.valueType
+                && lhs.parseIdentifier == rhs.parseIdentifier && lhs.method == rhs.method && lhs.url == rhs.url
+        }
+    }
+    
+    private final class Entry {
+        let data: Data
+        let value: Any
+        
+        init(data: Data, value: Any) {
+            self.data = data
+            self.value = value
+        }
+    }
+    
+    /// A random per-process key, so servers can't craft bodies whose digests collide.
+    private static let digestKey: (UInt64, UInt64) = {
+        var key: (UInt64, UInt64) = (0, 0)
+        withUnsafeMutableBytes(of: &key) { bytes in
+            arc4random_buf(bytes.baseAddress, bytes.count)
+        }
+        return key
+    }()
+    
+    private let inner: QueueConfined<LRUCache<Key, Entry>>
+}
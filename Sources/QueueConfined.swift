@@ -13,6 +13,7 @@
 //
 
 import Foundation
+import PMHTTP.Private
 
 /// Manages access to a contained value using a concurrent dispatch queue.
 // NB: This is a class because struct copies would break the safety
@@ -67,3 +68,65 @@ internal class QueueConfined<Value: AnyObject> {
         return f(value)
     }
 }
+
+/// A `QueueConfined` that also publishes an immutable snapshot derived from its value, which can
+/// be read from any thread without going through the queue.
+///
+/// The snapshot is republished at the end of every barrier block, so a value read with `snapshot`
+/// reflects every barrier block that has finished. Blocks passed to `sync` and `async` must not
+/// modify the value, which `QueueConfined` already requires since they may run concurrently.
+///
+/// This is meant for values that are read far more often than they're written. Writes that
+/// readers must observe immediately should use `syncBarrier`, since `snapshot` doesn't wait for
+/// pending `asyncBarrier` blocks.
+internal final class SnapshotQueueConfined<Value: AnyObject, Snapshot: AnyObject>: QueueConfined<Value> {
+    private let makeSnapshot: (Value) -> Snapshot
+    private let reference: _PMHTTPAtomicReference
+    
+    /// - Parameter makeSnapshot: A block that returns a snapshot of the value. It's executed on the
+    ///   queue at the end of every barrier block, and must not modify the value.
+    init(label: String, value: Value, makeSnapshot: @escaping (Value) -> Snapshot) {
+        self.makeSnapshot = makeSnapshot
+        reference = _PMHTTPAtomicReference(value: makeSnapshot(value))
+        super.init(label: label, value: value)
+    }
+    
+    /// The most recently published snapshot.
+    var snapshot: Snapshot {
+        return unsafeDowncast(reference.value as AnyObject, to: Snapshot.self)
+    }
+    
+    override func syncBarrier(_ f: (Value) -> Void) {
+        super.syncBarrier { value in
+            f(value)
+            self.publish(value)
+        }
+    }
+    
+    override func syncBarrier<T>(_ f: (Value) -> T) -> T {
+        return super.syncBarrier { value -> T in
+            let result = f(value)
+            self.publish(value)
+            return result
+        }
+    }
+    
+    override func asyncBarrier(_ f: @escaping (Value) -> Void) {
+        super.asyncBarrier { value in
+            f(value)
+            self.publish(value)
+        }
+    }
+    
+    override func unsafeDirectAccess<T>(_ f: (Value) -> T) -> T {
+        return super.unsafeDirectAccess { value -> T in
+            let result = f(value)
+            self.publish(value)
+            return result
+        }
+    }
+    
+    private func publish(_ value: Value) {
+        reference.value = makeSnapshot(value)
+    }
+}
@@ -0,0 +1,360 @@
+//
+//  RequestBatching.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import Foundation
+import PMJSON
+
+extension HTTPManager {
+    /// Creates a batcher that sends requests to a batch endpoint.
+    ///
+    /// - Parameter path: The path of the batch endpoint, interpreted relative to the environment.
+    ///   May be an absolute URL.
+    /// - Parameter maximumDelay: (Optional) The maximum amount of time a request waits for other
+    ///   requests to join its batch. The default value is 0.5 seconds.
+    /// - Parameter maximumBatchSize: (Optional) The maximum number of requests in each batch. The
+    ///   default value is 50.
+    /// - Returns: An `HTTPManagerRequestBatcher`, or `nil` if the `path` cannot be parsed by `URL`.
+    ///
+    /// - SeeAlso: `HTTPManagerRequestBatcher`.
+    @objc(requestBatcherForPath:maximumDelay:maximumBatchSize:)
+    public func requestBatcher(forPath path: String, maximumDelay: TimeInterval = 0.5, maximumBatchSize: Int = 50) -> HTTPManagerRequestBatcher! {
+        // NB: Using NSURL here because `URL(string: "", relativeTo: foo)` returns `nil`.
+        guard let url = NSURL(string: path, relativeTo: environment?.baseURL) as URL? else { return nil }
+        return HTTPManagerRequestBatcher(apiManager: self, url: url, maximumDelay: maximumDelay, maximumBatchSize: maximumBatchSize)
+    }
+}
+
+/// Collects requests and sends them to a batch endpoint as a single multipart upload.
+///
+/// Each request added to the batcher waits until `maximumDelay` has passed since the first request
+/// of its batch was added, or until the batch holds `maximumBatchSize` requests, whichever comes
+/// first. The batch is then sent as a `POST` to the batch endpoint. The body is
+/// `multipart/form-data` and has one `application/http` part per request, named `request-<n>` in
+/// the order the requests were added. Each part holds the request line, header fields and body of
+/// the request, serialized as in HTTP/1.1.
+///
+/// The batch endpoint is expected to respond with a `multipart/mixed` (or other multipart) body
+/// that has one `application/http` part per request, in the same order. Each part holds the status
+/// line, header fields and body of the response to that request. Responses are handled like the
+/// response to an `HTTPManagerDataRequest`. A status code outside of 2xx or 3xx produces an
+/// `HTTPManagerError.failedResponse`, or an `HTTPManagerError.unauthorized` for 401.
+///
+/// If the batch request itself fails, every request in the batch fails with the same error. If
+/// the response isn't multipart, every request fails with
+/// `HTTPManagerError.unexpectedContentType`. If it has too few parts, only the requests without a
+/// response fail with that error.
+///
+/// The batch request uses the `HTTPManager`'s defaults, such as `defaultAuth` and
+/// `defaultRetryBehavior`. It is user-initiated if any request in the batch is. Each request's own
+/// header fields, including any added by its `auth`, are serialized into its part. Mocks,
+/// retry behaviors and `HTTPAuth` retries don't apply to the individual requests.
+///
+/// Every request added to the batcher is completed. The batcher keeps its `HTTPManager` alive,
+/// the same as a request does, and any requests still waiting when the batcher is deallocated are
+/// sent right away.
+///
+/// **Thread safety:** All methods in this class are safe to call from any thread.
+public final class HTTPManagerRequestBatcher: NSObject {
+    /// The URL of the batch endpoint.
+    @objc public let url: URL
+    
+    /// The maximum amount of time a request waits for other requests to join its batch.
+    @objc public let maximumDelay: TimeInterval
+    
+    /// The maximum number of requests in each batch.
+    @objc public let maximumBatchSize: Int
+    
+    internal init(apiManager: HTTPManager, url: URL, maximumDelay: TimeInterval, maximumBatchSize: Int) {
+        self.apiManager = apiManager
+        self.url = url
+        self.maximumDelay = max(maximumDelay, 0)
+        self.maximumBatchSize = max(maximumBatchSize, 1)
+        super.init()
+    }
+    
+    deinit {
+        // A delayed flush doesn't keep the batcher alive, so send anything it was waiting for.
+        let batch = inner.unsafeDirectAccess({ $0.takeBatch() })
+        if !batch.isEmpty {
+            HTTPManagerRequestBatcher.send(batch, to: url, apiManager: apiManager)
+        }
+    }
+    
+    /// The number of requests waiting for their batch to be sent.
+    @objc public var pendingRequestCount: Int {
+        return inner.sync({ $0.pending.count })
+    }
+    
+    /// Adds a request to the next batch.
+    ///
+    /// - Parameter request: The request to add. Its `preparedURLRequest` is serialized when the
+    ///   request is added, so later changes to the request have no effect.
+    /// - Parameter queue: (Optional) The queue to call the handler on. The default value of `nil`
+    ///   means the handler will be called on a global concurrent queue.
+    /// - Parameter completion: The handler to call with the response to the request. The `task`
+    ///   parameter is the task for the batch the request was sent in.
+    @nonobjc public func add(_ request: HTTPManagerNetworkRequest, withCompletionQueue queue: OperationQueue? = nil, completion: @escaping (_ task: HTTPManagerTask, _ result: HTTPManagerTaskResult<Data>) -> Void) {
+        let entry = Entry(request: request, queue: queue, completion: completion)
+        let (batch, scheduleFlush) = inner.syncBarrier { inner -> ([Entry]?, Int?) in
+            inner.pending.append(entry)
+            if inner.pending.count >= maximumBatchSize {
+                return (inner.takeBatch(), nil)
+            }
+            return (nil, inner.pending.count == 1 ? inner.generation : nil)
+        }
+        if let batch = batch {
+            send(batch)
+        } else if let generation = scheduleFlush {
+            let qos: DispatchQoS.QoSClass = request.userInitiated ? .userInitiated : .utility
+            DispatchQueue.global(qos: qos).asyncAfter(deadline: .now() + maximumDelay) { [weak self] in
+                self?.flush(generation: generation)
+            }
+        }
+    }
+    
+    /// Sends any waiting requests immediately instead of waiting for `maximumDelay`.
+    @objc public func flush() {
+        flush(generation: nil)
+    }
+    
+    // MARK: - Private
+    
+    private let apiManager: HTTPManager
+    
+    private struct Entry {
+        let url: URL
+        let part: Data
+        let auth: HTTPAuth?
+        let assumeErrorsAreJSON: Bool
+        let userInitiated: Bool
+        let queue: OperationQueue?
+        let completion: (HTTPManagerTask, HTTPManagerTaskResult<Data>) -> Void
+        
+        init(request: HTTPManagerNetworkRequest, queue: OperationQueue?, completion: @escaping (HTTPManagerTask, HTTPManagerTaskResult<Data>) -> Void) {
+            let urlRequest = request.preparedURLRequest
+            url = urlRequest.url ?? request.url
+            part = HTTPManagerRequestBatcher.serialize(urlRequest)
+            auth = request.auth
+            assumeErrorsAreJSON = request.assumeErrorsAreJSON
+            userInitiated = request.userInitiated
+            self.queue = queue
+            self.completion = completion
+        }
+        
+        func complete(_ task: HTTPManagerTask, _ result: HTTPManagerTaskResult<Data>) {
+            if let queue = queue {
+                queue.addOperation {
+                    self.completion(task, result)
+                }
+            } else {
+                completion(task, result)
+            }
+        }
+    }
+    
+    private final class Inner {
+        var pending: [Entry] = []
+        /// Incremented every time a batch is taken, so a delayed flush can tell whether the batch
+        /// it was scheduled for has already been sent.
+        var generation = 0
+        
+        func takeBatch() -> [Entry] {
+            let batch = pending
+            pending = []
+            generation += 1
+            return batch
+        }
+    }
+    
+    private let inner = QueueConfined(label: "HTTPManagerRequestBatcher internal queue", value: Inner())
+    
+    /// Sends the waiting requests.
+    /// - Parameter generation: If non-`nil`, the requests are only sent if they're still the batch
+    ///   with this generation.
+    private func flush(generation: Int?) {
+        let batch = inner.syncBarrier { inner -> [Entry] in
+            guard generation == nil || generation == inner.generation else { return [] }
+            return inner.takeBatch()
+        }
+        if !batch.isEmpty {
+            send(batch)
+        }
+    }
+    
+    private func send(_ batch: [Entry]) {
+        HTTPManagerRequestBatcher.send(batch, to: url, apiManager: apiManager)
+    }
+    
+    /// Sends a batch. This doesn't reference the batcher, so it can be used from `deinit`.
+    private static func send(_ batch: [Entry], to url: URL, apiManager: HTTPManager) {
+        let request = apiManager.request(POST: url, parameters: [])
+        for (i, entry) in batch.enumerated() {
+            request.addMultipart(data: entry.part, withName: "request-\(i)", mimeType: "application/http")
+        }
+        request.userInitiated = batch.contains(where: { $0.userInitiated })
+        let entries = batch.map({ (url: $0.url, auth: $0.auth, assumeErrorsAreJSON: $0.assumeErrorsAreJSON) })
+        request.parse(using: { response, data -> [HTTPManagerTaskResult<Data>] in
+            return try HTTPManagerRequestBatcher.results(for: entries, response: response, data: data)
+        }).performRequest { task, result in
+            switch result {
+            case .success(_, let results):
+                for (entry, result) in zip(batch, results) {
+                    entry.complete(task, result)
+                }
+            case .error(let response, let error):
+                for entry in batch {
+                    entry.complete(task, .error(response, error))
+                }
+            case .canceled:
+                for entry in batch {
+                    entry.complete(task, .canceled)
+                }
+            }
+        }
+    }
+    
+    // MARK: Serialization
+    
+    private static let crlf = Data(bytes: [0x0D, 0x0A])
+    private static let headerTerminator = Data(bytes: [0x0D, 0x0A, 0x0D, 0x0A])
+    
+    /// Serializes a request as an HTTP/1.1 message.
+    private static func serialize(_ request: URLRequest) -> Data {
+        var target = "/"
+        var host = ""
+        if let url = request.url, let comps = URLComponents(url: url, resolvingAgainstBaseURL: true) {
+            target = comps.percentEncodedPath.isEmpty ? "/" : comps.percentEncodedPath
+            if let query = comps.percentEncodedQuery {
+                target += "?\(query)"
+            }
+            host = comps.percentEncodedHost ?? ""
+            if let port = comps.port {
+                host += ":\(port)"
+            }
+        }
+        let body: Data
+        if let httpBody = request.httpBody {
+            body = httpBody
+        } else if let stream = request.httpBodyStream {
+            stream.open()
+            body = (try? stream.readAll()) ?? Data()
+        } else {
+            body = Data()
+        }
+        var head = "\(request.httpMethod ?? "GET") \(target) HTTP/1.1\r\nHost: \(host)\r\n"
+        for (field, value) in (request.allHTTPHeaderFields ?? [:]).sorted(by: { $0.key < $1.key })
+            where field.caseInsensitiveCompare("Content-Length") != .orderedSame && field.caseInsensitiveCompare("Host") != .orderedSame
+        {
+            head += "\(field): \(value)\r\n"
+        }
+        if !body.isEmpty {
+            head += "Content-Length: \(body.count)\r\n"
+        }
+        head += "\r\n"
+        var data = head.data(using: .utf8)!
+        data.append(body)
+        return data
+    }
+    
+    /// Splits the response to a batch into the results for each request.
+    private static func results(for entries: [(url: URL, auth: HTTPAuth?, assumeErrorsAreJSON: Bool)], response: URLResponse, data: Data) throws -> [HTTPManagerTaskResult<Data>] {
+        guard let response = response as? HTTPURLResponse else {
+            return entries.map({ _ in .error(response, URLError(.badServerResponse)) })
+        }
+        let contentType = response.allHeaderFields["Content-Type"] as? String ?? ""
+        let mediaType = MediaType(contentType)
+        guard mediaType.type.caseInsensitiveCompare("multipart") == .orderedSame,
+            let boundary = mediaType.params.first(where: { $0.0.caseInsensitiveCompare("boundary") == .orderedSame })?.1,
+            let parts = multipartBodyParts(of: data, boundary: boundary)
+            else { throw HTTPManagerError.unexpectedContentType(contentType: contentType, response: response, body: data) }
+        return entries.enumerated().map({ (i, entry) -> HTTPManagerTaskResult<Data> in
+            guard i < parts.count, let (partResponse, body) = httpResponse(from: parts[i], url: entry.url) else {
+                return .error(response, HTTPManagerError.unexpectedContentType(contentType: contentType, response: response, body: data))
+            }
+            let statusCode = partResponse.statusCode
+            guard (200...399).contains(statusCode) else {
+                let json: JSON?
+                switch partResponse.mimeType.map(MediaType.init) {
+                case _ where entry.assumeErrorsAreJSON: fallthrough
+                case MediaType("application/json")?, MediaType("text/json")?: json = try? JSON.decode(body)
+                default: json = nil
+                }
+                if statusCode == 401 { // Unauthorized
+                    return .error(partResponse, HTTPManagerError.unauthorized(auth: entry.auth, response: partResponse, body: body, bodyJson: json))
+                } else {
+                    return .error(partResponse, HTTPManagerError.failedResponse(statusCode: statusCode, response: partResponse, body: body, bodyJson: json))
+                }
+            }
+            return .success(partResponse, body)
+        })
+    }
+    
+    /// Returns the bodies of the parts of a multipart body, or `nil` if the body is malformed.
+    ///
+    /// The header fields of each part are skipped, as only `application/http` parts are expected.
+    internal static func multipartBodyParts(of data: Data, boundary: String) -> [Data]? {
+        let delimiter = "--\(boundary)".data(using: .utf8)!
+        var partDelimiter = crlf
+        partDelimiter.append(delimiter)
+        guard var cursor = data.range(of: delimiter)?.upperBound else { return nil }
+        var parts: [Data] = []
+        while true {
+            // A delimiter followed by "--" closes the body.
+            if data.distance(from: cursor, to: data.endIndex) >= 2 && data[cursor] == 0x2D && data[data.index(after: cursor)] == 0x2D {
+                return parts
+            }
+            // Skip any transport padding after the delimiter.
+            guard let lineEnd = data.range(of: crlf, in: cursor..<data.endIndex),
+                let next = data.range(of: partDelimiter, in: lineEnd.upperBound..<data.endIndex)
+                else { return nil }
+            let part = data.subdata(in: lineEnd.upperBound..<next.lowerBound)
+            if part.starts(with: crlf) {
+                // The part has no header fields.
+                parts.append(part.subdata(in: part.index(part.startIndex, offsetBy: 2)..<part.endIndex))
+            } else if let headerEnd = part.range(of: headerTerminator) {
+                parts.append(part.subdata(in: headerEnd.upperBound..<part.endIndex))
+            } else {
+                return nil
+            }
+            cursor = next.upperBound
+        }
+    }
+    
+    /// Parses an HTTP/1.1 response message.
+    internal static func httpResponse(from message: Data, url: URL) -> (HTTPURLResponse, Data)? {
+        let headEnd = message.range(of: headerTerminator)
+        let head = message.subdata(in: message.startIndex..<(headEnd?.lowerBound ?? message.endIndex))
+        var body = headEnd.map({ message.subdata(in: $0.upperBound..<message.endIndex) }) ?? Data()
+        guard let headString = String(data: head, encoding: .isoLatin1) else { return nil }
+        var lines = headString.components(separatedBy: "\r\n")
+        let statusLine = lines.removeFirst().split(separator: " ", maxSplits: 2, omittingEmptySubsequences: true)
+        guard statusLine.count >= 2, statusLine[0].hasPrefix("HTTP/"), let statusCode = Int(statusLine[1]) else { return nil }
+        var headerFields: [String: String] = [:]
+        for line in lines {
+            guard let idx = line.index(of: ":") else { continue }
+            let field = trimLWS(String(line[..<idx]))
+            let value = trimLWS(String(line[line.index(after: idx)...]))
+            if let existing = headerFields[field] {
+                headerFields[field] = "\(existing), \(value)"
+            } else {
+                headerFields[field] = value
+            }
+        }
+        if let length = headerFields.first(where: { $0.key.caseInsensitiveCompare("Content-Length") == .orderedSame }).flatMap({ Int($0.value) }), length < body.count {
+            body = body.prefix(length)
+        }
+        guard let response = HTTPURLResponse(url: url, statusCode: statusCode, httpVersion: String(statusLine[0]), headerFields: headerFields) else { return nil }
+        return (response, body)
+    }
+}
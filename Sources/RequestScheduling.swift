@@ -0,0 +1,237 @@
+//
+//  RequestScheduling.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import Foundation
+
+/// The priority used to order requests that are waiting for an `HTTPManagerRequestScheduler`.
+@objc public enum HTTPManagerRequestPriority: Int, CustomStringConvertible {
+    /// Work the user isn't waiting on, such as prefetching. These requests only start when no
+    /// other requests for the same host are waiting.
+    case background = 0
+    /// The default priority.
+    case normal = 1
+    /// Work the user is waiting on. Requests with `HTTPManagerRequest.userInitiated` set always
+    /// use this priority.
+    case userInitiated = 2
+    
+    public var description: String {
+        switch self {
+        case .background: return "background"
+        case .normal: return "normal"
+        case .userInitiated: return "userInitiated"
+        }
+    }
+}
+
+/// Limits the number of network tasks that run concurrently for each host, starting waiting
+/// tasks in priority order.
+///
+/// When `HTTPManager.requestScheduler` is set, resuming a task only starts its network task if
+/// fewer than `maximumConcurrentRequestsPerHost` network tasks are running for the host of the
+/// request. Otherwise the task waits in a queue for its priority and starts once a running network
+/// task for the host finishes. Waiting tasks start in priority order, so a user-initiated request
+/// overtakes every normal and background request that's already waiting, and requests of the same
+/// priority start in the order they were resumed.
+///
+/// Retries wait for the scheduler the same way. A waiting task keeps the state `.running`, and
+/// canceling it removes it from the queue. The time a task spent waiting and the number of tasks
+/// that were ahead of it are available from `HTTPManagerTask.schedulerQueueDuration` and
+/// `HTTPManagerTask.schedulerQueueDepth`, e.g. in the `HTTPManager.metricsCallback`.
+///
+/// **Thread safety:** All methods in this class are safe to call from any thread.
+///
+/// - SeeAlso: `HTTPManager.requestScheduler`, `HTTPManagerRequest.priority`.
+public final class HTTPManagerRequestScheduler: NSObject {
+    /// The maximum number of network tasks that may run at once for each host.
+    @objc public let maximumConcurrentRequestsPerHost: Int
+    
+    /// Creates a new request scheduler.
+    ///
+    /// - Parameter maximumConcurrentRequestsPerHost: The maximum number of network tasks that may
+    ///   run at once for each host. Values less than 1 are treated as 1.
+    @objc public init(maximumConcurrentRequestsPerHost: Int) {
+        self.maximumConcurrentRequestsPerHost = max(maximumConcurrentRequestsPerHost, 1)
+        super.init()
+    }
+    
+    /// The number of tasks waiting to start, across every host.
+    @objc public var queuedTaskCount: Int {
+        return inner.sync({ $0.queuedCount })
+    }
+    
+    /// Returns the number of tasks waiting to start for `host`.
+    @objc(queuedTaskCountForHost:)
+    public func queuedTaskCount(forHost host: String) -> Int {
+        return inner.sync({ $0.hosts[host.lowercased()]?.queuedCount ?? 0 })
+    }
+    
+    // MARK: - Internal
+    
+    /// Starts `networkTask` once the scheduler admits it.
+    ///
+    /// Does nothing if `networkTask` is already waiting or running, which happens when coalesced
+    /// tasks that share a network task are resumed.
+    internal func submit(_ task: HTTPManagerTask, networkTask: URLSessionTask) {
+        let key = networkTask.originalRequest?.url?.host?.lowercased() ?? ""
+        let id = ObjectIdentifier(networkTask)
+        let now = DispatchTime.now().uptimeNanoseconds
+        let start = inner.syncBarrier { inner -> Bool in
+            let host = inner.hosts[key] ?? {
+                let host = HostState()
+                inner.hosts[key] = host
+                return host
+            }()
+            guard host.running[id] == nil && !host.queued.contains(id) else { return false }
+            if host.running.count < maximumConcurrentRequestsPerHost {
+                host.running[id] = networkTask
+                return true
+            }
+            let depth = host.queuedCount
+            host.append(Entry(task: task, networkTask: networkTask, enqueueTime: now, depth: depth), priority: task.priority)
+            inner.queuedCount += 1
+            return false
+        }
+        if start {
+            task.setSchedulingInfo(queueDuration: 0, queueDepth: 0)
+            task.startNetworkTask(networkTask)
+        }
+    }
+    
+    /// Records that `networkTask` has finished, starting the next waiting task for its host.
+    ///
+    /// If `networkTask` is still waiting, it's removed from the queue instead.
+    internal func finish(_ networkTask: URLSessionTask) {
+        let key = networkTask.originalRequest?.url?.host?.lowercased() ?? ""
+        let id = ObjectIdentifier(networkTask)
+        let now = DispatchTime.now().uptimeNanoseconds
+        let next = inner.syncBarrier { inner -> Entry? in
+            guard let host = inner.hosts[key] else { return nil }
+            defer {
+                if host.running.isEmpty && host.queuedCount == 0 {
+                    inner.hosts[key] = nil
+                }
+            }
+            if host.running.removeValue(forKey: id) == nil {
+                // It may be a canceled task that never started.
+                if host.remove(id) {
+                    inner.queuedCount -= 1
+                }
+                return nil
+            }
+            guard let entry = host.dequeue() else { return nil }
+            inner.queuedCount -= 1
+            host.running[ObjectIdentifier(entry.networkTask)] = entry.networkTask
+            return entry
+        }
+        if let entry = next {
+            entry.task.setSchedulingInfo(queueDuration: TimeInterval(now &- entry.enqueueTime) / 1e9, queueDepth: entry.depth)
+            entry.task.startNetworkTask(entry.networkTask)
+        }
+    }
+    
+    // MARK: - Private
+    
+    private struct Entry {
+        let task: HTTPManagerTask
+        let networkTask: URLSessionTask
+        let enqueueTime: UInt64
+        /// The number of tasks for the host that were waiting when this one was queued.
+        let depth: Int
+    }
+    
+    /// A FIFO queue of entries.
+    private struct Queue {
+        private var entries: [Entry?] = []
+        private var head = 0
+        
+        mutating func append(_ entry: Entry) {
+            entries.append(entry)
+        }
+        
+        mutating func popFirst() -> Entry? {
+            while head < entries.count {
+                let entry = entries[head]
+                entries[head] = nil
+                head += 1
+                if let entry = entry {
+                    compact()
+                    return entry
+                }
+            }
+            compact()
+            return nil
+        }
+        
+        /// Discards the consumed prefix once it makes up most of the storage.
+        private mutating func compact() {
+            if head == entries.count {
+                entries.removeAll(keepingCapacity: true)
+                head = 0
+            } else if head > 32 && head * 2 > entries.count {
+                entries.removeFirst(head)
+                head = 0
+            }
+        }
+    }
+    
+    private final class HostState {
+        /// The running network tasks. These are retained so their identifiers can't be reused.
+        var running: [ObjectIdentifier: URLSessionTask] = [:]
+        /// The waiting tasks, indexed by `HTTPManagerRequestPriority.rawValue`.
+        ///
+        /// Removed tasks are left in place and skipped by `dequeue()`. Their entries retain their
+        /// network tasks, so the identifiers in `queued` can't be reused while they're there.
+        var queues = [Queue](repeating: Queue(), count: 3)
+        /// The network tasks in `queues` that are still waiting.
+        var queued: Set<ObjectIdentifier> = []
+        
+        var queuedCount: Int {
+            return queued.count
+        }
+        
+        func append(_ entry: Entry, priority: HTTPManagerRequestPriority) {
+            queues[priority.rawValue].append(entry)
+            queued.insert(ObjectIdentifier(entry.networkTask))
+        }
+        
+        func remove(_ id: ObjectIdentifier) -> Bool {
+            guard queued.remove(id) != nil else { return false }
+            if queued.isEmpty {
+                // Drop the removed entries instead of waiting for dequeue() to skip them.
+                queues = [Queue](repeating: Queue(), count: queues.count)
+            }
+            return true
+        }
+        
+        /// Removes and returns the oldest waiting task with the highest priority.
+        func dequeue() -> Entry? {
+            for i in queues.indices.reversed() {
+                while let entry = queues[i].popFirst() {
+                    if queued.remove(ObjectIdentifier(entry.networkTask)) != nil {
+                        return entry
+                    }
+                }
+            }
+            return nil
+        }
+    }
+    
+    private final class Inner {
+        var hosts: [String: HostState] = [:]
+        /// The number of waiting tasks across every host.
+        var queuedCount = 0
+    }
+    
+    private let inner = QueueConfined(label: "HTTPManagerRequestScheduler internal queue", value: Inner())
+}
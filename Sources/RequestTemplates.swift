@@ -0,0 +1,225 @@
+//
+//  RequestTemplates.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import Foundation
+
+extension HTTPManager {
+    /// Creates a template for GET requests to an endpoint.
+    ///
+    /// - Parameter path: The path for the requests, interpreted relative to the environment. May
+    ///   be an absolute URL. Path components of the form `:name` are placeholders that are
+    ///   replaced with the path parameters given to `HTTPManagerRequestTemplate.request(…)`.
+    /// - Parameter parameters: (Optional) Request parameters that are passed in the query string
+    ///   of every request. Default is `[:]`. These are expanded the same way as the parameters of
+    ///   `request(GET:parameters:)`.
+    /// - Parameter configure: (Optional) A block that configures the request that every request
+    ///   created from the template is copied from. This is invoked once before this method
+    ///   returns.
+    /// - Returns: An `HTTPManagerRequestTemplate`, or `nil` if the `path` cannot be parsed by
+    ///   `URL`.
+    ///
+    /// - SeeAlso: `HTTPManagerRequestTemplate`.
+    @objc(requestTemplateForGET:parameters:configure:)
+    public func requestTemplate(GET path: String, parameters: [String: Any] = [:], configure: ((HTTPManagerDataRequest) -> Void)? = nil) -> HTTPManagerRequestTemplate! {
+        return requestTemplate(GET: path, parameters: expandParameters(parameters), configure: configure)
+    }
+    
+    /// Creates a template for GET requests to an endpoint.
+    ///
+    /// - Parameter path: The path for the requests, interpreted relative to the environment. May
+    ///   be an absolute URL. Path components of the form `:name` are placeholders that are
+    ///   replaced with the path parameters given to `HTTPManagerRequestTemplate.request(…)`.
+    /// - Parameter parameters: Request parameters that are passed in the query string of every
+    ///   request.
+    /// - Parameter configure: (Optional) A block that configures the request that every request
+    ///   created from the template is copied from. This is invoked once before this method
+    ///   returns.
+    /// - Returns: An `HTTPManagerRequestTemplate`, or `nil` if the `path` cannot be parsed by
+    ///   `URL`.
+    ///
+    /// - SeeAlso: `HTTPManagerRequestTemplate`.
+    @objc(requestTemplateForGET:queryItems:configure:)
+    public func requestTemplate(GET path: String, parameters: [URLQueryItem], configure: ((HTTPManagerDataRequest) -> Void)? = nil) -> HTTPManagerRequestTemplate! {
+        return HTTPManagerRequestTemplate(apiManager: self, path: path, parameters: parameters, configure: configure)
+    }
+}
+
+/// A precompiled GET request for an endpoint that's requested often.
+///
+/// A template resolves its path against the environment, applies the `HTTPManager`'s defaults
+/// (such as `defaultAuth` and `defaultHeaderFields`) and encodes its query parameters once, when
+/// it's created. Each request created from the template is a copy of that fully configured request
+/// with the path parameters and any extra query parameters substituted into its URL, so it skips
+/// the per-request work of `HTTPManager.request(GET:parameters:)`.
+///
+/// Because the configuration is frozen when the template is created, later changes to the
+/// `HTTPManager`, such as a new `environment` or `defaultAuth`, don't affect it. Create a new
+/// template when those change.
+///
+/// **Example:**
+///
+/// ```
+/// let userTemplate = HTTP.requestTemplate(GET: "users/:id", parameters: ["fields": "name,email"])!
+/// userTemplate.request(pathParameters: ["id": userID])
+///     .parseAsJSON(using: { try User(json: $1) })
+///     .performRequest { task, result in
+///         // ...
+/// }
+/// ```
+///
+/// **Thread safety:** Templates are immutable, and all methods in this class are safe to call
+/// from any thread.
+public final class HTTPManagerRequestTemplate: NSObject {
+    /// The names of the path placeholders, in the order they appear in the path.
+    @objc public let pathParameterNames: [String]
+    
+    /// Returns a new request for the template.
+    ///
+    /// - Parameter pathParameters: (Optional) The values for the path placeholders, keyed by name.
+    ///   The values are percent-encoded as path components, so they may contain `/`. Default is
+    ///   `[:]`.
+    /// - Parameter parameters: (Optional) Request parameters that are passed in the query string
+    ///   after the template's own parameters. Default is `[]`.
+    /// - Returns: An `HTTPManagerDataRequest`, or `nil` if `pathParameters` is missing a value for
+    ///   one of the `pathParameterNames`.
+    @objc(requestWithPathParameters:queryItems:)
+    public func request(pathParameters: [String: String] = [:], parameters: [URLQueryItem] = []) -> HTTPManagerDataRequest! {
+        var string = urlPrefix
+        string.reserveCapacity(estimatedLength)
+        for part in pathParts {
+            switch part {
+            case .literal(let literal):
+                string += literal
+            case .placeholder(let name):
+                guard let value = pathParameters[name]?.addingPercentEncoding(withAllowedCharacters: HTTPManagerRequestTemplate.pathParameterAllowedCharacters) else { return nil }
+                string += value
+            }
+        }
+        if !query.isEmpty || !parameters.isEmpty {
+            string += "?"
+            string += query
+            if !parameters.isEmpty {
+                if !query.isEmpty {
+                    string += "&"
+                }
+                string += FormURLEncoded.string(for: parameters)
+            }
+        }
+        guard let url = URL(string: string) else { return nil }
+        let request = HTTPManagerDataRequest(__copyOfRequest: prototype)
+        request.baseURL = url
+        return request
+    }
+    
+    public override var description: String {
+        return "<HTTPManagerRequestTemplate: \(prototype.requestMethod) \(urlPrefix)\(pathParts.map({ $0.description }).joined())\(query.isEmpty ? "" : "?\(query)")>"
+    }
+    
+    // MARK: - Internal
+    
+    fileprivate init?(apiManager: HTTPManager, path: String, parameters: [URLQueryItem], configure: ((HTTPManagerDataRequest) -> Void)?) {
+        // NB: URLComponents parses ":foo/bar" as a path but URL does not.
+        guard var comps = URLComponents(string: path) else { return nil }
+        // Escape the colon of each placeholder so it can't be mistaken for a scheme, and so we
+        // can find the placeholders again after resolving against the environment.
+        var names: [String] = []
+        comps.percentEncodedPath = comps.percentEncodedPath.components(separatedBy: "/").map({ component in
+            guard component.hasPrefix(":") && component != ":" else { return component }
+            let name = String(component.unicodeScalars.dropFirst())
+            names.append(name)
+            return HTTPManagerRequestTemplate.placeholderPrefix + name
+        }).joined(separator: "/")
+        // NB: Using NSURL here because `URL(string: "", relativeTo: foo)` returns `nil`.
+        guard let escapedPath = comps.string, let url = NSURL(string: escapedPath, relativeTo: apiManager.environment?.baseURL) as URL? else { return nil }
+        let prototype = apiManager.request(GET: url, parameters: [])
+        configure?(prototype)
+        self.prototype = prototype
+        guard var resolved = URLComponents(url: prototype.baseURL.absoluteURL, resolvingAgainstBaseURL: false) else { return nil }
+        
+        var pathParts: [PathPart] = []
+        var literal = ""
+        for (i, component) in resolved.percentEncodedPath.components(separatedBy: "/").enumerated() {
+            if i > 0 {
+                literal += "/"
+            }
+            if component.hasPrefix(HTTPManagerRequestTemplate.placeholderPrefix),
+                case let name = String(component.unicodeScalars.dropFirst(HTTPManagerRequestTemplate.placeholderPrefix.unicodeScalars.count)),
+                names.contains(name)
+            {
+                if !literal.isEmpty {
+                    pathParts.append(.literal(literal))
+                    literal = ""
+                }
+                pathParts.append(.placeholder(name))
+            } else {
+                literal += component
+            }
+        }
+        if !literal.isEmpty {
+            pathParts.append(.literal(literal))
+        }
+        self.pathParts = pathParts
+        pathParameterNames = names
+        
+        var queryParts: [String] = []
+        if let query = resolved.percentEncodedQuery, !query.isEmpty {
+            queryParts.append(query)
+        }
+        if !parameters.isEmpty {
+            queryParts.append(FormURLEncoded.string(for: parameters))
+        }
+        query = queryParts.joined(separator: "&")
+        
+        resolved.percentEncodedPath = ""
+        resolved.percentEncodedQuery = nil
+        resolved.percentEncodedFragment = nil
+        guard let prefix = resolved.string else { return nil }
+        urlPrefix = prefix
+        // Leave some room for the path parameters and extra query parameters.
+        estimatedLength = prefix.utf8.count + pathParts.reduce(0, { $0 + $1.description.utf8.count }) + query.utf8.count + 64
+        super.init()
+    }
+    
+    // MARK: - Private
+    
+    private enum PathPart: CustomStringConvertible {
+        /// Percent-encoded path text, including any `/` separators.
+        case literal(String)
+        case placeholder(String)
+        
+        var description: String {
+            switch self {
+            case .literal(let literal): return literal
+            case .placeholder(let name): return ":\(name)"
+            }
+        }
+    }
+    
+    private static let placeholderPrefix = "%3A"
+    
+    private static let pathParameterAllowedCharacters: CharacterSet = {
+        var characters = CharacterSet.urlPathAllowed
+        characters.remove(charactersIn: "/;")
+        return characters
+    }()
+    
+    /// The fully configured request that every request is copied from.
+    private let prototype: HTTPManagerDataRequest
+    /// The scheme, host and port, e.g. `"https://example.com"`.
+    private let urlPrefix: String
+    private let pathParts: [PathPart]
+    /// The percent-encoded query string, without the leading `?`.
+    private let query: String
+    private let estimatedLength: Int
+}
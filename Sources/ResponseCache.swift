@@ -0,0 +1,292 @@
+//
+//  ResponseCache.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import Foundation
+
+/// An in-memory cache of responses and the values parsed from them.
+///
+/// Unlike `URLCache`, the cache stores the value produced by a request's parse handler along with
+/// the response, so a cache hit skips both the network and the parse. Requests opt in with
+/// `HTTPManagerParseRequest.usesResponseCache` and are only cached if they're `GET` requests that
+/// aren't mocked.
+///
+/// Entries are keyed by the URL and header fields of the prepared request, including any headers
+/// added by the request's `auth`. Parsed values are only shared between requests that set the
+/// same `HTTPManagerParseRequest.parseIdentifier` and parse into the same type. Requests without a
+/// parse identifier share the cached response body but always run their own parse handler.
+/// The cache is bounded by the total size of the cached response bodies and evicts the least
+/// recently used entries first.
+///
+/// An entry is fresh for the lifetime given by the response's `Cache-Control: max-age` directive
+/// or `Expires` header. A stale entry is still returned immediately, but the request is also
+/// revalidated in the background using `If-None-Match` and `If-Modified-Since` when the response
+/// provided an `ETag` or `Last-Modified` header. A `304 Not Modified` response refreshes the entry,
+/// and any other successful response replaces it. Entries that have been stale for longer than
+/// `maximumStaleness` are discarded instead of being returned.
+///
+/// Only `200 OK` responses are cached. Responses with `Cache-Control: no-store` are never cached,
+/// and responses with `Cache-Control: no-cache` or no freshness information are stored already
+/// stale, so each use revalidates them.
+///
+/// **Thread safety:** All methods in this class are safe to call from any thread.
+public final class HTTPManagerResponseCache: NSObject {
+    /// The maximum total size in bytes of the cached response bodies.
+    @objc public let byteLimit: Int
+    
+    /// The maximum amount of time an entry may be stale and still be returned while it's being
+    /// revalidated.
+    @objc public let maximumStaleness: TimeInterval
+    
+    /// Creates a new response cache.
+    ///
+    /// - Parameter byteLimit: The maximum total size in bytes of the cached response bodies.
+    /// - Parameter maximumStaleness: (Optional) The maximum amount of time an entry may be stale
+    ///   and still be returned while it's being revalidated. The default value is 1 day.
+    @objc public init(byteLimit: Int, maximumStaleness: TimeInterval = 24 * 60 * 60) {
+        self.byteLimit = byteLimit
+        self.maximumStaleness = maximumStaleness
+        inner = QueueConfined(label: "HTTPManagerResponseCache internal queue", value: Inner(byteLimit: byteLimit))
+        super.init()
+    }
+    
+    /// The total size in bytes of the cached response bodies.
+    @objc public var currentByteCount: Int {
+        return inner.sync({ $0.entries.totalCost })
+    }
+    
+    /// Removes every entry from the cache.
+    @objc public func removeAllEntries() {
+        inner.asyncBarrier { inner in
+            inner.entries.removeAll()
+        }
+    }
+    
+    // MARK: - Internal
+    
+    /// The key for a cache entry.
+    struct Key: Hashable {
+        let url: URL?
+        let headerFields: [String: String]
+        
+        init(request: URLRequest) {
+            url = request.url
+            headerFields = request.allHTTPHeaderFields ?? [:]
+        }
+        
+        #if swift(>=4.1.9) // detect Swift 4.2 compiler
+        func hash(into hasher: inout Hasher) {
+            hasher.combine(url)
+            hasher.combine(headerFields)
+        }
+        #else
+        var hashValue: Int {
+            var hasher = SipHasher()
+            hasher.write(Int64(url?.hashValue ?? 0))
+            hasher.write(headerFields)
+            return Int(truncatingIfNeeded: hasher.finish())
+        }
+        #endif
+        
+        static func ==(lhs: Key, rhs: Key) -> Bool {
+            return lhs.url == rhs.url && lhs.headerFields == rhs.headerFields
+        }
+    }
+    
+    /// Identifies a parsed value stored alongside a cached response.
+    struct ValueKey: Hashable {
+        let valueType: ObjectIdentifier
+        let parseIdentifier: String
+        
+        init(valueType: Any.Type, parseIdentifier: String) {
+            self.valueType = ObjectIdentifier(valueType)
+            self.parseIdentifier = parseIdentifier
+        }
+        
+        #if swift(>=4.1.9) // detect Swift 4.2 compiler
+        func hash(into hasher: inout Hasher) {
+            hasher.combine(valueType)
+            hasher.combine(parseIdentifier)
+        }
+        #else
+        var hashValue: Int {
+            var hasher = SipHasher()
+            hasher.write(Int64(valueType.hashValue))
+            hasher.write(parseIdentifier)
+            return Int(truncatingIfNeeded: hasher.finish())
+        }
+        #endif
+        
+        static func ==(lhs: ValueKey, rhs: ValueKey) -> Bool {
+            return lhs.valueType == rhs.valueType && lhs.parseIdentifier == rhs.parseIdentifier
+        }
+    }
+    
+    /// The result of a cache lookup.
+    struct Hit {
+        let response: HTTPURLResponse
+        let data: Data
+        /// The value previously parsed from `data`, if one was stored for the requested value key.
+        let value: Any?
+        /// The header fields for a conditional request, if `needsRevalidation` is `true`.
+        let validators: [String: String]
+        /// `true` if the entry is stale and the caller should revalidate it. Only one caller is told
+        /// to revalidate an entry at a time.
+        let needsRevalidation: Bool
+    }
+    
+    /// Looks up an entry, marking it as the most recently used.
+    ///
+    /// - Parameter valueKey: The parsed value the caller wants, or `nil` if the caller's parsed
+    ///   value can't be shared.
+    /// - Returns: The cached entry, or `nil` if there is no usable entry.
+    func lookup(_ key: Key, valueKey: ValueKey?) -> Hit? {
+        let now = Date()
+        return inner.syncBarrier { inner -> Hit? in
+            guard let entry = inner.entries.value(forKey: key) else { return nil }
+            if now.timeIntervalSince(entry.expirationDate) > maximumStaleness {
+                inner.entries.removeValue(forKey: key)
+                return nil
+            }
+            let needsRevalidation = now >= entry.expirationDate && !entry.isRevalidating
+            if needsRevalidation {
+                entry.isRevalidating = true
+            }
+            return Hit(response: entry.response, data: entry.data, value: valueKey.flatMap({ entry.values[$0] }),
+                       validators: needsRevalidation ? entry.validators : [:], needsRevalidation: needsRevalidation)
+        }
+    }
+    
+    /// Stores a response along with the value parsed from it, replacing any existing entry.
+    ///
+    /// The value is only stored if `valueKey` is non-`nil`. Does nothing if the response isn't
+    /// cacheable.
+    func store(_ response: HTTPURLResponse, data: Data, value: Any, valueKey: ValueKey?, for key: Key) {
+        guard response.statusCode == 200, let lifetime = HTTPManagerResponseCache.freshnessLifetime(of: response) else {
+            inner.asyncBarrier { inner in
+                // A response we can't cache invalidates whatever we had.
+                inner.entries.removeValue(forKey: key)
+            }
+            return
+        }
+        let entry = Entry(response: response, data: data, expirationDate: Date(timeIntervalSinceNow: lifetime))
+        if let valueKey = valueKey {
+            entry.values[valueKey] = value
+        }
+        inner.asyncBarrier { inner in
+            inner.entries.setValue(entry, forKey: key, cost: data.count)
+        }
+    }
+    
+    /// Adds a value parsed from a cached response to that response's entry.
+    ///
+    /// Does nothing if the entry has since been replaced.
+    func add(_ value: Any, valueKey: ValueKey, for key: Key, response: HTTPURLResponse) {
+        inner.asyncBarrier { inner in
+            guard let entry = inner.entries.peekValue(forKey: key), entry.response === response else { return }
+            entry.values[valueKey] = value
+        }
+    }
+    
+    /// Refreshes an entry after revalidation returned `304 Not Modified`.
+    func refresh(for key: Key, notModified response: HTTPURLResponse) {
+        inner.asyncBarrier { inner in
+            guard let entry = inner.entries.peekValue(forKey: key) else { return }
+            entry.isRevalidating = false
+            // A 304 may update the freshness information. Otherwise the original response's applies.
+            guard let lifetime = HTTPManagerResponseCache.freshnessInfo(of: response).lifetime ?? HTTPManagerResponseCache.freshnessLifetime(of: entry.response) else {
+                inner.entries.removeValue(forKey: key)
+                return
+            }
+            entry.expirationDate = Date(timeIntervalSinceNow: lifetime)
+        }
+    }
+    
+    /// Marks an entry as no longer being revalidated, so a later lookup will try again.
+    func revalidationFailed(for key: Key) {
+        inner.asyncBarrier { inner in
+            inner.entries.peekValue(forKey: key)?.isRevalidating = false
+        }
+    }
+    
+    /// Returns the freshness lifetime of a response, or `nil` if the response must not be stored.
+    private static func freshnessLifetime(of response: HTTPURLResponse) -> TimeInterval? {
+        let info = freshnessInfo(of: response)
+        guard info.isStorable else { return nil }
+        return info.lifetime ?? 0
+    }
+    
+    /// Returns whether a response may be stored and its explicit freshness lifetime, if any.
+    private static func freshnessInfo(of response: HTTPURLResponse) -> (isStorable: Bool, lifetime: TimeInterval?) {
+        var lifetime: TimeInterval?
+        if let cacheControl = response.allHeaderFields["Cache-Control"] as? String {
+            for (key, value) in DelimitedParameters(cacheControl, delimiter: ",") {
+                switch CaseInsensitiveASCIIString(key) {
+                case "no-store":
+                    return (false, nil)
+                case "no-cache":
+                    lifetime = 0
+                case "max-age" where lifetime == nil:
+                    lifetime = value.flatMap({ TimeInterval($0) })
+                default:
+                    break
+                }
+            }
+        }
+        if lifetime == nil, let expires = (response.allHeaderFields["Expires"] as? String).map({ HTTPManager.parsedDateHeader(from: $0) }) {
+            // An invalid Expires value means the response is already expired.
+            let date = HTTPManager.parsedDateHeader(from: response) ?? Date()
+            lifetime = expires.map({ $0.timeIntervalSince(date) }) ?? 0
+        }
+        if let age = (response.allHeaderFields["Age"] as? String).flatMap({ TimeInterval($0) }) {
+            lifetime = lifetime.map({ $0 - age })
+        }
+        return (true, lifetime.map({ max($0, 0) }))
+    }
+    
+    private let inner: QueueConfined<Inner>
+    
+    private final class Entry {
+        let response: HTTPURLResponse
+        let data: Data
+        var expirationDate: Date
+        /// Parsed values keyed by their type and parse identifier.
+        var values: [ValueKey: Any] = [:]
+        var isRevalidating = false
+        
+        init(response: HTTPURLResponse, data: Data, expirationDate: Date) {
+            self.response = response
+            self.data = data
+            self.expirationDate = expirationDate
+        }
+        
+        var validators: [String: String] {
+            var headers: [String: String] = [:]
+            if let etag = response.allHeaderFields["ETag"] as? String {
+                headers["If-None-Match"] = etag
+            }
+            if let lastModified = response.allHeaderFields["Last-Modified"] as? String {
+                headers["If-Modified-Since"] = lastModified
+            }
+            return headers
+        }
+    }
+    
+    private final class Inner {
+        let entries: LRUCache<Key, Entry>
+        
+        init(byteLimit: Int) {
+            entries = LRUCache(costLimit: byteLimit)
+        }
+    }
+}
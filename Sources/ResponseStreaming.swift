@@ -0,0 +1,365 @@
+//
+//  ResponseStreaming.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import Foundation
+import PMJSON
+
+/// Delivers the body of a response to a handler as it's received instead of accumulating it.
+///
+/// A single `ResponseStream` is shared by every attempt of an `HTTPManagerTask`. Chunks are handed
+/// to the handler in order on a private serial queue. If the handler falls behind by more than
+/// `maximumBufferedBytes`, the network task is suspended until the handler catches up, which keeps
+/// peak memory bounded regardless of the size of the response.
+///
+/// Only successful responses are streamed. Error responses, redirects, 204 No Content, and
+/// responses with an unexpected content type are accumulated as usual so they can produce the
+/// normal `HTTPManagerError` values.
+internal final class ResponseStream {
+    init(expectedContentTypes: [String], maximumBufferedBytes: Int, userInitiated: Bool, handler: @escaping (_ response: URLResponse, _ data: Data) throws -> Void) {
+        self.expectedContentTypes = expectedContentTypes
+        self.maximumBufferedBytes = max(maximumBufferedBytes, 1)
+        self.handler = handler
+        queue = DispatchQueue(label: "PMHTTP response stream queue", qos: userInitiated ? .userInitiated : .utility)
+    }
+    
+    /// The error thrown by the handler, if any.
+    var error: Error? {
+        return inner.sync({ $0.error })
+    }
+    
+    /// `true` if the handler has been invoked with any data.
+    ///
+    /// Once this is `true` the task can no longer be retried, as that would replay the body from
+    /// the beginning.
+    var hasDeliveredData: Bool {
+        return inner.sync({ $0.hasDeliveredData })
+    }
+    
+    /// Invoked from the session delegate queue when a response is received.
+    /// - Returns: `true` if the body of the response should be streamed, or `false` if it should
+    ///   be accumulated normally.
+    func begin(_ response: URLResponse) -> Bool {
+        let shouldStream: Bool
+        if let response = response as? HTTPURLResponse {
+            let statusCode = response.statusCode
+            shouldStream = (200...299).contains(statusCode) && statusCode != 204
+                && unexpectedContentType(of: response, expectedContentTypes: expectedContentTypes) == nil
+        } else {
+            shouldStream = true
+        }
+        let suspendedTask = inner.syncBarrier { inner -> URLSessionTask? in
+            inner.response = shouldStream ? response : nil
+            defer { inner.suspendedTask = nil }
+            return inner.suspendedTask
+        }
+        suspendedTask?.resume()
+        return shouldStream
+    }
+    
+    /// Invoked from the session delegate queue for every chunk of a streamed response.
+    func append(_ data: Data, for networkTask: URLSessionTask) {
+        let streamedResponse = inner.syncBarrier { [maximumBufferedBytes] inner -> URLResponse? in
+            guard !inner.isCanceled && inner.error == nil, let response = inner.response else { return nil }
+            inner.bufferedBytes += data.count
+            if inner.suspendedTask == nil && inner.bufferedBytes > maximumBufferedBytes {
+                // Suspend while holding the barrier so it can't race with the resume in deliver().
+                inner.suspendedTask = networkTask
+                networkTask.suspend()
+            }
+            return response
+        }
+        guard let response = streamedResponse else { return }
+        queue.async {
+            autoreleasepool {
+                self.deliver(data, response: response, networkTask: networkTask)
+            }
+        }
+    }
+    
+    /// Discards any chunks that haven't been delivered yet.
+    func cancel() {
+        inner.asyncBarrier { inner in
+            inner.isCanceled = true
+        }
+    }
+    
+    /// Executes a block on the given queue once all outstanding chunks have been delivered.
+    func notify(queue: DispatchQueue, execute block: @escaping () -> Void) {
+        self.queue.async {
+            queue.async(execute: block)
+        }
+    }
+    
+    private let expectedContentTypes: [String]
+    private let maximumBufferedBytes: Int
+    private let handler: (_ response: URLResponse, _ data: Data) throws -> Void
+    private let queue: DispatchQueue
+    private let inner = QueueConfined(label: "PMHTTP response stream internal queue", value: Inner())
+    
+    private class Inner {
+        /// The response currently being streamed, or `nil` if the current response isn't streamed.
+        var response: URLResponse?
+        /// The number of bytes handed to `append(_:for:)` that haven't been delivered yet.
+        var bufferedBytes = 0
+        /// The network task that was suspended because too many bytes are buffered.
+        var suspendedTask: URLSessionTask?
+        var hasDeliveredData = false
+        var isCanceled = false
+        var error: Error?
+    }
+    
+    private func deliver(_ data: Data, response: URLResponse, networkTask: URLSessionTask) {
+        let shouldDeliver = inner.syncBarrier { inner -> Bool in
+            guard !inner.isCanceled && inner.error == nil else { return false }
+            inner.hasDeliveredData = true
+            return true
+        }
+        if shouldDeliver {
+            do {
+                try handler(response, data)
+            } catch {
+                inner.syncBarrier { inner in
+                    if inner.error == nil {
+                        inner.error = error
+                    }
+                }
+                // The session delegate substitutes our error for the resulting cancellation.
+                networkTask.cancel()
+            }
+        }
+        inner.syncBarrier { [maximumBufferedBytes] inner in
+            inner.bufferedBytes -= data.count
+            // Use hysteresis so we don't toggle the task on every chunk.
+            if let task = inner.suspendedTask, inner.bufferedBytes <= maximumBufferedBytes / 2 {
+                inner.suspendedTask = nil
+                task.resume()
+            }
+        }
+    }
+}
+
+// MARK: -
+
+/// Writes a streamed response body to a file and maps it back into memory once it's complete.
+///
+/// A single writer is shared by every attempt of an `HTTPManagerTask`. Each new response starts the
+/// file over. The writer isn't thread-safe, but the `ResponseStream` serializes writes and the task
+/// processor only runs once they've all been delivered.
+internal final class ResponseFileWriter {
+    /// The URL of the file that the body is written to.
+    let fileURL: URL
+    
+    init(destinationURL: URL?) {
+        if let destinationURL = destinationURL {
+            fileURL = destinationURL
+            isTemporary = false
+        } else {
+            fileURL = URL(fileURLWithPath: NSTemporaryDirectory(), isDirectory: true).appendingPathComponent("PMHTTP-\(UUID().uuidString)")
+            isTemporary = true
+        }
+    }
+    
+    deinit {
+        stream?.close()
+        if !isFinished && response != nil {
+            // The task failed or was canceled, so don't leave a partial file behind.
+            _ = try? FileManager.default.removeItem(at: fileURL)
+        }
+    }
+    
+    /// Appends a chunk of the body of `response` to the file.
+    func write(_ data: Data, for response: URLResponse) throws {
+        let stream = try self.stream(for: response)
+        try data.withUnsafeBytes { (bytes: UnsafePointer<UInt8>) in
+            var offset = 0
+            while offset < data.count {
+                let count = stream.write(bytes + offset, maxLength: data.count - offset)
+                guard count > 0 else {
+                    throw stream.streamError ?? CocoaError(.fileWriteUnknown, userInfo: [NSURLErrorKey: fileURL])
+                }
+                offset += count
+            }
+        }
+        byteCount += data.count
+    }
+    
+    /// Closes the file and returns its contents mapped into memory.
+    /// - Parameter response: The response that completed the task. If no body was written for
+    ///   this response, e.g. because it was a 204 No Content, the file is left empty.
+    func finish(for response: URLResponse) throws -> Data {
+        let stream = try self.stream(for: response)
+        stream.close()
+        self.stream = nil
+        isFinished = true
+        // Empty files can't be mapped.
+        let data = byteCount > 0 ? try Data(contentsOf: fileURL, options: .alwaysMapped) : Data()
+        if isTemporary {
+            // The mapping keeps the contents alive after the file is unlinked.
+            _ = try? FileManager.default.removeItem(at: fileURL)
+        }
+        return data
+    }
+    
+    private let isTemporary: Bool
+    private var stream: OutputStream?
+    /// The response whose body is currently being written.
+    private var response: URLResponse?
+    private var byteCount = 0
+    private var isFinished = false
+    
+    /// Returns the stream for writing the body of `response`, truncating the file if it was
+    /// previously written for a different response.
+    private func stream(for response: URLResponse) throws -> OutputStream {
+        if let stream = stream, response === self.response {
+            return stream
+        }
+        stream?.close()
+        guard let stream = OutputStream(url: fileURL, append: false) else {
+            throw CocoaError(.fileWriteUnknown, userInfo: [NSURLErrorKey: fileURL])
+        }
+        stream.open()
+        if let error = stream.streamError {
+            throw error
+        }
+        self.stream = stream
+        self.response = response
+        byteCount = 0
+        isFinished = false
+        return stream
+    }
+}
+
+// MARK: -
+
+/// Splits a UTF-8 JSON document whose top-level value is an array into the encoded form of each
+/// of its elements, as the document is received.
+///
+/// The splitter only tracks enough of the JSON grammar to find element boundaries. Each element is
+/// expected to be decoded separately, which reports any errors within the element itself.
+internal struct JSONArrayElementSplitter {
+    /// Feeds the next chunk of the document to the splitter.
+    /// - Parameter data: The next chunk of the document.
+    /// - Parameter body: A block that's invoked with the encoded form of each element that's
+    ///   completed by this chunk.
+    /// - Throws: `JSONParserError` if the document isn't an array, or any error thrown by `body`.
+    mutating func append(_ data: Data, _ body: (Data) throws -> Void) throws {
+        let count = data.count
+        try data.withUnsafeBytes { (bytes: UnsafePointer<UInt8>) in
+            var elementStart = 0
+            var i = 0
+            while i < count {
+                let c = bytes[i]
+                switch state {
+                case .prologue:
+                    if c == UInt8(ascii: "[") {
+                        state = .elementStart(first: true)
+                    } else if !isJSONWhitespace(c) {
+                        throw error(.invalidSyntax)
+                    }
+                case .elementStart(let first):
+                    if isJSONWhitespace(c) {
+                        break
+                    } else if c == UInt8(ascii: "]") && first {
+                        state = .epilogue
+                    } else if c == UInt8(ascii: "]") || c == UInt8(ascii: ",") {
+                        throw error(.invalidSyntax)
+                    } else {
+                        state = .element
+                        depth = 0
+                        inString = false
+                        escaped = false
+                        elementStart = i
+                        // Reprocess this byte as part of the element.
+                        continue
+                    }
+                case .element:
+                    if inString {
+                        if escaped {
+                            escaped = false
+                        } else if c == UInt8(ascii: "\\") {
+                            escaped = true
+                        } else if c == UInt8(ascii: "\"") {
+                            inString = false
+                        }
+                    } else if c == UInt8(ascii: "\"") {
+                        inString = true
+                    } else if c == UInt8(ascii: "[") || c == UInt8(ascii: "{") {
+                        depth += 1
+                    } else if depth > 0 && (c == UInt8(ascii: "]") || c == UInt8(ascii: "}")) {
+                        depth -= 1
+                    } else if depth == 0 && (c == UInt8(ascii: ",") || c == UInt8(ascii: "]")) {
+                        pending.append(bytes + elementStart, count: i - elementStart)
+                        let element = pending
+                        pending.removeAll(keepingCapacity: true)
+                        state = c == UInt8(ascii: ",") ? .elementStart(first: false) : .epilogue
+                        try body(element)
+                    }
+                case .epilogue:
+                    if !isJSONWhitespace(c) {
+                        throw error(.trailingCharacters)
+                    }
+                }
+                if c == 0x0A { // \n
+                    line += 1
+                    column = 0
+                } else {
+                    column += 1
+                }
+                i += 1
+            }
+            if case .element = state {
+                pending.append(bytes + elementStart, count: count - elementStart)
+            }
+        }
+    }
+    
+    /// Validates that the whole document has been received.
+    /// - Throws: `JSONParserError` if the document ended before the array was closed.
+    func finish() throws {
+        guard case .epilogue = state else {
+            throw error(.unexpectedEOF)
+        }
+    }
+    
+    private enum State {
+        /// Before the opening `[`.
+        case prologue
+        /// Before the start of an element. `first` is `true` if the array may still be empty.
+        case elementStart(first: Bool)
+        /// Within an element.
+        case element
+        /// After the closing `]`.
+        case epilogue
+    }
+    
+    private var state: State = .prologue
+    /// The bytes of an element that began in a previous chunk.
+    private var pending = Data()
+    private var depth = 0
+    private var inString = false
+    private var escaped = false
+    private var line: UInt = 0
+    private var column: UInt = 0
+    
+    private func error(_ code: JSONParserError.Code) -> JSONParserError {
+        return JSONParserError(code: code, line: line, column: column)
+    }
+}
+
+private func isJSONWhitespace(_ c: UInt8) -> Bool {
+    switch c {
+    case 0x20, 0x09, 0x0A, 0x0D: return true
+    default: return false
+    }
+}
@@ -0,0 +1,236 @@
+//
+//  RetryScheduling.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import Foundation
+
+/// A limit on how many retries may be performed against each host, shared by every task that
+/// uses it.
+///
+/// Each host gets a bucket of `capacity` tokens that refills at `refillRate` tokens per second.
+/// Every retry requested by an `HTTPManagerRetryBehavior` takes a token from the bucket for the host
+/// of the request, and if the bucket is empty the retry isn't performed and the task fails with
+/// the error that triggered the retry. This keeps the recovery traffic from an outage bounded no
+/// matter how many tasks are retrying. Retries requested by an `HTTPAuth` aren't limited.
+///
+/// **Thread safety:** All methods in this class are safe to call from any thread.
+///
+/// - SeeAlso: `HTTPManager.retryBudget`.
+public final class HTTPManagerRetryBudget: NSObject {
+    /// The maximum number of tokens in each host's bucket, which is also the number of retries a
+    /// host may get in a burst.
+    @objc public let capacity: Int
+    
+    /// The number of tokens per second added to each host's bucket.
+    @objc public let refillRate: Double
+    
+    /// Creates a new retry budget.
+    ///
+    /// - Parameter capacity: The maximum number of tokens in each host's bucket.
+    /// - Parameter refillRate: The number of tokens per second added to each host's bucket.
+    @objc public init(capacity: Int, refillRate: Double) {
+        self.capacity = max(capacity, 0)
+        self.refillRate = max(refillRate, 0)
+        super.init()
+    }
+    
+    /// Takes a token from the bucket for `host`.
+    ///
+    /// - Returns: `true` if a token was available, or `false` if the retry should not be performed.
+    internal func consumeToken(forHost host: String?) -> Bool {
+        let key = host?.lowercased() ?? ""
+        let now = DispatchTime.now().uptimeNanoseconds
+        return inner.syncBarrier { inner -> Bool in
+            var bucket = inner.buckets[key] ?? Bucket(tokens: Double(capacity), lastRefill: now)
+            bucket.tokens = min(Double(capacity), bucket.tokens + Double(now &- bucket.lastRefill) / 1e9 * refillRate)
+            bucket.lastRefill = now
+            let ok = bucket.tokens >= 1
+            if ok {
+                bucket.tokens -= 1
+            }
+            inner.buckets[key] = bucket
+            if inner.buckets.count > HTTPManagerRetryBudget.prunedBucketCount {
+                inner.prune(now: now, capacity: capacity, refillRate: refillRate)
+            }
+            return ok
+        }
+    }
+    
+    /// Returns a token taken by `consumeToken(forHost:)` for a retry that didn't happen.
+    internal func refundToken(forHost host: String?) {
+        let key = host?.lowercased() ?? ""
+        inner.asyncBarrier { [capacity] inner in
+            // A missing bucket starts out full, so there's nothing to return the token to.
+            guard var bucket = inner.buckets[key] else { return }
+            bucket.tokens = min(Double(capacity), bucket.tokens + 1)
+            inner.buckets[key] = bucket
+        }
+    }
+    
+    /// The number of buckets above which buckets that have refilled are discarded.
+    private static let prunedBucketCount = 64
+    
+    private struct Bucket {
+        var tokens: Double
+        var lastRefill: UInt64
+    }
+    
+    private final class Inner {
+        var buckets: [String: Bucket] = [:]
+        
+        /// Removes the buckets that would be full by now, since a missing bucket starts out full.
+        func prune(now: UInt64, capacity: Int, refillRate: Double) {
+            for (key, bucket) in buckets where bucket.tokens + Double(now &- bucket.lastRefill) / 1e9 * refillRate >= Double(capacity) {
+                buckets[key] = nil
+            }
+        }
+    }
+    
+    private let inner = QueueConfined(label: "HTTPManagerRetryBudget internal queue", value: Inner())
+}
+
+/// Runs delayed retries from a single timing wheel instead of a separate dispatch timer per task.
+///
+/// The wheel has `slotCount` slots that each cover `tickInterval` seconds, and blocks scheduled
+/// further out than one revolution wait for the appropriate number of revolutions. A single timer
+/// is armed for the next slot that has blocks in it, so the scheduler doesn't wake up when nothing
+/// is due. Blocks run no earlier than their delay and up to about one tick later.
+///
+/// **Thread safety:** All methods in this class are safe to call from any thread.
+internal final class RetryScheduler {
+    /// The scheduler used for retries by the built-in retry strategies.
+    static let shared = RetryScheduler(tickInterval: 0.01, slotCount: 512)
+    
+    let tickInterval: TimeInterval
+    let slotCount: Int
+    
+    init(tickInterval: TimeInterval, slotCount: Int) {
+        precondition(tickInterval > 0 && slotCount > 0, "RetryScheduler requires a positive tick interval and slot count")
+        self.tickInterval = tickInterval
+        self.slotCount = slotCount
+        slots = Array(repeating: [], count: slotCount)
+        startTime = DispatchTime.now().uptimeNanoseconds
+        let queue = DispatchQueue(label: "PMHTTP retry scheduler queue")
+        self.queue = queue
+        timer = DispatchSource.makeTimerSource(queue: queue)
+        timer.setEventHandler { [unowned self] in
+            self.advance()
+        }
+        timer.resume()
+    }
+    
+    deinit {
+        timer.cancel()
+    }
+    
+    /// Executes `block` asynchronously on `queue` after `delay` seconds.
+    func schedule(after delay: TimeInterval, on queue: DispatchQueue, execute block: @escaping () -> Void) {
+        guard delay > 0 else {
+            queue.async(execute: block)
+            return
+        }
+        let now = DispatchTime.now().uptimeNanoseconds
+        self.queue.async {
+            self.insert(Entry(queue: queue, block: block), delay: delay, now: now)
+        }
+    }
+    
+    /// The number of blocks that are waiting to run.
+    var pendingCount: Int {
+        return queue.sync(execute: { count })
+    }
+    
+    // MARK: - Private
+    
+    private struct Entry {
+        let queue: DispatchQueue
+        let block: () -> Void
+        /// The number of times the wheel must pass the entry's slot before it runs.
+        var rounds: Int = 0
+        
+        init(queue: DispatchQueue, block: @escaping () -> Void) {
+            self.queue = queue
+            self.block = block
+        }
+    }
+    
+    private let queue: DispatchQueue
+    private let timer: DispatchSourceTimer
+    private let startTime: UInt64
+    
+    // The following properties must only be accessed from `queue`.
+    private var slots: [[Entry]]
+    private var count = 0
+    /// The number of ticks since `startTime` that have been processed.
+    private var processedTicks = 0
+    
+    private var tickNanoseconds: Double {
+        return tickInterval * 1e9
+    }
+    
+    /// Returns the number of whole ticks between `startTime` and `time`.
+    private func ticks(at time: UInt64) -> Int {
+        return Int(Double(time &- startTime) / tickNanoseconds)
+    }
+    
+    private func insert(_ entry: Entry, delay: TimeInterval, now: UInt64) {
+        if count == 0 {
+            // The wheel was idle, so there's nothing to do for the ticks we skipped.
+            processedTicks = max(processedTicks, ticks(at: DispatchTime.now().uptimeNanoseconds))
+        }
+        // Round up so the block never runs early.
+        let dueTick = Int(((Double(now &- startTime) + delay * 1e9) / tickNanoseconds).rounded(.up))
+        let ticksAhead = max(dueTick - processedTicks, 1)
+        var entry = entry
+        entry.rounds = (ticksAhead - 1) / slotCount
+        slots[(processedTicks + ticksAhead) % slotCount].append(entry)
+        count += 1
+        armTimer()
+    }
+    
+    private func advance() {
+        // The timer may fire late, so catch up on every tick that has elapsed.
+        let elapsedTicks = ticks(at: DispatchTime.now().uptimeNanoseconds)
+        while processedTicks < elapsedTicks && count > 0 {
+            processedTicks += 1
+            let index = processedTicks % slotCount
+            guard !slots[index].isEmpty else { continue }
+            var remaining: [Entry] = []
+            for var entry in slots[index] {
+                if entry.rounds == 0 {
+                    entry.queue.async(execute: entry.block)
+                    count -= 1
+                } else {
+                    entry.rounds -= 1
+                    remaining.append(entry)
+                }
+            }
+            slots[index] = remaining
+        }
+        armTimer()
+    }
+    
+    /// Arms the timer for the next slot that has any blocks in it.
+    private func armTimer() {
+        guard count > 0 else {
+            timer.schedule(deadline: .distantFuture)
+            return
+        }
+        var ticksAhead = 1
+        while slots[(processedTicks + ticksAhead) % slotCount].isEmpty {
+            ticksAhead += 1
+        }
+        let deadline = startTime + UInt64(Double(processedTicks + ticksAhead) * tickNanoseconds)
+        timer.schedule(deadline: DispatchTime(uptimeNanoseconds: deadline), leeway: .nanoseconds(Int(tickNanoseconds / 2)))
+    }
+}
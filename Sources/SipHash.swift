@@ -12,7 +12,7 @@
 //  except according to those terms.
 //
 
-#if !swift(>=4.1.9) // detect Swift 4.2 compiler
+import Foundation
 
 /// A generic hasher that implements SipHash-2-4.
 /// Once a hasher is created, data can be added to it iteratively.
@@ -86,6 +86,55 @@ internal struct SipHasher: TextOutputStream {
         }
     }
     
+    /// Writes a buffer of bytes to the hasher.
+    ///
+    /// This produces the same result as the generic `write(_:)` but loads 8 bytes at a time, which
+    /// is considerably faster for large inputs.
+    mutating func write(_ bytes: UnsafeRawBufferPointer) {
+        guard let base = bytes.baseAddress else { return }
+        var count: UInt = numericCast(bytes.count)
+        b += count
+        var offset = 0
+        if tailLen != 0 {
+            let needed = 8 - tailLen
+            for i in 0..<min(count, needed) {
+                tail |= UInt64(bytes[offset]) << UInt64(8 * (tailLen + i))
+                offset += 1
+            }
+            if count < needed {
+                tailLen += count
+                return
+            } else {
+                compress(tail)
+                // NB: tail and tailLen are reset later
+                count -= needed
+            }
+        }
+        var block: UInt64 = 0
+        for _ in 0..<(count / 8) {
+            // memcpy because the buffer isn't necessarily 8-byte aligned
+            memcpy(&block, base + offset, 8)
+            compress(UInt64(littleEndian: block))
+            offset += 8
+        }
+        tailLen = count % 8
+        if tailLen > 0 {
+            tail = 0
+            for i in 0..<tailLen {
+                tail |= UInt64(bytes[offset]) << UInt64(8 * i)
+                offset += 1
+            }
+        }
+    }
+    
+    /// Writes the contents of `data` to the hasher.
+    mutating func write(_ data: Data) {
+        guard !data.isEmpty else { return }
+        data.withUnsafeBytes { (bytes: UnsafePointer<UInt8>) in
+            write(UnsafeRawBufferPointer(start: bytes, count: data.count))
+        }
+    }
+    
     mutating func finish() -> UInt64 {
         defer { self = SipHasher(key: (k0, k1)) }
         if tailLen == 0 {
@@ -230,10 +279,23 @@ internal struct SipHasher: TextOutputStream {
         write(scalar.value)
     }
     
+    /// Writes the entries of `dictionary` to the hasher without depending on their order.
+    mutating func write(_ dictionary: [String: String]) {
+        var combined: UInt64 = 0
+        for (key, value) in dictionary {
+            var hasher = SipHasher()
+            // The length keeps ("ab", "c") and ("a", "bc") apart.
+            hasher.write(Int64(key.utf16.count))
+            hasher.write(key)
+            hasher.write(value)
+            combined = combined &+ hasher.finish()
+        }
+        write(Int64(dictionary.count))
+        write(combined)
+    }
+    
     /// Writes the string representation of `c` to the hasher.
     mutating func write(_ c: Character) {
         c.write(to: &self)
     }
 }
-
-#endif // !swift(>=4.1.9)
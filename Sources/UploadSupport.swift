@@ -29,21 +29,76 @@ internal enum FormURLEncoded {
         guard !queryItems.isEmpty else {
             return ""
         }
-        let encodedQueryItems = queryItems.lazySequence.map({ item -> String in
-            let encodedName = item.name.addingPercentEncoding(withAllowedCharacters: .formUrlencodedAllowedCharacters) ?? ""
-            if let value = item.value {
-                let encodedValue = value.addingPercentEncoding(withAllowedCharacters: .formUrlencodedAllowedCharacters) ?? ""
-                return "\(encodedName)=\(encodedValue)"
-            } else {
-                return encodedName
-            }
-        })
-        return encodedQueryItems.joined(separator: "&")
+        // The encoded form is always ASCII.
+        return String(decoding: data(for: queryItems), as: UTF8.self)
     }
     
     static func data(for queryItems: [URLQueryItem]) -> Data {
-        return string(for: queryItems).data(using: .utf8) ?? Data()
+        guard !queryItems.isEmpty else {
+            return Data()
+        }
+        return allowedBytes.withUnsafeBufferPointer { allowed -> Data in
+            // Measure the output first so it can be written into a single allocation.
+            var count = queryItems.count - 1 // separators
+            for item in queryItems {
+                count += encodedLength(of: item.name, allowed: allowed)
+                if let value = item.value {
+                    count += 1 + encodedLength(of: value, allowed: allowed)
+                }
+            }
+            var data = Data(count: count)
+            data.withUnsafeMutableBytes { (output: UnsafeMutablePointer<UInt8>) in
+                var offset = 0
+                for (i, item) in queryItems.enumerated() {
+                    if i > 0 {
+                        output[offset] = 0x26 // &
+                        offset += 1
+                    }
+                    encode(item.name, into: output, at: &offset, allowed: allowed)
+                    if let value = item.value {
+                        output[offset] = 0x3d // =
+                        offset += 1
+                        encode(value, into: output, at: &offset, allowed: allowed)
+                    }
+                }
+                assert(offset == count, "internal HTTPManager error: form encoding wrote \(offset) bytes, expected \(count)")
+            }
+            return data
+        }
+    }
+    
+    private static func encodedLength(of string: String, allowed: UnsafeBufferPointer<Bool>) -> Int {
+        var length = 0
+        for c in string.utf8 {
+            length += allowed[Int(c)] ? 1 : 3
+        }
+        return length
     }
+    
+    private static func encode(_ string: String, into output: UnsafeMutablePointer<UInt8>, at offset: inout Int, allowed: UnsafeBufferPointer<Bool>) {
+        for c in string.utf8 {
+            if allowed[Int(c)] {
+                output[offset] = c
+                offset += 1
+            } else {
+                output[offset] = 0x25 // %
+                output[offset + 1] = hexDigits[Int(c >> 4)]
+                output[offset + 2] = hexDigits[Int(c & 0xf)]
+                offset += 3
+            }
+        }
+    }
+    
+    /// Whether each byte value may appear unencoded.
+    private static let allowedBytes: ContiguousArray<Bool> = ContiguousArray((0...255).lazy.map({ (x: Int) -> Bool in
+        switch UInt8(x) {
+        case 0x2a, 0x2d, 0x2e, 0x5f: return true // * - . _
+        case 0x30...0x39, 0x41...0x5a, 0x61...0x7a: return true // 0-9 A-Z a-z
+        default: return false
+        }
+    }))
+    
+    private static let hexDigits: ContiguousArray<UInt8> = ContiguousArray("0123456789ABCDEF".utf8)
 }
 
 internal enum UploadBody {
@@ -63,26 +118,6 @@ internal enum UploadBody {
     }
 }
 
-private extension CharacterSet {
-    static let formUrlencodedAllowedCharacters: CharacterSet = {
-        var cs: CharacterSet = ["*", "-", ".", "_"]
-        cs.insert(charactersIn: "0"..."9")
-        cs.insert(charactersIn: "A"..."Z")
-        cs.insert(charactersIn: "a"..."z")
-        cs.makeImmutable()
-        return cs
-    }()
-    
-    /// Ensures the wrapped character set is immutable.
-    ///
-    /// Mutable character sets are less efficient than immutable ones.
-    private mutating func makeImmutable() {
-        // The only way to ensure this right now is to bridge through Obj-C.
-        // There's also no way to test if we're mutable or not due to the _SwiftNativeNS* wrapper.
-        self = unsafeDowncast((self as NSCharacterSet).copy() as AnyObject, to: NSCharacterSet.self) as CharacterSet
-    }
-}
-
 internal enum MultipartBodyPart {
     case known(Data)
     case pending(Deferred)
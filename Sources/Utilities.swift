@@ -73,17 +73,36 @@ internal struct CaseInsensitiveASCIIString: Hashable, ExpressibleByStringLiteral
     func hash(into hasher: inout Hasher) {
         CaseInsensitiveASCIIString.lowercaseTable.withUnsafeBufferPointer { table in
             #if compiler(>=5)
-            let nativeView = string.utf8
+            // Lowercase the UTF-8 bytes a chunk at a time so the hasher sees them in bulk. Feeding
+            // the hasher single bytes or whole chunks produces the same result, so it doesn't matter
+            // whether the contiguous fast path is taken.
+            func combine<S: Sequence>(_ bytes: S) where S.Element == UInt8 {
+                var chunk: (UInt64, UInt64, UInt64, UInt64) = (0, 0, 0, 0)
+                withUnsafeMutableBytes(of: &chunk) { chunk in
+                    var count = 0
+                    for x in bytes {
+                        chunk[count] = _fastPath(x <= 127) ? table[Int(x)] : x
+                        count += 1
+                        if count == chunk.count {
+                            hasher.combine(bytes: UnsafeRawBufferPointer(chunk))
+                            count = 0
+                        }
+                    }
+                    hasher.combine(bytes: UnsafeRawBufferPointer(rebasing: chunk[0..<count]))
+                }
+            }
+            if string.utf8.withContiguousStorageIfAvailable({ combine($0) }) == nil {
+                combine(string.utf8)
+            }
             #else
-            let nativeView = string.utf16
-            #endif
-            for x in nativeView {
+            for x in string.utf16 {
                 if _fastPath(x <= 127) {
                     hasher.combine(table[Int(x)])
                 } else {
                     hasher.combine(x)
                 }
             }
+            #endif
         }
     }
     #else
@@ -119,6 +138,22 @@ func ==(lhs: CaseInsensitiveASCIIString, rhs: CaseInsensitiveASCIIString) -> Boo
     return CaseInsensitiveASCIIString.lowercaseTable.withUnsafeBufferPointer { table in
         #if swift(>=4.1.9) // Swift 4.2+ compiler, required for compiler()
         #if compiler(>=5)
+        // Fast path: compare the contiguous UTF-8 bytes directly.
+        let fastResult = lhs.string.utf8.withContiguousStorageIfAvailable { lhsBytes in
+            rhs.string.utf8.withContiguousStorageIfAvailable { rhsBytes -> Bool in
+                guard lhsBytes.count == rhsBytes.count else { return false }
+                for i in 0..<lhsBytes.count {
+                    let (a, b) = (lhsBytes[i], rhsBytes[i])
+                    if a != b && (a > 127 || b > 127 || table[Int(a)] != table[Int(b)]) {
+                        return false
+                    }
+                }
+                return true
+            }
+        }
+        if let result = fastResult ?? nil {
+            return result
+        }
         let (lhsView, rhsView) = (lhs.string.utf8, rhs.string.utf8)
         #else
         let (lhsView, rhsView) = (lhs.string.utf16, rhs.string.utf16)
@@ -487,6 +487,109 @@ final class AuthTests: PMHTTPTestCase {
         waitForExpectations(timeout: 5, handler: nil)
     }
     
+    func testProactiveRefresh() {
+        // A token that expires within the refresh interval is refreshed before any request fails
+        let refreshExpectation = expectation(description: "proactive refresh")
+        let auth = ExpiringTokenAuth(token: "oldToken", expirationDate: Date(timeIntervalSinceNow: 10), refreshToken: "refresh123", refreshed: { refreshExpectation.fulfill() })
+        expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+            XCTAssertEqual(request.headers["Authorization"], "Test oldToken", "request Authorization header")
+            completionHandler(HTTPServer.Response(status: .ok))
+        }
+        expectationForHTTPRequest(httpServer, path: "/token/refresh") { (request, completionHandler) in
+            XCTAssertEqual(request.urlComponents.query, "token=refresh123", "request query")
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "application/json"], body: "{\"token\": \"newToken\"}"))
+        }
+        expectationForRequestSuccess(HTTP.request(GET: "foo").with({ $0.auth = auth }))
+        waitForExpectations(timeout: 5, handler: nil)
+        
+        // The new token doesn't expire soon, so it's used without refreshing again
+        expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+            XCTAssertEqual(request.headers["Authorization"], "Test newToken", "request Authorization header")
+            completionHandler(HTTPServer.Response(status: .ok))
+        }
+        expectationForRequestSuccess(HTTP.request(GET: "foo").with({ $0.auth = auth }))
+        waitForExpectations(timeout: 5, handler: nil)
+        XCTAssertEqual(auth.refreshCount, 1, "refresh count")
+        
+        // A token outside the refresh interval isn't refreshed
+        let laterAuth = ExpiringTokenAuth(token: "oldToken", expirationDate: Date(timeIntervalSinceNow: 10), refreshToken: "refresh123")
+        laterAuth.proactiveRefreshInterval = 5
+        expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+            XCTAssertEqual(request.headers["Authorization"], "Test oldToken", "request Authorization header")
+            completionHandler(HTTPServer.Response(status: .ok))
+        }
+        expectationForRequestSuccess(HTTP.request(GET: "foo").with({ $0.auth = laterAuth }))
+        waitForExpectations(timeout: 5, handler: nil)
+        XCTAssertEqual(laterAuth.refreshCount, 0, "refresh count")
+        
+        // A failed proactive refresh isn't repeated, but a 401 still refreshes
+        var failingRefreshExpectation: XCTestExpectation? = expectation(description: "failed proactive refresh")
+        let failingAuth = ExpiringTokenAuth(token: "oldToken", expirationDate: Date(timeIntervalSinceNow: 10), refreshToken: "frunk", refreshed: {
+            DispatchQueue.main.async {
+                failingRefreshExpectation?.fulfill()
+                failingRefreshExpectation = nil
+            }
+        })
+        expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+            XCTAssertEqual(request.headers["Authorization"], "Test oldToken", "request Authorization header")
+            completionHandler(HTTPServer.Response(status: .ok))
+        }
+        expectationForHTTPRequest(httpServer, path: "/token/refresh") { (request, completionHandler) in
+            XCTAssertEqual(request.urlComponents.query, "token=frunk", "request query")
+            completionHandler(HTTPServer.Response(status: .badRequest))
+        }
+        expectationForRequestSuccess(HTTP.request(GET: "foo").with({ $0.auth = failingAuth }))
+        waitForExpectations(timeout: 5, handler: nil)
+        expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+            XCTAssertEqual(request.headers["Authorization"], "Test oldToken", "request Authorization header")
+            completionHandler(HTTPServer.Response(status: .unauthorized))
+        }
+        expectationForHTTPRequest(httpServer, path: "/token/refresh") { (request, completionHandler) in
+            XCTAssertEqual(request.urlComponents.query, "token=frunk", "request query")
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "application/json"], body: "{\"token\": \"newToken\"}"))
+        }
+        expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+            XCTAssertEqual(request.headers["Authorization"], "Test newToken", "request Authorization header")
+            completionHandler(HTTPServer.Response(status: .ok))
+        }
+        expectationForRequestSuccess(HTTP.request(GET: "foo").with({ $0.auth = failingAuth }))
+        waitForExpectations(timeout: 5, handler: nil)
+        XCTAssertEqual(failingAuth.refreshCount, 2, "refresh count")
+    }
+    
+    func testExpiredTokenWaitsForRefresh() {
+        // Requests created after the token expired wait for the refresh and use the new token
+        let auth = ExpiringTokenAuth(token: "oldToken", expirationDate: Date(timeIntervalSinceNow: -10), refreshToken: "refresh123")
+        expectationForHTTPRequest(httpServer, path: "/token/refresh") { (request, completionHandler) in
+            XCTAssertEqual(request.urlComponents.query, "token=refresh123", "request query")
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "application/json"], body: "{\"token\": \"newToken\"}"))
+        }
+        for _ in 0..<2 {
+            expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+                XCTAssertEqual(request.headers["Authorization"], "Test newToken", "request Authorization header")
+                completionHandler(HTTPServer.Response(status: .ok))
+            }
+            expectationForRequestSuccess(HTTP.request(GET: "foo").with({ $0.auth = auth }))
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+        XCTAssertEqual(auth.refreshCount, 1, "refresh count")
+        
+        // Uploads wait too
+        let uploadAuth = ExpiringTokenAuth(token: "oldToken", expirationDate: Date(timeIntervalSinceNow: -10), refreshToken: "refresh456")
+        expectationForHTTPRequest(httpServer, path: "/token/refresh") { (request, completionHandler) in
+            XCTAssertEqual(request.urlComponents.query, "token=refresh456", "request query")
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "application/json"], body: "{\"token\": \"newToken\"}"))
+        }
+        expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+            XCTAssertEqual(request.headers["Authorization"], "Test newToken", "request Authorization header")
+            XCTAssertEqual(request.body.flatMap({ String(data: $0, encoding: .utf8) }), "bar=baz", "request body")
+            completionHandler(HTTPServer.Response(status: .ok))
+        }
+        expectationForRequestSuccess(HTTP.request(POST: "foo", parameters: ["bar": "baz"]).with({ $0.auth = uploadAuth }))
+        waitForExpectations(timeout: 5, handler: nil)
+        XCTAssertEqual(uploadAuth.refreshCount, 1, "refresh count")
+    }
+    
     func testWithoutDefaultAuth() {
         let auth = TokenAuth(token: "oldToken", refreshToken: "refresh123")
         HTTP.defaultAuth = auth
@@ -535,6 +638,54 @@ final class AuthTests: PMHTTPTestCase {
         let refreshToken: String
     }
     
+    class ExpiringTokenAuth: HTTPRefreshableAuth {
+        /// - Parameter refreshed: A block that's invoked after each refresh has completed.
+        init(token: String, expirationDate: Date, refreshToken: String, refreshed: (() -> Void)? = nil) {
+            self.refreshToken = refreshToken
+            let counter = Counter()
+            refreshCounter = counter
+            super.init(info: (token: token, expirationDate: expirationDate), authenticationHeadersBlock: { (request, info) -> [String: String] in
+                return ["Authorization": "Test \(info.token)"]
+            }, expirationDateBlock: { (info) -> Date? in
+                return info.expirationDate
+            }) { (response, body, info, completion) -> HTTPManagerTask? in
+                counter.increment()
+                return HTTP.request(GET: "token/refresh", parameters: ["token": refreshToken])
+                    .with({ $0.userInitiated = true })
+                    .parseAsJSON(using: { try $1.getString("token") })
+                    .performRequest { (task, result) in
+                        completion(result.value.map({ (token: $0, expirationDate: Date(timeIntervalSinceNow: 3600)) }), result.isSuccess)
+                        refreshed?()
+                }
+            }
+        }
+        
+        let refreshToken: String
+        
+        var refreshCount: Int {
+            return refreshCounter.value
+        }
+        
+        private let refreshCounter: Counter
+        
+        private final class Counter {
+            private let lock = NSLock()
+            private var _value = 0
+            
+            var value: Int {
+                lock.lock()
+                defer { lock.unlock() }
+                return _value
+            }
+            
+            func increment() {
+                lock.lock()
+                _value += 1
+                lock.unlock()
+            }
+        }
+    }
+    
     func test403Forbidden() {
         class Auth: HTTPAuth {
             let expectation: XCTestExpectation
@@ -0,0 +1,187 @@
+//
+//  BodyCompressionTests.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import XCTest
+import Compression
+import PMJSON
+@testable import PMHTTP
+
+final class BodyCompressionTests: PMHTTPTestCase {
+    func testCompressData() {
+        let data = Data(String(repeating: "Hello world. ", count: 1000).utf8)
+        let gzip = HTTPManagerRequestBodyCompression.gzip.compress(data) ?? Data()
+        XCTAssertEqual(Array(gzip.prefix(2)), [0x1f, 0x8b], "gzip magic number")
+        XCTAssertEqual(BodyCompressionTests.gzipLength(of: gzip), data.count, "gzip ISIZE")
+        XCTAssertEqual(BodyCompressionTests.decompress(gzip, gzip: true, expectedLength: data.count), data, "decompressed gzip")
+        XCTAssertLessThan(gzip.count, data.count / 10, "gzip length")
+        let deflate = HTTPManagerRequestBodyCompression.deflate.compress(data) ?? Data()
+        XCTAssertEqual(deflate.first, 0x78, "zlib header")
+        XCTAssertEqual(BodyCompressionTests.decompress(deflate, gzip: false, expectedLength: data.count), data, "decompressed deflate")
+        XCTAssertLessThan(deflate.count, data.count / 10, "deflate length")
+        XCTAssertEqual(HTTPManagerRequestBodyCompression.none.compress(data), data, "uncompressed data")
+        XCTAssertEqual(HTTPManagerRequestBodyCompression.gzip.compress(Data()).map({ BodyCompressionTests.gzipLength(of: $0) }), 0, "empty gzip ISIZE")
+        
+        // Streams are read in pieces smaller than the body
+        let original = Data((0..<100_000).map({ UInt8(truncatingIfNeeded: $0 % 251) }))
+        for gzip in [true, false] {
+            let stream = (gzip ? HTTPManagerRequestBodyCompression.gzip : .deflate).compressingStream(InputStream(data: original))
+            stream.open()
+            var streamed = Data()
+            var buffer = [UInt8](repeating: 0, count: 16)
+            while case let count = stream.read(&buffer, maxLength: buffer.count), count > 0 {
+                streamed.append(contentsOf: buffer[0..<count])
+            }
+            XCTAssertEqual(stream.streamStatus, .atEnd, "stream status (gzip: \(gzip))")
+            stream.close()
+            XCTAssertEqual(BodyCompressionTests.decompress(streamed, gzip: gzip, expectedLength: original.count), original, "decompressed stream (gzip: \(gzip))")
+        }
+    }
+    
+    func testCompressingStreamError() {
+        // A source that fails must fail the compressed stream rather than ending it early, which
+        // would produce a valid but truncated body.
+        let url = URL(fileURLWithPath: NSTemporaryDirectory()).appendingPathComponent("BodyCompressionTests-\(UUID().uuidString)")
+        let stream = HTTPManagerRequestBodyCompression.gzip.compressingStream(InputStream(url: url)!)
+        stream.open()
+        var buffer = [UInt8](repeating: 0, count: 1024)
+        XCTAssertEqual(stream.read(&buffer, maxLength: buffer.count), -1, "read result")
+        XCTAssertEqual(stream.streamStatus, .error, "stream status")
+        XCTAssertNotNil(stream.streamError, "stream error")
+        XCTAssertEqual(stream.read(&buffer, maxLength: buffer.count), -1, "read result after error")
+        XCTAssertThrowsError(try stream.readAll(), "readAll")
+    }
+    
+    func testCompressedFormUpload() {
+        let value = String(repeating: "abc", count: 1000)
+        expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+            XCTAssertEqual(request.headers["Content-Encoding"], "gzip", "Content-Encoding")
+            XCTAssertEqual(request.headers["Content-Length"].flatMap({ Int($0) }), request.body?.count, "Content-Length")
+            let expected = Data("value=\(value)".utf8)
+            XCTAssertEqual(request.body.flatMap({ BodyCompressionTests.decompress($0, gzip: true, expectedLength: expected.count) }), expected, "decompressed body")
+            completionHandler(HTTPServer.Response(status: .ok))
+        }
+        expectationForRequestSuccess(HTTP.request(POST: "foo", parameters: ["value": value]).with({ $0.requestBodyCompression = .gzip }))
+        waitForExpectations(timeout: 5, handler: nil)
+        
+        // Large bodies are compressed in the background
+        let largeValue = String(repeating: "abc", count: 100_000)
+        expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+            XCTAssertEqual(request.headers["Content-Encoding"], "gzip", "Content-Encoding")
+            XCTAssertEqual(request.headers["Content-Length"].flatMap({ Int($0) }), request.body?.count, "Content-Length")
+            let expected = Data("value=\(largeValue)".utf8)
+            XCTAssertEqual(request.body.flatMap({ BodyCompressionTests.decompress($0, gzip: true, expectedLength: expected.count) }), expected, "decompressed body")
+            completionHandler(HTTPServer.Response(status: .ok))
+        }
+        expectationForRequestSuccess(HTTP.request(POST: "foo", parameters: ["value": largeValue]).with({ $0.requestBodyCompression = .gzip }))
+        waitForExpectations(timeout: 5, handler: nil)
+        
+        // Bodies below the threshold go out as-is
+        expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+            XCTAssertNil(request.headers["Content-Encoding"], "Content-Encoding")
+            XCTAssertEqual(request.body.flatMap({ String(data: $0, encoding: .utf8) }), "value=abc", "body")
+            completionHandler(HTTPServer.Response(status: .ok))
+        }
+        expectationForRequestSuccess(HTTP.request(POST: "foo", parameters: ["value": "abc"]).with({ $0.requestBodyCompression = .gzip }))
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testCompressedJSONUpload() {
+        let json: JSON = ["values": JSON(Array(repeating: JSON("hello"), count: 500))]
+        let encoded = JSON.encodeAsData(json)
+        for useContentLength in [false, true] {
+            expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+                XCTAssertEqual(request.headers["Content-Encoding"], "deflate", "Content-Encoding")
+                XCTAssertEqual(request.body?.first, 0x78, "zlib header")
+                XCTAssertLessThan(request.body?.count ?? .max, encoded.count, "compressed length")
+                XCTAssertEqual(request.body.flatMap({ BodyCompressionTests.decompress($0, gzip: false, expectedLength: encoded.count) }), encoded, "decompressed body")
+                if useContentLength {
+                    XCTAssertEqual(request.headers["Content-Length"].flatMap({ Int($0) }), request.body?.count, "Content-Length")
+                }
+                completionHandler(HTTPServer.Response(status: .ok))
+            }
+            let req = HTTP.request(POST: "foo", json: json)!
+            req.serverRequiresContentLength = useContentLength
+            req.requestBodyCompression = .deflate
+            expectationForRequestSuccess(req)
+            waitForExpectations(timeout: 5, handler: nil)
+        }
+    }
+    
+    func testCompressedMultipartUpload() {
+        let text = String(repeating: "Hello world. ", count: 500)
+        for useContentLength in [false, true] {
+            var bodyLength: Int?
+            expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+                XCTAssertEqual(request.headers["Content-Encoding"], "gzip", "Content-Encoding")
+                XCTAssertEqual(request.body.map({ Array($0.prefix(2)) }) ?? [], [0x1f, 0x8b], "gzip magic number")
+                bodyLength = request.body.map(BodyCompressionTests.gzipLength(of:))
+                let body = request.body.flatMap({ BodyCompressionTests.decompress($0, gzip: true, expectedLength: bodyLength ?? 0) })
+                    .flatMap({ String(data: $0, encoding: .utf8) })
+                XCTAssertTrue(body?.contains("Content-Disposition: form-data; name=\"message\"\r\nContent-Type: text/plain; charset=utf-8\r\n\r\n\(text)\r\n") ?? false, "decompressed body")
+                if useContentLength {
+                    XCTAssertEqual(request.headers["Content-Length"].flatMap({ Int($0) }), request.body?.count, "Content-Length")
+                }
+                completionHandler(HTTPServer.Response(status: .ok))
+            }
+            let req = HTTP.request(POST: "foo")!
+            req.serverRequiresContentLength = useContentLength
+            req.requestBodyCompression = .gzip
+            req.addMultipart(text: text, withName: "message")
+            expectationForRequestSuccess(req)
+            waitForExpectations(timeout: 5, handler: nil)
+            XCTAssertGreaterThan(bodyLength ?? 0, text.utf8.count, "uncompressed length")
+        }
+    }
+    
+    func testExistingContentEncoding() {
+        expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+            XCTAssertEqual(request.headers["Content-Encoding"], "identity", "Content-Encoding")
+            XCTAssertEqual(request.body?.count, 2000, "body length")
+            completionHandler(HTTPServer.Response(status: .ok))
+        }
+        let req = HTTP.request(POST: "foo", data: Data(repeating: 0x41, count: 2000))!
+        req.headerFields["Content-Encoding"] = "identity"
+        req.requestBodyCompression = .gzip
+        expectationForRequestSuccess(req)
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    /// Decompresses a gzip or zlib stream with the given length, or returns `nil` if it isn't valid
+    /// or doesn't decompress to that length.
+    private static func decompress(_ data: Data, gzip: Bool, expectedLength: Int) -> Data? {
+        guard #available(iOS 9, macOS 10.11, tvOS 9, watchOS 2, *) else { return nil }
+        // The Compression framework only reads raw deflate data, so strip the gzip or zlib framing.
+        // zlib never writes the optional gzip header fields.
+        let headerLength = gzip ? 10 : 2, trailerLength = gzip ? 8 : 4
+        guard data.count >= headerLength + trailerLength else { return nil }
+        let deflated = data.subdata(in: (data.startIndex + headerLength)..<(data.endIndex - trailerLength))
+        // Leave room for an extra byte so that output that's too long is detected.
+        let capacity = expectedLength + 1
+        var result = Data(count: capacity)
+        let count = result.withUnsafeMutableBytes { (output: UnsafeMutablePointer<UInt8>) in
+            deflated.withUnsafeBytes { (input: UnsafePointer<UInt8>) in
+                compression_decode_buffer(output, capacity, input, deflated.count, nil, COMPRESSION_ZLIB)
+            }
+        }
+        guard count == expectedLength else { return nil }
+        result.count = count
+        return result
+    }
+    
+    /// Returns the uncompressed length recorded in the trailer of a gzip stream.
+    private static func gzipLength(of data: Data) -> Int {
+        guard data.count >= 4 else { return -1 }
+        return data.suffix(4).reversed().reduce(0, { $0 << 8 | Int($1) })
+    }
+}
@@ -0,0 +1,124 @@
+//
+//  ConcurrencyTests.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import XCTest
+import PMJSON
+@testable import PMHTTP
+
+#if swift(>=4.1.9) // Swift 4.2+ compiler, required for compiler()
+#if compiler(>=5.5)
+
+@available(iOS 13, macOS 10.15, tvOS 13, watchOS 6, *)
+final class ConcurrencyTests: PMHTTPTestCase {
+    // NB: These tests register request callbacks directly instead of using
+    // expectationForHTTPRequest(_:path:handler:), as waiting on expectations isn't available from
+    // async tests on every supported toolchain. The callbacks are cleared in tearDown.
+    
+    func testPerformRequest() async throws {
+        _ = httpServer.registerRequestCallback(for: "/foo", callback: { (request, completionHandler) in
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "application/json"], body: "[1,2,3]"))
+        })
+        let value = try await HTTP.request(GET: "foo")!.parseAsJSON().performRequest()
+        XCTAssertEqual(value, [1,2,3])
+        
+        _ = httpServer.registerRequestCallback(for: "/bar", callback: { (request, completionHandler) in
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "text/plain"], body: "hello"))
+        })
+        let (response, data) = try await HTTP.request(GET: "bar").performRequestWithResponse()
+        XCTAssertEqual((response as? HTTPURLResponse)?.statusCode, 200, "status code")
+        XCTAssertEqual(String(data: data, encoding: .utf8), "hello", "body")
+    }
+    
+    func testPerformRequestFailure() async {
+        _ = httpServer.registerRequestCallback(for: "/foo", callback: { (request, completionHandler) in
+            completionHandler(HTTPServer.Response(status: .notFound))
+        })
+        do {
+            _ = try await HTTP.request(GET: "foo").performRequest()
+            XCTFail("expected HTTPManagerError.failedResponse")
+        } catch HTTPManagerError.failedResponse(let statusCode, _, _, _) {
+            XCTAssertEqual(statusCode, 404, "status code")
+        } catch {
+            XCTFail("expected HTTPManagerError.failedResponse, found \(error)")
+        }
+    }
+    
+    func testTaskCancellation() async {
+        let requestSema = DispatchSemaphore(value: 0)
+        let resultSema = DispatchSemaphore(value: 0)
+        _ = httpServer.registerRequestCallback(for: "/foo", callback: { (request, completionHandler) in
+            requestSema.signal()
+            XCTAssert(resultSema.wait(timeout: DispatchTime.now() + 2) == .success, "timeout on dispatch semaphore")
+            completionHandler(HTTPServer.Response(status: .ok))
+        })
+        let task = Task {
+            try await HTTP.request(GET: "foo").performRequest()
+        }
+        await withCheckedContinuation { (continuation: CheckedContinuation<Void, Never>) in
+            DispatchQueue.global().async {
+                XCTAssert(requestSema.wait(timeout: DispatchTime.now() + 2) == .success, "timeout on dispatch semaphore")
+                continuation.resume()
+            }
+        }
+        task.cancel()
+        do {
+            _ = try await task.value
+            XCTFail("expected CancellationError")
+        } catch is CancellationError {
+        } catch {
+            XCTFail("expected CancellationError, found \(error)")
+        }
+        resultSema.signal()
+        
+        // A task that's already canceled never starts the request
+        let canceledTask = Task { () -> Data in
+            withUnsafeCurrentTask { $0?.cancel() }
+            return try await HTTP.request(GET: "foo").performRequest()
+        }
+        do {
+            _ = try await canceledTask.value
+            XCTFail("expected CancellationError")
+        } catch is CancellationError {
+        } catch {
+            XCTFail("expected CancellationError, found \(error)")
+        }
+    }
+    
+    func testPerformRequests() async throws {
+        for i in 0..<3 {
+            _ = httpServer.registerRequestCallback(for: "/item/\(i)", callback: { (request, completionHandler) in
+                completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "application/json"], body: "{\"id\": \(i)}"))
+            })
+        }
+        let requests = (0..<3).map({ HTTP.request(GET: "item/\($0)")!.parseAsJSON(using: { try $1.getInt("id") }) })
+        let values = try await requests.performRequests()
+        XCTAssertEqual(values, [0, 1, 2], "values")
+        
+        // One failure fails the batch
+        _ = httpServer.registerRequestCallback(for: "/fail", callback: { (request, completionHandler) in
+            completionHandler(HTTPServer.Response(status: .internalServerError))
+        })
+        do {
+            _ = try await [requests[0], HTTP.request(GET: "fail")!.parseAsJSON(using: { try $1.getInt("id") })].performRequests()
+            XCTFail("expected HTTPManagerError.failedResponse")
+        } catch HTTPManagerError.failedResponse(let statusCode, _, _, _) {
+            XCTAssertEqual(statusCode, 500, "status code")
+        } catch {
+            XCTFail("expected HTTPManagerError.failedResponse, found \(error)")
+        }
+    }
+}
+
+#endif
+#endif
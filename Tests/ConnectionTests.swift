@@ -0,0 +1,91 @@
+//
+//  ConnectionTests.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import XCTest
+import PMHTTP
+
+final class ConnectionTests: PMHTTPTestCase {
+    override func tearDown() {
+        if #available(iOS 10, macOS 10.12, tvOS 10, watchOS 3, *) {
+            HTTP.metricsCallback = nil
+        }
+        HTTP.defaultAssumesHTTP3Capable = false
+        super.tearDown()
+    }
+    
+    func testPrewarmConnection() {
+        HTTP.environment = HTTPManagerEnvironment(string: "http://\(httpServer.address)/api/v1")!
+        expectationForHTTPRequest(httpServer, path: "/") { (request, completionHandler) in
+            XCTAssertEqual(request.method, .HEAD, "request method")
+            XCTAssertNil(request.headers["Authorization"], "Authorization header")
+            completionHandler(HTTPServer.Response(status: .notFound))
+        }
+        let prewarmExpectation = expectation(description: "prewarm")
+        HTTP.prewarmConnection(completion: { error in
+            XCTAssertNil(error, "prewarm error")
+            prewarmExpectation.fulfill()
+        })
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testPrewarmWithoutEnvironment() {
+        HTTP.environment = nil
+        let prewarmExpectation = expectation(description: "prewarm")
+        HTTP.prewarmConnection(completion: { error in
+            XCTAssertEqual((error as? URLError)?.code, .badURL, "prewarm error")
+            prewarmExpectation.fulfill()
+        })
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testConnectionInfo() {
+        if #available(iOS 10, macOS 10.12, tvOS 10, watchOS 3, *) {
+            let metricsExpectation = expectation(description: "task metrics")
+            HTTP.metricsCallback = .init(queue: nil, handler: { (task, networkTask, metrics) in
+                XCTAssertEqual(task.connectionInfo?.networkProtocolName, "http/1.1", "network protocol name")
+                XCTAssertEqual(task.connectionInfo?.isReusedConnection, true, "reused connection")
+                XCTAssertEqual(task.connectionInfo?.isMultiplexed, false, "multiplexed")
+                metricsExpectation.fulfill()
+            })
+            expectationForHTTPRequest(httpServer, path: "/") { (request, completionHandler) in
+                completionHandler(HTTPServer.Response(status: .ok))
+            }
+            let prewarmExpectation = expectation(description: "prewarm")
+            HTTP.prewarmConnection(completion: { _ in prewarmExpectation.fulfill() })
+            wait(for: [prewarmExpectation], timeout: 5)
+            
+            // The request goes over the prewarmed connection.
+            expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+                completionHandler(HTTPServer.Response(status: .ok, text: "Hello world"))
+            }
+            expectationForRequestSuccess(HTTP.request(GET: "foo"))
+            waitForExpectations(timeout: 5, handler: nil)
+        }
+    }
+    
+    func testAssumesHTTP3CapableEnvironmentDefaults() {
+        HTTP.defaultAssumesHTTP3Capable = true
+        XCTAssertTrue(HTTP.request(GET: "foo").assumesHTTP3Capable, "request in environment")
+        XCTAssertFalse(HTTP.request(GET: "http://apple.com/foo").assumesHTTP3Capable, "request outside environment")
+        XCTAssertTrue(HTTP.request(GET: "http://apple.com/foo").with({ $0.setDefaultEnvironmentalProperties() }).assumesHTTP3Capable, "request with environmental properties")
+        XCTAssertTrue(HTTP.request(GET: "foo").parseAsJSON().assumesHTTP3Capable, "parse request")
+        #if swift(>=4.1.9) // Swift 4.2+ compiler, required for compiler()
+        #if compiler(>=5.4) // URLRequest.assumesHTTP3Capable needs the iOS 14.5 SDK
+        if #available(iOS 14.5, macOS 11.3, tvOS 14.5, watchOS 7.4, *) {
+            XCTAssertTrue(HTTP.request(GET: "foo").preparedURLRequest.assumesHTTP3Capable, "prepared URL request")
+        }
+        #endif
+        #endif
+    }
+}
@@ -0,0 +1,47 @@
+//
+//  DateFormatters.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import Foundation
+
+/// The `DateFormatter`s that `HTTPManager.parsedDateHeader(from:)` used to try in sequence.
+///
+/// Shared by `DateParsingTests` and the PMHTTPBenchmarks target.
+struct DateFormatters {
+    let rfc1123: DateFormatter
+    let rfc850: DateFormatter
+    let asctime: DateFormatter
+    
+    init() {
+        var calendar = Calendar(identifier: .gregorian)
+        calendar.timeZone = TimeZone(secondsFromGMT: 0)!
+        func makeFormatter(_ format: String) -> DateFormatter {
+            let formatter = DateFormatter()
+            formatter.locale = Locale(identifier: "en_US_POSIX")
+            formatter.calendar = calendar
+            formatter.timeZone = calendar.timeZone
+            formatter.dateFormat = format
+            formatter.isLenient = false
+            return formatter
+        }
+        rfc1123 = makeFormatter("EEE',' dd MMM yyyy HH':'mm':'ss 'GMT'")
+        let rfc850 = makeFormatter("EEEE',' dd'-'MMM'-'yy HH':'mm':'ss 'GMT'")
+        rfc850.twoDigitStartDate = calendar.date(byAdding: DateComponents(year: -49), to: Date())
+        self.rfc850 = rfc850
+        asctime = makeFormatter("EEE MMM dd HH':'mm':'ss yyyy")
+    }
+    
+    func parse(_ string: String) -> Date? {
+        return rfc1123.date(from: string) ?? rfc850.date(from: string) ?? asctime.date(from: string)
+    }
+}
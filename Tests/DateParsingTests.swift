@@ -48,5 +48,32 @@ class DateParsingTests: XCTestCase {
         XCTAssertNil(HTTPManager.parsedDateHeader(from: "bob's yer uncle"))
         XCTAssertNil(HTTPManager.parsedDateHeader(from: "2016-01-02 03:04:05"))
         XCTAssertNil(HTTPManager.parsedDateHeader(from: "1457035967"))
+        XCTAssertNil(HTTPManager.parsedDateHeader(from: "Tue, 30 Feb 2016 15:00:00 GMT"), "invalid day")
+        XCTAssertNil(HTTPManager.parsedDateHeader(from: "Sun, 29 Feb 2015 15:00:00 GMT"), "not a leap year")
+        XCTAssertNil(HTTPManager.parsedDateHeader(from: "Mon, 29 Feb 2016 24:00:00 GMT"), "invalid hour")
+        XCTAssertNil(HTTPManager.parsedDateHeader(from: "Mon, 29 Foo 2016 15:00:00 GMT"), "invalid month")
+        XCTAssertNil(HTTPManager.parsedDateHeader(from: "Mon, 29 Feb 2016 15:00:00 PST"), "invalid time zone")
+        XCTAssertNil(HTTPManager.parsedDateHeader(from: "Mon, 29 Feb 2016 15:00:00 GMT "), "trailing space")
+        XCTAssertNil(HTTPManager.parsedDateHeader(from: "Mon, 29-Feb-2016 15:00:00 GMT"), "4-digit RFC 850 year")
+        XCTAssertNil(HTTPManager.parsedDateHeader(from: "Mon, 29 Feb 2016 15:00:00 GMT and then some more text"), "too long")
+        XCTAssertNil(HTTPManager.parsedDateHeader(from: "Caturday, 29-Feb-16 15:00:00 GMT"), "invalid weekday")
+    }
+    
+    func testMatchesDateFormatters() {
+        // Compare against the DateFormatter chain the parser replaced, over a range of dates that
+        // covers every day of the month, leap days, and both centuries of RFC 850 two-digit years
+        // (which are interpreted relative to the current date).
+        let formatters = DateFormatters()
+        let thisYear = calendar.component(.year, from: Date())
+        var date = calendar.date(from: DateComponents(era: 1, year: thisYear - 45, month: 1, day: 1, hour: 0, minute: 0, second: 0, nanosecond: 0))!
+        let end = calendar.date(byAdding: DateComponents(year: 90), to: date)!
+        while date < end {
+            for formatter in [formatters.rfc1123, formatters.rfc850, formatters.asctime] {
+                let string = formatter.string(from: date)
+                XCTAssertEqual(HTTPManager.parsedDateHeader(from: string), date, string)
+                XCTAssertEqual(HTTPManager.parsedDateHeader(from: string), formatters.parse(string), string)
+            }
+            date += 86400 * 3 + 3671 // step through the days of the week and times of day
+        }
     }
 }
@@ -0,0 +1,43 @@
+//
+//  FormURLEncodedTests.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import XCTest
+@testable import PMHTTP
+
+final class FormURLEncodedTests: XCTestCase {
+    func testEncoding() {
+        XCTAssertEqual(FormURLEncoded.string(for: []), "")
+        XCTAssertEqual(FormURLEncoded.data(for: []), Data())
+        let queryItems = [URLQueryItem(name: "foo", value: "bar"), URLQueryItem(name: "flag", value: nil),
+                          URLQueryItem(name: "", value: ""), URLQueryItem(name: " +&=", value: "*-._~"),
+                          URLQueryItem(name: "caf\u{E9}", value: "\u{1F600}")]
+        let expected = "foo=bar&flag&=&%20%2B%26%3D=*-._%7E&caf%C3%A9=%F0%9F%98%80"
+        XCTAssertEqual(FormURLEncoded.string(for: queryItems), expected)
+        XCTAssertEqual(FormURLEncoded.data(for: queryItems), expected.data(using: .utf8))
+    }
+    
+    func testMatchesFoundationEncoding() {
+        var allowed = CharacterSet(charactersIn: "*-._")
+        allowed.insert(charactersIn: "0"..."9")
+        allowed.insert(charactersIn: "A"..."Z")
+        allowed.insert(charactersIn: "a"..."z")
+        // Every ASCII character, plus a selection of multi-byte characters.
+        let strings = (0..<128).map({ String(UnicodeScalar(UInt8($0))) }) + ["\u{80}", "\u{7FF}", "\u{800}", "\u{FFFD}", "\u{10000}", "\u{10FFFF}"]
+        for string in strings {
+            let item = URLQueryItem(name: string, value: string)
+            let encoded = string.addingPercentEncoding(withAllowedCharacters: allowed)!
+            XCTAssertEqual(FormURLEncoded.string(for: [item]), "\(encoded)=\(encoded)", String(reflecting: string))
+        }
+    }
+}
@@ -0,0 +1,63 @@
+//
+//  HTTPHeadersTests.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import XCTest
+@testable import PMHTTP
+
+final class HTTPHeadersTests: XCTestCase {
+    typealias HTTPHeaders = HTTPManagerRequest.HTTPHeaders
+    
+    func testNormalization() {
+        XCTAssertEqual(HTTPHeaders.normalizedHTTPHeaderField("content-type"), "Content-Type")
+        XCTAssertEqual(HTTPHeaders.normalizedHTTPHeaderField("CONTENT-TYPE"), "Content-Type")
+        XCTAssertEqual(HTTPHeaders.normalizedHTTPHeaderField("Content-Type"), "Content-Type")
+        XCTAssertEqual(HTTPHeaders.normalizedHTTPHeaderField("www-authenticate"), "WWW-Authenticate")
+        XCTAssertEqual(HTTPHeaders.normalizedHTTPHeaderField("Etag"), "ETag")
+        XCTAssertEqual(HTTPHeaders.normalizedHTTPHeaderField("content-md5"), "Content-MD5")
+        XCTAssertEqual(HTTPHeaders.normalizedHTTPHeaderField("te"), "TE")
+        XCTAssertEqual(HTTPHeaders.normalizedHTTPHeaderField("x-dni-foo"), "X-DNI-Foo")
+        XCTAssertEqual(HTTPHeaders.normalizedHTTPHeaderField("x-foo bar"), HTTPHeaders.normalizedHTTPHeaderField("X-Foo_bar"))
+        XCTAssertEqual(HTTPHeaders.normalizedHTTPHeaderField("x--foo"), "X--Foo")
+        XCTAssertEqual(HTTPHeaders.normalizedHTTPHeaderField("x-caf\u{E9}"), "X-Caf_")
+    }
+    
+    func testNormalizationMatchesSlowPath() {
+        let fields = ["Accept", "accept", "ACCEPT-ENCODING", "Content-MD5", "Content-Md5", "WWW-Authenticate",
+                      "Www-Authenticate", "ETag", "ETAG", "TE", "Te", "X-DNI", "X-Dni", "X-Foo", "x-foo", "XFoo",
+                      "X-1st", "X-Foo_Bar", "-", "--", "-Foo-", "A-B-C", "Wwww", "Tee", "X-Caf\u{E9}",
+                      "X-\u{1F600}", "\u{0130}f-Match", "If-\u{212A}eep"]
+        for field in fields {
+            XCTAssertEqual(HTTPHeaders.normalizedHTTPHeaderField(field), HTTPHeaders.slowNormalizedHTTPHeaderField(field), field)
+            if HTTPHeaders.isNormalizedHTTPHeaderField(field) {
+                XCTAssertEqual(HTTPHeaders.slowNormalizedHTTPHeaderField(field), field, "\(field) is normalized")
+            }
+        }
+    }
+    
+    func testCaseInsensitiveASCIIString() {
+        XCTAssertEqual(CaseInsensitiveASCIIString("Content-Type"), CaseInsensitiveASCIIString("content-TYPE"))
+        XCTAssertNotEqual(CaseInsensitiveASCIIString("Content-Type"), CaseInsensitiveASCIIString("Content-Typ"))
+        XCTAssertNotEqual(CaseInsensitiveASCIIString("Content-Type"), CaseInsensitiveASCIIString("Content-Tape"))
+        XCTAssertEqual(CaseInsensitiveASCIIString("caf\u{E9}"), CaseInsensitiveASCIIString("CAF\u{E9}"))
+        XCTAssertNotEqual(CaseInsensitiveASCIIString("caf\u{E9}"), CaseInsensitiveASCIIString("CAF\u{C9}"))
+        // A long string hashes across several chunks.
+        let long = String(repeating: "Abc-", count: 40)
+        XCTAssertEqual(CaseInsensitiveASCIIString(long), CaseInsensitiveASCIIString(long.lowercased()))
+        XCTAssertEqual(CaseInsensitiveASCIIString(long).hashValue, CaseInsensitiveASCIIString(long.uppercased()).hashValue)
+        // Bridged strings may not have contiguous UTF-8 storage, but must still hash the same.
+        let bridged = NSString(string: long.uppercased()) as String
+        XCTAssertEqual(CaseInsensitiveASCIIString(long), CaseInsensitiveASCIIString(bridged))
+        XCTAssertEqual(CaseInsensitiveASCIIString(long).hashValue, CaseInsensitiveASCIIString(bridged).hashValue)
+    }
+}
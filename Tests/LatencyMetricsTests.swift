@@ -0,0 +1,109 @@
+//
+//  LatencyMetricsTests.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import XCTest
+@testable import PMHTTP
+
+final class LatencyMetricsTests: PMHTTPTestCase {
+    override func tearDown() {
+        HTTP.latencyRecorder = nil
+        super.tearDown()
+    }
+    
+    func testTaskLatency() {
+        let recorder = HTTPManagerLatencyRecorder()
+        HTTP.latencyRecorder = recorder
+        expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+            DispatchQueue.global().asyncAfter(deadline: .now() + 0.05) {
+                completionHandler(HTTPServer.Response(status: .ok, text: "success"))
+            }
+        }
+        let task = expectationForRequestSuccess(HTTP.request(GET: "foo")) { (task, response, value) in
+            guard let latency = task.latency else {
+                return XCTFail("expected task latency")
+            }
+            XCTAssertEqual(latency.attempts, 1, "attempts")
+            XCTAssertGreaterThanOrEqual(latency.duration(of: .network), 0.04, "network duration")
+            XCTAssertEqual(latency.duration(of: .retry), 0, "retry duration")
+            let phases: [HTTPManagerLatencyPhase] = [.queue, .network, .dispatch, .processing, .retry, .completion]
+            let sum = phases.reduce(0, { $0 + latency.duration(of: $1) })
+            XCTAssertGreaterThanOrEqual(latency.duration(of: .total) + 0.000_001, sum, "total duration")
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+        XCTAssertNotNil(task.latency, "task latency")
+        let snapshot = recorder.snapshot()
+        XCTAssertEqual(snapshot.count, 1, "endpoint count")
+        if let endpoint = snapshot.first {
+            XCTAssert(endpoint.endpoint.hasPrefix("GET "), "endpoint \(endpoint.endpoint) has method prefix")
+            XCTAssert(endpoint.endpoint.hasSuffix("/foo"), "endpoint \(endpoint.endpoint) has path suffix")
+            XCTAssertEqual(endpoint.count, 1, "endpoint task count")
+            XCTAssertGreaterThanOrEqual(endpoint.histogram(for: .network).minimum, 0.04, "network minimum")
+        }
+    }
+    
+    func testRetryLatency() {
+        let recorder = HTTPManagerLatencyRecorder()
+        HTTP.latencyRecorder = recorder
+        expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Length": "64", "Connection": "close"]))
+        }
+        expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+            completionHandler(HTTPServer.Response(status: .ok, text: "success"))
+        }
+        let req = HTTP.request(GET: "foo")!
+        req.retryBehavior = .retryNetworkFailure(withStrategy: .retryOnce)
+        expectationForRequestSuccess(req) { (task, response, value) in
+            XCTAssertEqual(task.latency?.attempts, 2, "attempts")
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+        XCTAssertEqual(recorder.snapshot().first?.count, 1, "endpoint task count")
+    }
+    
+    func testCanceledTaskIsNotRecorded() {
+        let recorder = HTTPManagerLatencyRecorder()
+        HTTP.latencyRecorder = recorder
+        let task = expectationForRequestCanceled(HTTP.request(GET: "foo"), startAutomatically: false)
+        task.cancel()
+        waitForExpectations(timeout: 5, handler: nil)
+        XCTAssertEqual(recorder.snapshot().count, 0, "endpoint count")
+    }
+    
+    func testHistogram() {
+        let recorder = HTTPManagerLatencyRecorder(maximumEndpointCount: 2)
+        for ms in 1...100 {
+            let nanoseconds = HTTPManagerLatencyPhase.allPhases.map({ _ in UInt64(ms) * 1_000_000 })
+            recorder.record(HTTPManagerTaskLatency(attempts: 1, nanoseconds: nanoseconds), endpoint: "GET /foo")
+        }
+        recorder.record(HTTPManagerTaskLatency(attempts: 1, nanoseconds: HTTPManagerLatencyPhase.allPhases.map({ _ in 1_000_000 })), endpoint: "GET /bar")
+        recorder.record(HTTPManagerTaskLatency(attempts: 1, nanoseconds: HTTPManagerLatencyPhase.allPhases.map({ _ in 1_000_000 })), endpoint: "GET /baz")
+        recorder.record(HTTPManagerTaskLatency(attempts: 1, nanoseconds: HTTPManagerLatencyPhase.allPhases.map({ _ in 1_000_000 })), endpoint: "GET /qux")
+        
+        let snapshot = recorder.snapshot()
+        XCTAssertEqual(snapshot.map({ $0.endpoint }), [HTTPManagerLatencyRecorder.otherEndpoint, "GET /bar", "GET /foo"], "endpoints")
+        XCTAssertEqual(snapshot.map({ $0.count }), [2, 1, 100], "endpoint task counts")
+        guard let foo = snapshot.last else { return }
+        let histogram = foo.histogram(for: .total)
+        XCTAssertEqual(histogram.count, 100, "count")
+        XCTAssertEqual(histogram.minimum, 0.001, accuracy: 0.000_001, "minimum")
+        XCTAssertEqual(histogram.maximum, 0.1, accuracy: 0.000_001, "maximum")
+        XCTAssertEqual(histogram.mean, 0.0505, accuracy: 0.000_001, "mean")
+        XCTAssertEqual(histogram.p50, 0.05, accuracy: 0.05 * 0.125, "p50")
+        XCTAssertEqual(histogram.p95, 0.095, accuracy: 0.095 * 0.125, "p95")
+        XCTAssertEqual(histogram.p99, 0.099, accuracy: 0.099 * 0.125, "p99")
+        XCTAssertEqual(histogram.percentile(100), 0.1, accuracy: 0.000_001, "p100")
+        
+        recorder.reset()
+        XCTAssertEqual(recorder.snapshot().count, 0, "endpoint count after reset")
+    }
+}
@@ -0,0 +1,189 @@
+//
+//  MockRecordingTests.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import XCTest
+@testable import PMHTTP
+
+final class MockRecordingTests: PMHTTPTestCase {
+    private var archiveURL: URL!
+    
+    override func setUp() {
+        super.setUp()
+        archiveURL = URL(fileURLWithPath: NSTemporaryDirectory()).appendingPathComponent("MockRecordingTests-\(UUID().uuidString).pmhttpmock")
+    }
+    
+    override func tearDown() {
+        try? FileManager.default.removeItem(at: archiveURL)
+        super.tearDown()
+    }
+    
+    func testRecordAndReplay() throws {
+        let recorder = try HTTPMockRecorder(fileURL: archiveURL)
+        HTTP.mockManager.recorder = recorder
+        expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "text/plain", "X-Custom": "value"], body: "Hello world"))
+        }
+        expectationForRequestSuccess(HTTP.request(GET: "foo", parameters: ["id": 1]))
+        waitForExpectations(timeout: 5, handler: nil)
+        HTTP.mockManager.recorder = nil
+        recorder.flush()
+        XCTAssertEqual(recorder.recordedCount, 1, "recorded count")
+        
+        let archive = try HTTPMockArchive(contentsOf: archiveURL)
+        XCTAssertEqual(archive.count, 1, "archive count")
+        if archive.count == 1 {
+            let entry = archive.entry(at: 0)
+            XCTAssertEqual(entry.httpMethod, "GET", "method")
+            XCTAssertEqual(entry.urlString, "http://\(httpServer.address)/foo?id=1", "URL")
+            XCTAssertEqual(entry.statusCode, 200, "status code")
+            XCTAssertEqual(entry.headerFields["X-Custom"], "value", "X-Custom header")
+            XCTAssertNil(entry.headerFields["Content-Length"], "Content-Length header")
+            XCTAssertEqual(String(data: entry.body, encoding: .utf8), "Hello world", "body")
+            XCTAssertGreaterThan(entry.duration, 0, "duration")
+        }
+        
+        // The replay handles the request without hitting the server.
+        HTTP.mockManager.addReplay(of: archive, timing: .immediate)
+        expectationForRequestSuccess(HTTP.request(GET: "foo", parameters: ["id": 1])) { (task, response, value) in
+            XCTAssertEqual((response as? HTTPURLResponse)?.statusCode, 200, "status code")
+            XCTAssertEqual((response as? HTTPURLResponse)?.allHeaderFields["X-Custom"] as? String, "value", "X-Custom header")
+            XCTAssertEqual(String(data: value, encoding: .utf8), "Hello world", "body")
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testCoalescedRequestsRecordOnce() throws {
+        let recorder = try HTTPMockRecorder(fileURL: archiveURL)
+        HTTP.mockManager.recorder = recorder
+        HTTP.coalescesIdenticalRequests = true
+        defer { HTTP.coalescesIdenticalRequests = false }
+        let resultSema = DispatchSemaphore(value: 0)
+        expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+            XCTAssert(resultSema.wait(timeout: DispatchTime.now() + 2) == .success, "timeout on dispatch semaphore")
+            completionHandler(HTTPServer.Response(status: .ok, text: "Hello world"))
+        }
+        let task = expectationForRequestSuccess(HTTP.request(GET: "foo"))
+        let task2 = expectationForRequestSuccess(HTTP.request(GET: "foo"))
+        XCTAssert(task.networkTask === task2.networkTask, "identical requests should share a network task")
+        resultSema.signal()
+        waitForExpectations(timeout: 5, handler: nil)
+        HTTP.mockManager.recorder = nil
+        recorder.flush()
+        XCTAssertEqual(recorder.recordedCount, 1, "recorded count")
+    }
+    
+    func testRecorderAppends() throws {
+        let recorder = try HTTPMockRecorder(fileURL: archiveURL)
+        recorder.record(URLRequest(url: URL(string: "http://example.com/a")!), response: response(url: "http://example.com/a"), body: Data("a".utf8), startTime: 0, endTime: 0)
+        recorder.flush()
+        let recorder2 = try HTTPMockRecorder(fileURL: archiveURL)
+        recorder2.record(URLRequest(url: URL(string: "http://example.com/b")!), response: response(url: "http://example.com/b"), body: Data("b".utf8), startTime: 0, endTime: 0)
+        recorder2.flush()
+        let archive = try HTTPMockArchive(contentsOf: archiveURL)
+        XCTAssertEqual((0..<archive.count).map({ archive.entry(at: $0).urlString }), ["http://example.com/a", "http://example.com/b"], "archive URLs")
+        
+        try Data("not an archive".utf8).write(to: archiveURL)
+        XCTAssertThrowsError(try HTTPMockRecorder(fileURL: archiveURL), "recorder for invalid file") { error in
+            XCTAssertEqual(error as? HTTPMockArchiveError, .invalidHeader, "error")
+        }
+    }
+    
+    func testRecorderDiscardsPartialRecord() throws {
+        var data = HTTPMockArchive.header
+        appendRecord(to: &data, url: "http://example.com/a", body: "a")
+        appendRecord(to: &data, url: "http://example.com/partial", body: "partial")
+        // Simulate a session that was killed while writing its last record.
+        try data.prefix(data.count - 3).write(to: archiveURL)
+        let recorder = try HTTPMockRecorder(fileURL: archiveURL)
+        recorder.record(URLRequest(url: URL(string: "http://example.com/b")!), response: response(url: "http://example.com/b"), body: Data("b".utf8), startTime: 0, endTime: 0)
+        recorder.flush()
+        let archive = try HTTPMockArchive(contentsOf: archiveURL)
+        XCTAssertEqual((0..<archive.count).map({ archive.entry(at: $0).urlString }), ["http://example.com/a", "http://example.com/b"], "archive URLs")
+        if archive.count == 2 {
+            XCTAssertEqual(String(data: archive.entry(at: 1).body, encoding: .utf8), "b", "appended body")
+        }
+    }
+    
+    func testArchiveTruncation() throws {
+        var data = HTTPMockArchive.header
+        appendRecord(to: &data, url: "http://example.com/foo", body: "one")
+        appendRecord(to: &data, url: "http://example.com/foo", body: "two")
+        let archive = try HTTPMockArchive(data: data.prefix(data.count - 1))
+        XCTAssertEqual(archive.count, 1, "archive count")
+        XCTAssertEqual(try HTTPMockArchive(data: data).count, 2, "archive count")
+        
+        XCTAssertThrowsError(try HTTPMockArchive(data: Data("PMHTTPMA\u{2}\0\0\0".utf8)), "unsupported version") { error in
+            XCTAssertEqual(error as? HTTPMockArchiveError, .invalidHeader, "error")
+        }
+        // A record whose fields overrun its length is corrupt rather than truncated.
+        var corrupt = HTTPMockArchive.header
+        corrupt.append(contentsOf: [4, 0, 0, 0, 1, 2, 3, 4])
+        XCTAssertThrowsError(try HTTPMockArchive(data: corrupt), "corrupt record") { error in
+            XCTAssertEqual(error as? HTTPMockArchiveError, .invalidRecord, "error")
+        }
+    }
+    
+    func testReplayOrder() throws {
+        var data = HTTPMockArchive.header
+        appendRecord(to: &data, url: "http://\(httpServer.address)/foo", body: "one")
+        appendRecord(to: &data, url: "http://\(httpServer.address)/bar", body: "bar")
+        appendRecord(to: &data, url: "http://\(httpServer.address)/foo", body: "two")
+        HTTP.mockManager.addReplay(of: try HTTPMockArchive(data: data), timing: .immediate)
+        // Requests for the same URL are served in recorded order, repeating the last response.
+        for body in ["one", "two", "two"] {
+            expectationForRequestSuccess(HTTP.request(GET: "foo")) { (task, response, value) in
+                XCTAssertEqual(String(data: value, encoding: .utf8), body, "body")
+            }
+            waitForExpectations(timeout: 5, handler: nil)
+        }
+        
+        // Regular mocks take precedence over replays.
+        HTTP.mockManager.addMock(for: "bar", statusCode: 200, text: "mock")
+        expectationForRequestSuccess(HTTP.request(GET: "bar")) { (task, response, value) in
+            XCTAssertEqual(String(data: value, encoding: .utf8), "mock", "body")
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testReplayOriginalTiming() throws {
+        var data = HTTPMockArchive.header
+        appendRecord(to: &data, url: "http://\(httpServer.address)/foo", body: "slow", duration: 300_000_000)
+        let archive = try HTTPMockArchive(data: data)
+        let token = HTTP.mockManager.addReplay(of: archive)
+        let start = Date()
+        expectationForRequestSuccess(HTTP.request(GET: "foo")) { (task, response, value) in
+            XCTAssertGreaterThanOrEqual(Date().timeIntervalSince(start), 0.3, "replay delay")
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+        
+        // Removing the replay sends requests back to the server.
+        HTTP.mockManager.removeMock(token)
+        expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+            completionHandler(HTTPServer.Response(status: .ok, text: "live"))
+        }
+        expectationForRequestSuccess(HTTP.request(GET: "foo")) { (task, response, value) in
+            XCTAssertEqual(String(data: value, encoding: .utf8), "live", "body")
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    private func response(url: String) -> HTTPURLResponse {
+        return HTTPURLResponse(url: URL(string: url)!, statusCode: 200, httpVersion: "HTTP/1.1", headerFields: ["Content-Type": "text/plain"])!
+    }
+    
+    private func appendRecord(to data: inout Data, url: String, body: String, duration: UInt64 = 0) {
+        HTTPMockArchive.appendRecord(to: &data, startOffset: 0, duration: duration, statusCode: 200, method: "GET", url: url,
+                                     headers: [("Content-Type", "text/plain")], body: Data(body.utf8))
+    }
+}
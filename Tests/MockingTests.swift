@@ -811,6 +811,39 @@ class MockingTests: PMHTTPTestCase {
         waitForExpectations(timeout: 5, handler: nil)
     }
     
+    func testMockPrecedence() {
+        // The most recently added mock wins, regardless of whether mocks are literal, tokens,
+        // absolute, or restricted to a method.
+        func expectBody(_ path: String, method: HTTPManagerRequest.Method = .GET, _ body: String, line: UInt = #line) {
+            let request: HTTPManagerNetworkRequest
+            switch method {
+            case .GET: request = HTTP.request(GET: path)!
+            case .POST: request = HTTP.request(POST: path)!
+            default: fatalError("unexpected method")
+            }
+            expectationForRequestSuccess(request) { (task, response, value) in
+                XCTAssertEqual(String(data: value, encoding: .utf8), body, "body text", line: line)
+            }
+            waitForExpectations(timeout: 5, handler: nil)
+        }
+        HTTP.mockManager.addMock(for: "users/:id", statusCode: 200, text: "token")
+        HTTP.mockManager.addMock(for: "users/me", statusCode: 200, text: "literal")
+        expectBody("users/me", "literal")
+        expectBody("users/42", "token")
+        HTTP.mockManager.addMock(for: "http://\(httpServer.address)/users/:id", statusCode: 200, text: "absolute")
+        expectBody("users/me", "absolute")
+        let token = HTTP.mockManager.addMock(for: "users/:id", httpMethod: "post", statusCode: 200, text: "post")
+        expectBody("users/me", "absolute")
+        expectBody("users/me", method: .POST, "post")
+        HTTP.mockManager.removeMock(token)
+        expectBody("users/me", method: .POST, "absolute")
+        HTTP.mockManager.addMock(for: "http://example.com/users/:id", statusCode: 200, text: "other host")
+        expectBody("users/me", "absolute")
+        HTTP.mockManager.addMock(for: "/:path", statusCode: 200, text: "root")
+        expectBody("users/me", "absolute")
+        expectBody("users", "root")
+    }
+    
     func testRelativeMockWithNoEnvironment() {
         HTTP.environment = nil
         HTTP.mockManager.interceptUnhandledExternalURLs = true
@@ -911,4 +944,30 @@ class MockingTests: PMHTTPTestCase {
         }
         waitForExpectations(timeout: 1, handler: nil)
     }
+    
+    func testConcurrentCompletions() {
+        // Many tasks registered from different threads while the delegate queue is busy with
+        // other tasks' callbacks must all be found and completed.
+        HTTP.mockManager.addMock(for: "foo", statusCode: 200, text: "Mock response")
+        for concurrency in [10, 100, 500] {
+            let group = DispatchGroup()
+            let lock = NSLock()
+            var successes = 0
+            DispatchQueue.concurrentPerform(iterations: concurrency) { _ in
+                group.enter()
+                HTTP.request(GET: "foo")!.performRequest { task, result in
+                    if result.value.flatMap({ String(data: $0, encoding: .utf8) }) == "Mock response" {
+                        lock.lock()
+                        successes += 1
+                        lock.unlock()
+                    }
+                    group.leave()
+                }
+            }
+            XCTAssertEqual(group.wait(timeout: .now() + 30), .success, "\(concurrency) concurrent requests completed")
+            lock.lock()
+            XCTAssertEqual(successes, concurrency, "\(concurrency) concurrent requests succeeded")
+            lock.unlock()
+        }
+    }
 }
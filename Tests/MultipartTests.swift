@@ -346,6 +346,60 @@ class MultipartTests: PMHTTPTestCase {
         }
     }
     
+    func testDeferredBodyPartsWithContentLengthDontBlock() {
+        for compressed in [false, true] {
+            let text = String(repeating: "Hello world. ", count: 500)
+            let req = HTTP.request(POST: "foo")!
+            req.serverRequiresContentLength = true
+            if compressed {
+                req.requestBodyCompression = .gzip
+            }
+            let sema = DispatchSemaphore(value: 0)
+            req.addMultipartBody { upload in
+                // Time out instead of deadlocking if creating the task waits on this block.
+                _ = sema.wait(timeout: .now() + 2)
+                upload.addMultipart(text: text, withName: "message")
+            }
+            expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+                defer { completionHandler(HTTPServer.Response(status: .ok)) }
+                XCTAssertEqual(request.headers["Content-Length"].flatMap({ Int($0) }), request.body?.count, "content length")
+                if compressed {
+                    XCTAssertEqual(request.headers["Content-Encoding"], "gzip", "Content-Encoding")
+                    XCTAssertLessThan(request.body?.count ?? .max, text.utf8.count, "compressed length")
+                } else {
+                    XCTAssertNil(request.headers["Content-Encoding"], "Content-Encoding")
+                    XCTAssertEqual((try? request.parseMultipartBody())?.parts.first.flatMap({ String(data: $0.body, encoding: .utf8) }), text, "multipart body part 0 content")
+                }
+            }
+            let start = DispatchTime.now()
+            let task = expectationForRequestSuccess(req) { (task, response, value) in
+                XCTAssertEqual((response as? HTTPURLResponse)?.statusCode, 200, "status code")
+            }
+            XCTAssertLessThan(DispatchTime.now().uptimeNanoseconds - start.uptimeNanoseconds, 1_000_000_000, "time spent creating the task")
+            let placeholder = task.networkTask
+            sema.signal()
+            waitForExpectations(timeout: 5, handler: nil)
+            XCTAssertFalse(task.networkTask === placeholder, "network task replaced")
+            XCTAssertNotNil(task.networkTask.originalRequest?.value(forHTTPHeaderField: "Content-Length"), "network task Content-Length")
+        }
+    }
+    
+    func testCancelDeferredBodyPartsWithContentLength() {
+        let req = HTTP.request(POST: "foo")!
+        req.serverRequiresContentLength = true
+        let sema = DispatchSemaphore(value: 0)
+        req.addMultipartBody { upload in
+            _ = sema.wait(timeout: .now() + 2)
+            upload.addMultipart(text: "Hello world", withName: "message")
+        }
+        // The task is canceled before its network task exists, so the server never sees it.
+        let task = expectationForRequestCanceled(req)
+        task.cancel()
+        sema.signal()
+        waitForExpectations(timeout: 5, handler: nil)
+        XCTAssertEqual(task.state, .canceled, "task state")
+    }
+    
     func testMixedEagerAndDeferredBodyParts() {
         let req = HTTP.request(POST: "foo")!
         req.addMultipart(text: "Hello world", withName: "first")
@@ -516,4 +570,126 @@ class MultipartTests: PMHTTPTestCase {
         XCTAssertNotNil(req.preparedURLRequest.httpBody, "request HTTP body")
         XCTAssertNil(req.preparedURLRequest.httpBodyStream, "request HTTP body stream")
     }
+    
+    func testBodyStreamSmallReads() throws {
+        var data = Data(count: 64 * 1024 + 3)
+        data.withUnsafeMutableBytes { [count=data.count] (bytes: UnsafeMutablePointer<UInt8>) -> Void in
+            for i in 0..<count {
+                bytes[i] = UInt8(truncatingIfNeeded: i % 23)
+            }
+        }
+        let parts: [MultipartBodyPart] = [
+            .known(.init(.text("Hello world"), name: "message")),
+            .known(.init(.data(Data()), name: "empty")),
+            // Use a slice to make sure offsets are relative to the data's start index.
+            .known(.init(.data(data[1..<data.count]), name: "binary", mimeType: "image/jpeg", filename: "photo.jpg"))
+        ]
+        let parameters = [URLQueryItem(name: "key", value: "value")]
+        let stream = HTTPBody.createMultipartMixedStream("boundary", parameters: parameters, bodyParts: parts)
+        stream.open()
+        let expected = try stream.readAll()
+        // Reading with buffers that don't line up with any part boundaries must produce the same body.
+        for bufferSize in [1, 7, 4096] {
+            let stream = HTTPBody.createMultipartMixedStream("boundary", parameters: parameters, bodyParts: parts)
+            stream.open()
+            var result = Data()
+            var buffer = [UInt8](repeating: 0, count: bufferSize)
+            while true {
+                let count = stream.read(&buffer, maxLength: bufferSize)
+                guard count > 0 else {
+                    XCTAssertEqual(count, 0, "read result")
+                    break
+                }
+                result.append(buffer, count: count)
+            }
+            XCTAssertEqual(result, expected, "body read with buffer size \(bufferSize)")
+        }
+        // A single read fills the buffer across every part rather than stopping at a part boundary.
+        do {
+            let stream = HTTPBody.createMultipartMixedStream("boundary", parameters: parameters, bodyParts: parts)
+            stream.open()
+            var buffer = [UInt8](repeating: 0, count: expected.count + 1)
+            XCTAssertEqual(stream.read(&buffer, maxLength: buffer.count), expected.count, "single read length")
+        }
+        XCTAssert(expected.range(of: "Content-Disposition: form-data; name=\"binary\"; filename=\"photo.jpg\"\r\nContent-Type: image/jpeg\r\n\r\n".data(using: String.Encoding.utf8)!) != nil, "binary part header")
+        XCTAssert(expected.range(of: data[1..<data.count]) != nil, "binary part content")
+    }
+    
+    func testSerializedBodyLength() throws {
+        let parts: [MultipartBodyPart] = [
+            .known(.init(.text("Hello wörld"), name: "message")),
+            .known(.init(.data(Data()), name: "empty")),
+            .known(.init(.data(Data(repeating: 1, count: 1000)), name: "binary", filename: "a\"b"))
+        ]
+        let parameters = [URLQueryItem(name: "key", value: "value"), URLQueryItem(name: "flag", value: nil)]
+        let body = SerializedMultipartBody(boundary: "boundary", parameters: parameters, bodyParts: parts)
+        let stream = HTTPBody.createMultipartMixedStream(body)
+        stream.open()
+        XCTAssertEqual(body.count, try stream.readAll().count, "serialized body length")
+        XCTAssertEqual(SerializedMultipartBody(boundary: "boundary", parameters: [], bodyParts: []).count, "--boundary--\r\n".utf8.count, "empty body length")
+    }
+    
+    func testBodyStreamGetBuffer() throws {
+        let data = Data(repeating: 0x5A, count: 256 * 1024)
+        let parts: [MultipartBodyPart] = [
+            .known(.init(.text("Hello world"), name: "message")),
+            .known(.init(.data(data), name: "binary"))
+        ]
+        let stream = HTTPBody.createMultipartMixedStream("boundary", parameters: [], bodyParts: parts)
+        stream.open()
+        let expected = try stream.readAll()
+        let stream2 = HTTPBody.createMultipartMixedStream("boundary", parameters: [], bodyParts: parts)
+        stream2.open()
+        var result = Data()
+        var lentCount = 0
+        var buffer = [UInt8](repeating: 0, count: 16)
+        while true {
+            var ptr: UnsafeMutablePointer<UInt8>?
+            var length = 0
+            if stream2.getBuffer(&ptr, length: &length), let ptr = ptr {
+                lentCount += length
+                result.append(ptr, count: length)
+                continue
+            }
+            let count = stream2.read(&buffer, maxLength: buffer.count)
+            guard count > 0 else { break }
+            result.append(buffer, count: count)
+        }
+        XCTAssertEqual(result, expected, "body")
+        // Everything but the portion of the binary part that shared a read with its header
+        // should have been lent out.
+        XCTAssertGreaterThanOrEqual(lentCount, data.count - buffer.count, "lent byte count")
+    }
+    
+    func testBodyStreamReadWhileScheduling() throws {
+        // Reads must produce the same body while another thread schedules the stream.
+        let parts: [MultipartBodyPart] = (0..<4).map({ i in .known(.init(.data(Data(repeating: UInt8(i), count: 256 * 1024)), name: "part\(i)")) })
+        let stream = HTTPBody.createMultipartMixedStream("boundary", parameters: [], bodyParts: parts)
+        stream.open()
+        let expected = try stream.readAll()
+        #if swift(>=4.2)
+        let mode = RunLoop.Mode.default
+        #else
+        let mode = RunLoopMode.defaultRunLoopMode
+        #endif
+        let stream2 = HTTPBody.createMultipartMixedStream("boundary", parameters: [], bodyParts: parts)
+        stream2.open()
+        var result = Data()
+        DispatchQueue.concurrentPerform(iterations: 2) { i in
+            if i == 0 {
+                var buffer = [UInt8](repeating: 0, count: 4096)
+                while case let count = stream2.read(&buffer, maxLength: buffer.count), count > 0 {
+                    result.append(buffer, count: count)
+                }
+            } else {
+                let runLoop = RunLoop.current
+                for _ in 0..<1000 {
+                    stream2.schedule(in: runLoop, forMode: mode)
+                    stream2.remove(from: runLoop, forMode: mode)
+                }
+            }
+        }
+        stream2.close()
+        XCTAssertEqual(result, expected, "body")
+    }
 }
@@ -149,4 +149,55 @@ class NetworkActivityTests: PMHTTPTestCase {
         XCTAssertEqual(values, [1, 1])
         XCTAssertEqual(numberOfOutstandingTasks, 0)
     }
+    
+    func testChangeThreshold() {
+        guard sanityCheck() else { return }
+        HTTPManager.networkActivityChangeThreshold = 10
+        defer { HTTPManager.networkActivityChangeThreshold = 1 }
+        
+        var values: [Int] = []
+        HTTPManager.networkActivityHandler = { values.append($0) }
+        let group = DispatchGroup()
+        for _ in 0..<3 {
+            group.enter()
+            expectationForHTTPRequest(httpServer, path: "/foo", handler: { (request, completionHandler) in
+                group.notify(queue: DispatchQueue.main) {
+                    completionHandler(HTTPServer.Response(status: .ok))
+                }
+                group.leave()
+            })
+            expectationForRequestSuccess(HTTP.request(GET: "foo"))
+        }
+        waitForExpectations(timeout: 2, handler: nil)
+        CFRunLoopRunInMode(CFRunLoopMode.defaultMode, 0, true)
+        // Only the changes to and from zero are reported.
+        XCTAssertEqual(values.count, 2, "handler invocations: \(values)")
+        XCTAssertEqual(values.last, 0)
+    }
+    
+    func testCoalescingInterval() {
+        guard sanityCheck() else { return }
+        HTTPManager.networkActivityCoalescingInterval = 60
+        defer { HTTPManager.networkActivityCoalescingInterval = 0 }
+        
+        var values: [Int] = []
+        HTTPManager.networkActivityHandler = { values.append($0) }
+        let group = DispatchGroup()
+        for _ in 0..<3 {
+            group.enter()
+            expectationForHTTPRequest(httpServer, path: "/foo", handler: { (request, completionHandler) in
+                group.notify(queue: DispatchQueue.main) {
+                    completionHandler(HTTPServer.Response(status: .ok))
+                }
+                group.leave()
+            })
+            expectationForRequestSuccess(HTTP.request(GET: "foo"))
+        }
+        waitForExpectations(timeout: 2, handler: nil)
+        CFRunLoopRunInMode(CFRunLoopMode.defaultMode, 0, true)
+        // The changes between the first task starting and the last one finishing are held back for
+        // the rest of the interval, and by then there's nothing left to report.
+        XCTAssertEqual(values.count, 2, "handler invocations: \(values)")
+        XCTAssertEqual(values.last, 0)
+    }
 }
@@ -0,0 +1,133 @@
+//
+//  PMHTTPManagerTaskStateBoxTests.m
+//  PMHTTPTests
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+#import <XCTest/XCTest.h>
+#import <stdatomic.h>
+@import PMHTTP;
+
+// _PMHTTPManagerTaskStateBox has hidden visibility, so it's looked up at runtime and messaged
+// through this protocol. The box only retains and releases its network task, so these tests give it
+// TestTask objects that track their own deallocation.
+@protocol TestTaskStateBox <NSObject>
+@property (atomic, nonnull, retain) id networkTask;
+- (nonnull instancetype)initWithState:(unsigned char)state networkTask:(nonnull id)task;
+@end
+
+static atomic_long deallocCount;
+
+static const uint32_t kTestTaskAlive = 0x5a5a5a5a;
+
+@interface TestTask : NSObject
+@property (atomic, readonly) uint32_t marker;
+@end
+
+@implementation TestTask {
+    _Atomic(uint32_t) _marker;
+}
+
+- (instancetype)init {
+    if ((self = [super init])) {
+        atomic_init(&_marker, kTestTaskAlive);
+    }
+    return self;
+}
+
+- (uint32_t)marker {
+    return atomic_load_explicit(&_marker, memory_order_relaxed);
+}
+
+- (void)dealloc {
+    atomic_store_explicit(&_marker, 0, memory_order_relaxed);
+    atomic_fetch_add_explicit(&deallocCount, 1, memory_order_relaxed);
+}
+@end
+
+@interface PMHTTPManagerTaskStateBoxTests : XCTestCase
+@end
+
+@implementation PMHTTPManagerTaskStateBoxTests
+
+- (void)setUp {
+    [super setUp];
+    atomic_store(&deallocCount, 0);
+}
+
+- (nonnull id<TestTaskStateBox>)newBox {
+    Class boxClass = NSClassFromString(@"_PMHTTPManagerTaskStateBox");
+    XCTAssertNotNil(boxClass, @"_PMHTTPManagerTaskStateBox class");
+    return [(id<TestTaskStateBox>)[boxClass alloc] initWithState:0 networkTask:[TestTask new]];
+}
+
+- (void)testReplacedTasksAreReleased {
+    @autoreleasepool {
+        id<TestTaskStateBox> box = [self newBox];
+        for (int i = 0; i < 100; ++i) {
+            @autoreleasepool {
+                box.networkTask = [TestTask new];
+            }
+        }
+        // With no concurrent readers, every replaced task is released by the swap that replaced it.
+        XCTAssertEqual(atomic_load(&deallocCount), 100L, @"released tasks while the box is alive");
+        @autoreleasepool {
+            XCTAssertEqual([(TestTask *)box.networkTask marker], kTestTaskAlive, @"current task");
+        }
+        XCTAssertEqual(atomic_load(&deallocCount), 100L, @"released tasks after reading");
+    }
+    XCTAssertEqual(atomic_load(&deallocCount), 101L, @"released tasks after the box is released");
+}
+
+- (void)testConcurrentGetAndSet {
+    static const long kThreads = 8;
+    static const long kIterations = 20000;
+    // dispatch_apply is synchronous, so the block can safely use these through pointers.
+    atomic_long setCount = 0;
+    atomic_long invalidReads = 0;
+    atomic_long *setCountPtr = &setCount;
+    atomic_long *invalidReadsPtr = &invalidReads;
+    @autoreleasepool {
+        id<TestTaskStateBox> box = [self newBox];
+        // Half the threads replace the task while the other half read it. Several setters run at
+        // once, so a swap can race with another swap as well as with readers.
+        dispatch_apply(kThreads, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t thread) {
+            for (long i = 0; i < kIterations; ++i) {
+                @autoreleasepool {
+                    if (thread % 2 == 0) {
+                        box.networkTask = [TestTask new];
+                        atomic_fetch_add_explicit(setCountPtr, 1, memory_order_relaxed);
+                    } else {
+                        TestTask *task = box.networkTask;
+                        if (task.marker != kTestTaskAlive) {
+                            atomic_fetch_add_explicit(invalidReadsPtr, 1, memory_order_relaxed);
+                        }
+                    }
+                }
+            }
+        });
+        XCTAssertEqual(atomic_load(&invalidReads), 0, @"reads of released tasks");
+        XCTAssertEqual(atomic_load(&setCount), kThreads / 2 * kIterations, @"set count");
+        // Tasks retired while readers were active may still be waiting for a later swap.
+        XCTAssertLessThanOrEqual(atomic_load(&deallocCount), atomic_load(&setCount), @"released tasks while the box is alive");
+        @autoreleasepool {
+            XCTAssertEqual([(TestTask *)box.networkTask marker], kTestTaskAlive, @"current task");
+        }
+        // Once the readers are gone, the next swap releases everything that was retired.
+        @autoreleasepool {
+            box.networkTask = [TestTask new];
+        }
+        XCTAssertEqual(atomic_load(&deallocCount), atomic_load(&setCount) + 1, @"released tasks after a quiescent swap");
+    }
+    XCTAssertEqual(atomic_load(&deallocCount), atomic_load(&setCount) + 2, @"released tasks after the box is released");
+}
+
+@end
@@ -505,6 +505,90 @@ final class PMHTTPRetryTests: PMHTTPTestCase {
         }
         waitForExpectations(timeout: 5, handler: nil)
     }
+    
+    func testRetryWithBackoff() {
+        var requestTimes: [TimeInterval] = []
+        for _ in 0..<3 {
+            expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+                requestTimes.append(CACurrentMediaTime())
+                completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Length": "64", "Connection": "close"]))
+            }
+        }
+        let req = HTTP.request(GET: "foo")!
+        req.retryBehavior = .retryNetworkFailure(withCustomStrategy: HTTPManagerRetryBehavior.backoffStrategy(maximumAttempts: 2, baseDelay: 0.05, maximumDelay: 0.1))
+        expectationForRequestFailure(req) { task, response, error in
+            if let error = error as? URLError {
+                XCTAssertEqual(error.code, URLError.networkConnectionLost, "error code")
+            } else {
+                XCTFail("expected URLError, got \(error)")
+            }
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+        XCTAssertEqual(requestTimes.count, 3, "request count")
+        for (earlier, later) in zip(requestTimes, requestTimes.dropFirst()) {
+            let retryDelay_ms = Int((later - earlier) * 1000)
+            XCTAssertGreaterThanOrEqual(retryDelay_ms, 50, "retry delay")
+        }
+    }
+    
+    func testRetryBudget() {
+        HTTP.retryBudget = HTTPManagerRetryBudget(capacity: 1, refillRate: 0)
+        defer { HTTP.retryBudget = nil }
+        
+        // The first retry takes the only token.
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Length": "64", "Connection": "close"]))
+        }
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .ok, text: "success"))
+        }
+        let req = HTTP.request(GET: "foo")!
+        req.retryBehavior = .retryNetworkFailure(withStrategy: .retryOnce)
+        expectationForRequestSuccess(req)
+        waitForExpectations(timeout: 5, handler: nil)
+        
+        // The next one finds the budget exhausted, so the task fails without a second request.
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Length": "64", "Connection": "close"]))
+        }
+        expectationForRequestFailure(req) { task, response, error in
+            if let error = error as? URLError {
+                XCTAssertEqual(error.code, URLError.networkConnectionLost, "error code")
+            } else {
+                XCTFail("expected URLError, got \(error)")
+            }
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testRetryBudgetIgnoresCanceledRetries() {
+        HTTP.retryBudget = HTTPManagerRetryBudget(capacity: 1, refillRate: 0)
+        defer { HTTP.retryBudget = nil }
+        
+        // The task is canceled before its retry starts, so the retry doesn't spend the token.
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Length": "64", "Connection": "close"]))
+        }
+        let canceledReq = HTTP.request(GET: "foo")!
+        canceledReq.retryBehavior = .retryNetworkFailure(withCustomStrategy: { (task, error, attempt, callback) in
+            task.cancel()
+            callback(true)
+        })
+        expectationForRequestCanceled(canceledReq)
+        waitForExpectations(timeout: 5, handler: nil)
+        
+        // So the next task can still retry.
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Length": "64", "Connection": "close"]))
+        }
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .ok, text: "success"))
+        }
+        let req = HTTP.request(GET: "foo")!
+        req.retryBehavior = .retryNetworkFailure(withStrategy: .retryOnce)
+        expectationForRequestSuccess(req)
+        waitForExpectations(timeout: 5, handler: nil)
+    }
 }
 
 private class KVOLog<T: AnyObject>: NSObject {
@@ -1902,6 +1902,172 @@ final class PMHTTPTests: PMHTTPTestCase {
         waitForExpectations(timeout: 5, handler: nil)
     }
     
+    func testSessionPool() {
+        HTTP.usesSessionPool = true
+        defer { HTTP.usesSessionPool = false }
+        for userInitiated in [false, true, false] {
+            expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+                completionHandler(HTTPServer.Response(status: .ok, text: "Hello world"))
+            }
+            let req = HTTP.request(GET: "foo")!
+            req.userInitiated = userInitiated
+            expectationForRequestSuccess(req) { task, response, value in
+                XCTAssertEqual(task.userInitiated, userInitiated, "task userInitiated")
+                XCTAssertEqual(String(data: value, encoding: String.Encoding.utf8), "Hello world")
+            }
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+        
+        // Resetting the session tears down the pool; new requests must get fresh pooled sessions.
+        HTTP.resetSession()
+        expectationForHTTPRequest(httpServer, path: "/bar") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .ok, text: "Hello again"))
+        }
+        expectationForRequestSuccess(HTTP.request(GET: "bar")) { task, response, value in
+            XCTAssertEqual(String(data: value, encoding: String.Encoding.utf8), "Hello again")
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testSessionPoolEviction() {
+        HTTP.usesSessionPool = true
+        HTTP.maximumPooledSessionCount = 2
+        defer {
+            HTTP.usesSessionPool = false
+            HTTP.maximumPooledSessionCount = HTTPManager.defaultMaximumPooledSessionCount
+        }
+        // Using a again makes b the least recently used session, so c evicts b.
+        for host in ["a", "b", "a", "c"] {
+            HTTP.mockManager.addMock(for: "http://\(host).example.com/foo", statusCode: 200, text: host, delay: 0)
+            expectationForRequestSuccess(HTTP.request(GET: URL(string: "http://\(host).example.com/foo")!)) { task, response, value in
+                XCTAssertEqual(String(data: value, encoding: String.Encoding.utf8), host)
+            }
+            waitForExpectations(timeout: 5, handler: nil)
+        }
+        XCTAssertEqual(HTTP.pooledSessionHosts.sorted(), ["a.example.com", "c.example.com"], "pooled session hosts")
+        
+        // The evicted host gets a new session, and lowering the limit evicts immediately.
+        expectationForRequestSuccess(HTTP.request(GET: URL(string: "http://b.example.com/foo")!))
+        waitForExpectations(timeout: 5, handler: nil)
+        XCTAssertEqual(HTTP.pooledSessionHosts.sorted(), ["b.example.com", "c.example.com"], "pooled session hosts")
+        HTTP.maximumPooledSessionCount = 1
+        XCTAssertEqual(HTTP.pooledSessionHosts, ["b.example.com"], "pooled session hosts")
+    }
+    
+    func testCoalescedRequests() {
+        HTTP.coalescesIdenticalRequests = true
+        defer { HTTP.coalescesIdenticalRequests = false }
+        let resultSema = DispatchSemaphore(value: 0)
+        // The server sees two requests, but they may arrive in either order.
+        let handler: (HTTPServer.Request, @escaping (HTTPServer.Response) -> Void) -> Void = { request, completionHandler in
+            if request.headers["X-Foo"] == "bar" {
+                completionHandler(HTTPServer.Response(status: .ok, text: "Hello bar"))
+            } else {
+                XCTAssert(resultSema.wait(timeout: DispatchTime.now() + 2) == .success, "timeout on dispatch semaphore")
+                completionHandler(HTTPServer.Response(status: .ok, text: "Hello world"))
+            }
+        }
+        expectationForHTTPRequest(httpServer, path: "/foo", handler: handler)
+        expectationForHTTPRequest(httpServer, path: "/foo", handler: handler)
+        let task = expectationForRequestSuccess(HTTP.request(GET: "foo")) { task, response, value in
+            XCTAssertEqual(String(data: value, encoding: String.Encoding.utf8), "Hello world")
+        }
+        let req = HTTP.request(GET: "foo")!.parse(using: { response, data -> String in
+            return String(data: data, encoding: String.Encoding.utf8) ?? ""
+        })
+        let task2 = expectationForRequestSuccess(req) { task, response, value in
+            XCTAssertEqual(value, "Hello world")
+        }
+        XCTAssert(task.networkTask === task2.networkTask, "identical requests should share a network task")
+        // Requests that differ in their headers don't share a network task.
+        let req3 = HTTP.request(GET: "foo")!
+        req3.headerFields["X-Foo"] = "bar"
+        let task3 = expectationForRequestSuccess(req3) { task, response, value in
+            XCTAssertEqual(String(data: value, encoding: String.Encoding.utf8), "Hello bar")
+        }
+        XCTAssert(task.networkTask !== task3.networkTask, "requests with different headers shouldn't share a network task")
+        resultSema.signal()
+        waitForExpectations(timeout: 5, handler: nil)
+        
+        // Once the shared request completes, a new request gets its own network task.
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .ok, text: "Hello again"))
+        }
+        let task4 = expectationForRequestSuccess(HTTP.request(GET: "foo")) { task, response, value in
+            XCTAssertEqual(String(data: value, encoding: String.Encoding.utf8), "Hello again")
+        }
+        XCTAssert(task.networkTask !== task4.networkTask, "completed network task shouldn't be shared")
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testCoalescedRequestCancel() {
+        HTTP.coalescesIdenticalRequests = true
+        defer { HTTP.coalescesIdenticalRequests = false }
+        do {
+            // Canceling one task doesn't affect the other.
+            let requestSema = DispatchSemaphore(value: 0)
+            let resultSema = DispatchSemaphore(value: 0)
+            expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+                requestSema.signal()
+                XCTAssert(resultSema.wait(timeout: DispatchTime.now() + 2) == .success, "timeout on dispatch semaphore")
+                completionHandler(HTTPServer.Response(status: .ok, text: "Hello world"))
+            }
+            let task = expectationForRequestCanceled(HTTP.request(GET: "foo"))
+            let task2 = expectationForRequestSuccess(HTTP.request(GET: "foo")) { task, response, value in
+                XCTAssertEqual(String(data: value, encoding: String.Encoding.utf8), "Hello world")
+            }
+            XCTAssert(task.networkTask === task2.networkTask, "identical requests should share a network task")
+            XCTAssert(requestSema.wait(timeout: DispatchTime.now() + 2) == .success, "timeout on dispatch semaphore")
+            task.cancel()
+            XCTAssertEqual(task2.networkTask.state, .running, "network task state")
+            resultSema.signal()
+            waitForExpectations(timeout: 5, handler: nil)
+        }
+        
+        do {
+            // A task that joined the network task completes as soon as it's canceled.
+            let requestSema = DispatchSemaphore(value: 0)
+            let resultSema = DispatchSemaphore(value: 0)
+            let canceledSema = DispatchSemaphore(value: 0)
+            expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+                requestSema.signal()
+                XCTAssert(resultSema.wait(timeout: DispatchTime.now() + 2) == .success, "timeout on dispatch semaphore")
+                completionHandler(HTTPServer.Response(status: .ok, text: "Hello world"))
+            }
+            let task = expectationForRequestSuccess(HTTP.request(GET: "foo")) { task, response, value in
+                XCTAssertEqual(String(data: value, encoding: String.Encoding.utf8), "Hello world")
+            }
+            let task2 = expectationForRequestCanceled(HTTP.request(GET: "foo")) { _ in
+                canceledSema.signal()
+            }
+            XCTAssert(task.networkTask === task2.networkTask, "identical requests should share a network task")
+            XCTAssert(requestSema.wait(timeout: DispatchTime.now() + 2) == .success, "timeout on dispatch semaphore")
+            task2.cancel()
+            XCTAssert(canceledSema.wait(timeout: DispatchTime.now() + 1) == .success, "canceled task should complete before the network task")
+            resultSema.signal()
+            waitForExpectations(timeout: 5, handler: nil)
+        }
+        
+        do {
+            // Canceling every task cancels the network task.
+            let requestSema = DispatchSemaphore(value: 0)
+            let resultSema = DispatchSemaphore(value: 0)
+            expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+                requestSema.signal()
+                XCTAssert(resultSema.wait(timeout: DispatchTime.now() + 2) == .success, "timeout on dispatch semaphore")
+                completionHandler(HTTPServer.Response(status: .ok))
+            }
+            let task = expectationForRequestCanceled(HTTP.request(GET: "foo"))
+            let task2 = expectationForRequestCanceled(HTTP.request(GET: "foo"))
+            XCTAssert(requestSema.wait(timeout: DispatchTime.now() + 2) == .success, "timeout on dispatch semaphore")
+            task.cancel()
+            task2.cancel()
+            XCTAssertNotEqual(task2.networkTask.state, .running, "network task state")
+            resultSema.signal()
+            waitForExpectations(timeout: 5, handler: nil)
+        }
+    }
+    
     func testChangingSessionConfigurationDoesntInvalidateRunningTasks() {
         let sema = DispatchSemaphore(value: 0)
         expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
@@ -0,0 +1,129 @@
+//
+//  ParseResultMemoTests.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import XCTest
+import PMJSON
+@testable import PMHTTP
+
+final class ParseResultMemoTests: PMHTTPTestCase {
+    override func tearDown() {
+        HTTP.parseResultMemo.removeAll()
+        HTTP.parseMemoizationByteLimit = 4 * 1024 * 1024
+        super.tearDown()
+    }
+    
+    func testMemoizedParse() {
+        let parseCount = ParseCounter()
+        func makeRequest() -> HTTPManagerParseRequest<JSON> {
+            return HTTP.request(GET: "foo")!.parseAsJSON(using: { response, json -> JSON in
+                parseCount.increment()
+                return json
+            }).with({
+                $0.memoizesParse = true
+                $0.parseIdentifier = "json"
+            })
+        }
+        func expectResponse(_ body: String, value: JSON, parseCount expectedCount: Int) {
+            expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+                completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "application/json"], body: body))
+            }
+            expectationForRequestSuccess(makeRequest()) { task, response, result in
+                XCTAssertEqual(result, value)
+            }
+            waitForExpectations(timeout: 5, handler: nil)
+            XCTAssertEqual(parseCount.value, expectedCount, "parse count")
+        }
+        expectResponse("[1,2,3]", value: [1,2,3], parseCount: 1)
+        // An identical body reuses the parsed value.
+        expectResponse("[1,2,3]", value: [1,2,3], parseCount: 1)
+        // A different body is parsed.
+        expectResponse("[4,5,6]", value: [4,5,6], parseCount: 2)
+        // Both bodies are remembered.
+        expectResponse("[1,2,3]", value: [1,2,3], parseCount: 2)
+        
+        // Disabling memoization parses every body.
+        HTTP.parseMemoizationByteLimit = 0
+        expectResponse("[1,2,3]", value: [1,2,3], parseCount: 3)
+        XCTAssertEqual(HTTP.parseResultMemo.currentByteCount, 0, "remembered bytes")
+    }
+    
+    func testUnmemoizedParse() {
+        let parseCount = ParseCounter()
+        // Requests that don't memoize, and requests that don't identify their parse handler, parse
+        // every body.
+        for (i, parseIdentifier) in [nil, "json", nil].enumerated() {
+            expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+                completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "application/json"], body: "[1]"))
+            }
+            let req = HTTP.request(GET: "foo")!.parseAsJSON(using: { response, json -> JSON in
+                parseCount.increment()
+                return json
+            }).with({
+                $0.memoizesParse = parseIdentifier == nil
+                $0.parseIdentifier = parseIdentifier
+            })
+            expectationForRequestSuccess(req) { task, response, result in
+                XCTAssertEqual(result, [1])
+            }
+            waitForExpectations(timeout: 5, handler: nil)
+            XCTAssertEqual(parseCount.value, i + 1, "parse count")
+        }
+    }
+    
+    func testEviction() {
+        let memo = ParseResultMemo(byteLimit: 10)
+        var parseCount = 0
+        let url = URL(string: "http://example.com/foo")
+        let parse = memo.memoizing({ (response: URLResponse, data: Data) -> String in
+            parseCount += 1
+            return String(data: data, encoding: .utf8)!
+        }, url: url, method: "GET", parseIdentifier: "string")
+        let response = URLResponse()
+        func parseBody(_ body: String) -> String? {
+            return try? parse(response, body.data(using: .utf8)!)
+        }
+        XCTAssertEqual(parseBody("aaaa"), "aaaa")
+        XCTAssertEqual(parseBody("bbbb"), "bbbb")
+        XCTAssertEqual(parseCount, 2, "parse count")
+        XCTAssertEqual(memo.currentByteCount, 8, "remembered bytes")
+        // Touch "aaaa" so "bbbb" is the least recently used.
+        XCTAssertEqual(parseBody("aaaa"), "aaaa")
+        XCTAssertEqual(parseCount, 2, "parse count")
+        XCTAssertEqual(parseBody("cccc"), "cccc")
+        XCTAssertEqual(memo.currentByteCount, 8, "remembered bytes")
+        XCTAssertEqual(parseBody("aaaa"), "aaaa")
+        XCTAssertEqual(parseCount, 3, "parse count")
+        XCTAssertEqual(parseBody("bbbb"), "bbbb")
+        XCTAssertEqual(parseCount, 4, "parse count")
+        // Values are remembered per type.
+        let parseInt = memo.memoizing({ (response: URLResponse, data: Data) -> Int in
+            parseCount += 1
+            return data.count
+        }, url: url, method: "GET", parseIdentifier: "string")
+        XCTAssertEqual(try? parseInt(response, "bbbb".data(using: .utf8)!), 4)
+        XCTAssertEqual(parseCount, 5, "parse count")
+        // And per parse identifier.
+        let parseReversed = memo.memoizing({ (response: URLResponse, data: Data) -> String in
+            parseCount += 1
+            return String(String(data: data, encoding: .utf8)!.reversed())
+        }, url: url, method: "GET", parseIdentifier: "reversed")
+        XCTAssertEqual(try? parseReversed(response, "abcd".data(using: .utf8)!), "dcba")
+        XCTAssertEqual(try? parse(response, "abcd".data(using: .utf8)!), "abcd")
+        XCTAssertEqual(parseCount, 7, "parse count")
+        // Bodies larger than the limit aren't remembered.
+        XCTAssertEqual(parseBody("ddddddddddd"), "ddddddddddd")
+        XCTAssertEqual(parseBody("ddddddddddd"), "ddddddddddd")
+        XCTAssertEqual(parseCount, 9, "parse count")
+    }
+}
@@ -0,0 +1,81 @@
+//
+//  QueueConfinedTests.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import XCTest
+@testable import PMHTTP
+
+final class QueueConfinedTests: XCTestCase {
+    private final class Counter {
+        var value = 0
+    }
+    
+    private final class Snapshot {
+        let value: Int
+        
+        init(_ counter: Counter) {
+            value = counter.value
+        }
+    }
+    
+    func testSnapshotPublishing() {
+        let confined = SnapshotQueueConfined(label: "test queue", value: Counter(), makeSnapshot: Snapshot.init)
+        XCTAssertEqual(confined.snapshot.value, 0)
+        confined.syncBarrier { $0.value = 1 }
+        XCTAssertEqual(confined.snapshot.value, 1)
+        XCTAssertEqual(confined.syncBarrier({ counter -> Int in
+            counter.value = 2
+            return counter.value
+        }), 2)
+        XCTAssertEqual(confined.snapshot.value, 2)
+        confined.asyncBarrier { $0.value = 3 }
+        // A barrier block that's enqueued later can only run after the previous one has published.
+        confined.syncBarrier { _ in }
+        XCTAssertEqual(confined.snapshot.value, 3)
+        _ = confined.unsafeDirectAccess { $0.value = 4 }
+        XCTAssertEqual(confined.snapshot.value, 4)
+    }
+    
+    func testConcurrentSnapshotReads() {
+        let confined = SnapshotQueueConfined(label: "test queue", value: Counter(), makeSnapshot: Snapshot.init)
+        let group = DispatchGroup()
+        DispatchQueue.global(qos: .utility).async(group: group) {
+            for _ in 0..<1000 {
+                confined.asyncBarrier { $0.value += 1 }
+            }
+        }
+        // Readers never see a value go backwards, even while it's being replaced.
+        DispatchQueue.concurrentPerform(iterations: 4) { _ in
+            var last = 0
+            for _ in 0..<10_000 {
+                let value = confined.snapshot.value
+                XCTAssertGreaterThanOrEqual(value, last)
+                last = value
+            }
+        }
+        group.wait()
+        confined.syncBarrier { _ in }
+        XCTAssertEqual(confined.snapshot.value, 1000)
+    }
+    
+    func testEnvironmentIsVisibleImmediately() {
+        let httpManager = HTTPManager()
+        let environment = HTTPManager.Environment(string: "http://example.com")!
+        httpManager.environment = environment
+        XCTAssertEqual(httpManager.environment, environment)
+        httpManager.defaultHeaderFields = ["X-Foo": "bar"]
+        let request = httpManager.request(GET: "foo")
+        XCTAssertEqual(request?.url.absoluteString, "http://example.com/foo")
+        XCTAssertEqual(request?.headerFields["X-Foo"], "bar")
+    }
+}
@@ -0,0 +1,198 @@
+//
+//  RequestBatchingTests.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import XCTest
+@testable import PMHTTP
+
+final class RequestBatchingTests: PMHTTPTestCase {
+    func testBatchSizeFlush() {
+        let batcher = HTTP.requestBatcher(forPath: "batch", maximumDelay: 60, maximumBatchSize: 3)!
+        expectationForHTTPRequest(httpServer, path: "/batch") { (request, completionHandler) in
+            let multipartBody: HTTPServer.MultipartBody
+            do {
+                multipartBody = try request.parseMultipartBody()
+            } catch {
+                XCTFail("no multipart body; error: \(error)")
+                return completionHandler(HTTPServer.Response(status: .badRequest))
+            }
+            XCTAssertEqual(multipartBody.parts.count, 3, "multipart body part count")
+            let requestLines = multipartBody.parts.map({ $0.bodyText?.components(separatedBy: "\r\n").first })
+            XCTAssertEqual(requestLines.flatMap({ $0 }), ["GET /foo?id=1 HTTP/1.1", "GET /bar HTTP/1.1", "POST /baz HTTP/1.1"], "request lines")
+            for (i, part) in multipartBody.parts.enumerated() {
+                XCTAssertEqual(part.contentDisposition, HTTPServer.ContentDisposition("form-data; name=\"request-\(i)\""), "multipart body part \(i) Content-Disposition")
+                XCTAssertEqual(part.contentType, MediaType("application/http"), "multipart body part \(i) Content-Type")
+            }
+            XCTAssert(multipartBody.parts.last?.bodyText?.hasSuffix("\r\n\r\nname=value") ?? false, "multipart body part 2 body")
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "multipart/mixed; boundary=xyzzy"], body: RequestBatchingTests.multipartBody(boundary: "xyzzy", messages: [
+                "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 3\r\n\r\nfoo",
+                "HTTP/1.1 404 Not Found\r\nContent-Type: application/json\r\n\r\n{\"error\": \"not found\"}",
+                "HTTP/1.1 204 No Content\r\n\r\n"
+                ])))
+        }
+        let fooExpectation = expectation(description: "foo")
+        batcher.add(HTTP.request(GET: "foo", parameters: ["id": 1])) { (task, result) in
+            switch result {
+            case let .success(response, data):
+                XCTAssertEqual((response as? HTTPURLResponse)?.statusCode, 200, "status code")
+                XCTAssertEqual(response.url?.absoluteString, "http://\(self.httpServer.address)/foo?id=1", "response URL")
+                XCTAssertEqual(response.mimeType, "text/plain", "MIME type")
+                XCTAssertEqual(String(data: data, encoding: .utf8), "foo", "body")
+            default:
+                XCTFail("expected success, found \(result)")
+            }
+            fooExpectation.fulfill()
+        }
+        let barExpectation = expectation(description: "bar")
+        batcher.add(HTTP.request(GET: "bar")) { (task, result) in
+            if case .error(_, HTTPManagerError.failedResponse(let statusCode, _, _, let json)) = result {
+                XCTAssertEqual(statusCode, 404, "status code")
+                XCTAssertEqual(json, ["error": "not found"], "body JSON")
+            } else {
+                XCTFail("expected HTTPManagerError.failedResponse, found \(result)")
+            }
+            barExpectation.fulfill()
+        }
+        XCTAssertEqual(batcher.pendingRequestCount, 2, "pending request count")
+        let bazExpectation = expectation(description: "baz")
+        batcher.add(HTTP.request(POST: "baz", parameters: ["name": "value"]), withCompletionQueue: .main) { (task, result) in
+            XCTAssert(Thread.isMainThread, "completion queue")
+            if case let .success(response, data) = result {
+                XCTAssertEqual((response as? HTTPURLResponse)?.statusCode, 204, "status code")
+                XCTAssertEqual(data, Data(), "body")
+            } else {
+                XCTFail("expected success, found \(result)")
+            }
+            bazExpectation.fulfill()
+        }
+        XCTAssertEqual(batcher.pendingRequestCount, 0, "pending request count")
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testDelayFlush() {
+        let batcher = HTTP.requestBatcher(forPath: "batch", maximumDelay: 0.05, maximumBatchSize: 10)!
+        expectationForHTTPRequest(httpServer, path: "/batch") { (request, completionHandler) in
+            XCTAssertEqual((try? request.parseMultipartBody())?.parts.count, 2, "multipart body part count")
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "multipart/mixed; boundary=\"a b\""], body: RequestBatchingTests.multipartBody(boundary: "a b", messages: [
+                "HTTP/1.1 200 OK\r\n\r\none",
+                "HTTP/1.1 200 OK\r\n\r\ntwo"
+                ])))
+        }
+        for (i, text) in ["one", "two"].enumerated() {
+            let expectation = self.expectation(description: "request \(i)")
+            batcher.add(HTTP.request(GET: "item/\(i)")) { (task, result) in
+                XCTAssertEqual(result.value.flatMap({ String(data: $0, encoding: .utf8) }), text, "body")
+                expectation.fulfill()
+            }
+        }
+        XCTAssertEqual(batcher.pendingRequestCount, 2, "pending request count")
+        waitForExpectations(timeout: 5, handler: nil)
+        XCTAssertEqual(batcher.pendingRequestCount, 0, "pending request count")
+    }
+    
+    func testBatchFailure() {
+        let batcher = HTTP.requestBatcher(forPath: "batch", maximumDelay: 60, maximumBatchSize: 10)!
+        expectationForHTTPRequest(httpServer, path: "/batch") { (request, completionHandler) in
+            completionHandler(HTTPServer.Response(status: .internalServerError))
+        }
+        for i in 0..<2 {
+            let expectation = self.expectation(description: "request \(i)")
+            batcher.add(HTTP.request(GET: "item/\(i)")) { (task, result) in
+                if case .error(_, HTTPManagerError.failedResponse(let statusCode, _, _, _)) = result {
+                    XCTAssertEqual(statusCode, 500, "status code")
+                } else {
+                    XCTFail("expected HTTPManagerError.failedResponse, found \(result)")
+                }
+                expectation.fulfill()
+            }
+        }
+        batcher.flush()
+        waitForExpectations(timeout: 5, handler: nil)
+        
+        // A response that isn't multipart fails every request in the batch
+        expectationForHTTPRequest(httpServer, path: "/batch") { (request, completionHandler) in
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "text/plain"], body: "hello"))
+        }
+        let expectation = self.expectation(description: "request")
+        batcher.add(HTTP.request(GET: "foo")) { (task, result) in
+            if case .error(_, HTTPManagerError.unexpectedContentType(let contentType, _, _)) = result {
+                XCTAssertEqual(contentType, "text/plain", "content type")
+            } else {
+                XCTFail("expected HTTPManagerError.unexpectedContentType, found \(result)")
+            }
+            expectation.fulfill()
+        }
+        batcher.flush()
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testPendingRequestsSentOnDeinit() {
+        expectationForHTTPRequest(httpServer, path: "/batch") { (request, completionHandler) in
+            XCTAssertEqual((try? request.parseMultipartBody())?.parts.count, 1, "multipart body part count")
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "multipart/mixed; boundary=xyzzy"], body: RequestBatchingTests.multipartBody(boundary: "xyzzy", messages: [
+                "HTTP/1.1 200 OK\r\n\r\nfoo"
+                ])))
+        }
+        let expectation = self.expectation(description: "request")
+        weak var weakBatcher: HTTPManagerRequestBatcher?
+        autoreleasepool {
+            let batcher = HTTP.requestBatcher(forPath: "batch", maximumDelay: 60, maximumBatchSize: 10)!
+            weakBatcher = batcher
+            batcher.add(HTTP.request(GET: "foo")) { (task, result) in
+                XCTAssertEqual(result.value.flatMap({ String(data: $0, encoding: .utf8) }), "foo", "body")
+                expectation.fulfill()
+            }
+        }
+        XCTAssertNil(weakBatcher, "batcher")
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testBatcherKeepsManagerAlive() {
+        expectationForHTTPRequest(httpServer, path: "/batch") { (request, completionHandler) in
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "multipart/mixed; boundary=xyzzy"], body: RequestBatchingTests.multipartBody(boundary: "xyzzy", messages: [
+                "HTTP/1.1 204 No Content\r\n\r\n"
+                ])))
+        }
+        weak var weakManager: HTTPManager?
+        var batcher: HTTPManagerRequestBatcher?
+        autoreleasepool {
+            let httpManager = HTTPManager()
+            httpManager.environment = HTTP.environment
+            weakManager = httpManager
+            batcher = httpManager.requestBatcher(forPath: "batch", maximumDelay: 0.05, maximumBatchSize: 10)
+        }
+        XCTAssertNotNil(weakManager, "HTTPManager")
+        let expectation = self.expectation(description: "request")
+        batcher?.add(HTTP.request(GET: "foo")) { (task, result) in
+            if case let .success(response, _) = result {
+                XCTAssertEqual((response as? HTTPURLResponse)?.statusCode, 204, "status code")
+            } else {
+                XCTFail("expected success, found \(result)")
+            }
+            expectation.fulfill()
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+        batcher = nil
+    }
+    
+    func testMultipartBodyParts() {
+        let body = "preamble\r\n--xyzzy  \r\nContent-Type: text/plain\r\n\r\nfirst\r\n--xyzzy\r\n\r\nsecond\r\n\r\n--xyzzy--\r\nepilogue".data(using: .utf8)!
+        let parts = HTTPManagerRequestBatcher.multipartBodyParts(of: body, boundary: "xyzzy")
+        XCTAssertEqual(parts?.map({ String(data: $0, encoding: .utf8)! }) ?? [], ["first", "second\r\n"], "parts")
+        XCTAssertNil(HTTPManagerRequestBatcher.multipartBodyParts(of: "--xyzzy\r\n\r\nunterminated".data(using: .utf8)!, boundary: "xyzzy"), "unterminated body")
+    }
+    
+    private static func multipartBody(boundary: String, messages: [String]) -> String {
+        return messages.map({ "--\(boundary)\r\nContent-Type: application/http\r\n\r\n\($0)\r\n" }).joined() + "--\(boundary)--\r\n"
+    }
+}
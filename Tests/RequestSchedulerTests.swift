@@ -0,0 +1,124 @@
+//
+//  RequestSchedulerTests.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import XCTest
+@testable import PMHTTP
+
+final class RequestSchedulerTests: PMHTTPTestCase {
+    override func tearDown() {
+        HTTP.requestScheduler = nil
+        super.tearDown()
+    }
+    
+    func testPriorityOrder() {
+        let scheduler = HTTPManagerRequestScheduler(maximumConcurrentRequestsPerHost: 1)
+        HTTP.requestScheduler = scheduler
+        let order = RequestOrder()
+        let blockSema = DispatchSemaphore(value: 0)
+        expectationForHTTPRequest(httpServer, path: "/first") { (request, completionHandler) in
+            order.append("first")
+            XCTAssert(blockSema.wait(timeout: DispatchTime.now() + 5) == .success, "timeout on dispatch semaphore")
+            completionHandler(HTTPServer.Response(status: .ok))
+        }
+        for path in ["normal", "background", "userInitiated"] {
+            expectationForHTTPRequest(httpServer, path: "/\(path)") { (request, completionHandler) in
+                order.append(path)
+                completionHandler(HTTPServer.Response(status: .ok))
+            }
+        }
+        let first = expectationForRequestSuccess(HTTP.request(GET: "first"))
+        expectationForRequestSuccess(HTTP.request(GET: "normal"))
+        expectationForRequestSuccess(HTTP.request(GET: "background").with({ $0.priority = .background }))
+        let userInitiated = expectationForRequestSuccess(HTTP.request(GET: "userInitiated").with({ $0.userInitiated = true }))
+        XCTAssertEqual(scheduler.queuedTaskCount, 3, "queued task count")
+        XCTAssertEqual(userInitiated.priority, .userInitiated, "task priority")
+        blockSema.signal()
+        waitForExpectations(timeout: 5, handler: nil)
+        // The user-initiated request overtakes the requests that were queued before it.
+        XCTAssertEqual(order.value, ["first", "userInitiated", "normal", "background"], "request order")
+        XCTAssertEqual(scheduler.queuedTaskCount, 0, "queued task count")
+        XCTAssertEqual(first.schedulerQueueDepth, 0, "first queue depth")
+        XCTAssertEqual(first.schedulerQueueDuration, 0, "first queue duration")
+        XCTAssertEqual(userInitiated.schedulerQueueDepth, 2, "user-initiated queue depth")
+        XCTAssertGreaterThan(userInitiated.schedulerQueueDuration, 0, "user-initiated queue duration")
+    }
+    
+    func testConcurrencyLimit() {
+        let scheduler = HTTPManagerRequestScheduler(maximumConcurrentRequestsPerHost: 2)
+        HTTP.requestScheduler = scheduler
+        let lock = NSLock()
+        var running = 0
+        var maximumRunning = 0
+        for i in 0..<6 {
+            expectationForHTTPRequest(httpServer, path: "/item/\(i)") { (request, completionHandler) in
+                lock.lock()
+                running += 1
+                maximumRunning = max(maximumRunning, running)
+                lock.unlock()
+                DispatchQueue.global().asyncAfter(deadline: .now() + 0.05) {
+                    lock.lock()
+                    running -= 1
+                    lock.unlock()
+                    completionHandler(HTTPServer.Response(status: .ok))
+                }
+            }
+            expectationForRequestSuccess(HTTP.request(GET: "item/\(i)"))
+        }
+        XCTAssertEqual(scheduler.queuedTaskCount, 4, "queued task count")
+        waitForExpectations(timeout: 5, handler: nil)
+        lock.lock()
+        XCTAssertLessThanOrEqual(maximumRunning, 2, "maximum concurrent requests")
+        lock.unlock()
+        XCTAssertEqual(scheduler.queuedTaskCount, 0, "queued task count")
+    }
+    
+    func testCancelQueuedTask() {
+        let scheduler = HTTPManagerRequestScheduler(maximumConcurrentRequestsPerHost: 1)
+        HTTP.requestScheduler = scheduler
+        let blockSema = DispatchSemaphore(value: 0)
+        expectationForHTTPRequest(httpServer, path: "/foo") { (request, completionHandler) in
+            XCTAssert(blockSema.wait(timeout: DispatchTime.now() + 5) == .success, "timeout on dispatch semaphore")
+            completionHandler(HTTPServer.Response(status: .ok))
+        }
+        expectationForHTTPRequest(httpServer, path: "/baz") { (request, completionHandler) in
+            completionHandler(HTTPServer.Response(status: .ok))
+        }
+        expectationForRequestSuccess(HTTP.request(GET: "foo"))
+        // The server never sees the canceled request.
+        let canceled = expectationForRequestCanceled(HTTP.request(GET: "bar"))
+        expectationForRequestSuccess(HTTP.request(GET: "baz"))
+        XCTAssertEqual(scheduler.queuedTaskCount, 2, "queued task count")
+        canceled.cancel()
+        blockSema.signal()
+        waitForExpectations(timeout: 5, handler: nil)
+        XCTAssertEqual(scheduler.queuedTaskCount, 0, "queued task count")
+    }
+    
+    private final class RequestOrder {
+        private let lock = NSLock()
+        private var _value: [String] = []
+        
+        var value: [String] {
+            lock.lock()
+            defer { lock.unlock() }
+            return _value
+        }
+        
+        func append(_ path: String) {
+            lock.lock()
+            _value.append(path)
+            lock.unlock()
+        }
+    }
+}
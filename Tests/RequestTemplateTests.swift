@@ -0,0 +1,73 @@
+//
+//  RequestTemplateTests.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import XCTest
+@testable import PMHTTP
+
+final class RequestTemplateTests: PMHTTPTestCase {
+    override func tearDown() {
+        HTTP.defaultHeaderFields = [:]
+        super.tearDown()
+    }
+    
+    func testTemplateURL() {
+        let address = httpServer.address
+        HTTP.environment = HTTPManagerEnvironment(string: "http://\(address)/v1")!
+        let template = HTTP.requestTemplate(GET: "users/:id/items/:item", parameters: [URLQueryItem(name: "fields", value: "name")])!
+        XCTAssertEqual(template.pathParameterNames, ["id", "item"], "path parameter names")
+        XCTAssertEqual(template.request(pathParameters: ["id": "42", "item": "a b/c"])?.url.absoluteString, "http://\(address)/v1/users/42/items/a%20b%2Fc?fields=name", "URL")
+        XCTAssertEqual(template.request(pathParameters: ["id": "42", "item": "1"], parameters: [URLQueryItem(name: "page", value: "2")])?.url.absoluteString, "http://\(address)/v1/users/42/items/1?fields=name&page=2", "URL with query items")
+        XCTAssertNil(template.request(pathParameters: ["id": "42"]), "request missing a path parameter")
+        
+        let rootTemplate = HTTP.requestTemplate(GET: ":id")!
+        XCTAssertEqual(rootTemplate.request(pathParameters: ["id": "foo"])?.url.absoluteString, "http://\(address)/v1/foo", "URL for leading placeholder")
+        let absoluteTemplate = HTTP.requestTemplate(GET: "http://example.com/items?sort=asc", parameters: ["limit": 10])!
+        XCTAssertEqual(absoluteTemplate.pathParameterNames, [], "path parameter names")
+        XCTAssertEqual(absoluteTemplate.request()?.url.absoluteString, "http://example.com/items?sort=asc&limit=10", "absolute URL")
+    }
+    
+    func testTemplateFreezesDefaults() {
+        HTTP.defaultHeaderFields = ["X-Foo": "Bar"]
+        HTTP.defaultRetryBehavior = .retryNetworkFailure(withStrategy: .retryOnce)
+        let template = HTTP.requestTemplate(GET: "users/:id", configure: { request in
+            request.userInitiated = true
+            request.headerFields["X-Baz"] = "Qux"
+        })!
+        let externalTemplate = HTTP.requestTemplate(GET: "http://example.com/users/:id")!
+        HTTP.defaultHeaderFields = ["X-Foo": "Changed"]
+        HTTP.defaultRetryBehavior = nil
+        
+        let req = template.request(pathParameters: ["id": "1"])!
+        XCTAssertEqual(req.headerFields, ["X-Foo": "Bar", "X-Baz": "Qux"], "header fields")
+        XCTAssertNotNil(req.retryBehavior, "retry behavior")
+        XCTAssertTrue(req.userInitiated, "user initiated")
+        XCTAssertEqual(externalTemplate.request(pathParameters: ["id": "1"])?.headerFields, [:], "header fields outside the environment")
+        
+        // Requests from the template are independent of each other.
+        req.headerFields["X-Foo"] = nil
+        XCTAssertEqual(template.request(pathParameters: ["id": "2"])?.headerFields, ["X-Foo": "Bar", "X-Baz": "Qux"], "header fields")
+    }
+    
+    func testTemplateRequest() {
+        let template = HTTP.requestTemplate(GET: "users/:id", parameters: ["fields": "name"])!
+        expectationForHTTPRequest(httpServer, path: "/users/42") { (request, completionHandler) in
+            XCTAssertEqual(request.urlComponents.queryItems ?? [], [URLQueryItem(name: "fields", value: "name"), URLQueryItem(name: "page", value: "2")], "query items")
+            completionHandler(HTTPServer.Response(status: .ok, text: "success"))
+        }
+        expectationForRequestSuccess(template.request(pathParameters: ["id": "42"], parameters: [URLQueryItem(name: "page", value: "2")])) { (task, response, value) in
+            XCTAssertEqual(String(data: value, encoding: .utf8), "success", "body")
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+}
@@ -0,0 +1,221 @@
+//
+//  ResponseCacheTests.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import XCTest
+import PMJSON
+@testable import PMHTTP
+
+final class ResponseCacheTests: PMHTTPTestCase {
+    override func setUp() {
+        super.setUp()
+        HTTP.responseCache = HTTPManagerResponseCache(byteLimit: 1024 * 1024)
+    }
+    
+    override func tearDown() {
+        HTTP.responseCache = nil
+        super.tearDown()
+    }
+    
+    func testFreshHit() {
+        let parseCount = ParseCounter()
+        func makeRequest() -> HTTPManagerParseRequest<JSON> {
+            return HTTP.request(GET: "foo")!.parseAsJSON(using: { response, json -> JSON in
+                parseCount.increment()
+                return json
+            }).with({
+                $0.usesResponseCache = true
+                $0.parseIdentifier = "json"
+            })
+        }
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "application/json", "Cache-Control": "max-age=60"], body: "[1,2,3]"))
+        }
+        expectationForRequestSuccess(makeRequest()) { task, response, value in
+            XCTAssertEqual(value, [1,2,3])
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+        XCTAssertEqual(parseCount.value, 1, "parse count")
+        
+        // The server has no more handlers, so this can only succeed if it's served from the cache.
+        expectationForRequestSuccess(makeRequest()) { task, response, value in
+            XCTAssertEqual(value, [1,2,3])
+            XCTAssertEqual((response as? HTTPURLResponse)?.statusCode, 200, "status code")
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+        XCTAssertEqual(parseCount.value, 1, "parse count")
+        
+        // Requests that don't opt in still go to the network.
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "application/json"], body: "[4]"))
+        }
+        expectationForRequestSuccess(HTTP.request(GET: "foo")!.parseAsJSON()) { task, response, value in
+            XCTAssertEqual(value, [4])
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testParsedValuesRequireMatchingParseIdentifier() {
+        let parseCount = ParseCounter()
+        func makeRequest(parseIdentifier: String?, negate: Bool) -> HTTPManagerParseRequest<JSON> {
+            return HTTP.request(GET: "foo")!.parseAsJSON(using: { response, json -> JSON in
+                parseCount.increment()
+                guard negate else { return json }
+                return JSON(try json.getArray().map({ JSON(-(try $0.getInt64())) }))
+            }).with({
+                $0.usesResponseCache = true
+                $0.parseIdentifier = parseIdentifier
+            })
+        }
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "application/json", "Cache-Control": "max-age=60"], body: "[1,2,3]"))
+        }
+        expectationForRequestSuccess(makeRequest(parseIdentifier: "identity", negate: false)) { task, response, value in
+            XCTAssertEqual(value, [1,2,3])
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+        XCTAssertEqual(parseCount.value, 1, "parse count")
+        
+        // A different parse handler for the same URL and result type parses the cached body itself.
+        expectationForRequestSuccess(makeRequest(parseIdentifier: "negated", negate: true)) { task, response, value in
+            XCTAssertEqual(value, [-1,-2,-3])
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+        XCTAssertEqual(parseCount.value, 2, "parse count")
+        
+        // So does a request without a parse identifier.
+        expectationForRequestSuccess(makeRequest(parseIdentifier: nil, negate: true)) { task, response, value in
+            XCTAssertEqual(value, [-1,-2,-3])
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+        XCTAssertEqual(parseCount.value, 3, "parse count")
+        
+        // Both identified values were kept.
+        expectationForRequestSuccess(makeRequest(parseIdentifier: "identity", negate: false)) { task, response, value in
+            XCTAssertEqual(value, [1,2,3])
+        }
+        expectationForRequestSuccess(makeRequest(parseIdentifier: "negated", negate: true)) { task, response, value in
+            XCTAssertEqual(value, [-1,-2,-3])
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+        XCTAssertEqual(parseCount.value, 3, "parse count")
+    }
+    
+    func testStaleWhileRevalidate() {
+        func makeRequest() -> HTTPManagerParseRequest<JSON> {
+            return HTTP.request(GET: "foo")!.parseAsJSON().with({ $0.usesResponseCache = true })
+        }
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "application/json", "Cache-Control": "no-cache", "ETag": "\"v1\""], body: "[1]"))
+        }
+        expectationForRequestSuccess(makeRequest()) { task, response, value in
+            XCTAssertEqual(value, [1])
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+        
+        // The entry is stale, so it's returned immediately while it's revalidated.
+        let cache = HTTP.responseCache!
+        expectation(for: NSPredicate(block: { _, _ in cache.currentByteCount == 5 }), evaluatedWith: cache, handler: nil)
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            XCTAssertEqual(request.headers["If-None-Match"], "\"v1\"")
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "application/json", "Cache-Control": "no-cache", "ETag": "\"v2\""], body: "[1,2]"))
+        }
+        expectationForRequestSuccess(makeRequest()) { task, response, value in
+            XCTAssertEqual(value, [1])
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+        
+        // The new response replaced the entry, and is revalidated on its next use.
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            XCTAssertEqual(request.headers["If-None-Match"], "\"v2\"")
+            completionHandler(HTTPServer.Response(status: .notModified, headers: ["Cache-Control": "max-age=60", "ETag": "\"v2\""]))
+        }
+        expectationForRequestSuccess(makeRequest()) { task, response, value in
+            XCTAssertEqual(value, [1,2])
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+        
+        // The server has no more handlers, so this must be served from the cache.
+        expectationForRequestSuccess(makeRequest()) { task, response, value in
+            XCTAssertEqual(value, [1,2])
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testNoStore() {
+        let cache = HTTP.responseCache!
+        for _ in 0..<2 {
+            expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+                completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "application/json", "Cache-Control": "no-store"], body: "[1]"))
+            }
+            expectationForRequestSuccess(HTTP.request(GET: "foo")!.parseAsJSON().with({ $0.usesResponseCache = true })) { task, response, value in
+                XCTAssertEqual(value, [1])
+            }
+            waitForExpectations(timeout: 5, handler: nil)
+            XCTAssertEqual(cache.currentByteCount, 0, "cached bytes")
+        }
+    }
+    
+    func testEviction() {
+        let cache = HTTPManagerResponseCache(byteLimit: 10)
+        func key(_ path: String) -> HTTPManagerResponseCache.Key {
+            return HTTPManagerResponseCache.Key(request: URLRequest(url: URL(string: "http://example.com/\(path)")!))
+        }
+        let valueKey = HTTPManagerResponseCache.ValueKey(valueType: String.self, parseIdentifier: "string")
+        func store(_ path: String, _ body: String) {
+            let response = HTTPURLResponse(url: URL(string: "http://example.com/\(path)")!, statusCode: 200, httpVersion: "HTTP/1.1", headerFields: ["Cache-Control": "max-age=60"])!
+            cache.store(response, data: body.data(using: .utf8)!, value: body, valueKey: valueKey, for: key(path))
+        }
+        store("a", "aaaa")
+        store("b", "bbbb")
+        XCTAssertEqual(cache.currentByteCount, 8, "cached bytes")
+        // Touch "a" so "b" is the least recently used.
+        XCTAssertEqual(cache.lookup(key("a"), valueKey: valueKey)?.value as? String, "aaaa")
+        store("c", "cccc")
+        XCTAssertEqual(cache.currentByteCount, 8, "cached bytes")
+        XCTAssertNotNil(cache.lookup(key("a"), valueKey: valueKey), "entry a")
+        XCTAssertNil(cache.lookup(key("b"), valueKey: valueKey), "entry b")
+        XCTAssertNotNil(cache.lookup(key("c"), valueKey: valueKey), "entry c")
+        // Values are stored per type and parse identifier.
+        for otherKey in [HTTPManagerResponseCache.ValueKey(valueType: Int.self, parseIdentifier: "string"),
+                         HTTPManagerResponseCache.ValueKey(valueType: String.self, parseIdentifier: "other"),
+                         nil]
+        {
+            let hit = cache.lookup(key("c"), valueKey: otherKey)
+            XCTAssertNotNil(hit, "entry c")
+            XCTAssertNil(hit?.value ?? nil, "value for \(String(describing: otherKey))")
+        }
+        // Bodies larger than the limit aren't stored.
+        store("d", "ddddddddddd")
+        XCTAssertNil(cache.lookup(key("d"), valueKey: valueKey), "entry d")
+        cache.removeAllEntries()
+        XCTAssertEqual(cache.currentByteCount, 0, "cached bytes")
+    }
+}
+
+final class ParseCounter {
+    var value: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return _value
+    }
+    
+    func increment() {
+        lock.lock()
+        defer { lock.unlock() }
+        _value += 1
+    }
+    
+    private let lock = NSLock()
+    private var _value = 0
+}
@@ -0,0 +1,81 @@
+//
+//  RetrySchedulingTests.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import XCTest
+@testable import PMHTTP
+
+final class RetrySchedulingTests: XCTestCase {
+    func testSchedulerDelays() {
+        // Use a small wheel so some of the delays take more than one revolution.
+        let scheduler = RetryScheduler(tickInterval: 0.01, slotCount: 8)
+        let queue = DispatchQueue(label: "test queue")
+        let start = DispatchTime.now().uptimeNanoseconds
+        var fired: [(delay: TimeInterval, elapsed: TimeInterval)] = []
+        let delays: [TimeInterval] = [0.2, 0.05, 0.12, 0.05, 0]
+        for delay in delays {
+            let expectation = self.expectation(description: "delay \(delay)")
+            scheduler.schedule(after: delay, on: queue) {
+                fired.append((delay, TimeInterval(DispatchTime.now().uptimeNanoseconds - start) / 1e9))
+                expectation.fulfill()
+            }
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+        queue.sync {
+            XCTAssertEqual(fired.map({ $0.delay }), delays.sorted(), "firing order")
+            for (delay, elapsed) in fired {
+                XCTAssertGreaterThanOrEqual(elapsed, delay, "elapsed time for delay \(delay)")
+            }
+        }
+        XCTAssertEqual(scheduler.pendingCount, 0, "pending count")
+        
+        // The scheduler is reusable after being idle.
+        let expectation = self.expectation(description: "delay after idle")
+        scheduler.schedule(after: 0.03, on: queue) {
+            expectation.fulfill()
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testRetryBudget() {
+        let budget = HTTPManagerRetryBudget(capacity: 2, refillRate: 0)
+        XCTAssertTrue(budget.consumeToken(forHost: "example.com"))
+        XCTAssertTrue(budget.consumeToken(forHost: "EXAMPLE.com"))
+        XCTAssertFalse(budget.consumeToken(forHost: "example.com"))
+        // A refunded token can be taken again, but the bucket never exceeds its capacity.
+        budget.refundToken(forHost: "example.com")
+        XCTAssertTrue(budget.consumeToken(forHost: "example.com"))
+        XCTAssertFalse(budget.consumeToken(forHost: "example.com"))
+        budget.refundToken(forHost: "example.net")
+        XCTAssertTrue(budget.consumeToken(forHost: "example.net"))
+        XCTAssertTrue(budget.consumeToken(forHost: "example.net"))
+        XCTAssertFalse(budget.consumeToken(forHost: "example.net"))
+        // Each host has its own bucket.
+        XCTAssertTrue(budget.consumeToken(forHost: "example.org"))
+        
+        let refilling = HTTPManagerRetryBudget(capacity: 1, refillRate: 100)
+        XCTAssertTrue(refilling.consumeToken(forHost: "example.com"))
+        Thread.sleep(forTimeInterval: 0.05)
+        XCTAssertTrue(refilling.consumeToken(forHost: "example.com"))
+    }
+    
+    func testDecorrelatedJitter() {
+        var previousDelay: TimeInterval?
+        for _ in 0..<1000 {
+            let delay = HTTPManagerRetryBehavior.decorrelatedJitter(previousDelay: previousDelay, baseDelay: 0.5, maximumDelay: 10)
+            XCTAssertGreaterThanOrEqual(delay, 0.5)
+            XCTAssertLessThanOrEqual(delay, min((previousDelay ?? 0.5) * 3, 10))
+            previousDelay = delay
+        }
+    }
+}
@@ -12,8 +12,6 @@
 //  except according to those terms.
 //
 
-#if !swift(>=4.1.9) // detect Swift 4.2 compiler
-
 import XCTest
 @testable import PMHTTP
 
@@ -67,6 +65,23 @@ class SipHashTests: XCTestCase {
                 let result = hasher.finish()
                 XCTAssert(result == exp, "input of length \(i): 0x\(String(result, radix: 16)) is not equal to 0x\(String(exp, radix:16))")
             }
+            // hash as bulk writes, split so the second write starts unaligned
+            buf.withUnsafeBytes { bytes in
+                hasher.write(UnsafeRawBufferPointer(rebasing: bytes[0..<i]))
+                var result = hasher.finish()
+                XCTAssert(result == exp, "bulk input of length \(i): 0x\(String(result, radix: 16)) is not equal to 0x\(String(exp, radix:16))")
+                let split = min(i, 3)
+                hasher.write(UnsafeRawBufferPointer(rebasing: bytes[0..<split]))
+                hasher.write(UnsafeRawBufferPointer(rebasing: bytes[split..<i]))
+                result = hasher.finish()
+                XCTAssert(result == exp, "bulk input of length \(i): 0x\(String(result, radix: 16)) is not equal to 0x\(String(exp, radix:16))")
+            }
+            // hash as Data
+            do {
+                hasher.write(Data(buf[0..<i]))
+                let result = hasher.finish()
+                XCTAssert(result == exp, "data input of length \(i): 0x\(String(result, radix: 16)) is not equal to 0x\(String(exp, radix:16))")
+            }
             // hash as one write per byte
             do {
                 for j in 0..<i {
@@ -78,5 +93,3 @@ class SipHashTests: XCTestCase {
         }
     }
 }
-
-#endif // !swift(>=4.1.9)
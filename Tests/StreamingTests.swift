@@ -0,0 +1,337 @@
+//
+//  StreamingTests.swift
+//  PMHTTP
+//
+//  Created by Lily Ballard on 10/14/26.
+//  Copyright © 2026 Postmates.
+//
+//  Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+//  http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+//  <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+//  option. This file may not be copied, modified, or distributed
+//  except according to those terms.
+//
+
+import XCTest
+@testable import PMHTTP
+
+final class StreamingTests: PMHTTPTestCase {
+    func testStream() {
+        let body = makeBody(count: 512 * 1024)
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "application/octet-stream"], body: body))
+        }
+        let received = Accumulator()
+        let req = HTTP.request(GET: "foo")!.stream(using: { response, data in
+            XCTAssertEqual((response as? HTTPURLResponse)?.statusCode, 200, "status code")
+            received.append(data)
+        })
+        expectationForRequestSuccess(req) { task, response, _ in
+            XCTAssertEqual((response as? HTTPURLResponse)?.statusCode, 200, "status code")
+            XCTAssertEqual(received.data, body, "streamed body")
+            XCTAssertGreaterThan(received.chunkCount, 0, "chunk count")
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testStreamBackpressure() {
+        let body = makeBody(count: 256 * 1024)
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .ok, body: body))
+        }
+        let received = Accumulator()
+        let req = HTTP.request(GET: "foo")!.stream(maximumBufferedBytes: 1024, using: { _, data in
+            // Simulate a slow consumer so the transfer has to pause.
+            usleep(1000)
+            received.append(data)
+        })
+        expectationForRequestSuccess(req) { _, _, _ in
+            XCTAssertEqual(received.data, body, "streamed body")
+        }
+        waitForExpectations(timeout: 10, handler: nil)
+    }
+    
+    func testStreamErrorResponse() {
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .notFound, text: "not found"))
+        }
+        let req = HTTP.request(GET: "foo")!.stream(using: { _, _ in
+            XCTFail("stream handler invoked for error response")
+        })
+        expectationForRequestFailure(req) { task, response, error in
+            if case let HTTPManagerError.failedResponse(statusCode, _, body, _) = error {
+                XCTAssertEqual(statusCode, 404, "error status code")
+                XCTAssertEqual(String(data: body, encoding: .utf8), "not found", "error body")
+            } else {
+                XCTFail("Unexpected error: \(error)")
+            }
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testStreamUnexpectedContentType() {
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            XCTAssertEqual(request.headers["Accept"], "application/json", "request Accept header")
+            completionHandler(HTTPServer.Response(status: .ok, text: "hello"))
+        }
+        let req = HTTP.request(GET: "foo")!.stream(using: { _, _ in
+            XCTFail("stream handler invoked for unexpected content type")
+        })
+        req.expectedContentTypes = ["application/json"]
+        expectationForRequestFailure(req) { task, response, error in
+            if case let HTTPManagerError.unexpectedContentType(contentType, _, body) = error {
+                XCTAssertEqual(contentType, "text/plain", "error content type")
+                XCTAssertEqual(String(data: body, encoding: .utf8), "hello", "error body")
+            } else {
+                XCTFail("Unexpected error: \(error)")
+            }
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testStreamHandlerError() {
+        struct StreamError: Error {}
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .ok, body: self.makeBody(count: 128 * 1024)))
+        }
+        let req = HTTP.request(GET: "foo")!.stream(using: { _, _ in
+            throw StreamError()
+        })
+        req.retryBehavior = HTTPManagerRetryBehavior({ task, error, attempt, callback in
+            XCTFail("retry behavior invoked after the stream handler received data")
+            callback(false)
+        })
+        expectationForRequestFailure(req) { task, response, error in
+            XCTAssert(error is StreamError, "Unexpected error: \(error)")
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testStreamCancel() {
+        let sema = DispatchSemaphore(value: 0)
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .ok, body: self.makeBody(count: 256 * 1024)))
+        }
+        let received = Accumulator()
+        let req = HTTP.request(GET: "foo")!.stream(maximumBufferedBytes: 1024, using: { _, data in
+            // Block on the first chunk so the transfer is paused when we cancel.
+            if received.chunkCount == 0 {
+                sema.wait()
+            }
+            received.append(data)
+        })
+        let task = expectationForRequestCanceled(req)
+        DispatchQueue.global().asyncAfter(deadline: .now() + 0.1) {
+            task.cancel()
+            sema.signal()
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testStreamJSONArray() {
+        let elements: [JSON] = (0..<2000).map({ i in ["id": .int64(Int64(i)), "name": .string("item \"\(i)\", [{}]\\"), "tags": ["a", "b"]] })
+        let body = JSON.encodeAsData(.array(JSONArray(elements)))
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            XCTAssertEqual(request.headers["Accept"], "application/json", "request Accept header")
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "application/json"], body: body))
+        }
+        let received = Collector<[JSON]>([])
+        let req = HTTP.request(GET: "foo")!.streamAsJSONArray(maximumBufferedBytes: 1024, using: { _, element in
+            received.append(element)
+        })
+        expectationForRequestSuccess(req) { _, _, _ in
+            XCTAssertEqual(received.values, elements, "streamed elements")
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testStreamDecodedJSONArray() {
+        struct Item: Decodable, Equatable {
+            var id: Int
+            var name: String
+            
+            static func ==(lhs: Item, rhs: Item) -> Bool {
+                return lhs.id == rhs.id && lhs.name == rhs.name
+            }
+        }
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "application/json"], body: "[{\"id\": 1, \"name\": \"a\"}, {\"id\": 2, \"name\": \"b\"}]"))
+        }
+        let received = Collector<[Item]>([])
+        let req = HTTP.request(GET: "foo")!.streamAsJSONArray(of: Item.self, using: { _, item in
+            received.append(item)
+        })
+        expectationForRequestSuccess(req) { _, _, _ in
+            XCTAssertEqual(received.values, [Item(id: 1, name: "a"), Item(id: 2, name: "b")], "streamed elements")
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testStreamJSONArrayEmpty() {
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "application/json"], body: " [ ] "))
+        }
+        let req = HTTP.request(GET: "foo")!.streamAsJSONArray(using: { _, _ in
+            XCTFail("stream handler invoked for an empty array")
+        })
+        expectationForRequestSuccess(req)
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testStreamJSONArrayNoContent() {
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .noContent))
+        }
+        let req = HTTP.request(GET: "foo")!.streamAsJSONArray(using: { _, _ in
+            XCTFail("stream handler invoked for 204 No Content")
+        })
+        expectationForRequestFailure(req) { task, response, error in
+            if case HTTPManagerError.unexpectedNoContent = error {} else {
+                XCTFail("Unexpected error: \(error)")
+            }
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testStreamJSONArrayTruncated() {
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .ok, headers: ["Content-Type": "application/json"], body: "[1, 2, [3"))
+        }
+        let received = Collector<[JSON]>([])
+        let req = HTTP.request(GET: "foo")!.streamAsJSONArray(using: { _, element in
+            received.append(element)
+        })
+        expectationForRequestFailure(req) { task, response, error in
+            XCTAssertEqual((error as? JSONParserError)?.code, .unexpectedEOF, "error code")
+            XCTAssertEqual(received.values, [1, 2], "streamed elements")
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testJSONArrayElementSplitter() throws {
+        let json = "\n[ 1,\"a,]\\\"\" ,{\"b\":[1,{}]}, [[], \"}\"] ,null]\n"
+        let expected = ["1", "\"a,]\\\"\" ", "{\"b\":[1,{}]}", "[[], \"}\"] ", "null"]
+        // Feed the document one byte at a time to exercise elements that span chunks.
+        var splitter = JSONArrayElementSplitter()
+        var elements: [String] = []
+        for byte in json.data(using: String.Encoding.utf8)! {
+            try splitter.append(Data([byte]), { elements.append(String(data: $0, encoding: .utf8)!) })
+        }
+        try splitter.finish()
+        XCTAssertEqual(elements, expected, "split elements")
+        
+        splitter = JSONArrayElementSplitter()
+        XCTAssertThrowsError(try splitter.append("{}".data(using: String.Encoding.utf8)!, { _ in XCTFail("unexpected element") }), "object document") { error in
+            XCTAssertEqual((error as? JSONParserError)?.code, .invalidSyntax, "error code")
+        }
+        splitter = JSONArrayElementSplitter()
+        XCTAssertThrowsError(try splitter.append("[1] 2".data(using: String.Encoding.utf8)!, { _ in }), "trailing characters") { error in
+            XCTAssertEqual((error as? JSONParserError)?.code, .trailingCharacters, "error code")
+        }
+        splitter = JSONArrayElementSplitter()
+        XCTAssertThrowsError(try splitter.append("[1,]".data(using: String.Encoding.utf8)!, { _ in }), "trailing comma") { error in
+            XCTAssertEqual((error as? JSONParserError)?.code, .invalidSyntax, "error code")
+        }
+    }
+    
+    func testDownload() {
+        let body = makeBody(count: 512 * 1024)
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .ok, body: body))
+        }
+        let req = HTTP.request(GET: "foo")!.download()
+        XCTAssertNil(req.destinationURL, "destination URL")
+        expectationForRequestSuccess(req) { task, response, data in
+            XCTAssertEqual(data, body, "downloaded body")
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testDownloadToFile() {
+        let body = makeBody(count: 256 * 1024)
+        let fileURL = URL(fileURLWithPath: NSTemporaryDirectory(), isDirectory: true).appendingPathComponent("PMHTTPTests-\(UUID().uuidString)")
+        defer { _ = try? FileManager.default.removeItem(at: fileURL) }
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .ok, body: body))
+        }
+        let req = HTTP.request(GET: "foo")!.download(to: fileURL, using: { response, data in
+            return data.count
+        })
+        expectationForRequestSuccess(req) { task, response, count in
+            XCTAssertEqual(count, body.count, "parsed value")
+            XCTAssertEqual(try? Data(contentsOf: fileURL), body, "file contents")
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testDownloadErrorResponse() {
+        let fileURL = URL(fileURLWithPath: NSTemporaryDirectory(), isDirectory: true).appendingPathComponent("PMHTTPTests-\(UUID().uuidString)")
+        defer { _ = try? FileManager.default.removeItem(at: fileURL) }
+        expectationForHTTPRequest(httpServer, path: "/foo") { request, completionHandler in
+            completionHandler(HTTPServer.Response(status: .notFound, text: "not found"))
+        }
+        let req = HTTP.request(GET: "foo")!.download(to: fileURL)
+        expectationForRequestFailure(req) { task, response, error in
+            if case let HTTPManagerError.failedResponse(statusCode, _, body, _) = error {
+                XCTAssertEqual(statusCode, 404, "error status code")
+                XCTAssertEqual(String(data: body, encoding: .utf8), "not found", "error body")
+            } else {
+                XCTFail("Unexpected error: \(error)")
+            }
+            XCTAssertFalse(FileManager.default.fileExists(atPath: fileURL.path), "file exists")
+        }
+        waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    private func makeBody(count: Int) -> Data {
+        var data = Data(count: count)
+        data.withUnsafeMutableBytes { (ptr: UnsafeMutablePointer<UInt8>) in
+            for i in 0..<count {
+                ptr[i] = UInt8(truncatingIfNeeded: i &* 31)
+            }
+        }
+        return data
+    }
+}
+
+private final class Accumulator {
+    private let lock = NSLock()
+    private var _data = Data()
+    private var _chunkCount = 0
+    
+    var data: Data {
+        lock.lock()
+        defer { lock.unlock() }
+        return _data
+    }
+    
+    var chunkCount: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return _chunkCount
+    }
+    
+    func append(_ data: Data) {
+        lock.lock()
+        defer { lock.unlock() }
+        _data.append(data)
+        _chunkCount += 1
+    }
+}
+
+private final class Collector<T> {
+    private let lock = NSLock()
+    private var _values: [T] = []
+    
+    var values: [T] {
+        lock.lock()
+        defer { lock.unlock() }
+        return _values
+    }
+    
+    func append(_ value: T) {
+        lock.lock()
+        defer { lock.unlock() }
+        _values.append(value)
+    }
+}